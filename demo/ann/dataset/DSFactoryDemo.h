@@ -0,0 +1,132 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   DSFactoryDemo.h
+ *
+ * Created on December 16, 2024, 5:40 PM
+ */
+
+#ifndef DSFACTORYDEMO_H
+#define DSFACTORYDEMO_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <filesystem> //require C++17
+namespace fs = std::filesystem;
+using namespace std;
+
+#include "ann/annheader.h"
+#include "dataset/DSFactory.h"
+
+//the features of the train split of ds_name (one batch of the whole dataset)
+double_tensor dsfactory_train_features(string cfg_file, string ds_name){
+    DSFactory factory(cfg_file);
+    auto pMap = factory.get_datasets(ds_name, 3);
+    TensorDataset<double, double>* pTrain = pMap->get("train_ds");
+    DataLoader<double, double> loader(pTrain, pTrain->len(), false, false);
+    double_tensor X;
+    for(auto batch: loader) X = batch.getData();
+    delete pMap;
+    return X;
+}
+
+//max |a - b|/(1 + |b|); infinity if the shapes differ
+double dsfactory_error(const double_tensor& a, const double_tensor& b){
+    if(a.shape() != b.shape()) return INFINITY;
+    return xt::amax(xt::abs(a - b)/(1 + xt::abs(b)))();
+}
+
+/*
+ * dsFactoryCheck: the feature statistics of DSFactory::get_datasets (mu/sigma of the train
+ *  split, saved as <prefix>_mu.npy/<prefix>_sigma.npy) on a temporary dataset:
+ *  + the saved stats are those of estimate_params on the train features, and the features
+ *      are normalized with them;
+ *  + the next call loads them (the same features, bit for bit);
+ *  + a train file newer than the stats, stats of the wrong size, or reuse_stats: 0 (with
+ *      stale stats on disk) => estimated again, equal to a fresh estimate_params.
+ */
+bool dsFactoryCheck(size_t nrows=3000, size_t nfeatures=6){
+    string root = (fs::temp_directory_path()/fs::path("dsfactory-check")).string();
+    string ds_name = "3c-check";
+    fs::path ds_path = fs::path(root)/fs::path(ds_name);
+    fs::remove_all(root);
+    fs::create_directories(ds_path);
+    string cfg_file = (fs::path(root)/fs::path("config.txt")).string();
+    string cfg_noreuse = (fs::path(root)/fs::path("config-noreuse.txt")).string();
+    {
+        ofstream cfg(cfg_file), cfg2(cfg_noreuse);
+        cfg << "dataset_root: " << root << "\n";
+        cfg2 << "dataset_root: " << root << "\nreuse_stats: 0\n";
+    }
+    string train_file = (ds_path/fs::path("3c_train.npy")).string();
+    string mu_file = (ds_path/fs::path("3c_mu.npy")).string();
+    string sigma_file = (ds_path/fs::path("3c_sigma.npy")).string();
+
+    xt::random::seed(2024);
+    auto make_table = [&](size_t n, double offset){
+        double_tensor table = xt::random::randn<double>({n, nfeatures + 1})*4 + offset;
+        for(size_t r=0; r < n; r++) table(r, nfeatures) = (double)(r%3);
+        return table;
+    };
+    //estimate_params and the normalized features of the train table, from scratch
+    auto expected = [&](const double_tensor& table, double_tensor& mu, double_tensor& sigma){
+        double_tensor F = xt::view(table, xt::all(), xt::range(0, nfeatures));
+        estimate_params(F, mu, sigma);
+        return double_tensor((F - mu)/sigma);
+    };
+    double_tensor train = make_table(nrows, 10);
+    xt::dump_npy(train_file, train);
+    xt::dump_npy((ds_path/fs::path("3c_valid.npy")).string(), make_table(nrows/10, 10));
+    xt::dump_npy((ds_path/fs::path("3c_test.npy")).string(), make_table(nrows/10, 10));
+
+    //(1) first call: estimated and saved
+    double_tensor mu, sigma;
+    double_tensor X_expected = expected(train, mu, sigma);
+    double_tensor X1 = dsfactory_train_features(cfg_file, ds_name);
+    bool saved = fs::exists(mu_file) && fs::exists(sigma_file) &&
+                 (dsfactory_error(xt::load_npy<double>(mu_file), mu) == 0) &&
+                 (dsfactory_error(xt::load_npy<double>(sigma_file), sigma) == 0);
+    double_tensor F = xt::view(train, xt::all(), xt::range(0, nfeatures));
+    double stats_err = max(dsfactory_error(mu, xt::mean(F, 0)), dsfactory_error(sigma, xt::stddev(F)));
+    double norm_err = dsfactory_error(X1, X_expected);
+    cout << "estimated: saved " << (saved? "yes" : "no") << ", stats vs xt::mean/stddev " << stats_err
+         << ", features " << norm_err << endl;
+
+    //(2) second call: loaded, the same features
+    auto mu_time = fs::last_write_time(mu_file);
+    double_tensor X2 = dsfactory_train_features(cfg_file, ds_name);
+    bool cached = (fs::last_write_time(mu_file) == mu_time) && (dsfactory_error(X2, X1) == 0);
+    cout << "cached: " << (cached? "same features, not rewritten" : "different") << endl;
+
+    //(3) a newer train file: estimated again
+    train = make_table(nrows, -5);
+    xt::dump_npy(train_file, train);
+    fs::last_write_time(train_file, mu_time + chrono::seconds(10));
+    X_expected = expected(train, mu, sigma);
+    double stale_err = dsfactory_error(dsfactory_train_features(cfg_file, ds_name), X_expected);
+
+    //(4) stats of the wrong size (newer than the train file): estimated again
+    auto newer = fs::last_write_time(train_file) + chrono::seconds(10);
+    xt::dump_npy(mu_file, double_tensor(xt::zeros<double>({nfeatures + 1})));
+    fs::last_write_time(mu_file, newer);
+    fs::last_write_time(sigma_file, newer);
+    double size_err = dsfactory_error(dsfactory_train_features(cfg_file, ds_name), X_expected);
+
+    //(5) reuse_stats: 0, with wrong stats newer than the train file
+    xt::dump_npy(mu_file, double_tensor(xt::zeros<double>({nfeatures})));
+    fs::last_write_time(mu_file, newer);
+    fs::last_write_time(sigma_file, newer);
+    double noreuse_err = dsfactory_error(dsfactory_train_features(cfg_noreuse, ds_name), X_expected);
+    cout << "estimated again: newer train file " << stale_err << ", wrong size " << size_err
+         << ", reuse_stats 0 " << noreuse_err << endl;
+    fs::remove_all(root);
+    return saved && (stats_err < 1e-12) && (norm_err < 1e-12) && cached &&
+           (stale_err < 1e-12) && (size_err < 1e-12) && (noreuse_err < 1e-12);
+}
+
+#endif /* DSFACTORYDEMO_H */
@@ -0,0 +1,98 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   ActivationDemo.h
+ *
+ * Created on December 16, 2024, 10:05 AM
+ */
+
+#ifndef ACTIVATIONDEMO_H
+#define ACTIVATIONDEMO_H
+
+#include <iostream>
+#include <string>
+#include <cmath>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "kernels/vecmath.h"
+
+//max over i of |a[i] - b[i]|/(1 + |b[i]|); NaN if a and b do not have the same NaNs
+double activation_error(const double_tensor& a, const double_tensor& b){
+    double err = 0;
+    for(size_t i=0; i < a.size(); i++){
+        double x = a.data()[i], y = b.data()[i];
+        if(std::isnan(x) || std::isnan(y)) return NAN;
+        err = max(err, std::abs(x - y)/(1 + std::abs(y)));
+    }
+    return err;
+}
+
+/*
+ * activation_layer_error: forward then backward (both in place, training mode) of layer on X,
+ *  against the scalar formulas f (forward) and df (the derivative from X and Y)
+ */
+template<class F, class DF>
+double activation_layer_error(ILayer& layer, const double_tensor& X, const double_tensor& DY, F f, DF df){
+    double_tensor Y_ref = X, DX_ref = DY;
+    for(size_t i=0; i < X.size(); i++){
+        Y_ref.data()[i] = f(X.data()[i]);
+        DX_ref.data()[i] = DY.data()[i]*df(X.data()[i], Y_ref.data()[i]);
+    }
+    layer.set_working_mode(true);
+    double_tensor Y = layer.forward(X);
+    double_tensor DX = layer.backward(DY);
+    return max(activation_error(Y, Y_ref), activation_error(DX, DX_ref));
+}
+
+/*
+ * activationCheck: ReLU, Sigmoid and Tanh (forward and backward) on every SIMD level the cpu
+ *  has (see set_simd_level), against the scalar formulas:
+ *  + lengths that are not multiples of 4, 8 or 64 (the vector and mask-word tails), and a
+ *      long one split into chunks on the thread pool;
+ *  + inputs beyond the clamp of the vector exp (x < -708.39, x > 709), and signed zeros.
+ */
+bool activationCheck(){
+    xt::random::seed(2024);
+    size_t lengths[] = {1, 3, 5, 7, 9, 13, 63, 65, 127, 129, 1001, 100003};
+    double extremes[] = {-1000, -800, -745, -709.5, -708.5, -0.0, 0.0, 708.5, 709.5, 745, 800, 1000};
+    SimdLevel levels[] = {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512};
+    string names[] = {"scalar", "avx2", "avx512"};
+    SimdLevel saved = simd_level();
+    bool ok = true;
+    for(SimdLevel level: levels){
+        if(set_simd_level(level) != level) continue; //not on this cpu
+        double worst[3] = {0, 0, 0};
+        for(size_t n: lengths){
+            double_tensor X = xt::random::randn<double>({n})*20;
+            for(size_t i=0; i < n; i += 3) X.data()[i] = extremes[(i/3)%12];
+            double_tensor DY = xt::random::randn<double>({n});
+            ReLU relu;
+            Sigmoid sigmoid;
+            Tanh tanh_layer;
+            double errs[3] = {
+                activation_layer_error(relu, X, DY,
+                    [](double x){ return (x >= 0)? x : 0.0; },
+                    [](double x, double){ return (x >= 0)? 1.0 : 0.0; }),
+                activation_layer_error(sigmoid, X, DY,
+                    [](double x){ return 1.0/(1.0 + std::exp(-x)); },
+                    [](double, double y){ return y*(1 - y); }),
+                activation_layer_error(tanh_layer, X, DY,
+                    [](double x){ return std::tanh(x); },
+                    [](double, double y){ return 1 - y*y; })
+            };
+            for(int k=0; k < 3; k++) worst[k] = (std::isnan(errs[k]) || std::isnan(worst[k]))? NAN : max(worst[k], errs[k]);
+        }
+        bool level_ok = (worst[0] == 0) && (worst[1] < 1e-14) && (worst[2] < 1e-14);
+        cout << names[level] << ": max error relu " << worst[0] << ", sigmoid " << worst[1]
+             << ", tanh " << worst[2] << (level_ok? "" : "  <- FAILED") << endl;
+        ok &= level_ok;
+    }
+    set_simd_level(saved);
+    return ok;
+}
+
+#endif /* ACTIVATIONDEMO_H */
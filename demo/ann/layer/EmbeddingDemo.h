@@ -0,0 +1,121 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   EmbeddingDemo.h
+ *
+ * Created on November 24, 2024, 3:40 PM
+ */
+
+#ifndef EMBEDDINGDEMO_H
+#define EMBEDDINGDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "optim/SGD.h"
+#include "optim/Adam.h"
+#include "optim/Adagrad.h"
+
+void embeddingDemo1(){
+    Embedding layer(10, 3);
+    layer.set_working_mode(true);
+    SGD optim(0.5);
+    IParamGroup* pGroup = optim.create_group(layer.getname());
+    layer.register_params(pGroup);
+    cout << layer.get_desc() << endl;
+
+    //two samples, two categorical columns each
+    double_tensor X = {{1, 4}, {1, 9}};
+    double_tensor Y = layer.forward(X);
+    cout << "Y: " << xt::adapt(Y.shape()) << endl << Y << endl;
+
+    optim.zero_grad();
+    layer.backward(xt::ones<double>(Y.shape()));
+    SparseRowGrad& grad = layer.get_grad();
+    cout << "rows with a gradient:";
+    for(size_t k=0; k < grad.size(); k++) cout << " " << grad.row_id(k) << "(" << grad.values(k)[0] << ")";
+    cout << endl;
+    optim.step();
+    cout << "after one step: " << endl << layer.forward(X) << endl;
+}
+
+/*
+ * embeddingDemo2: one categorical feature with nvocab values, embedded in ndim dimensions;
+ *  the one-hot encoding through FCLayer(nvocab, ndim) against Embedding(nvocab, ndim):
+ *  the same outputs and SGD updates; the time of forward + backward + step.
+ */
+template<class Fn>
+double time_steps(int nsteps, Fn fn){
+    auto start = chrono::steady_clock::now();
+    for(int s=0; s < nsteps; s++) fn(s);
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count()/nsteps;
+}
+
+void embeddingDemo2(int nvocab=20000, int ndim=16, int batch=256, int nsteps=20){
+    xt::random::seed(2024);
+    Embedding embedding(nvocab, ndim);
+    FCLayer onehot(nvocab, ndim, false);
+    double_tensor W = xt::transpose(embedding.forward(xt::arange<double>(nvocab))); //the same table
+    onehot.set_weights(W);
+    embedding.set_working_mode(true);
+    onehot.set_working_mode(true);
+    SGD optim_e(1e-2), optim_f(1e-2);
+    embedding.register_params(optim_e.create_group("embedding"));
+    onehot.register_params(optim_f.create_group("onehot"));
+
+    double_tensor ids = xt::floor(xt::random::rand<double>({(size_t)nsteps, (size_t)batch})*nvocab);
+    auto one_hot = [&](int s){
+        double_tensor X = xt::zeros<double>({(size_t)batch, (size_t)nvocab});
+        for(int n=0; n < batch; n++) X(n, (size_t)ids(s, n)) = 1.0;
+        return X;
+    };
+    double t_onehot = time_steps(nsteps, [&](int s){
+        double_tensor X = one_hot(s);
+        optim_f.zero_grad();
+        double_tensor Y = onehot.forward(X);
+        onehot.backward(Y);
+        optim_f.step();
+    });
+    double t_embedding = time_steps(nsteps, [&](int s){
+        double_tensor X = xt::view(ids, s, xt::all());
+        optim_e.zero_grad();
+        double_tensor Y = embedding.forward(X);
+        embedding.backward(Y);
+        optim_e.step();
+    });
+    //the rows of the first batch, read from both tables
+    double_tensor Y_e = embedding.forward(xt::view(ids, 0, xt::all()));
+    double_tensor Y_f = onehot.forward(one_hot(0));
+    cout << "nvocab " << nvocab << ", ndim " << ndim << ", batch " << batch << endl;
+    cout << "max |Embedding - one-hot FC| after " << nsteps << " SGD steps: "
+         << xt::amax(xt::abs(Y_e - Y_f))() << endl;
+    cout << fixed << setprecision(3)
+         << "one-hot + FCLayer: " << t_onehot*1e3 << " ms/step" << endl
+         << "Embedding        : " << t_embedding*1e3 << " ms/step" << endl;
+
+    //the step cost of Embedding does not depend on nvocab
+    for(int vocab: {10000, 1000000}){
+        Embedding table(vocab, ndim);
+        table.set_working_mode(true);
+        Adam adam(1e-3);
+        table.register_params(adam.create_group("table"));
+        double_tensor batch_ids = xt::floor(xt::random::rand<double>({(size_t)batch})*vocab);
+        double t_step = time_steps(nsteps, [&](int){
+            adam.zero_grad();
+            double_tensor Y = table.forward(batch_ids);
+            table.backward(Y);
+            adam.step();
+        });
+        cout << "Embedding(" << vocab << ", " << ndim << ") + Adam: " << t_step*1e3 << " ms/step" << endl;
+    }
+    cout << defaultfloat;
+}
+
+#endif /* EMBEDDINGDEMO_H */
@@ -0,0 +1,146 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   GemmDemo.h
+ *
+ * Created on December 17, 2024, 10:30 AM
+ */
+
+#ifndef GEMMDEMO_H
+#define GEMMDEMO_H
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "kernels/gemm.h"
+#include "kernels/vecmath.h"
+
+/*
+ * gemm_case_error: gemm on op(A) (M x K), op(B) (K x N), C (M x N) stored with row strides
+ *  padded by pad elements, against the naive triple loop in long double:
+ *  max |C - C_ref|/(|alpha| sum_k |a_ik||b_kj| + |beta||c_ij|), in units of K*epsilon;
+ *  + beta == 0: C starts as NaN (it must not be read);
+ *  + the padding of C must be untouched (else: infinity).
+ */
+template<class T>
+double gemm_case_error(mt19937& rng, bool transA, bool transB, size_t M, size_t N, size_t K,
+        size_t pad, T alpha, T beta){
+    uniform_real_distribution<double> uniform(-1.0, 1.0);
+    size_t rowsA = transA? K : M, colsA = transA? M : K;
+    size_t rowsB = transB? N : K, colsB = transB? K : N;
+    size_t lda = colsA + pad, ldb = colsB + pad, ldc = N + pad;
+    vector<T> A(rowsA*lda), B(rowsB*ldb), C(M*ldc);
+    for(auto& v: A) v = (T)uniform(rng);
+    for(auto& v: B) v = (T)uniform(rng);
+    const T sentinel = (T)12345;
+    for(size_t i=0; i < M; i++)
+        for(size_t j=0; j < ldc; j++)
+            C[i*ldc + j] = (j >= N)? sentinel : ((beta == T(0))? numeric_limits<T>::quiet_NaN() : (T)uniform(rng));
+    vector<T> C0 = C;
+
+    gemm(transA, transB, M, N, K, alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldc);
+
+    double worst = 0;
+    double eps = numeric_limits<T>::epsilon();
+    for(size_t i=0; i < M; i++){
+        for(size_t j=N; j < ldc; j++) if(C[i*ldc + j] != sentinel) return INFINITY;
+        for(size_t j=0; j < N; j++){
+            long double sum = 0, bound = 0;
+            for(size_t k=0; k < K; k++){
+                long double a = transA? A[k*lda + i] : A[i*lda + k];
+                long double b = transB? B[j*ldb + k] : B[k*ldb + j];
+                sum += a*b;
+                bound += std::abs(a*b);
+            }
+            long double ref = (long double)alpha*sum;
+            bound = std::abs((long double)alpha)*bound;
+            if(beta != T(0)){
+                ref += (long double)beta*C0[i*ldc + j];
+                bound += std::abs((long double)beta*C0[i*ldc + j]);
+            }
+            double c = C[i*ldc + j];
+            if(std::isnan(c)) return INFINITY;
+            double err = (double)(std::abs(c - ref)/(bound + numeric_limits<T>::min()));
+            worst = max(worst, err/((K + 2)*eps));
+        }
+    }
+    return worst;
+}
+
+/*
+ * gemm_type_error: the worst gemm_case_error over
+ *  + nrandom random shapes (mostly small, one large dimension at times), each in the four
+ *      transpose cases, with and without padded strides, beta 0 (NaN C), 1 or another value;
+ *  + edge tiles: M, N, K around the MR/NR of every micro-kernel, the MC/KC blocks and
+ *      the NC column blocks (not multiples of any of them).
+ */
+template<class T>
+double gemm_type_error(int nrandom, size_t& ncases){
+    mt19937 rng(2024);
+    uniform_int_distribution<size_t> small(1, 48), large(49, 600), coin(0, 7);
+    double worst = 0;
+    T betas[] = {T(0), T(1), T(-0.5)};
+    for(int r=0; r < nrandom; r++){
+        size_t dims[3] = {small(rng), small(rng), small(rng)};
+        if(coin(rng) == 0) dims[r%3] = large(rng); //M > MC, N > a few NR, K > KC
+        size_t pad = (r%2 == 0)? 0 : 1 + r%5;
+        T beta = betas[r%3];
+        T alpha = (r%4 == 3)? T(-1.5) : T(1);
+        for(int trans=0; trans < 4; trans++){
+            worst = max(worst, gemm_case_error<T>(rng, trans & 1, trans & 2, dims[0], dims[1], dims[2], pad, alpha, beta));
+            ncases++;
+        }
+    }
+    size_t edge_MN[] = {1, 3, 5, 7, 9, 13, 17, 23, 25, 47, 49, 97, 129};
+    size_t edge_K[] = {1, 255, 257, 513};
+    for(size_t m: edge_MN){
+        for(size_t n: edge_MN){
+            for(size_t k: edge_K){
+                if(m*n*k > 2000000) continue;
+                int trans = (m + n + k)%4;
+                worst = max(worst, gemm_case_error<T>(rng, trans & 1, trans & 2, m, n, k, 3, T(1), T(0)));
+                ncases++;
+            }
+        }
+    }
+    for(int trans=0; trans < 4; trans++){ //more columns than NC
+        worst = max(worst, gemm_case_error<T>(rng, trans & 1, trans & 2, 3, 4100, 5, 2, T(1), T(1)));
+        ncases++;
+    }
+    return worst;
+}
+
+/*
+ * gemmCheck: gemm (double and float) on every SIMD level the cpu has, against the naive
+ *  triple loop (see gemm_type_error); the error is measured in units of K*epsilon of the
+ *  type, relative to the sum of the absolute products.
+ */
+bool gemmCheck(int nrandom=400){
+    SimdLevel levels[] = {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512};
+    string names[] = {"scalar", "avx2", "avx512"};
+    SimdLevel saved = simd_level();
+    bool ok = true;
+    for(SimdLevel level: levels){
+        if(set_simd_level(level) != level) continue; //not on this cpu
+        size_t ncases = 0;
+        double err_double = gemm_type_error<double>(nrandom, ncases);
+        double err_float = gemm_type_error<float>(nrandom, ncases);
+        bool level_ok = (err_double < 1) && (err_float < 1);
+        cout << names[level] << ": " << ncases << " cases, max error (in K*eps) double " << err_double
+             << ", float " << err_float << (level_ok? "" : "  <- FAILED") << endl;
+        ok &= level_ok;
+    }
+    set_simd_level(saved);
+    return ok;
+}
+
+#endif /* GEMMDEMO_H */
@@ -0,0 +1,99 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   SoftmaxDemo.h
+ *
+ * Created on December 16, 2024, 2:40 PM
+ */
+
+#ifndef SOFTMAXDEMO_H
+#define SOFTMAXDEMO_H
+
+#include <iostream>
+#include <string>
+#include <cmath>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "kernels/vecmath.h"
+
+/*
+ * softmax_reference: softmax of X along axis and its backward for DY, one slice at a time,
+ *  in long double with the two-pass max shift
+ */
+void softmax_reference(const double_tensor& X, const double_tensor& DY, int axis,
+        double_tensor& Y, double_tensor& DX){
+    size_t outer = 1, len = X.shape()[axis], inner = 1;
+    for(int d=0; d < axis; d++) outer *= X.shape()[d];
+    for(int d=axis + 1; d < (int)X.dimension(); d++) inner *= X.shape()[d];
+    Y = X; DX = DY;
+    for(size_t o=0; o < outer; o++)
+        for(size_t i=0; i < inner; i++){
+            size_t base = o*len*inner + i;
+            long double m = X.data()[base], s = 0, dot = 0;
+            for(size_t k=0; k < len; k++) m = std::max(m, (long double)X.data()[base + k*inner]);
+            for(size_t k=0; k < len; k++) s += std::exp((long double)X.data()[base + k*inner] - m);
+            for(size_t k=0; k < len; k++){
+                size_t idx = base + k*inner;
+                long double y = std::exp((long double)X.data()[idx] - m)/s;
+                Y.data()[idx] = y;
+                dot += y*DY.data()[idx];
+            }
+            for(size_t k=0; k < len; k++){
+                size_t idx = base + k*inner;
+                DX.data()[idx] = Y.data()[idx]*(DY.data()[idx] - dot);
+            }
+        }
+}
+
+/*
+ * softmaxCheck: the Softmax layer (forward and backward) along every axis of 2-D and 3-D
+ *  tensors, on every SIMD level the cpu has, against softmax_reference:
+ *  + contiguous rows (last axis) and strided columns, with more columns than one block
+ *      and sizes that are not multiples of 4 or 8 (the vector tails);
+ *  + inputs of ±800, where exp overflows/underflows without the max shift.
+ */
+bool softmaxCheck(){
+    xt::random::seed(2024);
+    vector<vector<size_t>> shapes = {{37, 129}, {300, 5}, {5, 67, 33}, {3, 7, 301}, {2, 9, 1}};
+    SimdLevel levels[] = {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512};
+    string names[] = {"scalar", "avx2", "avx512"};
+    SimdLevel saved = simd_level();
+    bool ok = true;
+    for(SimdLevel level: levels){
+        if(set_simd_level(level) != level) continue; //not on this cpu
+        double worst = 0;
+        int ncases = 0;
+        for(auto& shape: shapes){
+            double_tensor X = xt::random::randn<double>(shape)*5;
+            for(size_t i=0; i < X.size(); i += 5) X.data()[i] = ((i/5)%2 == 0)? 800.0 : -800.0;
+            double_tensor DY = xt::random::randn<double>(shape);
+            for(int axis=0; axis < (int)shape.size(); axis++){
+                double_tensor Y_ref, DX_ref;
+                softmax_reference(X, DY, axis, Y_ref, DX_ref);
+                Softmax layer(axis);
+                layer.set_working_mode(true);
+                double_tensor Y = layer.forward(X);
+                double_tensor DX = layer.backward(DY);
+                double err = 0;
+                for(size_t i=0; i < X.size(); i++){
+                    double e = max(std::abs(Y.data()[i] - Y_ref.data()[i]), std::abs(DX.data()[i] - DX_ref.data()[i]));
+                    err = std::isnan(e)? INFINITY : max(err, e);
+                }
+                worst = max(worst, err);
+                ncases++;
+            }
+        }
+        bool level_ok = worst < 1e-14;
+        cout << names[level] << ": " << ncases << " (shape, axis) cases, max error " << worst
+             << (level_ok? "" : "  <- FAILED") << endl;
+        ok &= level_ok;
+    }
+    set_simd_level(saved);
+    return ok;
+}
+
+#endif /* SOFTMAXDEMO_H */
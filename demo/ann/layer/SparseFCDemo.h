@@ -0,0 +1,134 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   SparseFCDemo.h
+ *
+ * Created on November 25, 2024, 2:30 PM
+ */
+
+#ifndef SPARSEFCDEMO_H
+#define SPARSEFCDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <set>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+#include "tensor/csr_matrix.h"
+#include "optim/SGD.h"
+#include "optim/Adam.h"
+
+/*
+ * random_columns: k distinct columns of [0, ncols), ascending
+ */
+ulong_tensor random_columns(size_t ncols, size_t k){
+    std::set<unsigned long> cols;
+    while(cols.size() < k) cols.insert(xt::random::randint<unsigned long>({1}, 0, ncols)(0));
+    ulong_tensor result = xt::empty<unsigned long>({k});
+    std::copy(cols.begin(), cols.end(), result.begin());
+    return result;
+}
+
+/*
+ * random_sparse_rows: [nrows, ncols], nnz_per_row non-zeros per row (normal values)
+ */
+CSRMatrix<double> random_sparse_rows(size_t nrows, size_t ncols, size_t nnz_per_row){
+    CSRMatrix<double> M(ncols);
+    M.reserve(nrows, nrows*nnz_per_row);
+    for(size_t r=0; r < nrows; r++){
+        ulong_tensor cols = random_columns(ncols, nnz_per_row);
+        double_tensor values = xt::random::randn<double>({nnz_per_row});
+        M.add_row(cols.data(), values.data(), nnz_per_row);
+    }
+    return M;
+}
+
+/*
+ * sparseFCDemo1: a 99%-sparse batch through FCLayer, dense [batch, Nin] against CSR:
+ *  the same outputs and SGD updates; the time of forward + backward + step, and the input memory.
+ */
+void sparseFCDemo1(int nin=20000, int nout=64, int batch=256, int nsteps=10){
+    xt::random::seed(2024);
+    FCLayer dense(nin, nout, true);
+    FCLayer sparse(dense); //the same weights
+    dense.set_working_mode(true);
+    sparse.set_working_mode(true);
+    SGD optim_d(1e-2), optim_s(1e-2);
+    dense.register_params(optim_d.create_group("dense"));
+    sparse.register_params(optim_s.create_group("sparse"));
+
+    CSRMatrix<double> X = random_sparse_rows(batch, nin, nin/100);
+    double_tensor X_dense = X.to_dense();
+    double_tensor Y_d = dense.forward(X_dense);
+    double_tensor Y_s = sparse.forward(X);
+    cout << "nin " << nin << ", nout " << nout << ", batch " << batch << ", nnz " << X.nnz() << endl;
+    cout << "max |dense - CSR| forward: " << xt::amax(xt::abs(Y_d - Y_s))() << endl;
+
+    auto time_steps = [&](FCLayer& layer, SGD& optim, auto& input){
+        auto start = chrono::steady_clock::now();
+        for(int s=0; s < nsteps; s++){
+            optim.zero_grad();
+            double_tensor Y = layer.forward(input);
+            layer.backward(Y);
+            optim.step();
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count()/nsteps;
+    };
+    double t_dense = time_steps(dense, optim_d, X_dense);
+    double t_sparse = time_steps(sparse, optim_s, X);
+    cout << "max |dense - CSR| after " << nsteps << " SGD steps: "
+         << xt::amax(xt::abs(dense.forward(X_dense) - sparse.forward(X)))() << endl;
+    size_t csr_bytes = X.nnz()*(sizeof(double) + sizeof(uint32_t)) + (X.rows() + 1)*sizeof(size_t);
+    cout << fixed << setprecision(3)
+         << "dense input: " << t_dense*1e3 << " ms/step, " << X_dense.size()*sizeof(double)/1024.0 << " KB" << endl
+         << "CSR input  : " << t_sparse*1e3 << " ms/step, " << csr_bytes/1024.0 << " KB" << endl;
+    cout << defaultfloat;
+}
+
+/*
+ * sparseFCDemo2: MLPClassifier trained from a SparseTensorDataset (CSR batches end to end);
+ *  the class of a row is the block of columns (of nClasses) holding most of its mass.
+ */
+void sparseFCDemo2(int nsamples=2000, int nin=10000, int nepoch=20){
+    xt::random::seed(2024);
+    int nClasses = 3;
+    size_t block = nin/nClasses;
+    CSRMatrix<double> X(nin);
+    double_tensor labels = xt::zeros<double>({(size_t)nsamples});
+    for(int n=0; n < nsamples; n++){
+        int label = n % nClasses;
+        ulong_tensor cols = random_columns(block, 20) + label*block;
+        double_tensor values = xt::random::rand<double>({(size_t)20}) + 0.5;
+        X.add_row(cols.data(), values.data(), 20);
+        labels(n) = label;
+    }
+    SparseTensorDataset<double, double> train_ds(X.slice_rows(0, nsamples*4/5), xt::view(labels, xt::range(0, nsamples*4/5)));
+    SparseTensorDataset<double, double> test_ds(X.slice_rows(nsamples*4/5, nsamples), xt::view(labels, xt::range(nsamples*4/5, nsamples)));
+    DataLoader<double, double> train_loader(&train_ds, 50, true, false);
+    DataLoader<double, double> test_loader(&test_ds, 50, false, false);
+
+    ILayer* layers[] = {
+                    new FCLayer(nin, 32, true),
+                    new ReLU(),
+                    new FCLayer(32, nClasses, true),
+                    new Softmax()
+    };
+    MLPClassifier model("./config.txt", "sparse-fc", layers, sizeof(layers)/sizeof(ILayer*));
+    Adam optim(1e-2);
+    CrossEntropy loss;
+    ClassMetrics metrics(nClasses);
+    model.compile(&optim, &loss, &metrics);
+    model.fit(&train_loader, &test_loader, nepoch, 0);
+    cout << "Evaluation result on the testing dataset: " << endl;
+    cout << model.evaluate(&test_loader) << endl;
+}
+
+#endif /* SPARSEFCDEMO_H */
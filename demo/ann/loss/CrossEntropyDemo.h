@@ -0,0 +1,142 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   CrossEntropyDemo.h
+ *
+ * Created on December 14, 2024, 10:05 AM
+ */
+
+#ifndef CROSSENTROPYDEMO_H
+#define CROSSENTROPYDEMO_H
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+
+/*
+ * crossEntropyDemo1: sparse labels (class indices, [N]) against one-hot labels ([N, C]):
+ *  the same loss and the same gradient.
+ */
+void crossEntropyDemo1(){
+    double_tensor Y = {{0.7, 0.2, 0.1}, {0.1, 0.3, 0.6}, {0.25, 0.5, 0.25}};
+    double_tensor t_sparse = {0, 2, 1};
+    double_tensor t_dense = onehot_enc(label_indices(t_sparse, 3), 3);
+
+    CrossEntropy sparse_loss, dense_loss;
+    double loss_s = sparse_loss.forward(Y, t_sparse);
+    double loss_d = dense_loss.forward(Y, t_dense);
+    double_tensor DY_s = sparse_loss.backward();
+    double_tensor DY_d = dense_loss.backward();
+    cout << "loss (sparse labels): " << loss_s << endl;
+    cout << "loss (dense labels) : " << loss_d << endl;
+    cout << "max |DY_sparse - DY_dense|: " << xt::amax(xt::abs(DY_s - DY_d))() << endl;
+}
+
+/*
+ * crossEntropyDemo2: a sparse label must be an integer in [0, C);
+ *  a negative, fractional or too large label is rejected with std::out_of_range
+ *  by the loss, and by label_indices (the datasets and the metrics).
+ */
+void crossEntropyDemo2(){
+    double_tensor Y = {{0.7, 0.2, 0.1}, {0.1, 0.3, 0.6}};
+    double_tensor bad_labels[] = {{0, -1}, {0, 1.5}, {0, 3}};
+    int nrejected = 0;
+    for(auto& t: bad_labels){
+        CrossEntropy loss;
+        try{
+            loss.forward(Y, t);
+            cout << "accepted: " << t << endl;
+        }
+        catch(std::out_of_range& e){
+            cout << "rejected: " << e.what() << endl;
+            nrejected++;
+        }
+    }
+    try{
+        label_indices(double_tensor{1, 2, 5}, 3);
+    }
+    catch(std::out_of_range& e){
+        cout << "rejected: " << e.what() << endl;
+        nrejected++;
+    }
+    cout << nrejected << "/4 bad label sets rejected" << endl;
+}
+
+/*
+ * crossEntropyCheck: sparse labels (class indices, [N]) against their one-hot encoding ([N, C]):
+ *  + label_indices: the same indices;
+ *  + CrossEntropy (mean and sum): the same loss (up to the order of the sums) and the same
+ *      gradient, bit for bit, for batches split into chunks on the thread pool or not;
+ *  + fit from the same initial weights: the same trained model;
+ *  + invalid labels (negative, fractional, >= C) are rejected.
+ */
+bool crossEntropyCheck(){
+    xt::random::seed(2024);
+    size_t sizes[][2] = {{1, 2}, {7, 3}, {64, 10}, {5000, 17}, {20000, 3}};
+    double loss_err = 0, grad_err = 0;
+    bool same_indices = true;
+    for(auto& size: sizes){
+        size_t N = size[0], C = size[1];
+        double_tensor Y = softmax(xt::random::randn<double>({N, C})*3, 1);
+        double_tensor t_sparse = xt::floor(xt::random::rand<double>({N})*C);
+        double_tensor t_dense = onehot_enc(label_indices(t_sparse, C), C);
+        same_indices &= (label_indices(t_sparse, C) == label_indices(t_dense, C));
+        for(LossReduction reduction: {REDUCE_MEAN, REDUCE_SUM}){
+            CrossEntropy sparse_loss(reduction), dense_loss(reduction);
+            double loss_s = sparse_loss.forward(Y, t_sparse);
+            double loss_d = dense_loss.forward(Y, t_dense);
+            loss_err = max(loss_err, std::abs(loss_s - loss_d)/std::abs(loss_d));
+            grad_err = max(grad_err, (double)xt::amax(xt::abs(sparse_loss.backward() - dense_loss.backward()))());
+        }
+    }
+    cout << "loss: max relative difference " << loss_err << ", gradient: max difference " << grad_err
+         << ", label_indices: " << (same_indices? "same" : "different") << endl;
+
+    //training: the same gradients, the same model
+    double_tensor X = xt::random::randn<double>({(size_t)512, (size_t)6});
+    double_tensor t_sparse = xt::cast<double>(xt::argmax(xt::view(X, xt::all(), xt::range(0, 3)), 1));
+    double_tensor t_dense = onehot_enc(label_indices(t_sparse, 3), 3);
+    double_tensor W1 = xt::random::randn<double>({(size_t)6, (size_t)12})*0.3;
+    double_tensor W2 = xt::random::randn<double>({(size_t)12, (size_t)3})*0.3;
+    double_tensor Y_model[2];
+    for(int dense=0; dense < 2; dense++){
+        TensorDataset<double, double> ds(X, dense? t_dense : t_sparse);
+        DataLoader<double, double> loader(&ds, 32, false, false);
+        FCLayer* fc1 = new FCLayer(6, 12, true);
+        FCLayer* fc2 = new FCLayer(12, 3, true);
+        fc1->set_weights(W1);
+        fc2->set_weights(W2);
+        ILayer* layers[] = {fc1, new ReLU(), fc2, new Softmax()};
+        MLPClassifier model("./config.txt", "sparse-labels", layers, sizeof(layers)/sizeof(ILayer*));
+        SGD optim(1e-1);
+        CrossEntropy loss;
+        ClassMetrics metrics(3);
+        model.compile(&optim, &loss, &metrics);
+        model.fit(&loader, &loader, 2, 0);
+        Y_model[dense] = model.predict(X, true);
+    }
+    double model_err = xt::amax(xt::abs(Y_model[0] - Y_model[1]))();
+    cout << "fit with sparse and one-hot labels: max |Y_sparse - Y_dense| " << model_err << endl;
+
+    //invalid labels
+    double_tensor Y = {{0.7, 0.2, 0.1}, {0.1, 0.3, 0.6}};
+    double_tensor bad_labels[] = {{0, -1}, {0, 1.5}, {0, 3}};
+    int nrejected = 0;
+    for(auto& t: bad_labels){
+        CrossEntropy loss;
+        try{ loss.forward(Y, t); }
+        catch(std::out_of_range& e){ nrejected++; }
+    }
+    cout << nrejected << "/3 bad label sets rejected" << endl;
+    return same_indices && (loss_err < 1e-12) && (grad_err == 0) && (model_err == 0) && (nrejected == 3);
+}
+
+#endif /* CROSSENTROPYDEMO_H */
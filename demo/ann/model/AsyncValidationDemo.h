@@ -0,0 +1,81 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   AsyncValidationDemo.h
+ *
+ * Created on December 16, 2024, 5:00 PM
+ */
+
+#ifndef ASYNCVALIDATIONDEMO_H
+#define ASYNCVALIDATIONDEMO_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <filesystem> //require C++17
+namespace fs = std::filesystem;
+using namespace std;
+
+#include "ann/annheader.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+
+/*
+ * asyncValidationCheck: fit with async_validation (the snapshots are evaluated on a background
+ *  thread by launch_validation, reported by harvest_validation) against the same fit with the
+ *  synchronous evaluate at the end of each epoch:
+ *  + one result per epoch, reported in epoch order, and the results are the same;
+ *  + the last result is the evaluate of the trained model.
+ */
+bool asyncValidationCheck(int nepoch=5, int nsamples=2048){
+    string root = (fs::temp_directory_path()/fs::path("async-valid-check")).string();
+    fs::create_directories(root);
+    string cfg_file = (fs::path(root)/fs::path("config.txt")).string();
+    {
+        ofstream cfg(cfg_file);
+        cfg << "model_root: " << root << "\ninit_seed: 2024\n";
+    }
+    xt::random::seed(2024);
+    int nClasses = 4;
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)8});
+    double_tensor labels = xt::cast<double>(xt::argmax(xt::view(X, xt::all(), xt::range(0, nClasses)), 1));
+    double_tensor X_valid = xt::random::randn<double>({(size_t)nsamples/4, (size_t)8});
+    double_tensor labels_valid = xt::cast<double>(xt::argmax(xt::view(X_valid, xt::all(), xt::range(0, nClasses)), 1));
+    TensorDataset<double, double> train_ds(X, labels), valid_ds(X_valid, labels_valid);
+    DataLoader<double, double> train_loader(&train_ds, 64, false, false);
+    DataLoader<double, double> valid_loader(&valid_ds, 64, false, false);
+
+    vector<double_tensor> history[2];
+    double_tensor last_eval;
+    for(int async=0; async < 2; async++){
+        ILayer* layers[] = {new FCLayer(8, 32, true), new ReLU(), new FCLayer(32, nClasses, true), new Softmax()};
+        MLPClassifier model(cfg_file, "async-valid", layers, sizeof(layers)/sizeof(ILayer*));
+        model.set_async_validation(async == 1);
+        SGD optim(1e-2);
+        CrossEntropy loss;
+        ClassMetrics metrics(nClasses);
+        model.compile(&optim, &loss, &metrics);
+        model.fit(&train_loader, &valid_loader, nepoch, 0);
+        history[async] = model.get_validation_history();
+        if(async == 1) last_eval = model.evaluate(&valid_loader);
+    }
+
+    bool same = (history[0].size() == (size_t)nepoch) && (history[1].size() == (size_t)nepoch);
+    double max_diff = 0;
+    for(size_t e=0; same && (e < history[0].size()); e++){
+        same &= (history[0][e].shape() == history[1][e].shape());
+        if(same) max_diff = max(max_diff, (double)xt::amax(xt::abs(history[0][e] - history[1][e]))());
+    }
+    same &= (max_diff == 0);
+    bool last_ok = !history[1].empty() && (xt::amax(xt::abs(history[1].back() - last_eval))() == 0);
+    cout << "validation results: " << history[0].size() << " sync, " << history[1].size() << " async ("
+         << nepoch << " epochs), max difference " << max_diff
+         << ", last one equal to evaluate: " << (last_ok? "yes" : "no") << endl;
+    fs::remove_all(root);
+    return same && last_ok;
+}
+
+#endif /* ASYNCVALIDATIONDEMO_H */
@@ -0,0 +1,127 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   CheckpointDemo.h
+ *
+ * Created on December 16, 2024, 9:20 AM
+ */
+
+#ifndef CHECKPOINTDEMO_H
+#define CHECKPOINTDEMO_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <filesystem> //require C++17
+namespace fs = std::filesystem;
+using namespace std;
+
+#include "ann/annheader.h"
+#include "config/Config.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+#include "model/CheckpointWriter.h"
+
+//the checkpoint-k folders of root/model_name, in increasing k
+vector<int> checkpoint_folders(Config& config, string model_name){
+    xvector<int> indices = config.get_checkpoint_indices(model_name);
+    vector<int> sorted;
+    for(int idx=0; idx < indices.size(); idx++) sorted.push_back(indices.get(idx));
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+/*
+ * checkpointCheck: periodic checkpoints of fit (ckpt_interval 1, ckpt_keep K) in a temporary
+ *  model_root holding a leftover .checkpoint-k.tmp folder:
+ *  + the temporary folder is not a checkpoint: the indices start at 1, and only the last K
+ *      checkpoint-k folders remain after nepoch > K epochs;
+ *  + load of the last checkpoint gives the weights of the trained model, also from its .old
+ *      copy (a commit interrupted between its two renames);
+ *  + a writer fed faster than the disk drops the older pending checkpoints, the last one is
+ *      always written.
+ */
+bool checkpointCheck(int nepoch=6, int keep=2, int nsubmit=8, int nsamples=4096){
+    string root = (fs::temp_directory_path()/fs::path("ckpt-check")).string();
+    string model_name = "ckpt";
+    fs::remove_all(root);
+    fs::create_directories(fs::path(root)/fs::path(model_name)/fs::path(".checkpoint-7.tmp"));
+    string cfg_file = (fs::path(root)/fs::path("config.txt")).string();
+    {
+        ofstream cfg(cfg_file);
+        cfg << "model_root: " << root << "\nckpt_interval: 1\nckpt_keep: " << keep << "\n";
+    }
+    Config config(cfg_file);
+
+    xt::random::seed(2024);
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)3});
+    double_tensor labels = xt::cast<double>(xt::view(X, xt::all(), 0) > 0);
+    TensorDataset<double, double> ds(X, labels);
+    DataLoader<double, double> loader(&ds, 16, false, false);
+    ILayer* layers[] = {new FCLayer(3, 8, true), new ReLU(), new FCLayer(8, 2, true), new Softmax()};
+    MLPClassifier model(cfg_file, model_name, layers, sizeof(layers)/sizeof(ILayer*));
+    SGD optim(1e-1);
+    CrossEntropy loss;
+    ClassMetrics metrics(2);
+    model.compile(&optim, &loss, &metrics);
+    model.fit(&loader, &loader, nepoch, 0);
+
+    //(1) retention: consecutive indices, the last ones; more than K written (an epoch is longer
+    //than a write, though the writer may still drop a pending checkpoint)
+    vector<int> kept = checkpoint_folders(config, model_name);
+    if(kept.empty()) return false;
+    bool retention = ((int)kept.size() == keep) && (kept.back() > keep);
+    for(size_t k=1; k < kept.size(); k++) retention &= (kept[k] == kept[k - 1] + 1);
+    bool tmp_ignored = fs::exists(fs::path(root)/fs::path(model_name)/fs::path(".checkpoint-7.tmp"))
+                       && (kept.back() < 7);
+    cout << "checkpoints kept: " << kept.size() << " (keep " << keep << ", " << nepoch << " epochs), last: checkpoint-"
+         << kept.back() << ", leftover .tmp ignored: " << (tmp_ignored? "yes" : "no") << endl;
+
+    //(2) load: the same predictions, also through the .old fallback of resolve
+    double_tensor Y = model.predict(X, true);
+    string last = (fs::path(root)/fs::path(model_name)/fs::path("checkpoint-" + to_string(kept.back()))).string();
+    MLPClassifier reloaded(cfg_file);
+    bool same = reloaded.load(last, true) && (xt::amax(xt::abs(reloaded.predict(X, true) - Y))() == 0);
+    fs::path old_path = fs::path(root)/fs::path(model_name)/fs::path(".checkpoint-" + to_string(kept.back()) + ".old");
+    fs::rename(last, old_path);
+    MLPClassifier recovered(cfg_file);
+    bool same_old = recovered.load(last, true) && (xt::amax(xt::abs(recovered.predict(X, true) - Y))() == 0);
+    cout << "load of the last checkpoint: " << (same? "same" : "different")
+         << ", from its .old copy: " << (same_old? "same" : "different") << endl;
+    fs::remove_all(root);
+
+    //(3) a busy writer: nsubmit checkpoints in a row, the last one is on disk
+    fs::create_directories(root);
+    {
+        ofstream cfg(cfg_file);
+        cfg << "model_root: " << root << "\n";
+    }
+    Config busy_config(cfg_file);
+    string last_path;
+    double last_value = -1;
+    {
+        CheckpointWriter writer(&busy_config, "busy", keep);
+        for(int s=0; s < nsubmit; s++){
+            Checkpoint* pCkpt = new Checkpoint();
+            pCkpt->add_arch("# step " + to_string(s));
+            pCkpt->add_tensor("step.npy", xt::ones<double>({(size_t)256*1024})*s);
+            writer.submit(pCkpt);
+        }
+        writer.flush();
+        last_path = writer.last_checkpoint();
+        if(fs::exists(fs::path(last_path)/fs::path("step.npy")))
+            last_value = xt::load_npy<double>((fs::path(last_path)/fs::path("step.npy")).string())(0);
+    }
+    vector<int> busy_kept = checkpoint_folders(busy_config, "busy");
+    bool last_written = (last_value == nsubmit - 1) && ((int)busy_kept.size() <= keep);
+    cout << "busy writer: " << nsubmit << " submitted, " << (busy_kept.empty()? 0 : busy_kept.back())
+         << " written, last one on disk: "
+         << (last_written? "yes" : "no") << endl;
+    fs::remove_all(root);
+    return retention && tmp_ignored && same && same_old && last_written;
+}
+
+#endif /* CHECKPOINTDEMO_H */
@@ -0,0 +1,86 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   ConcurrentPredictDemo.h
+ *
+ * Created on December 16, 2024, 6:15 PM
+ */
+
+#ifndef CONCURRENTPREDICTDEMO_H
+#define CONCURRENTPREDICTDEMO_H
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <atomic>
+using namespace std;
+
+#include "ann/annheader.h"
+
+/*
+ * concurrentPredictCheck: nthreads threads share one model and call predict and predict_topk
+ *  on it (the const inference path, see MLPClassifier::infer), in both working modes:
+ *  + every result is the single-threaded one, bit for bit;
+ *  + the working mode of every layer is the one set before (nothing is switched to
+ *      inference mode and back behind the caller).
+ */
+bool concurrentPredictCheck(int nthreads=8, int nrepeat=20, int nsamples=300, int nClasses=7){
+    xt::random::seed(2024);
+    ILayer* layers[] = {
+        new FCLayer(10, 64, true), new ReLU(),
+        new FCLayer(64, 32, true), new Tanh(),
+        new FCLayer(32, nClasses, true), new Softmax()
+    };
+    int nlayers = sizeof(layers)/sizeof(ILayer*);
+    MLPClassifier model("./config.txt", "concurrent-predict", layers, nlayers);
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)10});
+    int k = 3;
+
+    bool ok = true;
+    for(bool trainable: {false, true}){
+        model.set_working_mode(trainable);
+        double_tensor P = model.predict(X, true);
+        double_tensor labels = model.predict(X, false);
+        ulong_tensor indices;
+        double_tensor scores;
+        model.predict_topk(X, k, indices, scores);
+
+        atomic<int> mismatches(0);
+        vector<thread> workers;
+        for(int w=0; w < nthreads; w++){
+            workers.push_back(thread([&, w](){
+                for(int r=0; r < nrepeat; r++){
+                    //a block of rows (its own shape) or the whole batch
+                    size_t begin = (w*37 + r*11)%nsamples, end = min((size_t)nsamples, begin + 1 + (w + r)%50);
+                    if((w + r)%3 == 0){ begin = 0; end = nsamples; }
+                    double_tensor X_rows = xt::view(X, xt::range(begin, end));
+                    double_tensor P_rows = model.predict(X_rows, true);
+                    double_tensor labels_rows = model.predict(X_rows, false);
+                    ulong_tensor indices_rows;
+                    double_tensor scores_rows;
+                    model.predict_topk(X_rows, k, indices_rows, scores_rows);
+                    bool same = (P_rows == xt::view(P, xt::range(begin, end))) &&
+                                (labels_rows == xt::view(labels, xt::range(begin, end))) &&
+                                (indices_rows == xt::view(indices, xt::range(begin, end))) &&
+                                (scores_rows == xt::view(scores, xt::range(begin, end)));
+                    if(!same) mismatches++;
+                }
+            }));
+        }
+        for(auto& worker: workers) worker.join();
+
+        int nchanged = 0;
+        for(int idx=0; idx < nlayers; idx++) nchanged += (layers[idx]->get_working_mode() != trainable);
+        bool mode_ok = (nchanged == 0) && (model.predict(X, true) == P);
+        cout << (trainable? "training" : "inference") << " mode: " << nthreads*nrepeat << " calls on "
+             << nthreads << " threads, " << mismatches.load() << " different from single-threaded, "
+             << nchanged << " layers with a changed working mode" << endl;
+        ok &= (mismatches.load() == 0) && mode_ok;
+    }
+    return ok;
+}
+
+#endif /* CONCURRENTPREDICTDEMO_H */
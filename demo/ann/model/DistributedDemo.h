@@ -0,0 +1,142 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   DistributedDemo.h
+ *
+ * Created on November 29, 2024, 10:00 AM
+ */
+
+#ifndef DISTRIBUTEDDEMO_H
+#define DISTRIBUTEDDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "model/ProcessGroup.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+
+/*
+ * launch_local: runs fn(rank, nprocs) in nprocs child processes (fork) and waits for them;
+ *  true if all of them returned 0. Call it before the first parallel_for of the process:
+ *  the children must not inherit the threads of the pool.
+ */
+bool launch_local(int nprocs, function<int(int, int)> fn){
+    vector<pid_t> children;
+    for(int rank=0; rank < nprocs; rank++){
+        pid_t pid = fork();
+        if(pid < 0){
+            cerr << "launch_local: fork failed" << endl;
+            return false;
+        }
+        if(pid == 0){
+            int code = 1;
+            try{
+                code = fn(rank, nprocs);
+            }
+            catch(exception& e){
+                cerr << "rank " << rank << ": " << e.what() << endl;
+            }
+            cout.flush();
+            _exit(code);
+        }
+        children.push_back(pid);
+    }
+    bool ok = true;
+    for(pid_t pid: children){
+        int status = 0;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+    }
+    return ok;
+}
+
+/*
+ * ddp_model: the same initial weights on every call (rank 0's are broadcast anyway)
+ */
+MLPClassifier* ddp_model(int width, int nClasses){
+    xt::random::seed(7);
+    int sizes[] = {width, 128, 128, nClasses};
+    ILayer* layers[6];
+    for(int k=0; k < 3; k++){
+        FCLayer* fc = new FCLayer(sizes[k], sizes[k + 1], true);
+        fc->set_weights(xt::random::randn<double>({(size_t)sizes[k + 1], (size_t)sizes[k]})/std::sqrt((double)sizes[k]));
+        layers[2*k] = fc;
+        layers[2*k + 1] = (k < 2)? (ILayer*)new ReLU() : (ILayer*)new Softmax();
+    }
+    return new MLPClassifier("./config.txt", "ddp", layers, 6);
+}
+
+/*
+ * distributedDemo1: nprocs local processes train the same model on their shards of a
+ *  synthetic dataset (batch per rank: batch/nprocs), gradients averaged by ring all-reduce.
+ *  Rank 0 then trains the model in a single process with the whole batch: the same
+ *  weights up to rounding (the shards of a step form the single-process batch).
+ */
+void distributedDemo1(int nprocs=4, int nsamples=4096, int width=64, int batch=256, int nepoch=3){
+    int nClasses = 4;
+    auto make_data = [&](double_tensor& X, double_tensor& labels){
+        xt::random::seed(2024);
+        X = xt::random::randn<double>({(size_t)nsamples, (size_t)width});
+        double_tensor W = xt::random::randn<double>({(size_t)width, (size_t)nClasses});
+        labels = xt::argmax(xt::linalg::dot(X, W), 1);
+    };
+    bool ok = launch_local(nprocs, [&](int rank, int world){
+        ProcessGroup group(rank, world, 29650);
+        double_tensor X, labels;
+        make_data(X, labels);
+        TensorDataset<double, double> full_ds(X, labels);
+        ShardedDataset<double, double> shard(&full_ds, rank, world);
+        DataLoader<double, double> train_loader(&shard, batch/world, false, false);
+
+        MLPClassifier* pModel = ddp_model(width, nClasses);
+        SGD optim(2e-1);
+        CrossEntropy loss;
+        ClassMetrics metrics(nClasses);
+        pModel->compile(&optim, &loss, &metrics);
+        pModel->set_distributed(&group);
+        auto start = chrono::steady_clock::now();
+        pModel->fit(&train_loader, &train_loader, nepoch, 0);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double_tensor Y = pModel->predict(X, true);
+
+        //replicas: rank 0's predictions against every rank's
+        double_tensor Y0 = Y;
+        group.broadcast(Y0.data(), Y0.size(), 0);
+        double diff = xt::amax(xt::abs(Y - Y0))();
+        group.allreduce_sum(&diff, 1);
+        if(rank == 0){
+            cout << "ranks " << world << ": " << fixed << setprecision(3) << seconds << " s, "
+                 << group.bytes_sent()/1024.0 << " KB sent by rank 0" << defaultfloat << endl;
+            cout << "sum over ranks of max |Y(rank) - Y(rank 0)|: " << diff << endl;
+
+            TensorDataset<double, double> ref_ds(X, labels);
+            DataLoader<double, double> ref_loader(&ref_ds, batch/world*world, false, false);
+            MLPClassifier* pRef = ddp_model(width, nClasses);
+            SGD ref_optim(2e-1);
+            CrossEntropy ref_loss;
+            ClassMetrics ref_metrics(nClasses);
+            pRef->compile(&ref_optim, &ref_loss, &ref_metrics);
+            pRef->fit(&ref_loader, &ref_loader, nepoch, 0);
+            double_tensor Y_ref = pRef->predict(X, true);
+            cout << "max |Y(DDP) - Y(single process)|: " << xt::amax(xt::abs(Y - Y_ref))() << endl;
+            cout << "accuracy: " << pModel->evaluate(&ref_loader)(0) << endl;
+            delete pRef;
+        }
+        delete pModel;
+        return 0;
+    });
+    if(!ok) cerr << "distributedDemo1: a rank failed" << endl;
+}
+
+#endif /* DISTRIBUTEDDEMO_H */
@@ -0,0 +1,82 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   GradAccumDemo.h
+ *
+ * Created on December 16, 2024, 4:10 PM
+ */
+
+#ifndef GRADACCUMDEMO_H
+#define GRADACCUMDEMO_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <filesystem> //require C++17
+namespace fs = std::filesystem;
+using namespace std;
+
+#include "ann/annheader.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+
+/*
+ * grad_accum_predictions: a 5-16-3 MLP (initial weights from init_seed of cfg_file) after one
+ *  epoch of one batch (the whole loader), with nsteps micro-batches per optimizer step
+ */
+double_tensor grad_accum_predictions(string cfg_file, DataLoader<double, double>* pLoader,
+        double_tensor& X, int nsteps, bool adam){
+    ILayer* layers[] = {new FCLayer(5, 16, true), new Tanh(), new FCLayer(16, 3, true), new Softmax()};
+    MLPClassifier model(cfg_file, "accum", layers, sizeof(layers)/sizeof(ILayer*));
+    model.set_grad_accumulation(nsteps);
+    SGD sgd(1e-1);
+    Adam adam_optim(1e-2);
+    IOptimizer* pOptim = adam? (IOptimizer*)&adam_optim : (IOptimizer*)&sgd;
+    CrossEntropy loss;
+    ClassMetrics metrics(3);
+    model.compile(pOptim, &loss, &metrics);
+    model.fit(pLoader, pLoader, 1, 0);
+    return model.predict(X, true);
+}
+
+/*
+ * gradAccumCheck: one optimizer step on a batch with grad_accum_steps = K against the same
+ *  step on the full batch (grad_accum_steps = 1), from the same initial weights:
+ *  + K dividing the batch size and not (the last micro-batch is smaller);
+ *  + SGD and Adam (the normalized gradient, not only its direction, must be the same).
+ */
+bool gradAccumCheck(int nsamples=100){
+    string root = (fs::temp_directory_path()/fs::path("accum-check")).string();
+    fs::create_directories(root);
+    string cfg_file = (fs::path(root)/fs::path("config.txt")).string();
+    {
+        ofstream cfg(cfg_file);
+        cfg << "model_root: " << root << "\ninit_seed: 2024\n";
+    }
+    xt::random::seed(2024);
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)5});
+    double_tensor labels = xt::floor(xt::random::rand<double>({(size_t)nsamples})*3);
+    TensorDataset<double, double> ds(X, labels);
+    DataLoader<double, double> loader(&ds, nsamples, false, false);
+
+    bool ok = true;
+    for(bool adam: {false, true}){
+        double_tensor Y_full = grad_accum_predictions(cfg_file, &loader, X, 1, adam);
+        double_tensor Y_again = grad_accum_predictions(cfg_file, &loader, X, 1, adam); //deterministic
+        for(int nsteps: {2, 3, 4, 7}){
+            double_tensor Y = grad_accum_predictions(cfg_file, &loader, X, nsteps, adam);
+            double err = xt::amax(xt::abs(Y - Y_full))();
+            bool step_ok = (err < 1e-12) && (xt::amax(xt::abs(Y_again - Y_full))() == 0);
+            cout << (adam? "Adam" : "SGD") << ", grad_accum_steps " << nsteps << ": max |Y - Y(full batch)| "
+                 << err << (step_ok? "" : "  <- FAILED") << endl;
+            ok &= step_ok;
+        }
+    }
+    fs::remove_all(root);
+    return ok;
+}
+
+#endif /* GRADACCUMDEMO_H */
@@ -0,0 +1,104 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   HogwildDemo.h
+ *
+ * Created on December 2, 2024, 9:30 AM
+ */
+
+#ifndef HOGWILDDEMO_H
+#define HOGWILDDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "config/Config.h"
+#include "dataset/DSFactory.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+
+/*
+ * hogwild_model: FC nin-hidden-hidden-nClasses (ReLU, Softmax), the same initial weights
+ *  on every call
+ */
+MLPClassifier* hogwild_model(int nin, int hidden, int nClasses){
+    xt::random::seed(11);
+    int sizes[] = {nin, hidden, hidden, nClasses};
+    ILayer* layers[6];
+    for(int k=0; k < 3; k++){
+        FCLayer* fc = new FCLayer(sizes[k], sizes[k + 1], true);
+        fc->set_weights(xt::random::randn<double>({(size_t)sizes[k + 1], (size_t)sizes[k]})/std::sqrt((double)sizes[k]));
+        layers[2*k] = fc;
+        layers[2*k + 1] = (k < 2)? (ILayer*)new ReLU() : (ILayer*)new Softmax();
+    }
+    return new MLPClassifier("./config.txt", "hogwild", layers, 6);
+}
+
+/*
+ * hogwild_compare: the same model trained synchronously, then with nworkers Hogwild workers
+ *  (lock-free, and with 64 lock stripes): samples/s of the training and test accuracy.
+ */
+void hogwild_compare(string name, TensorDataset<double, double>* train_ds, TensorDataset<double, double>* test_ds,
+                     int nin, int hidden, int nClasses, int batch, double lr, int nepoch, int nworkers){
+    DataLoader<double, double> train_loader(train_ds, batch, true, false, 7);
+    DataLoader<double, double> test_loader(test_ds, batch, false, false);
+    struct Mode { string label; int workers, stripes; };
+    Mode modes[] = {{"sync", 1, 0}, {"hogwild", nworkers, 0}, {"hogwild+stripes", nworkers, 64}};
+    double results[3][2];
+    for(int m=0; m < 3; m++){
+        MLPClassifier* pModel = hogwild_model(nin, hidden, nClasses);
+        SGD optim(lr);
+        CrossEntropy loss;
+        ClassMetrics metrics(nClasses);
+        pModel->compile(&optim, &loss, &metrics);
+        pModel->set_hogwild(modes[m].workers, modes[m].stripes);
+        auto start = chrono::steady_clock::now();
+        pModel->fit(&train_loader, &test_loader, nepoch, 0);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        results[m][0] = (double)train_ds->len()*nepoch/seconds;
+        results[m][1] = pModel->evaluate(&test_loader)(0);
+        delete pModel;
+    }
+    cout << name << ": " << nepoch << " epoch(s), batch " << batch << ", " << nworkers << " workers" << endl;
+    for(int m=0; m < 3; m++)
+        cout << fixed << setprecision(0) << "  " << setw(16) << left << modes[m].label << right
+             << setw(10) << results[m][0] << " samples/s, test accuracy "
+             << setprecision(3) << results[m][1] << defaultfloat << endl;
+}
+
+/*
+ * hogwildDemo1: synchronous vs Hogwild training on the bundled 2c and 3c datasets
+ */
+void hogwildDemo1(int nworkers=4, int nepoch=50){
+    DSFactory factory("./config.txt");
+    auto p2c = factory.get_datasets_2cc();
+    hogwild_compare("2c-classification", p2c->get("train_ds"), p2c->get("test_ds"), 2, 50, 2, 10, 2e-2, nepoch, nworkers);
+    auto p3c = factory.get_datasets_3cc();
+    hogwild_compare("3c-classification", p3c->get("train_ds"), p3c->get("test_ds"), 2, 50, 3, 10, 2e-2, nepoch, nworkers);
+}
+
+/*
+ * hogwildDemo2: the same on a larger synthetic dataset (labels: argmax of a random linear map)
+ */
+void hogwildDemo2(int nworkers=4, int nsamples=20000, int width=64, int nepoch=3){
+    int nClasses = 4;
+    xt::random::seed(2024);
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)width});
+    double_tensor W = xt::random::randn<double>({(size_t)width, (size_t)nClasses});
+    double_tensor labels = xt::argmax(xt::linalg::dot(X, W), 1);
+    size_t ntrain = nsamples*4/5;
+    double_tensor X_train = xt::view(X, xt::range(0, ntrain)), X_test = xt::view(X, xt::range(ntrain, nsamples));
+    double_tensor t_train = xt::view(labels, xt::range(0, ntrain)), t_test = xt::view(labels, xt::range(ntrain, nsamples));
+    TensorDataset<double, double> train_ds(X_train, t_train);
+    TensorDataset<double, double> test_ds(X_test, t_test);
+    hogwild_compare("synthetic", &train_ds, &test_ds, width, 128, nClasses, 32, 5e-2, nepoch, nworkers);
+}
+
+#endif /* HOGWILDDEMO_H */
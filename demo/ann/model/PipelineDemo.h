@@ -0,0 +1,74 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   PipelineDemo.h
+ *
+ * Created on November 27, 2024, 2:10 PM
+ */
+
+#ifndef PIPELINEDEMO_H
+#define PIPELINEDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "model/PipelineSchedule.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+
+/*
+ * pipelineDemo1: a few wide FC layers trained sequentially and with 2 and 4 pipeline stages
+ *  from the same weights: the stages, the time of the training, and the distance between
+ *  the predictions (the micro-batch sums only change the rounding).
+ */
+void pipelineDemo1(int width=1024, int nsamples=4096, int batch=512, int nepoch=2){
+    xt::random::seed(2024);
+    int nClasses = 10;
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)width});
+    double_tensor labels = xt::floor(xt::random::rand<double>({(size_t)nsamples})*nClasses);
+    TensorDataset<double, double> train_ds(X, labels);
+
+    vector<ILayer*> reference;
+    for(int d=0; d < 4; d++){
+        FCLayer* fc = new FCLayer(width, width, true);
+        fc->set_weights(xt::random::randn<double>({(size_t)width, (size_t)width})/std::sqrt((double)width));
+        reference.push_back(fc);
+        reference.push_back(new ReLU());
+    }
+    reference.push_back(new FCLayer(width, nClasses, true));
+    reference.push_back(new Softmax());
+    cout << PipelineSchedule(reference, 4).get_desc();
+
+    double_tensor Y_base;
+    for(int nstages: {1, 2, 4}){
+        vector<ILayer*> layers;
+        for(auto layer: reference) layers.push_back(layer->clone());
+        MLPClassifier model("./config.txt", "pipeline", layers.data(), layers.size());
+        model.set_grad_accumulation(1);
+        model.set_pipeline(nstages, 4*nstages);
+        SGD optim(1e-2);
+        CrossEntropy loss;
+        ClassMetrics metrics(nClasses);
+        model.compile(&optim, &loss, &metrics);
+        DataLoader<double, double> train_loader(&train_ds, batch, false, false);
+
+        auto start = chrono::steady_clock::now();
+        model.fit(&train_loader, &train_loader, nepoch, 0);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double_tensor Y = model.predict(X, true);
+        if(nstages == 1) Y_base = Y;
+        cout << fixed << setprecision(3)
+             << "stages " << nstages << ": " << seconds << " s, max |Y - Y(sequential)|: "
+             << defaultfloat << xt::amax(xt::abs(Y - Y_base))() << endl;
+    }
+    for(auto layer: reference) delete layer;
+}
+
+#endif /* PIPELINEDEMO_H */
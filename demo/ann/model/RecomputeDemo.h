@@ -0,0 +1,73 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   RecomputeDemo.h
+ *
+ * Created on November 26, 2024, 10:20 AM
+ */
+
+#ifndef RECOMPUTEDEMO_H
+#define RECOMPUTEDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+
+/*
+ * recomputeDemo1: a deep MLP (ndepth blocks of FC + ReLU) trained with and without activation
+ *  checkpointing from the same weights: the same loss/weights, the peak activation memory and
+ *  the time of the training for several segment sizes.
+ */
+void recomputeDemo1(int ndepth=12, int width=256, int nsamples=2048, int batch=512, int nepoch=2){
+    xt::random::seed(2024);
+    int nClasses = 4;
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)width});
+    double_tensor labels = xt::floor(xt::random::rand<double>({(size_t)nsamples})*nClasses);
+    TensorDataset<double, double> train_ds(X, labels);
+
+    vector<ILayer*> reference;
+    for(int d=0; d < ndepth; d++){
+        FCLayer* fc = new FCLayer(width, width, true);
+        fc->set_weights(xt::random::randn<double>({(size_t)width, (size_t)width})/std::sqrt((double)width));
+        reference.push_back(fc);
+        reference.push_back(new ReLU());
+    }
+    reference.push_back(new FCLayer(width, nClasses, true));
+    reference.push_back(new Softmax());
+
+    double_tensor Y_base;
+    for(int k: {0, 2, 4, 8}){
+        vector<ILayer*> layers;
+        for(auto layer: reference) layers.push_back(layer->clone());
+        MLPClassifier model("./config.txt", "recompute", layers.data(), layers.size());
+        model.set_recompute(k);
+        SGD optim(1e-2);
+        CrossEntropy loss;
+        ClassMetrics metrics(nClasses);
+        model.compile(&optim, &loss, &metrics);
+        DataLoader<double, double> train_loader(&train_ds, batch, false, false);
+
+        auto start = chrono::steady_clock::now();
+        model.fit(&train_loader, &train_loader, nepoch, 0);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double_tensor Y = model.predict(X, true);
+        if(k == 0) Y_base = Y;
+        cout << fixed << setprecision(3)
+             << "recompute_segment " << setw(2) << k << ": peak activations "
+             << setw(9) << model.get_peak_activation_bytes()/1024.0 << " KB, "
+             << seconds << " s, max |Y - Y(no recompute)|: " << defaultfloat
+             << xt::amax(xt::abs(Y - Y_base))() << endl;
+    }
+    for(auto layer: reference) delete layer;
+}
+
+#endif /* RECOMPUTEDEMO_H */
@@ -0,0 +1,216 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   StaticMLPDemo.h
+ *
+ * Created on November 23, 2024, 2:15 PM
+ */
+
+#ifndef STATICMLPDEMO_H
+#define STATICMLPDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <filesystem> //require C++17
+namespace fs = std::filesystem;
+using namespace std;
+
+#include "ann/annheader.h"
+#include "config/Config.h"
+#include "dataset/DSFactory.h"
+#include "loader/dataloader.h"
+#include "loader/dataset.h"
+#include "model/StaticMLP.h"
+
+//the architecture of twoclasses.h: FC 2-50-20-2, ReLU, Softmax
+typedef StaticMLP<StaticFC<2, 50>, StaticReLU,
+                  StaticFC<50, 20>, StaticReLU,
+                  StaticFC<20, 2>, StaticSoftmax> TwoClassesMLP;
+
+//the test set of 2c-classification as one [N, 2] matrix and its labels
+void static_mlp_test_set(double_tensor& X, ulong_tensor& labels){
+    DSFactory factory("./config.txt");
+    auto pMap = factory.get_datasets_2cc();
+    DataLoader<double, double> loader(pMap->get("test_ds"), 50, false, false);
+    xvector<double_tensor> xs;
+    xvector<double_tensor> ys;
+    for(auto batch: loader){
+        xs.add(batch.getData());
+        ys.add(batch.getLabel());
+    }
+    X = xs.get(0);
+    double_tensor Y = ys.get(0);
+    for(int idx=1; idx < xs.size(); idx++){
+        X = xt::concatenate(xt::xtuple(X, xs.get(idx)), 0);
+        Y = xt::concatenate(xt::xtuple(Y, ys.get(idx)), 0);
+    }
+    labels = (Y.dimension() == 1)? ulong_tensor(xt::cast<ulong>(Y)) : ulong_tensor(xt::argmax(Y, 1));
+}
+
+/*
+ * staticMLPDemo1: the checkpoint models/2c-classification-1 in MLPClassifier and in
+ *  TwoClassesMLP: the same outputs, and the time of the inference on the test set.
+ */
+void staticMLPDemo1(int repeat=2000){
+    string model_path = "./models/2c-classification-1";
+    MLPClassifier dynamic("./config.txt");
+    dynamic.load(model_path, true);
+    TwoClassesMLP model("2c-classification");
+    if(!model.load(model_path)) return;
+    cout << model.toString();
+
+    std::array<double, 2> x = {0.93980859328292, 0.4571194992357245};
+    std::array<double, 2> y = model.predict(x);
+    cout << "StaticMLP predict    : " << y[0] << ", " << y[1] << endl;
+    cout << "MLPClassifier predict: " << dynamic.predict(double_tensor{x[0], x[1]}, true) << endl;
+
+    double_tensor X;
+    ulong_tensor labels;
+    static_mlp_test_set(X, labels);
+    size_t nsamples = X.shape()[0];
+    ulong_tensor predicted = xt::zeros<ulong>({nsamples});
+    double_tensor Y = xt::zeros<double>({nsamples, (size_t)TwoClassesMLP::OUT});
+    model.predict_class(X.data(), nsamples, predicted.data());
+    model.predict(X.data(), nsamples, Y.data());
+    double_tensor Yd = dynamic.predict(X, true);
+    cout << "accuracy: " << xt::mean(xt::cast<double>(xt::equal(predicted, labels)))() << ", "
+         << "max |StaticMLP - MLPClassifier|: " << xt::amax(xt::abs(Y - Yd))() << endl;
+
+    auto start = chrono::steady_clock::now();
+    for(int r=0; r < repeat; r++) dynamic.predict(X, true);
+    double t_dynamic = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    for(int r=0; r < repeat; r++) model.predict(X.data(), nsamples, Y.data());
+    double t_static = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << fixed << setprecision(2)
+         << nsamples << " samples x " << repeat << ": MLPClassifier " << t_dynamic*1e9/(repeat*nsamples)
+         << " ns/sample, StaticMLP " << t_static*1e9/(repeat*nsamples) << " ns/sample" << endl;
+
+    start = chrono::steady_clock::now();
+    double checksum = 0;
+    for(int r=0; r < repeat; r++)
+        for(size_t idx=0; idx < nsamples; idx++)
+            checksum += model.predict({X(idx, 0), X(idx, 1)})[0];
+    double t_single = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "StaticMLP single-sample predict: " << t_single*1e9/(repeat*nsamples)
+         << " ns/sample (checksum " << checksum << ")" << endl;
+
+    int nsingle = repeat/20 + 1;
+    start = chrono::steady_clock::now();
+    checksum = 0;
+    for(int r=0; r < nsingle; r++)
+        for(size_t idx=0; idx < nsamples; idx++)
+            checksum += dynamic.predict(double_tensor{X(idx, 0), X(idx, 1)}, true)(0);
+    t_single = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "MLPClassifier single-sample predict: " << t_single*1e9/(nsingle*nsamples)
+         << " ns/sample (checksum " << checksum << ")" << endl;
+    cout << defaultfloat;
+}
+
+/*
+ * staticMLPDemo2: trains TwoClassesMLP from a random init on the training set
+ *  (mini-batches of 50, the tail batch is dropped), then saves it in the MLPClassifier format.
+ */
+void staticMLPDemo2(int nepochs=10, double lr=1e-2){
+    DSFactory factory("./config.txt");
+    auto pMap = factory.get_datasets_2cc();
+    DataLoader<double, double> train_loader(pMap->get("train_ds"), 50, true, true);
+
+    TwoClassesMLP model("2c-classification");
+    TwoClassesMLP::Workspace<50> ws;
+    ulong_tensor labels = xt::zeros<ulong>({50});
+    auto start = chrono::steady_clock::now();
+    for(int epoch=1; epoch <= nepochs; epoch++){
+        double loss = 0;
+        int nbatches = 0;
+        for(auto batch: train_loader){
+            double_tensor& X = batch.getData();
+            double_tensor& Y = batch.getLabel();
+            if(Y.dimension() == 1) labels = xt::cast<ulong>(Y);
+            else labels = xt::argmax(Y, 1);
+            loss += model.train_step(ws, X.data(), labels.data(), lr);
+            nbatches++;
+        }
+        cout << "epoch " << epoch << ": loss " << loss/nbatches << endl;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "training time: " << seconds << " s" << endl;
+
+    double_tensor X;
+    ulong_tensor test_labels;
+    static_mlp_test_set(X, test_labels);
+    ulong_tensor predicted = xt::zeros<ulong>({X.shape()[0]});
+    model.predict_class(X.data(), X.shape()[0], predicted.data());
+    cout << "test accuracy: " << xt::mean(xt::cast<double>(xt::equal(predicted, test_labels)))() << endl;
+
+    string model_path = "./models/2c-classification-static";
+    if(model.save(model_path)){
+        MLPClassifier reloaded("./config.txt");
+        reloaded.load(model_path, true);
+        double_tensor Yd = reloaded.predict(X, true);
+        cout << "reloaded by MLPClassifier, accuracy: "
+             << xt::mean(xt::cast<double>(xt::equal(xt::argmax(Yd, 1), test_labels)))() << endl;
+    }
+}
+
+/*
+ * staticMLPCheck: a random MLPClassifier saved and loaded into TwoClassesMLP: the same
+ *  outputs; then a few SGD steps of TwoClassesMLP on a separable problem lower the loss.
+ */
+bool staticMLPCheck(int nsamples=64, int nsteps=200){
+    xt::random::seed(2024);
+    ILayer* layers[] = {
+        new FCLayer(2, 50, true), new ReLU(),
+        new FCLayer(50, 20, true), new ReLU(),
+        new FCLayer(20, 2, true), new Softmax()
+    };
+    MLPClassifier dynamic("./config.txt", "static-check", layers, sizeof(layers)/sizeof(ILayer*));
+    string model_path = (fs::temp_directory_path()/fs::path("static-mlp-check")).string();
+    fs::remove_all(model_path);
+    fs::create_directories(model_path); //else save picks a new checkpoint folder
+    bool saved = dynamic.save(model_path);
+    TwoClassesMLP model("static-check");
+    bool loaded = saved && model.load(model_path);
+    fs::remove_all(model_path);
+
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)2});
+    double_tensor Y = xt::zeros<double>({(size_t)nsamples, (size_t)TwoClassesMLP::OUT});
+    model.predict(X.data(), nsamples, Y.data());
+    double diff = xt::amax(xt::abs(Y - dynamic.predict(X, true)))();
+    bool same = loaded && (diff < 1e-9);
+    cout << "StaticMLP against MLPClassifier (same weights): max |diff| " << diff << endl;
+
+    //class = (x0 > 0)
+    const int B = 16;
+    TwoClassesMLP::Workspace<B> ws;
+    ulong labels[B];
+    double first_loss = 0, last_loss = 0;
+    for(int s=0; s < nsteps; s++){
+        int begin = (s*B)%(nsamples - B + 1);
+        for(int r=0; r < B; r++) labels[r] = (X(begin + r, 0) > 0)? 1 : 0;
+        double loss = model.train_step(ws, X.data() + begin*2, labels, 1e-1);
+        if(s == 0) first_loss = loss;
+        last_loss = loss;
+    }
+    bool learns = last_loss < first_loss;
+    cout << "StaticMLP train_step: loss " << first_loss << " -> " << last_loss << endl;
+
+    //a label out of [0, OUT) is rejected
+    labels[B - 1] = TwoClassesMLP::OUT;
+    bool rejected = false;
+    try{
+        model.train_step(ws, X.data(), labels, 1e-1);
+    }
+    catch(std::out_of_range& e){
+        cout << "rejected: " << e.what() << endl;
+        rejected = true;
+    }
+    return same && learns && rejected;
+}
+
+#endif /* STATICMLPDEMO_H */
@@ -0,0 +1,57 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   TopKDemo.h
+ *
+ * Created on December 14, 2024, 10:40 AM
+ */
+
+#ifndef TOPKDEMO_H
+#define TOPKDEMO_H
+
+#include <iostream>
+#include <string>
+using namespace std;
+
+#include "ann/annheader.h"
+
+/*
+ * topkDemo1: predict_topk of a small MLP for k = 0, k = nclasses and k > nclasses
+ *  + k = 0: empty [N, 0] results;
+ *  + k >= nclasses: all the classes, by decreasing probability; the scores are the
+ *      probabilities of predict (sorted), the first index is the argmax.
+ */
+void topkDemo1(int nsamples=8, int nClasses=5){
+    xt::random::seed(2024);
+    ILayer* layers[] = {
+        new FCLayer(4, 16, true),
+        new ReLU(),
+        new FCLayer(16, nClasses, true),
+        new Softmax()
+    };
+    MLPClassifier model("./config.txt", "topk", layers, sizeof(layers)/sizeof(ILayer*));
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)4});
+    double_tensor P = model.predict(X, true); //the probabilities
+
+    for(int k: {0, nClasses, nClasses + 3}){
+        ulong_tensor indices;
+        double_tensor scores;
+        model.predict_topk(X, k, indices, scores);
+        double max_diff = 0;
+        bool argmax_first = true;
+        for(size_t r=0; (r < indices.shape()[0]) && (indices.shape()[1] > 0); r++){
+            for(size_t c=0; c < indices.shape()[1]; c++)
+                max_diff = max(max_diff, std::abs(scores(r, c) - P(r, indices(r, c))));
+            argmax_first &= (indices(r, 0) == (unsigned long)xt::argmax(xt::view(P, r))());
+        }
+        cout << "k=" << k << ": indices " << xt::adapt(indices.shape())
+             << ", max |score - P[index]|: " << max_diff;
+        if(indices.shape()[1] > 0) cout << ", argmax first: " << (argmax_first? "yes" : "no");
+        cout << endl;
+    }
+}
+
+#endif /* TOPKDEMO_H */
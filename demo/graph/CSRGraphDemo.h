@@ -0,0 +1,178 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   CSRGraphDemo.h
+ *
+ * Created on November 20, 2024, 2:10 PM
+ */
+
+#ifndef CSRGRAPHDEMO_H
+#define CSRGRAPHDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <queue>
+#include <random>
+#include <vector>
+#include "graph/CSRGraph.h"
+#include "graph/ListGraph.h"
+using namespace std;
+
+int csrIntHash(int& key, int capacity){ return (unsigned)key % capacity; }
+int csrCharHash(char& key, int capacity){ return key % capacity; }
+string csrChar2str(char& v){ return string(1, v); }
+
+/*
+ * baseline_bfs: BFS through the IGraph interface (one DLinkedList per visited vertex).
+ *  Vertices are 0..n-1.
+ */
+void baseline_bfs(IGraph<int>* pGraph, int source, vector<int>& level){
+    level.assign(pGraph->size(), -1);
+    queue<int> open;
+    level[source] = 0;
+    open.push(source);
+    while(!open.empty()){
+        int u = open.front();
+        open.pop();
+        DLinkedList<int> neighbors = pGraph->getOutwardEdges(u);
+        for(auto v: neighbors)
+            if(level[v] == -1){
+                level[v] = level[u] + 1;
+                open.push(v);
+            }
+    }
+}
+
+void csrGraphDemo1(){
+    ListGraph<char> graph(&csrCharHash, &csrChar2str);
+    for(char v: string("ABCDEFG")) graph.add(v);
+    graph.connect('A', 'B');
+    graph.connect('A', 'C');
+    graph.connect('B', 'D');
+    graph.connect('C', 'D');
+    graph.connect('D', 'E');
+    graph.connect('F', 'G');
+
+    CSRGraph<char>* pCSR = CSRGraph<char>::freeze(&graph, &csrCharHash);
+    cout << pCSR->size() << " vertices, " << pCSR->edges() << " edges" << endl;
+
+    vector<int> level = pCSR->bfs(pCSR->index_of('A'));
+    vector<int> component = pCSR->connected_components();
+    cout << "vertex  bfs(A)  component" << endl;
+    for(int v=0; v < pCSR->size(); v++)
+        cout << setw(6) << pCSR->vertex(v) << setw(8) << level[v]
+             << setw(11) << pCSR->vertex(component[v]) << endl;
+
+    cout << "topological order:";
+    for(int v: pCSR->topological_sort()) cout << " " << pCSR->vertex(v);
+    cout << endl;
+    delete pCSR;
+
+    graph.connect('E', 'A');
+    pCSR = CSRGraph<char>::freeze(&graph, &csrCharHash);
+    try{
+        pCSR->topological_sort();
+    }
+    catch(std::runtime_error& e){
+        cout << "after E->A: " << e.what() << endl;
+    }
+    delete pCSR;
+}
+
+/*
+ * csrGraphDemo2: a random graph (nvertices, about degree out-edges per vertex);
+ *  baseline_bfs against CSRGraph::bfs (freeze is timed on its own: it is paid once per graph).
+ */
+void csrGraphDemo2(int nvertices=200000, int degree=8, int nqueries=3){
+    mt19937 rng(2024);
+    uniform_int_distribution<int> pick(0, nvertices - 1);
+    ListGraph<int> graph(&csrIntHash);
+    for(int v=0; v < nvertices; v++) graph.add(v);
+    for(int v=0; v < nvertices; v++)
+        for(int e=0; e < degree; e++) graph.connect(v, pick(rng));
+    cout << nvertices << " vertices, " << (long)nvertices*degree << " edges" << endl;
+
+    auto start = chrono::steady_clock::now();
+    CSRGraph<int>* pCSR = CSRGraph<int>::freeze(&graph, &csrIntHash);
+    double freeze_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double base_time = 0, csr_time = 0;
+    bool same = true;
+    for(int q=0; q < nqueries; q++){
+        int source = pick(rng);
+        vector<int> expected;
+        start = chrono::steady_clock::now();
+        baseline_bfs(&graph, source, expected);
+        base_time += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        start = chrono::steady_clock::now();
+        vector<int> level = pCSR->bfs(pCSR->index_of(source));
+        csr_time += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        for(int v=0; v < nvertices; v++) same = same && (expected[v] == level[pCSR->index_of(v)]);
+    }
+
+    start = chrono::steady_clock::now();
+    vector<int> component = pCSR->connected_components();
+    double cc_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    int ncomponents = 0;
+    for(int v=0; v < nvertices; v++) ncomponents += (component[v] == v);
+
+    cout << fixed << setprecision(4);
+    cout << "BFS, baseline (IGraph)  : " << base_time/nqueries << " s/query" << endl;
+    cout << "BFS, CSRGraph           : " << csr_time/nqueries << " s/query"
+         << ", speed-up: " << setprecision(1) << base_time/csr_time << "x" << endl;
+    cout << setprecision(4) << "CSRGraph freeze (once)  : " << freeze_time << " s" << endl;
+    cout << "connected components    : " << ncomponents << " in " << cc_time << " s" << endl;
+    cout << "same levels: " << (same? "yes" : "NO") << endl;
+    delete pCSR;
+}
+
+/*
+ * csrGraphCheck: CSRGraph::bfs against baseline_bfs on a random graph, and
+ *  topological_sort on a random DAG: every edge must go forward in the order.
+ */
+bool csrGraphCheck(int nvertices=5000, int degree=4, int nqueries=5){
+    mt19937 rng(2024);
+    uniform_int_distribution<int> pick(0, nvertices - 1);
+    ListGraph<int> graph(&csrIntHash);
+    for(int v=0; v < nvertices; v++) graph.add(v);
+    for(int v=0; v < nvertices; v++)
+        for(int e=0; e < degree; e++) graph.connect(v, pick(rng));
+    CSRGraph<int>* pCSR = CSRGraph<int>::freeze(&graph, &csrIntHash);
+    bool same = true;
+    for(int q=0; q < nqueries; q++){
+        int source = pick(rng);
+        vector<int> expected;
+        baseline_bfs(&graph, source, expected);
+        vector<int> level = pCSR->bfs(pCSR->index_of(source));
+        for(int v=0; v < nvertices; v++) same = same && (expected[v] == level[pCSR->index_of(v)]);
+    }
+    delete pCSR;
+    cout << "CSRGraph::bfs against baseline_bfs: " << (same? "same levels" : "DIFFERENT") << endl;
+
+    ListGraph<int> dag(&csrIntHash);
+    for(int v=0; v < nvertices; v++) dag.add(v);
+    vector<pair<int, int>> edges;
+    for(int e=0; e < degree*nvertices; e++){
+        int u = pick(rng), v = pick(rng);
+        if(u == v) continue;
+        if(u > v) swap(u, v);
+        dag.connect(u, v);
+        edges.push_back({u, v});
+    }
+    pCSR = CSRGraph<int>::freeze(&dag, &csrIntHash);
+    vector<int> order = pCSR->topological_sort();
+    vector<int> rank(nvertices, -1);
+    for(size_t idx=0; idx < order.size(); idx++) rank[pCSR->vertex(order[idx])] = idx;
+    bool sorted = (order.size() == (size_t)nvertices);
+    for(auto& edge: edges) sorted = sorted && (rank[edge.first] < rank[edge.second]);
+    delete pCSR;
+    cout << "CSRGraph::topological_sort on a DAG: " << (sorted? "valid" : "INVALID") << endl;
+    return same && sorted;
+}
+
+#endif /* CSRGRAPHDEMO_H */
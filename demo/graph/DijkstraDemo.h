@@ -0,0 +1,193 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   DijkstraDemo.h
+ *
+ * Created on November 18, 2024, 4:20 PM
+ */
+
+#ifndef DIJKSTRADEMO_H
+#define DIJKSTRADEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include "heap/IndexedHeap.h"
+#include "graph/DijkstraFinder.h"
+#include "graph/ListGraph.h"
+#include "heap/Heap.h"
+using namespace std;
+
+int dijkstraIntHash(int& key, int capacity){ return (unsigned)key % capacity; }
+int dijkstraCharHash(char& key, int capacity){ return key % capacity; }
+string dijkstraChar2str(char& v){ return string(1, v); }
+
+/*
+ * baseline_dijkstra: Dijkstra through the IGraph interface and Heap<T> (binary heap);
+ *  Heap<T> has no decrease-key, so stale entries are pushed and skipped when popped.
+ *  Vertices are 0..n-1.
+ */
+struct DistVertex{
+    float dist;
+    int vertex;
+};
+int distVertexComparator(DistVertex& lhs, DistVertex& rhs){
+    if(lhs.dist < rhs.dist) return -1;
+    if(lhs.dist > rhs.dist) return 1;
+    return 0;
+}
+//Heap<T> also needs the relational operators and operator<< (for toString)
+bool operator<(const DistVertex& lhs, const DistVertex& rhs){ return lhs.dist < rhs.dist; }
+bool operator>(const DistVertex& lhs, const DistVertex& rhs){ return lhs.dist > rhs.dist; }
+ostream& operator<<(ostream& os, const DistVertex& item){
+    return os << "(" << item.vertex << ", " << item.dist << ")";
+}
+void baseline_dijkstra(IGraph<int>* pGraph, int start, vector<float>& dist){
+    int nvertices = pGraph->size();
+    dist.assign(nvertices, numeric_limits<float>::infinity());
+    vector<bool> done(nvertices, false);
+    Heap<DistVertex> heap(&distVertexComparator);
+    dist[start] = 0;
+    heap.push(DistVertex{0, start});
+    while(!heap.empty()){
+        DistVertex top = heap.pop();
+        if(done[top.vertex]) continue;
+        done[top.vertex] = true;
+        DLinkedList<int> neighbors = pGraph->getOutwardEdges(top.vertex);
+        for(auto to: neighbors){
+            float candidate = top.dist + pGraph->weight(top.vertex, to);
+            if(candidate < dist[to]){
+                dist[to] = candidate;
+                heap.push(DistVertex{candidate, to});
+            }
+        }
+    }
+}
+
+void dijkstraDemo1(){
+    ListGraph<char> graph(&dijkstraCharHash, &dijkstraChar2str);
+    for(char v: string("ABCDEF")) graph.add(v);
+    graph.connect('A', 'B', 4);
+    graph.connect('A', 'C', 2);
+    graph.connect('C', 'B', 1);
+    graph.connect('B', 'D', 5);
+    graph.connect('C', 'D', 8);
+    graph.connect('D', 'E', 3);
+    cout << graph.toString();
+
+    DijkstraFinder<char> finder(&dijkstraCharHash);
+    DLinkedList<Path<char>> paths = finder.dijkstra(&graph, 'A');
+    for(auto path: paths) cout << path.toString(&dijkstraChar2str) << endl;
+    cout << "F reachable: " << finder.reachable('F') << endl;
+}
+
+/*
+ * dijkstraDemo2: a random graph (nvertices, about degree out-edges per vertex);
+ *  baseline_dijkstra against DijkstraFinder (the compile step is timed on its own:
+ *  it is paid once per graph, the searches reuse the arrays).
+ */
+void dijkstraDemo2(int nvertices=100000, int degree=10, int nqueries=3){
+    mt19937 rng(2024);
+    uniform_int_distribution<int> pick(0, nvertices - 1);
+    uniform_real_distribution<float> weight(1.0f, 100.0f);
+    ListGraph<int> graph(&dijkstraIntHash);
+    for(int v=0; v < nvertices; v++) graph.add(v);
+    for(int v=0; v < nvertices; v++)
+        for(int e=0; e < degree; e++) graph.connect(v, pick(rng), weight(rng));
+    cout << nvertices << " vertices, " << (long)nvertices*degree << " edges" << endl;
+
+    DijkstraFinder<int> finder(&dijkstraIntHash);
+    auto start = chrono::steady_clock::now();
+    finder.compile(&graph);
+    double compile_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double base_time = 0, finder_time = 0;
+    bool same = true;
+    for(int q=0; q < nqueries; q++){
+        int source = pick(rng);
+        vector<float> dist;
+        start = chrono::steady_clock::now();
+        baseline_dijkstra(&graph, source, dist);
+        base_time += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        start = chrono::steady_clock::now();
+        finder.search(source);
+        finder_time += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        for(int v=0; v < nvertices; v++) same = same && (dist[v] == finder.cost(v));
+    }
+    cout << fixed << setprecision(4);
+    cout << "baseline (DLinkedList + Heap) : " << base_time/nqueries << " s/query" << endl;
+    cout << "DijkstraFinder (CSR + 4-ary)  : " << finder_time/nqueries << " s/query"
+         << ", speed-up: " << setprecision(1) << base_time/finder_time << "x" << endl;
+    cout << setprecision(4) << "DijkstraFinder compile (once) : " << compile_time << " s" << endl;
+    cout << "same distances: " << (same? "yes" : "NO") << endl;
+}
+
+/*
+ * dijkstraCheck: IndexedHeap against std::multiset on random push/decrease/remove/pop
+ *  sequences, then DijkstraFinder against baseline_dijkstra on random graphs.
+ */
+bool dijkstraCheck(int nops=200000, int nvertices=3000, int degree=6, int nqueries=5){
+    mt19937 rng(2024);
+    const int NIDS = 500;
+    IndexedHeap<int> heap(NIDS);
+    multiset<pair<int, int>> reference; //(key, id)
+    vector<int> key(NIDS, -1); //-1: not in the heap
+    bool heap_ok = true;
+    for(int op=0; (op < nops) && heap_ok; op++){
+        int id = rng()%NIDS;
+        int action = rng()%4;
+        if(action == 0 && !reference.empty()){
+            int top_key = heap.top_key();
+            int popped = heap.pop();
+            heap_ok = (top_key == reference.begin()->first) && (key[popped] == top_key);
+            reference.erase(reference.find({key[popped], popped}));
+            key[popped] = -1;
+        }
+        else if(action == 1 && key[id] >= 0){
+            heap.remove(id);
+            reference.erase(reference.find({key[id], id}));
+            key[id] = -1;
+        }
+        else{
+            int candidate = rng()%100000;
+            bool changed = heap.push_or_decrease(id, candidate);
+            bool expected = (key[id] < 0) || (candidate < key[id]);
+            heap_ok = heap_ok && (changed == expected);
+            if(expected){
+                if(key[id] >= 0) reference.erase(reference.find({key[id], id}));
+                key[id] = candidate;
+                reference.insert({candidate, id});
+            }
+        }
+        heap_ok = heap_ok && (heap.size() == (int)reference.size());
+    }
+    cout << "IndexedHeap against std::multiset: " << (heap_ok? "same" : "DIFFERENT") << endl;
+
+    uniform_int_distribution<int> pick(0, nvertices - 1);
+    uniform_real_distribution<float> weight(1.0f, 100.0f);
+    ListGraph<int> graph(&dijkstraIntHash);
+    for(int v=0; v < nvertices; v++) graph.add(v);
+    for(int v=0; v < nvertices; v++)
+        for(int e=0; e < degree; e++) graph.connect(v, pick(rng), weight(rng));
+    DijkstraFinder<int> finder(&dijkstraIntHash);
+    finder.compile(&graph);
+    bool same = true;
+    for(int q=0; q < nqueries; q++){
+        int source = pick(rng);
+        vector<float> dist;
+        baseline_dijkstra(&graph, source, dist);
+        finder.search(source);
+        for(int v=0; v < nvertices; v++) same = same && (dist[v] == finder.cost(v));
+    }
+    cout << "DijkstraFinder against baseline_dijkstra: " << (same? "same distances" : "DIFFERENT") << endl;
+    return heap_ok && same;
+}
+
+#endif /* DIJKSTRADEMO_H */
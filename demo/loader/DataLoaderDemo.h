@@ -52,7 +52,7 @@ void case_data_wo_label_1(){
     delete pLoader;
     
     cout << "Loading (2): with shuffle=true + no seed (seed < 0):" << endl;
-    cout << "when seed < 0: DO NOT call xt::random:seed" << endl;
+    cout << "when seed < 0: the order is keyed by a number the loader draws from the xtensor random engine" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = -1;
@@ -70,7 +70,7 @@ void case_data_wo_label_1(){
     delete pLoader;
     
     cout << "Loading (3): with shuffle=true + no seed (seed < 0):" << endl;
-    cout << "when seed < 0: DO NOT call xt::random:seed" << endl;
+    cout << "when seed < 0: the order is keyed by a number the loader draws from the xtensor random engine" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = -1;
@@ -86,11 +86,11 @@ void case_data_wo_label_1(){
     }
     cout << endl << endl;
     delete pLoader;
-    cout << "NOTE: Loading (2) and (3): DO NOT CALL seed; so results are different." << endl;
+    cout << "NOTE: Loading (2) and (3): no seed, two loaders; so results are different." << endl;
     cout << endl << endl;
     
     cout << "Loading (4): with shuffle=true + with seed (seed >= 0):" << endl;
-    cout << "when seed >= 0: CALL xt::random:seed" << endl;
+    cout << "when seed >= 0: the order is keyed by the seed (see CounterRNG)" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = 100;
@@ -107,7 +107,7 @@ void case_data_wo_label_1(){
     delete pLoader;
     
     cout << "Loading (5): with shuffle=true + with seed (seed >= 0):" << endl;
-    cout << "when seed >= 0: CALL xt::random:seed" << endl;
+    cout << "when seed >= 0: the order is keyed by the seed (see CounterRNG)" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = 100;
@@ -122,7 +122,7 @@ void case_data_wo_label_1(){
         cout << "label:" << endl << batch.getLabel() << endl;
     }
     delete pLoader;
-    cout << "NOTE: Loading (4) and (5): CALL xt::random::seed and use SAME seed => same results." << endl;
+    cout << "NOTE: Loading (4) and (5): use SAME seed => same results." << endl;
     cout << endl << endl;
 }
 
@@ -166,7 +166,7 @@ void case_data_wi_label_1(){
     delete pLoader;
     
     cout << "Loading (2): with shuffle=true + no seed (seed < 0):" << endl;
-    cout << "when seed < 0: DO NOT call xt::random:seed" << endl;
+    cout << "when seed < 0: the order is keyed by the global seed and the loader's creation index" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = -1;
@@ -184,7 +184,7 @@ void case_data_wi_label_1(){
     delete pLoader;
     
     cout << "Loading (3): with shuffle=true + no seed (seed < 0):" << endl;
-    cout << "when seed < 0: DO NOT call xt::random:seed" << endl;
+    cout << "when seed < 0: the order is keyed by the global seed and the loader's creation index" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = -1;
@@ -200,11 +200,11 @@ void case_data_wi_label_1(){
     }
     cout << endl << endl;
     delete pLoader;
-    cout << "NOTE: Loading (2) and (3): DO NOT CALL seed; so results are different." << endl;
+    cout << "NOTE: Loading (2) and (3): no seed, two loaders; so results are different." << endl;
     cout << endl << endl;
     
     cout << "Loading (4): with shuffle=true + with seed (seed >= 0):" << endl;
-    cout << "when seed >= 0: CALL xt::random:seed" << endl;
+    cout << "when seed >= 0: the order is keyed by the seed (see CounterRNG)" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = 100;
@@ -222,7 +222,7 @@ void case_data_wi_label_1(){
     cout << endl << endl;
     
     cout << "Loading (5): with shuffle=true + with seed (seed >= 0):" << endl;
-    cout << "when seed >= 0: CALL xt::random:seed" << endl;
+    cout << "when seed >= 0: the order is keyed by the seed (see CounterRNG)" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = 100;
@@ -237,7 +237,7 @@ void case_data_wi_label_1(){
         cout << "label:" << endl << batch.getLabel() << endl;
     }
     delete pLoader;
-    cout << "NOTE: Loading (4) and (5): CALL xt::random::seed and use SAME seed => same results." << endl;
+    cout << "NOTE: Loading (4) and (5): use SAME seed => same results." << endl;
     cout << endl << endl;
 }
 
@@ -285,6 +285,25 @@ void case_batch_larger_nsamples(){
     
 }
 
+/*
+ * case_shuffle_per_epoch: set_epoch gives each epoch its own order; the order of an epoch
+ *  depends on (seed, epoch) only: a second loader gets the same orders, in any call order.
+ */
+void case_shuffle_per_epoch(){
+    xt::xarray<int> X = xt::arange<int>(10);
+    xt::xarray<int> t = xt::arange<int>(10);
+    TensorDataset<int, int> ds(X, t);
+    DataLoader<int, int> loader1(&ds, 10, true, false, 100);
+    DataLoader<int, int> loader2(&ds, 10, true, false, 100);
+    for(int epoch: {0, 1, 2}){
+        loader1.set_epoch(epoch);
+        for(auto batch: loader1) cout << "loader1, epoch " << epoch << ": " << batch.getData() << endl;
+    }
+    for(int epoch: {2, 0}){
+        loader2.set_epoch(epoch);
+        for(auto batch: loader2) cout << "loader2, epoch " << epoch << ": " << batch.getData() << endl;
+    }
+}
 
 #endif /* DATALOADERDEMO_H */
 
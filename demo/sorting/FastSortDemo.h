@@ -0,0 +1,138 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   FastSortDemo.h
+ *
+ * Created on November 21, 2024, 4:30 PM
+ */
+
+#ifndef FASTSORTDEMO_H
+#define FASTSORTDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#ifdef FASTSORT_PSTL
+#include <execution>
+#endif
+#include "list/XArrayList.h"
+#include "sorting/PDQSort.h"
+#include "sorting/RadixSort.h"
+#include "sorting/ParallelMergeSort.h"
+using namespace std;
+
+void fastSortDemo1(){
+    XArrayList<int> list;
+    int values[] = {45, 97, 12, 2, 39, 3, 37, 87, -5, 12};
+    for(int v: values) list.add(v);
+    cout << left << setw(24) << "Before:" << list.toString() << endl;
+
+    PDQSort<int> pdq;
+    list.sort(pdq, &SortSimpleOrder<int>::compare4Desending);
+    cout << left << setw(24) << "PDQSort, Descending:" << list.toString() << endl;
+
+    RadixSort<int> radix;
+    list.sort(radix);
+    cout << left << setw(24) << "RadixSort, Ascending:" << list.toString() << endl;
+
+    XArrayList<double> reals;
+    double rvalues[] = {3.5, -0.25, 1e10, -7.0, 0.0, 2.0};
+    for(double v: rvalues) reals.add(v);
+    ParallelMergeSort<double> merge;
+    reals.sort(merge);
+    cout << left << setw(24) << "ParallelMergeSort:" << reals.toString() << endl;
+}
+
+/*
+ * fastSortDemo2: sorts n random 32-bit ints (and n doubles) with each backend;
+ *  the time of std::sort is the baseline; std::sort(std::execution::par) is added with
+ *  -DFASTSORT_PSTL (libstdc++ runs it on TBB: link with -ltbb).
+ */
+template<class T, class Fn>
+void bench_sort(string name, const vector<T>& input, Fn sort_fn){
+    vector<T> data(input);
+    auto start = chrono::steady_clock::now();
+    sort_fn(data.data(), data.size());
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    bool ok = std::is_sorted(data.begin(), data.end());
+    cout << left << setw(32) << name << ": " << fixed << setprecision(3) << seconds << " s"
+         << (ok? "" : "  (NOT SORTED)") << endl;
+}
+
+template<class T>
+void bench_sorts(const vector<T>& input){
+    bench_sort("std::sort", input, [](T* p, size_t n){ std::sort(p, p + n); });
+#ifdef FASTSORT_PSTL
+    bench_sort("std::sort(par)", input, [](T* p, size_t n){ std::sort(std::execution::par, p, p + n); });
+#endif
+    bench_sort("PDQSort (functor)", input, [](T* p, size_t n){ PDQSort<T>::sort(p, p + n, std::less<T>()); });
+    bench_sort("PDQSort (ISort, comparator)", input, [](T* p, size_t n){
+        PDQSort<T>().sort(p, n, &SortSimpleOrder<T>::compare4Ascending);
+    });
+    bench_sort("RadixSort", input, [](T* p, size_t n){ RadixSort<T>::sort(p, p + n); });
+    bench_sort("ParallelMergeSort", input, [](T* p, size_t n){ ParallelMergeSort<T>::sort(p, p + n, std::less<T>()); });
+}
+
+void fastSortDemo2(size_t n=10000000){
+    mt19937_64 rng(2024);
+    vector<int> ints(n);
+    for(auto& v: ints) v = (int)rng();
+    cout << n << " random int keys, " << ThreadPool::instance().size() << " thread(s)" << endl;
+    bench_sorts(ints);
+
+    uniform_real_distribution<double> real(-1e6, 1e6);
+    vector<double> reals(n);
+    for(auto& v: reals) v = real(rng);
+    cout << n << " random double keys" << endl;
+    bench_sorts(reals);
+}
+
+/*
+ * fastSortCheck: each backend against std::sort on random inputs of several sizes
+ *  (around the thresholds of the insertion sort and of the parallel merge), with many
+ *  duplicates, already sorted and reversed inputs, negative ints and doubles.
+ */
+template<class T, class Fn>
+bool same_as_std_sort(const vector<T>& input, Fn sort_fn){
+    vector<T> expected(input), data(input);
+    std::sort(expected.begin(), expected.end());
+    sort_fn(data.data(), data.size());
+    return data == expected;
+}
+template<class T>
+bool check_sorts(const vector<T>& input){
+    bool ok = same_as_std_sort(input, [](T* p, size_t n){ PDQSort<T>::sort(p, p + n, std::less<T>()); });
+    ok = ok && same_as_std_sort(input, [](T* p, size_t n){
+        PDQSort<T>().sort(p, n, &SortSimpleOrder<T>::compare4Ascending);
+    });
+    ok = ok && same_as_std_sort(input, [](T* p, size_t n){ RadixSort<T>::sort(p, p + n); });
+    ok = ok && same_as_std_sort(input, [](T* p, size_t n){ ParallelMergeSort<T>::sort(p, p + n, std::less<T>()); });
+    return ok;
+}
+bool fastSortCheck(){
+    mt19937_64 rng(2024);
+    bool ok = true;
+    for(size_t n: {0, 1, 2, 15, 24, 25, 100, 1000, 70000, 300000}){
+        vector<int> ints(n), dups(n);
+        for(auto& v: ints) v = (int)rng();
+        for(auto& v: dups) v = (int)(rng()%7) - 3;
+        vector<double> reals(n);
+        uniform_real_distribution<double> real(-1e6, 1e6);
+        for(auto& v: reals) v = real(rng);
+        ok = ok && check_sorts(ints) && check_sorts(dups) && check_sorts(reals);
+        std::sort(ints.begin(), ints.end());
+        ok = ok && check_sorts(ints);
+        std::reverse(ints.begin(), ints.end());
+        ok = ok && check_sorts(ints);
+    }
+    cout << "PDQSort, RadixSort, ParallelMergeSort against std::sort: " << (ok? "same" : "DIFFERENT") << endl;
+    return ok;
+}
+
+#endif /* FASTSORTDEMO_H */
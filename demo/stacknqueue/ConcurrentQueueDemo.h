@@ -0,0 +1,217 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   ConcurrentQueueDemo.h
+ *
+ * Created on November 16, 2024, 5:02 PM
+ */
+
+#ifndef CONCURRENTQUEUEDEMO_H
+#define CONCURRENTQUEUEDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "stacknqueue/SPSCQueue.h"
+#include "stacknqueue/MPMCQueue.h"
+using namespace std;
+
+/*
+ * MutexQueue: the baseline of the benchmarks, a bounded deque behind one mutex.
+ */
+template<class T>
+class MutexQueue{
+public:
+    MutexQueue(size_t capacity): capacity(capacity){}
+    bool try_push(const T& item){
+        lock_guard<mutex> lock(mtx);
+        if(items.size() == capacity) return false;
+        items.push_back(item);
+        return true;
+    }
+    bool try_pop(T& item){
+        lock_guard<mutex> lock(mtx);
+        if(items.empty()) return false;
+        item = items.front();
+        items.pop_front();
+        return true;
+    }
+private:
+    size_t capacity;
+    mutex mtx;
+    deque<T> items;
+};
+
+/*
+ * bench_queue: nproducers threads push nitems/nproducers values each, nconsumers threads pop
+ *  them all; prints the operations (push + pop) per second and checks the sum of the values.
+ */
+template<class Q>
+void bench_queue(string name, Q& queue, int nproducers, int nconsumers, long nitems){
+    long per_producer = nitems/nproducers;
+    long total = per_producer*nproducers;
+    atomic<long> popped(0), sum(0);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for(int p=0; p < nproducers; p++)
+        threads.push_back(thread([&, p](){
+            for(long v=p*per_producer; v < (p + 1)*per_producer; v++)
+                while(!queue.try_push(v)) this_thread::yield();
+        }));
+    for(int c=0; c < nconsumers; c++)
+        threads.push_back(thread([&](){
+            long value, local = 0;
+            while(popped.load(memory_order_relaxed) < total){
+                if(queue.try_pop(value)){
+                    local += value;
+                    popped.fetch_add(1, memory_order_relaxed);
+                }
+                else this_thread::yield();
+            }
+            sum += local;
+        }));
+    for(auto& th: threads) th.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    bool ok = (sum.load() == total*(total - 1)/2);
+    cout << left << setw(28) << name << ": "
+         << fixed << setprecision(2) << setw(8) << 2*total/seconds/1e6 << " Mops/s"
+         << (ok? "" : "  (WRONG SUM)") << endl;
+}
+
+/*
+ * SPSCBatch: SPSCQueue driven by try_push_n/try_pop_n, 32 items per call.
+ */
+void bench_spsc_batch(long nitems){
+    SPSCQueue<long> queue(1024);
+    const size_t BATCH = 32;
+    long sum = 0;
+    auto start = chrono::steady_clock::now();
+    thread producer([&](){
+        long buffer[BATCH];
+        for(long v=0; v < nitems; ){
+            size_t n = 0;
+            while((n < BATCH) && (v + (long)n < nitems)){ buffer[n] = v + n; n++; }
+            size_t done = 0;
+            while(done < n){
+                size_t k = queue.try_push_n(buffer + done, n - done);
+                if(k == 0) this_thread::yield();
+                done += k;
+            }
+            v += n;
+        }
+    });
+    long buffer[BATCH];
+    for(long count=0; count < nitems; ){
+        size_t k = queue.try_pop_n(buffer, BATCH);
+        if(k == 0){ this_thread::yield(); continue; }
+        for(size_t idx=0; idx < k; idx++) sum += buffer[idx];
+        count += k;
+    }
+    producer.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    bool ok = (sum == nitems*(nitems - 1)/2);
+    cout << left << setw(28) << "SPSCQueue (batch of 32)" << ": "
+         << fixed << setprecision(2) << setw(8) << 2*nitems/seconds/1e6 << " Mops/s"
+         << (ok? "" : "  (WRONG SUM)") << endl;
+}
+
+void concurrentQueueDemo1(){
+    SPSCQueue<int> queue(4);
+    for(int i=0; i < 5; i++) cout << "try_push(" << i << "): " << queue.try_push(i) << endl;
+    queue.println();
+    cout << "capacity: " << queue.capacity() << ", size: " << queue.size() << endl;
+    cout << "peek: " << queue.peek() << ", pop: " << queue.pop() << endl;
+    cout << "contains 2: " << queue.contains(2) << ", remove 2: " << queue.remove(2) << endl;
+    queue.println();
+
+    MPMCQueue<int> mpmc(8);
+    int items[] = {10, 20, 30, 40, 50};
+    cout << "try_push_n: " << mpmc.try_push_n(items, 5) << endl;
+    int out[3];
+    size_t n = mpmc.try_pop_n(out, 3);
+    cout << "try_pop_n: " << n << " => " << out[0] << ", " << out[1] << ", " << out[2] << endl;
+    mpmc.println();
+}
+
+//ops/sec: one producer, one consumer
+void concurrentQueueDemo2(long nitems=2000000){
+    SPSCQueue<long> spsc(1024);
+    MPMCQueue<long> mpmc(1024);
+    MutexQueue<long> locked(1024);
+    cout << "1 producer, 1 consumer, " << nitems << " items" << endl;
+    bench_queue("SPSCQueue", spsc, 1, 1, nitems);
+    bench_spsc_batch(nitems);
+    bench_queue("MPMCQueue", mpmc, 1, 1, nitems);
+    bench_queue("mutex + deque", locked, 1, 1, nitems);
+}
+
+//ops/sec: several producers and consumers
+void concurrentQueueDemo3(int nproducers=2, int nconsumers=2, long nitems=2000000){
+    MPMCQueue<long> mpmc(1024);
+    MutexQueue<long> locked(1024);
+    cout << nproducers << " producers, " << nconsumers << " consumers, " << nitems << " items" << endl;
+    bench_queue("MPMCQueue", mpmc, nproducers, nconsumers, nitems);
+    bench_queue("mutex + deque", locked, nproducers, nconsumers, nitems);
+}
+
+/*
+ * concurrentQueueCheck: SPSCQueue must deliver the items in order, and MPMCQueue every item
+ *  exactly once, in the order of each producer; small capacities, so the ring wraps often.
+ */
+bool concurrentQueueCheck(long nitems=200000, int nproducers=3, int nconsumers=3){
+    bool ok = true;
+    SPSCQueue<long> spsc(16);
+    thread producer([&](){
+        for(long v=0; v < nitems; v++) spsc.push(v);
+    });
+    for(long expected=0; expected < nitems; ){
+        long value;
+        if(!spsc.try_pop(value)){ this_thread::yield(); continue; }
+        ok = ok && (value == expected++);
+    }
+    producer.join();
+    cout << "SPSCQueue: FIFO order: " << (ok? "yes" : "NO") << endl;
+
+    MPMCQueue<long> mpmc(16);
+    long per_producer = nitems/nproducers;
+    vector<vector<char>> seen(nproducers, vector<char>(per_producer, 0));
+    atomic<long> popped(0);
+    atomic<bool> ordered(true);
+    vector<thread> threads;
+    for(int p=0; p < nproducers; p++)
+        threads.push_back(thread([&, p](){
+            for(long v=0; v < per_producer; v++)
+                while(!mpmc.try_push(p*per_producer + v)) this_thread::yield();
+        }));
+    for(int c=0; c < nconsumers; c++)
+        threads.push_back(thread([&](){
+            vector<long> last(nproducers, -1);
+            long value;
+            while(popped.load() < per_producer*nproducers){
+                if(!mpmc.try_pop(value)){ this_thread::yield(); continue; }
+                long p = value/per_producer, v = value%per_producer;
+                if(v <= last[p]) ordered = false;
+                last[p] = v;
+                seen[p][v]++;
+                popped++;
+            }
+        }));
+    for(auto& th: threads) th.join();
+    bool once = true;
+    for(auto& items: seen) for(char count: items) once = once && (count == 1);
+    cout << "MPMCQueue: every item once: " << (once? "yes" : "NO")
+         << ", per-producer order: " << (ordered? "yes" : "NO") << endl;
+    return ok && once && ordered;
+}
+
+#endif /* CONCURRENTQUEUEDEMO_H */
@@ -0,0 +1,66 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   TensorAllocatorDemo.h
+ *
+ * Created on December 4, 2024, 3:10 PM
+ */
+
+#ifndef TENSORALLOCATORDEMO_H
+#define TENSORALLOCATORDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+#include "ann/annheader.h"
+#include "loader/dataset.h"
+#include "loader/dataloader.h"
+
+/*
+ * tensorAllocatorDemo1: the buffers of double_tensor are 64-byte aligned; a few epochs of a
+ *  wide MLP without and with huge pages: the time and the allocation stats of each run.
+ */
+void tensorAllocatorDemo1(int width=1024, int nsamples=4096, int batch=256, int nepoch=2){
+    double_tensor A = xt::zeros<double>({3, 5});
+    double_tensor B = empty_tensor({7});
+    cout << "A.data() % 64 = " << (uintptr_t)A.data() % TensorMemory::ALIGNMENT
+         << ", B.data() % 64 = " << (uintptr_t)B.data() % TensorMemory::ALIGNMENT << endl;
+
+    xt::random::seed(2024);
+    int nClasses = 10;
+    double_tensor X = xt::random::randn<double>({(size_t)nsamples, (size_t)width});
+    double_tensor labels = xt::floor(xt::random::rand<double>({(size_t)nsamples})*nClasses);
+    TensorDataset<double, double> train_ds(X, labels);
+    DataLoader<double, double> train_loader(&train_ds, batch, false, false);
+
+    for(bool huge_pages: {false, true}){
+        ILayer* layers[] = {
+            new FCLayer(width, width, true), new ReLU(),
+            new FCLayer(width, width, true), new ReLU(),
+            new FCLayer(width, nClasses, true), new Softmax()
+        };
+        MLPClassifier model("./config.txt", "tensor-allocator", layers, 6);
+        TensorMemory::configure(huge_pages, 2048);
+        TensorMemory::reset_stats();
+        SGD optim(1e-3);
+        CrossEntropy loss;
+        ClassMetrics metrics(nClasses);
+        model.compile(&optim, &loss, &metrics);
+        auto start = chrono::steady_clock::now();
+        model.fit(&train_loader, &train_loader, nepoch, 0);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "huge pages " << (huge_pages? "on " : "off") << ": " << fixed << setprecision(3)
+             << seconds << " s" << defaultfloat << endl;
+        cout << TensorMemory::get_desc() << endl;
+    }
+    TensorMemory::configure(false);
+}
+
+#endif /* TENSORALLOCATORDEMO_H */
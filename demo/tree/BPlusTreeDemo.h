@@ -0,0 +1,179 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   BPlusTreeDemo.h
+ *
+ * Created on November 22, 2024, 5:10 PM
+ */
+
+#ifndef BPLUSTREEDEMO_H
+#define BPLUSTREEDEMO_H
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+#include "tree/BPlusTree.h"
+#include "tree/EytzingerTree.h"
+using namespace std;
+
+string bptreeEntry2str(int& key, int*& value){
+    stringstream os;
+    os << key << ":" << *value;
+    return os.str();
+}
+
+void bplusTreeDemo1(){
+    static int values[20];
+    BPlusTree<int, int*, 4> tree; //small nodes to show the splits
+    for(int idx=0; idx < 20; idx++){
+        values[idx] = 100 + idx;
+        tree.add((idx*7)%20, &values[idx]);
+    }
+    cout << "size: " << tree.size() << ", height: " << tree.height() << endl;
+    tree.println();
+
+    bool found;
+    int* value = tree.search(13, found);
+    cout << "search 13: " << (found? to_string(*value) : "not found") << endl;
+    cout << "range [5, 9]:";
+    for(auto v: tree.range(5, 9)) cout << " " << *v;
+    cout << endl;
+
+    for(int key=0; key < 20; key += 2) tree.remove(key);
+    cout << "after removing the even keys, height: " << tree.height() << endl;
+    tree.println(&bptreeEntry2str);
+
+    EytzingerTree<int, int*> table;
+    for(int key=1; key <= 10; key++) table.add(key, &values[key]);
+    cout << "Eytzinger layout: " << table.toString() << endl;
+    value = table.search(7, found);
+    cout << "search 7: " << (found? to_string(*value) : "not found") << endl;
+}
+
+/*
+ * bplusTreeDemo2: nkeys random int keys, nqueries lookups (half of them hit):
+ *  std::map (a node per key, the pointer tree of the BST/AVL demos), BPlusTree,
+ *  EytzingerTree and std::lower_bound on the sorted keys.
+ */
+template<class Fn>
+void bench_lookup(string name, const vector<int>& queries, Fn lookup){
+    auto start = chrono::steady_clock::now();
+    long hits = 0;
+    for(int key: queries) hits += lookup(key);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << left << setw(26) << name << ": " << fixed << setprecision(1)
+         << seconds*1e9/queries.size() << " ns/lookup, hits: " << hits << endl;
+}
+
+void bplusTreeDemo2(int nkeys=4000000, int nqueries=4000000){
+    mt19937 rng(2024);
+    vector<int> keys(nkeys);
+    for(auto& k: keys) k = (int)(rng() >> 1);
+    vector<int> payload(nkeys);
+    for(int idx=0; idx < nkeys; idx++) payload[idx] = idx & 0xFF;
+    vector<int> queries(nqueries);
+    for(int q=0; q < nqueries; q++) queries[q] = (q & 1)? keys[rng()%nkeys] : (int)(rng() >> 1);
+
+    map<int, int*> rbtree;
+    BPlusTree<int, int*> bptree;
+    for(int idx=0; idx < nkeys; idx++){
+        rbtree[keys[idx]] = &payload[idx];
+        bptree.add(keys[idx], &payload[idx]);
+    }
+    vector<int*> pointers(nkeys);
+    for(int idx=0; idx < nkeys; idx++) pointers[idx] = &payload[idx];
+    EytzingerTree<int, int*> table(keys.data(), pointers.data(), nkeys);
+    vector<int> sorted(keys);
+    std::sort(sorted.begin(), sorted.end());
+
+    cout << nkeys << " keys, BPlusTree height: " << bptree.height()
+         << ", EytzingerTree height: " << table.height() << endl;
+    bench_lookup("std::map", queries, [&](int key){ return rbtree.find(key) != rbtree.end(); });
+    bench_lookup("std::lower_bound (sorted)", queries, [&](int key){
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), key);
+        return (it != sorted.end()) && (*it == key);
+    });
+    bench_lookup("BPlusTree", queries, [&](int key){
+        bool found;
+        bptree.search(key, found);
+        return found;
+    });
+    bench_lookup("EytzingerTree", queries, [&](int key){
+        bool found;
+        table.search(key, found);
+        return found;
+    });
+
+    auto start = chrono::steady_clock::now();
+    long count = 0, sum = 0;
+    bptree.scan(0, 1 << 28, [&](int&, int*& value){
+        count++;
+        sum += *value;
+        return true;
+    });
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "BPlusTree range scan of [0, 2^28]: " << count << " keys in " << setprecision(4)
+         << seconds << " s (sum " << sum << ")" << endl;
+}
+
+/*
+ * bplusTreeCheck: BPlusTree (small and default nodes) and EytzingerTree against std::map on
+ *  random add/remove/search sequences; the ascending lists and a range are compared too.
+ */
+template<class Tree>
+bool same_as_map(Tree& tree, map<int, int>& reference, mt19937& rng, int nops, int nkeys){
+    vector<int> values(nkeys);
+    for(int idx=0; idx < nkeys; idx++) values[idx] = idx;
+    bool ok = true;
+    for(int op=0; (op < nops) && ok; op++){
+        int key = rng()%nkeys;
+        int action = rng()%3;
+        bool found;
+        if(action == 0){
+            tree.add(key, &values[key]);
+            reference[key] = key;
+        }
+        else if(action == 1){
+            tree.remove(key, &found);
+            ok = (found == (reference.erase(key) == 1));
+        }
+        else{
+            int* value = tree.search(key, found);
+            ok = (found == (reference.count(key) == 1)) && (!found || (*value == key));
+        }
+        ok = ok && (tree.size() == (int)reference.size());
+    }
+    DLinkedList<int*> ascending = tree.ascendingList();
+    auto it = reference.begin();
+    for(auto value: ascending) ok = ok && (it != reference.end()) && (*value == (it++)->first);
+    ok = ok && (it == reference.end());
+    int lo = nkeys/4, hi = nkeys/2;
+    auto first = reference.lower_bound(lo);
+    for(auto value: tree.range(lo, hi)) ok = ok && (first != reference.end()) && (*value == (first++)->first);
+    ok = ok && ((first == reference.end()) || (first->first > hi));
+    return ok;
+}
+bool bplusTreeCheck(int nops=100000, int nkeys=5000){
+    mt19937 rng(2024);
+    map<int, int> reference_small, reference_default, reference_eytzinger;
+    BPlusTree<int, int*, 4> small_nodes;
+    BPlusTree<int, int*> default_nodes;
+    EytzingerTree<int, int*> table;
+    bool small_ok = same_as_map(small_nodes, reference_small, rng, nops, nkeys);
+    bool default_ok = same_as_map(default_nodes, reference_default, rng, nops, nkeys);
+    //add/remove rebuild the Eytzinger layout: fewer operations
+    bool eytzinger_ok = same_as_map(table, reference_eytzinger, rng, nops/50, nkeys/10);
+    cout << "BPlusTree<4> against std::map: " << (small_ok? "same" : "DIFFERENT") << endl;
+    cout << "BPlusTree against std::map: " << (default_ok? "same" : "DIFFERENT") << endl;
+    cout << "EytzingerTree against std::map: " << (eytzinger_ok? "same" : "DIFFERENT") << endl;
+    return small_ok && default_ok && eytzinger_ok;
+}
+
+#endif /* BPLUSTREEDEMO_H */
@@ -0,0 +1,154 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   ThreadPoolDemo.h
+ *
+ * Created on December 17, 2024, 9:10 AM
+ */
+
+#ifndef THREADPOOLDEMO_H
+#define THREADPOOLDEMO_H
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "util/ThreadPool.h"
+#include "tensor/xtensor_lib.h"
+using namespace std;
+
+//sum of x[i]*x[i] over [0, n) with parallel_for inside each chunk of an outer parallel_for
+double threadpool_nested_sum(const double* x, size_t n, size_t nouter){
+    vector<double> partial(nouter, 0.0);
+    size_t block = (n + nouter - 1)/nouter;
+    parallel_for(nouter, [&](size_t obegin, size_t oend){
+        for(size_t o=obegin; o < oend; o++){
+            size_t begin = min(n, o*block), end = min(n, begin + block);
+            vector<double> inner(end - begin, 0.0);
+            parallel_for(end - begin, [&](size_t b, size_t e){
+                for(size_t i=b; i < e; i++) inner[i] = x[begin + i]*x[begin + i];
+            });
+            for(double v: inner) partial[o] += v;
+        }
+    }, (size_t)1 << 20); //heavy items: the outer loop is split too
+    double sum = 0;
+    for(double v: partial) sum += v;
+    return sum;
+}
+
+/*
+ * threadPoolCheck: the shared ThreadPool (the size and the threshold are restored at the end):
+ *  + configure: a resize while other threads run parallel_for is refused (false) or waits
+ *      for no caller; the callers that start during a resize run on their own thread
+ *      (ActiveScope), and every result is right; once idle, the pool takes the new size;
+ *  + nested parallel_for/run_chunks: the same results as the serial loops;
+ *  + a throwing chunk: its exception reaches the caller after the other chunks ran, and
+ *      the pool still works;
+ *  + parallel_reduce: the same sum, bit for bit, for 1, 2, 3 and 8 threads.
+ */
+bool threadPoolCheck(){
+    size_t saved_size = ThreadPool::instance().size();
+    size_t saved_threshold = ThreadPool::instance().threshold();
+    size_t threshold = 1 << 12;
+    xt::random::seed(2024);
+    size_t n = 1 << 18;
+    double_tensor X = xt::random::randn<double>({n});
+    const double* x = X.data();
+    double serial = 0;
+    for(size_t i=0; i < n; i++) serial += x[i]*x[i];
+    auto relative = [&](double v){ return std::abs(v - serial)/serial; };
+
+    //(1) parallel_reduce over several pool sizes
+    double reference = 0;
+    bool reduce_same = true;
+    for(int nthreads: {1, 2, 3, 8}){
+        ThreadPool::configure(nthreads, threshold);
+        double sum = parallel_reduce(n, 0.0, [&](size_t begin, size_t end){
+            double partial = 0;
+            for(size_t i=begin; i < end; i++) partial += x[i]*x[i];
+            return partial;
+        }, std::plus<double>());
+        if(nthreads == 1) reference = sum;
+        reduce_same &= (std::memcmp(&sum, &reference, sizeof(double)) == 0) && (relative(sum) < 1e-12);
+    }
+    cout << "parallel_reduce on 1, 2, 3, 8 threads: " << (reduce_same? "same sums" : "different sums") << endl;
+
+    //(2) nested parallel_for and run_chunks
+    ThreadPool::configure(4, threshold);
+    double nested_err = relative(threadpool_nested_sum(x, n, 16));
+    atomic<size_t> nvisited(0);
+    ThreadPool::instance().run_chunks(8, [&](size_t c){
+        ThreadPool::instance().run_chunks(8, [&](size_t d){
+            parallel_for(1000, [&](size_t b, size_t e){ nvisited += e - b; }, 1000);
+        });
+    });
+    bool nested_ok = (nested_err < 1e-12) && (nvisited.load() == 64*1000);
+    cout << "nested: parallel_for error " << nested_err << ", run_chunks items " << nvisited.load()
+         << " (expected " << 64*1000 << ")" << endl;
+
+    //(3) a throwing chunk
+    atomic<size_t> nrun(0);
+    bool thrown = false;
+    try{
+        ThreadPool::instance().run_chunks(32, [&](size_t c){
+            nrun++;
+            if(c == 5) throw std::runtime_error("chunk 5");
+        });
+    }
+    catch(std::runtime_error& e){
+        thrown = (string(e.what()) == "chunk 5");
+    }
+    bool nested_thrown = false;
+    try{
+        parallel_for(64, [&](size_t b, size_t e){
+            parallel_for(n, [&](size_t ib, size_t ie){
+                if((b == 0) && (ib == 0)) throw std::out_of_range("inner");
+            });
+        }, (size_t)1 << 20);
+    }
+    catch(std::out_of_range& e){
+        nested_thrown = true;
+    }
+    bool usable = relative(threadpool_nested_sum(x, n, 16)) < 1e-12;
+    bool throw_ok = thrown && (nrun.load() == 32) && nested_thrown && usable;
+    cout << "throwing chunk: rethrown " << (thrown? "yes" : "no") << ", chunks run " << nrun.load()
+         << "/32, from a nested loop " << (nested_thrown? "yes" : "no") << ", pool usable after: "
+         << (usable? "yes" : "no") << endl;
+
+    //(4) configure while other threads use the pool
+    atomic<bool> stop(false);
+    atomic<int> nwrong(0), ncalls(0);
+    vector<thread> callers;
+    for(int t=0; t < 3; t++){
+        callers.push_back(thread([&](){
+            while(!stop.load()){
+                if(relative(threadpool_nested_sum(x, n, 8)) >= 1e-12) nwrong++;
+                ncalls++;
+            }
+        }));
+    }
+    int nrefused = 0, nresized = 0;
+    for(int r=0; r < 200; r++){
+        if(ThreadPool::configure(2 + r%5, threshold)) nresized++;
+        else nrefused++;
+        std::this_thread::yield();
+    }
+    stop = true;
+    for(auto& caller: callers) caller.join();
+    bool idle_resize = ThreadPool::configure(6, threshold) && (ThreadPool::instance().size() == 6);
+    bool resize_ok = (nwrong.load() == 0) && idle_resize && (relative(threadpool_nested_sum(x, n, 16)) < 1e-12);
+    cout << "configure under load: " << nresized << " resized, " << nrefused << " refused, "
+         << ncalls.load() << " calls, " << nwrong.load() << " wrong results; idle resize: "
+         << (idle_resize? "yes" : "no") << endl;
+
+    ThreadPool::configure(saved_size, saved_threshold);
+    return reduce_same && nested_ok && throw_ok && resize_ok && (ThreadPool::instance().size() == saved_size);
+}
+
+#endif /* THREADPOOLDEMO_H */
@@ -17,6 +17,7 @@
 #include "layer/Sigmoid.h"
 #include "layer/Tanh.h"
 #include "layer/Softmax.h"
+#include "layer/Embedding.h"
 #include "ann/functions.h"
 #include "loss/CrossEntropy.h"
 #include "model/MLPClassifier.h"
@@ -28,7 +28,9 @@ public:
     Config(const Config& orig);
     virtual ~Config();
     string get(string key, string def_value);
+    int get_int(string key, int def_value);
     string get_new_checkpoint(string model_name);
+    xvector<int> get_checkpoint_indices(string model_name);
     
 protected:
     virtual void load_default();
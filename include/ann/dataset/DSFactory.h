@@ -31,10 +31,19 @@ public:
     DSFactory(const DSFactory& orig);
     virtual ~DSFactory();
     
+    xmap<string, TensorDataset<double, double>*>* get_datasets(string ds_name="", int nclasses=0);
     xmap<string, TensorDataset<double, double>*>* get_datasets_3cc();
     xmap<string, TensorDataset<double, double>*>* get_datasets_2cc();
     
 protected:
+    double_tensor make_labels(double_tensor t, int nclasses);
+    void load_stats(fs::path dataset_path, string prefix, string train_file,
+                    const double_tensor& train_table,
+                    double_tensor& mu, double_tensor& sigma);
+    TensorDataset<double, double>* make_dataset(const double_tensor& table,
+                                                const double_tensor& mu,
+                                                const double_tensor& sigma,
+                                                int nclasses);
     
     Config* m_pConfig;
 private:
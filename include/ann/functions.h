@@ -37,10 +37,13 @@ enum class_metrics{
 
 
 
-xt::xarray<double> softmax(xt::xarray<double> X, int axis=-1);
-double cross_entropy(xt::xarray<double> Ypred, xt::xarray<double> Ygt, bool mean_reduced=true);
-double cross_entropy(xt::xarray<double> Ypred, xt::xarray<unsigned long> ygt, bool mean_reduced=true);
-xt::xarray<double> onehot_enc(xt::xarray<unsigned long> x, int nclasses);
+double_tensor softmax(double_tensor X, int axis=-1);
+double cross_entropy(double_tensor Ypred, double_tensor Ygt, bool mean_reduced=true);
+double cross_entropy(double_tensor Ypred, xt::xarray<unsigned long> ygt, bool mean_reduced=true);
+double_tensor onehot_enc(xt::xarray<unsigned long> x, int nclasses);
+ulong_tensor label_indices(const double_tensor& t, size_t nclasses=0);
+void topk_rows(const double* Z, size_t nrows, size_t nclasses, size_t k, bool apply_softmax,
+               unsigned long* indices, double* scores);
 xt::xarray<ulong> confusion_matrix(xt::xarray<ulong> y_true, xt::xarray<ulong> y_pred,  int nclasses);
 xt::xarray<ulong> class_count(xt::xarray<ulong> confusion);
 double_tensor calc_classifcation_metrics(ulong_tensor y_true, ulong_tensor y_pred, int nclasses);
@@ -63,7 +66,14 @@ string trim(std::string &s);
 string to_lower(const string& str);
 
 
-void estimate_params(xt::xarray<double> X, xt::xarray<double>& mu, xt::xarray<double>& sigma);
-xt::xarray<double> normalize(xt::xarray<double> X, xt::xarray<double> mu, xt::xarray<double> sigma);
+void scale_inplace(double_tensor& X, double factor);
+void fill_zeros(double_tensor& X, const double_tensor::shape_type& shape);
+double_tensor sum_rows(const double_tensor& X);
+void estimate_params(const double* X, size_t nrows, size_t ncols, size_t ld,
+                     double_tensor& mu, double_tensor& sigma);
+void estimate_params(double_tensor X, double_tensor& mu, double_tensor& sigma);
+void normalize_rows(const double* X, size_t ldx, double* Y, size_t nrows, size_t ncols,
+                    const double_tensor& mu, const double_tensor& sigma);
+double_tensor normalize(double_tensor X, double_tensor mu, double_tensor sigma);
 #endif /* FUNTIONS_H */
 
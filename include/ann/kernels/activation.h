@@ -0,0 +1,40 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   activation.h
+ *
+ * Created on November 4, 2024, 8:41 PM
+ */
+
+#ifndef ACTIVATION_H
+#define ACTIVATION_H
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * In-place kernels for the activation layers; they work on contiguous buffers of n doubles
+ * and allocate nothing. The code path (AVX-512, AVX2 or scalar) is chosen by simd_level().
+ *
+ * relu_forward(X, n, mask):
+ *  + X[i] := (X[i] >= 0) ? X[i] : 0
+ *  + mask: nullptr, or relu_mask_words(n) words; bit i is set if X[i] >= 0
+ * relu_backward(DY, n, mask):
+ *  + DY[i] := bit i of mask ? DY[i] : 0
+ * sigmoid_forward(X, n):  X[i] := 1/(1 + exp(-X[i]))
+ * sigmoid_backward(DY, Y, n):  DY[i] := DY[i]*Y[i]*(1 - Y[i])
+ * tanh_forward(X, n):  X[i] := tanh(X[i])
+ * tanh_backward(DY, Y, n):  DY[i] := DY[i]*(1 - Y[i]*Y[i])
+ */
+inline size_t relu_mask_words(size_t n){ return (n + 63)/64; }
+
+void relu_forward(double* X, size_t n, uint64_t* mask);
+void relu_backward(double* DY, size_t n, const uint64_t* mask);
+void sigmoid_forward(double* X, size_t n);
+void sigmoid_backward(double* DY, const double* Y, size_t n);
+void tanh_forward(double* X, size_t n);
+void tanh_backward(double* DY, const double* Y, size_t n);
+
+#endif /* ACTIVATION_H */
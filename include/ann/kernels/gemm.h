@@ -0,0 +1,37 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   gemm.h
+ *
+ * Created on November 10, 2024, 4:05 PM
+ */
+
+#ifndef GEMM_H
+#define GEMM_H
+#include <cstddef>
+
+/*
+ * gemm: C := alpha*op(A)*op(B) + beta*C, all matrices row-major
+ *  + op(A) is M x K: A (transA = false, M x K) or A^T (transA = true, A is K x M)
+ *  + op(B) is K x N: B (transB = false, K x N) or B^T (transB = true, B is N x K)
+ *  + lda, ldb, ldc: row strides (in elements) of A, B and C as stored
+ *  + beta == 0: C is not read (it may hold garbage/NaN)
+ *
+ * Implementation: no external BLAS. The blocks of op(A) and op(B) are packed into
+ *  contiguous panels (so the transposed cases cost nothing extra) and multiplied by
+ *  a register-blocked micro-kernel (AVX-512, AVX2 or scalar, see simd_level());
+ *  blocks of C are computed on the thread pool.
+ */
+void gemm(bool transA, bool transB, size_t M, size_t N, size_t K,
+          double alpha, const double* A, size_t lda,
+          const double* B, size_t ldb,
+          double beta, double* C, size_t ldc);
+void gemm(bool transA, bool transB, size_t M, size_t N, size_t K,
+          float alpha, const float* A, size_t lda,
+          const float* B, size_t ldb,
+          float beta, float* C, size_t ldc);
+
+#endif /* GEMM_H */
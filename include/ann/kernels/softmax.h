@@ -0,0 +1,33 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   softmax.h
+ *
+ * Created on November 6, 2024, 7:55 PM
+ */
+
+#ifndef SOFTMAX_KERNEL_H
+#define SOFTMAX_KERNEL_H
+#include <cstddef>
+
+/*
+ * Softmax kernels over a tensor viewed as [outer, len, inner]:
+ *  + len: size of the softmax axis; outer/inner: products of the sizes before/after it
+ *  + inner == 1: the axis is contiguous (rows); otherwise the kernels walk the axis
+ *      with stride inner, a block of neighbouring columns at a time.
+ *  + X and Y may be the same buffer (in place); nothing is allocated.
+ *
+ * Each row is read twice:
+ *  (1) running max m and running sum s = sum(exp(x - m)), rescaled when m grows;
+ *  (2) y = exp(x - m)/s.
+ *
+ * softmax_backward(Y, DY, ...): DY := Y ⊙ (DY - sum(DY ⊙ Y)) along the axis, in place;
+ *      it is the Jacobian-vector product of softmax without forming the Jacobian.
+ */
+void softmax_forward(const double* X, double* Y, size_t outer, size_t len, size_t inner);
+void softmax_backward(const double* Y, double* DY, size_t outer, size_t len, size_t inner);
+
+#endif /* SOFTMAX_KERNEL_H */
@@ -0,0 +1,148 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   vecmath.h
+ *
+ * Created on November 4, 2024, 8:20 PM
+ */
+
+#ifndef VECMATH_H
+#define VECMATH_H
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <atomic>
+using namespace std;
+
+/*
+ * SIMD support for the kernels in ann/kernels:
+ *  + the library is compiled for the baseline x86-64; the AVX2/AVX-512 code paths
+ *      are compiled with per-function target attributes (ANN_TARGET_AVX2/ANN_TARGET_AVX512)
+ *      and selected at run time by simd_level().
+ *  + environment variable ANN_SIMD (scalar, avx2, avx512) caps the level;
+ *      it is used to pin a process to a code path (e.g., for comparing results).
+ */
+#if defined(__x86_64__) || defined(__i386__)
+    #define ANN_HAVE_X86 1
+    #include <immintrin.h>
+    #define ANN_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    #define ANN_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+    #define ANN_HAVE_X86 0
+#endif
+
+enum SimdLevel{
+    SIMD_SCALAR = 0,
+    SIMD_AVX2,
+    SIMD_AVX512
+};
+
+inline SimdLevel detect_simd_level(){
+    SimdLevel level = SIMD_SCALAR;
+#if ANN_HAVE_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) level = SIMD_AVX2;
+    if((level == SIMD_AVX2) && __builtin_cpu_supports("avx512f")) level = SIMD_AVX512;
+#endif
+    const char* env = getenv("ANN_SIMD");
+    if(env != nullptr){
+        string cap(env);
+        if((cap == "scalar") && (level > SIMD_SCALAR)) level = SIMD_SCALAR;
+        if((cap == "avx2") && (level > SIMD_AVX2)) level = SIMD_AVX2;
+    }
+    return level;
+}
+inline std::atomic<int>& simd_level_ref(){
+    static std::atomic<int> level(detect_simd_level());
+    return level;
+}
+inline SimdLevel simd_level(){
+    return (SimdLevel)simd_level_ref().load(std::memory_order_relaxed);
+}
+/*
+ * set_simd_level: as ANN_SIMD, at run time (the checks run every code path in one process);
+ *  the level is capped by that of the cpu; returns the level in use.
+ */
+inline SimdLevel set_simd_level(SimdLevel level){
+    SimdLevel cap = detect_simd_level();
+    simd_level_ref().store((level < cap)? level : cap, std::memory_order_relaxed);
+    return simd_level();
+}
+
+#if ANN_HAVE_X86
+/*
+ * exp for 4 (AVX2) and 8 (AVX-512) doubles:
+ *  + Cephes' algorithm: exp(x) = 2^n * exp(r), r = x - n*ln(2), |r| <= ln(2)/2
+ *  + exp(r) by the rational approximation 1 + 2r*P(r^2)/(Q(r^2) - r*P(r^2))
+ *  + accuracy: about 1 ulp; inputs are clamped to [-708.39, 709.0], NaN propagates
+ */
+namespace vecmath{
+    const double EXP_HI = 709.0; //keeps n <= 1023
+    const double EXP_LO = -708.39641853226408;
+    const double LOG2E = 1.4426950408889634073599;
+    const double LN2_HI = 6.93145751953125E-1;
+    const double LN2_LO = 1.42860682030941723212E-6;
+    const double P0 = 1.26177193074810590878E-4;
+    const double P1 = 3.02994407707441961300E-2;
+    const double P2 = 9.99999999999999999910E-1;
+    const double Q0 = 3.00198505138664455042E-6;
+    const double Q1 = 2.52448340349684104192E-3;
+    const double Q2 = 2.27265548208155028766E-1;
+    const double Q3 = 2.00000000000000000009E0;
+    const double SHIFTER = 6755399441055744.0; //1.5*2^52: rounds to an integer in the low bits
+}
+
+ANN_TARGET_AVX2 inline __m256d exp_avx2(__m256d x){
+    using namespace vecmath;
+    x = _mm256_min_pd(_mm256_set1_pd(EXP_HI), _mm256_max_pd(_mm256_set1_pd(EXP_LO), x));
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(LOG2E)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_HI), x);
+    r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_LO), r);
+    __m256d rr = _mm256_mul_pd(r, r);
+
+    __m256d p = _mm256_fmadd_pd(_mm256_set1_pd(P0), rr, _mm256_set1_pd(P1));
+    p = _mm256_fmadd_pd(p, rr, _mm256_set1_pd(P2));
+    p = _mm256_mul_pd(p, r);
+    __m256d q = _mm256_fmadd_pd(_mm256_set1_pd(Q0), rr, _mm256_set1_pd(Q1));
+    q = _mm256_fmadd_pd(q, rr, _mm256_set1_pd(Q2));
+    q = _mm256_fmadd_pd(q, rr, _mm256_set1_pd(Q3));
+    __m256d e = _mm256_div_pd(p, _mm256_sub_pd(q, p));
+    e = _mm256_fmadd_pd(e, _mm256_set1_pd(2.0), _mm256_set1_pd(1.0));
+
+    //2^n: put (n + 1023) into the exponent field
+    __m256d biased = _mm256_add_pd(n, _mm256_set1_pd(SHIFTER + 1023.0));
+    __m256i bits = _mm256_slli_epi64(_mm256_castpd_si256(biased), 52);
+    return _mm256_mul_pd(e, _mm256_castsi256_pd(bits));
+}
+
+ANN_TARGET_AVX512 inline __m512d exp_avx512(__m512d x){
+    using namespace vecmath;
+    x = _mm512_min_pd(_mm512_set1_pd(EXP_HI), _mm512_max_pd(_mm512_set1_pd(EXP_LO), x));
+    __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(LOG2E)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_HI), x);
+    r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_LO), r);
+    __m512d rr = _mm512_mul_pd(r, r);
+
+    __m512d p = _mm512_fmadd_pd(_mm512_set1_pd(P0), rr, _mm512_set1_pd(P1));
+    p = _mm512_fmadd_pd(p, rr, _mm512_set1_pd(P2));
+    p = _mm512_mul_pd(p, r);
+    __m512d q = _mm512_fmadd_pd(_mm512_set1_pd(Q0), rr, _mm512_set1_pd(Q1));
+    q = _mm512_fmadd_pd(q, rr, _mm512_set1_pd(Q2));
+    q = _mm512_fmadd_pd(q, rr, _mm512_set1_pd(Q3));
+    __m512d e = _mm512_div_pd(p, _mm512_sub_pd(q, p));
+    e = _mm512_fmadd_pd(e, _mm512_set1_pd(2.0), _mm512_set1_pd(1.0));
+
+    __m512d biased = _mm512_add_pd(n, _mm512_set1_pd(SHIFTER + 1023.0));
+    __m512i bits = _mm512_slli_epi64(_mm512_castpd_si512(biased), 52);
+    return _mm512_mul_pd(e, _mm512_castsi512_pd(bits));
+}
+#endif
+
+#endif /* VECMATH_H */
@@ -0,0 +1,74 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.h to edit this template
+ */
+
+/*
+ * File:   Embedding.h
+ *
+ * Created on November 24, 2024, 10:05 AM
+ */
+
+#ifndef EMBEDDING_H
+#define EMBEDDING_H
+#include "layer/ILayer.h"
+#include "optim/SparseRowGrad.h"
+
+/*
+ * Embedding: a lookup table W [Nvocab, Ndim] for categorical (integer) features
+ *  + forward: X holds category ids (stored as doubles, in [0, Nvocab));
+ *      X [N]    -> Y [N, Ndim]:   Y[n, :] = W[X[n], :];
+ *      X [N, k] -> Y [N, k*Ndim]: the embeddings of the k columns, concatenated (input of FC);
+ *  + backward: the gradient of W is row-sparse (SparseRowGrad): only the rows seen in the
+ *      batch are accumulated, and the layer registers it with register_sparse_param:
+ *      the cost of backward and of the optimizer step follow the batch, not Nvocab;
+ *      the returned DX is zeros (the ids have no gradient).
+ */
+class Embedding: public ILayer {
+public:
+    Embedding(int Nvocab=10, int Ndim=4);
+    Embedding(string sParams, string filename_w, string sName="");
+    Embedding(const Embedding& orig);
+    virtual ~Embedding();
+
+    double_tensor forward(double_tensor X);
+    double_tensor backward(double_tensor DY);
+    void infer(InferenceContext& ctx) const;
+    int register_params(IParamGroup* ptr_group);
+    void save(string model_path);
+    void load(string model_path, string layer_name="");
+    void stage(Checkpoint& ckpt);
+    int getNvocab(){ return m_nNvocab; }
+    int getNdim(){ return m_nNdim; }
+    string get_desc();
+    void set_weights(double_tensor W);
+    SparseRowGrad& get_grad(){ return m_grad_W; }
+    bool has_learnable_param(){ return true; };
+    LayerType get_type(){ return LayerType::EMBEDDING; };
+    ILayer* clone(){ return new Embedding(*this); };
+    size_t cache_bytes(){ return m_cached_ids.size()*sizeof(size_t); }
+    void release_cache(){ m_cached_ids = vector<size_t>(); }
+    void share_params(ILayer* pMaster);
+    void reseed_params(const CounterRNG& rng);
+
+protected:
+    virtual void init_weights();
+    void gather(const double_tensor& X, double_tensor& Y) const;
+    xt::svector<size_t> output_shape(const double_tensor& X) const;
+    //the table in use: the layer's own, or that of the master (share_params)
+    double_tensor& weights(){ return (m_pShared == nullptr)? m_aWeights : m_pShared->m_aWeights; }
+    const double_tensor& weights() const { return (m_pShared == nullptr)? m_aWeights : m_pShared->m_aWeights; }
+
+private:
+    int m_nNvocab, m_nNdim;
+
+    double_tensor m_aWeights; //Nvocab x Ndim
+    SparseRowGrad m_grad_W;
+    vector<size_t> m_cached_ids;
+    xt::svector<size_t> m_cached_shape;
+    unsigned long long m_unSample_Counter;
+    Embedding* m_pShared; //nullptr: own table
+    bool m_bRandom_Init; //W is that of init_weights, keyed by a default name (see reseed_params)
+};
+
+#endif /* EMBEDDING_H */
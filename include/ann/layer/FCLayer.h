@@ -13,6 +13,7 @@
 #ifndef FCLAYER_H
 #define FCLAYER_H
 #include "layer/ILayer.h"
+#include "tensor/csr_matrix.h"
 
 class FCLayer: public ILayer {
 public:
@@ -22,16 +23,25 @@ public:
     FCLayer(const FCLayer& orig);
     virtual ~FCLayer();
     
-    xt::xarray<double> forward(xt::xarray<double> X);
-    xt::xarray<double> backward(xt::xarray<double> DY);
+    double_tensor forward(double_tensor X);
+    double_tensor backward(double_tensor DY);
+    void infer(InferenceContext& ctx) const;
+    /* sparse input X [nrows, Nin] in CSR format (the first layer of a model fed by a
+     *  SparseTensorDataset): forward/infer cost O(nnz*Nout); the next backward computes
+     *  dW from the cached CSR X in O(nnz*Nout) and returns an empty DX (no layer below).
+     */
+    double_tensor forward(const CSRMatrix<double>& X);
+    void infer(const CSRMatrix<double>& X, InferenceContext& ctx) const;
     int register_params(IParamGroup* ptr_group);
     void save(string model_path);
     void load(string model_path, string layer_name="");
+    void stage(Checkpoint& ckpt);
     int getNin(){return m_nNin; }
     int getNout(){return m_nNout; }
     string get_desc();
     void set_weights(double_tensor W){
         this->m_aWeights = W;
+        this->m_bRandom_Init = false;
     }
     void set_bias(double_tensor b){
         this->m_aBias = b;
@@ -41,21 +51,45 @@ public:
     }
     bool has_learnable_param(){ return true; };
     LayerType get_type(){ return LayerType::FC; };
+    ILayer* clone(){ return new FCLayer(*this); };
+    size_t cache_bytes(){
+        return m_aCached_X.size()*sizeof(double) + m_cached_sparse_X.nnz()*(sizeof(double) + sizeof(uint32_t));
+    }
+    void release_cache(){
+        m_aCached_X = double_tensor();
+        m_cached_sparse_X = CSRMatrix<double>(m_nNin);
+    }
+    void share_params(ILayer* pMaster);
+    void reseed_params(const CounterRNG& rng);
 
 protected:
     virtual void init_weights();
+    void affine(const double_tensor& X, double_tensor& Y) const;
+    void affine(const CSRMatrix<double>& X, double_tensor& Y) const;
+    //gradients of W and b for a sparse (CSR) input; returns an empty DX:
+    //a sparse input comes from the data, so there is no layer to receive it
+    double_tensor backward_sparse(double_tensor& DY);
+    //the parameters in use: the layer's own, or those of the master (share_params)
+    double_tensor& weights(){ return (m_pShared == nullptr)? m_aWeights : m_pShared->m_aWeights; }
+    double_tensor& bias(){ return (m_pShared == nullptr)? m_aBias : m_pShared->m_aBias; }
+    const double_tensor& weights() const { return (m_pShared == nullptr)? m_aWeights : m_pShared->m_aWeights; }
+    const double_tensor& bias() const { return (m_pShared == nullptr)? m_aBias : m_pShared->m_aBias; }
     
 private:
     int m_nNin, m_nNout;
     bool m_bUse_Bias;
     
-    xt::xarray<double> m_aWeights; //N_out x N_in
-    xt::xarray<double> m_aBias;
+    double_tensor m_aWeights; //N_out x N_in
+    double_tensor m_aBias;
     
-    xt::xarray<double> m_aGrad_W;
-    xt::xarray<double> m_aGrad_b;
-    xt::xarray<double> m_aCached_X;
+    double_tensor m_aGrad_W;
+    double_tensor m_aGrad_b;
+    double_tensor m_aCached_X;
+    CSRMatrix<double> m_cached_sparse_X;
+    bool m_bSparse_Input; //the last forward (training mode) had a sparse input
+    bool m_bRandom_Init; //W is that of init_weights, keyed by a default name (see reseed_params)
     unsigned long long m_unSample_Counter;
+    FCLayer* m_pShared; //nullptr: own parameters
 };
 
 
@@ -15,15 +15,20 @@
 #include "tensor/xtensor_lib.h"
 #include "ann/functions.h"
 #include "optim/IParamGroup.h"
+#include "layer/InferenceContext.h"
 #include <string>
 using namespace std;
 
+class Checkpoint; //see model/CheckpointWriter.h
+class CounterRNG; //see util/CounterRNG.h
+
 enum LayerType{
     FC=0,
     RELU,
     SIGMOID,
     TANH,
     SOFTMAX,
+    EMBEDDING,
     NUM_LAYERS
 };
 class ILayer {
@@ -33,8 +38,11 @@ public:
     virtual ~ILayer();
     
     virtual void set_working_mode(bool mode=true){ m_trainable = mode; };
-    virtual xt::xarray<double> forward(xt::xarray<double> X)=0;
-    virtual xt::xarray<double> backward(xt::xarray<double> DY)=0;
+    bool get_working_mode(){ return m_trainable; }
+    virtual double_tensor forward(double_tensor X)=0;
+    virtual double_tensor backward(double_tensor DY)=0;
+    //inference only: reads ctx.current(), leaves the output in ctx.current(); touches no member
+    virtual void infer(InferenceContext& ctx) const=0;
     virtual void init_gradbuffer(){};
     virtual int register_params(IParamGroup* ptr_group){ return 0; } //default: 0=no learnable parameters
     virtual string getname(){return m_sName; }
@@ -42,8 +50,22 @@ public:
     virtual string get_desc()=0;
     virtual void save(string model_path){};
     virtual void load(string model_path, string layer_name=""){};
+    virtual void stage(Checkpoint& ckpt){}; //copy learnable params into ckpt
     virtual bool has_learnable_param(){ return false; };
     virtual LayerType get_type()=0;
+    virtual ILayer* clone()=0; //deep copy of the configuration, name and parameters (not the caches)
+    /* reseed_params: draws the randomly initialized parameters again from rng; the parameters
+     *  that were set, loaded or cloned are kept. MLPClassifier calls it with a key of the model.
+     */
+    virtual void reseed_params(const CounterRNG& rng){};
+    //the caches kept by forward (training mode) for backward: their size, and their release
+    virtual size_t cache_bytes(){ return 0; }
+    virtual void release_cache(){};
+    /* share_params: the layer reads and updates the learnable parameters of pMaster (a layer
+     *  of the same type and shape, that outlives it) instead of its own; its gradients stay
+     *  its own. For the replicas of the Hogwild workers (see IModel::set_hogwild).
+     */
+    virtual void share_params(ILayer* pMaster){};
 
 protected:
     bool m_trainable;
@@ -0,0 +1,50 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/* 
+ * File:   InferenceContext.h
+ *
+ * Created on November 14, 2024, 8:40 PM
+ */
+
+#ifndef INFERENCECONTEXT_H
+#define INFERENCECONTEXT_H
+#include "tensor/xtensor_lib.h"
+
+/*
+ * InferenceContext: the scratch state of one inference call (see ILayer::infer).
+ *  + the layers and the model are only read during inference; the activations live here,
+ *      so threads sharing one model only need one context each.
+ *  + two buffers are used in turn: a layer reads current() and writes next(shape), then
+ *      calls advance(); element-wise layers work on current() in place.
+ *  + a context is reused across calls: the buffers are only reallocated when a shape changes.
+ */
+class InferenceContext {
+public:
+    InferenceContext(): m_nCurrent(0){}
+    
+    //starts a call with the input X (copied into the current buffer)
+    void load(const double_tensor& X){
+        double_tensor& buffer = m_aBuffers[m_nCurrent];
+        if(buffer.shape() != X.shape()) buffer.resize(X.shape());
+        std::copy(X.data(), X.data() + X.size(), buffer.data());
+    }
+    double_tensor& current(){ return m_aBuffers[m_nCurrent]; }
+    
+    template<class S>
+    double_tensor& next(const S& shape){
+        double_tensor& buffer = m_aBuffers[1 - m_nCurrent];
+        if(!std::equal(shape.begin(), shape.end(), buffer.shape().begin(), buffer.shape().end()))
+            buffer.resize(shape);
+        return buffer;
+    }
+    void advance(){ m_nCurrent = 1 - m_nCurrent; }
+    
+private:
+    double_tensor m_aBuffers[2];
+    int m_nCurrent;
+};
+
+#endif /* INFERENCECONTEXT_H */
@@ -20,13 +20,17 @@ public:
     ReLU(const ReLU& orig);
     virtual ~ReLU();
     
-    xt::xarray<double> forward(xt::xarray<double> X);
-    xt::xarray<double> backward(xt::xarray<double> DY);
+    double_tensor forward(double_tensor X);
+    double_tensor backward(double_tensor DY);
+    void infer(InferenceContext& ctx) const;
     string get_desc();
     LayerType get_type(){ return LayerType::RELU; };
+    ILayer* clone(){ return new ReLU(*this); };
+    size_t cache_bytes(){ return m_aMask.size()*sizeof(uint64_t); }
+    void release_cache(){ m_aMask = xt::xarray<uint64_t>(); }
     
 private:
-    xt::xarray<bool> m_aMask;
+    xt::xarray<uint64_t> m_aMask; //bit i: X[i] >= 0 (see kernels/activation.h)
 };
 
 #endif /* RELU_H */
@@ -20,13 +20,17 @@ public:
     Sigmoid(const Sigmoid& orig);
     virtual ~Sigmoid();
     
-    xt::xarray<double> forward(xt::xarray<double> X);
-    xt::xarray<double> backward(xt::xarray<double> DY);
+    double_tensor forward(double_tensor X);
+    double_tensor backward(double_tensor DY);
+    void infer(InferenceContext& ctx) const;
     
     string get_desc();
     LayerType get_type(){ return LayerType::SIGMOID; };
+    ILayer* clone(){ return new Sigmoid(*this); };
+    size_t cache_bytes(){ return m_aCached_Y.size()*sizeof(double); }
+    void release_cache(){ m_aCached_Y = double_tensor(); }
 private:
-    xt::xarray<double> m_aCached_Y;
+    double_tensor m_aCached_Y;
 
 };
 
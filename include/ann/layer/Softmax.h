@@ -20,17 +20,24 @@ public:
     Softmax(const Softmax& orig);
     virtual ~Softmax();
 
-    virtual xt::xarray<double> forward(xt::xarray<double> X);
-    virtual xt::xarray<double> backward(xt::xarray<double> DY);
+    virtual double_tensor forward(double_tensor X);
+    virtual double_tensor backward(double_tensor DY);
+    virtual void infer(InferenceContext& ctx) const;
     
     string get_desc();
     LayerType get_type(){ return LayerType::SOFTMAX; };
+    ILayer* clone(){ return new Softmax(*this); };
+    size_t cache_bytes(){ return m_aCached_Y.size()*sizeof(double); }
+    void release_cache(){ m_aCached_Y = double_tensor(); }
+    int get_axis(){ return m_nAxis; };
     
     //void save(string model_path);
     //void load(string model_path, string layer_name="");
 private:
+    void axis_view(const double_tensor& X, size_t& outer, size_t& len, size_t& inner) const;
+    
     int m_nAxis;
-    xt::xarray<double> m_aCached_Y;    
+    double_tensor m_aCached_Y;    
 };
 
 #endif /* SOFTMAX_H */
@@ -21,12 +21,13 @@ public:
     CrossEntropy(const CrossEntropy& orig);
     virtual ~CrossEntropy();
     
-    virtual double forward(xt::xarray<double> X, xt::xarray<double> t);
-    virtual xt::xarray<double> backward();
+    virtual double forward(double_tensor X, double_tensor t);
+    virtual double_tensor backward();
+    ILossLayer* clone(){ return new CrossEntropy(m_eReduction); }
     
 private:
-    xt::xarray<double> m_aYtarget;
-    xt::xarray<double> m_aCached_Ypred;  
+    double_tensor m_aYtarget;
+    double_tensor m_aCached_Ypred;  
     //int m_nClasses;
 };
 
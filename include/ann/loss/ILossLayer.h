@@ -26,8 +26,11 @@ public:
     ILossLayer(const ILossLayer& orig);
     virtual ~ILossLayer();
     
-    virtual double forward(xt::xarray<double> X, xt::xarray<double> t)=0;
-    virtual xt::xarray<double> backward()=0;
+    virtual double forward(double_tensor X, double_tensor t)=0;
+    virtual double_tensor backward()=0;
+    virtual ILossLayer* clone()=0; //a new loss of the same kind and reduction (no cache)
+    LossReduction get_reduction(){ return m_eReduction; }
+    void set_reduction(LossReduction reduction){ m_eReduction = reduction; }
 protected:
     LossReduction m_eReduction;
 };
@@ -20,7 +20,7 @@ public:
     IMetrics(int nOutputs);
     IMetrics(const IMetrics& orig);
     virtual ~IMetrics();
-    virtual double evaluate(xt::xarray<double> pred, xt::xarray<double> target);
+    virtual double evaluate(double_tensor pred, double_tensor target);
     //
     virtual void reset_metrics()=0;
     virtual void accumulate(double_tensor y_true, double_tensor y_pred);
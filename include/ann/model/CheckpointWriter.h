@@ -0,0 +1,102 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.h to edit this template
+ */
+
+/* 
+ * File:   CheckpointWriter.h
+ *
+ * Created on November 2, 2024, 9:12 PM
+ */
+
+#ifndef CHECKPOINTWRITER_H
+#define CHECKPOINTWRITER_H
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using namespace std;
+
+#include "tensor/xtensor_lib.h"
+#include "config/Config.h"
+#include "dsaheader.h"
+
+/*
+ * Checkpoint: a staging buffer holding a copy of a model.
+ *  + m_sArch: content of the architecture file (arch.txt)
+ *  + m_filenames[i]: file name (inside the checkpoint folder) of m_tensors[i]
+ * Layers copy their parameters into it (see ILayer::stage); the copy is then
+ * serialised without touching the live model.
+ */
+class Checkpoint {
+public:
+    Checkpoint(){};
+    virtual ~Checkpoint(){};
+
+    void add_arch(string line){ m_sArch += line + "\n"; }
+    void add_tensor(string filename, const double_tensor& tensor){
+        m_filenames.add(filename);
+        m_tensors.add(tensor);
+    }
+    string get_arch(){ return m_sArch; }
+    int size(){ return m_tensors.size(); }
+    string get_filename(int idx){ return m_filenames.get(idx); }
+    double_tensor& get_tensor(int idx){ return m_tensors.get(idx); }
+
+protected:
+    string m_sArch;
+    xvector<string> m_filenames;
+    xvector<double_tensor> m_tensors;
+};
+
+/*
+ * CheckpointWriter: serialises checkpoints on a background thread.
+ *  + submit: hands a staged checkpoint over to the writer and returns at once;
+ *      if the writer is still busy, the pending checkpoint (if any) is replaced
+ *      by the newer one, so training never waits for the disk.
+ *  + each checkpoint is written into a hidden temporary folder, then renamed
+ *      into model_root/model-name/checkpoint-k (k: from Config::get_new_checkpoint).
+ *  + keep_last > 0: only the last keep_last checkpoints are kept on disk.
+ */
+class CheckpointWriter {
+public:
+    CheckpointWriter(Config* pConfig, string model_name, int keep_last=3);
+    CheckpointWriter(const CheckpointWriter& orig) = delete;
+    virtual ~CheckpointWriter();
+
+    void submit(Checkpoint* pCkpt); //takes the ownership of pCkpt
+    void flush(); //wait until all submitted checkpoints are on disk
+    string last_checkpoint();
+
+    /*
+     * commit(ckpt, model_path): write ckpt to model_path atomically
+     *  + the files are written (and synced) into a temporary folder first;
+     *  + the temporary folder then replaces model_path by renaming: an existing
+     *      model_path is moved aside to .<name>.old first and removed only after that.
+     */
+    static bool commit(Checkpoint& ckpt, string model_path, string arch_file="arch.txt");
+    /*
+     * resolve(model_path): the folder to load model_path from; that is model_path,
+     *  or its .<name>.old copy if a commit was interrupted between its two renames.
+     */
+    static string resolve(string model_path);
+
+protected:
+    void run();
+    void apply_retention();
+
+protected:
+    Config* m_pConfig;
+    string m_sModelName;
+    int m_nKeepLast;
+
+    Checkpoint* m_pPending;
+    bool m_bWriting;
+    bool m_bStop;
+    string m_sLastCheckpoint;
+    mutex m_mutex;
+    condition_variable m_cond;
+    thread m_worker;
+};
+
+#endif /* CHECKPOINTWRITER_H */
@@ -0,0 +1,85 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.h to edit this template
+ */
+
+/*
+ * File:   DistributedDataParallel.h
+ *
+ * Created on November 28, 2024, 2:15 PM
+ */
+
+#ifndef DISTRIBUTEDDATAPARALLEL_H
+#define DISTRIBUTEDDATAPARALLEL_H
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include "tensor/xtensor_lib.h"
+#include "layer/ILayer.h"
+#include "optim/SparseRowGrad.h"
+#include "model/ProcessGroup.h"
+
+/*
+ * DistributedDataParallel: averages the gradients of a model replica over the ranks of a
+ *  ProcessGroup (each rank trains on its own shard of the data, see ShardedDataset).
+ *  + the parameters and gradients are those the layers register through IParamGroup
+ *      (register_params); the constructor broadcasts the parameters of rank 0;
+ *  + dense gradients are packed into buckets of about bucket_bytes, in backward order
+ *      (the last layer first); a bucket is all-reduced by the communication thread as soon
+ *      as the backward of all its layers is done (mark_ready), while backward goes on;
+ *  + row-sparse gradients (Embedding) are all-gathered as (row, values) lists and summed,
+ *      in rank order: the cost follows the rows seen in the batches, not the table;
+ *  + use: prepare() before backward, mark_ready(layer) after the backward of each layer,
+ *      finish() before IOptimizer::step; without prepare(), finish() reduces all buckets;
+ *  + the sum is divided by world_size: the average of the ranks' (mean) gradients.
+ */
+class DistributedDataParallel {
+public:
+    DistributedDataParallel(ProcessGroup* pGroup, vector<ILayer*> layers, size_t bucket_bytes=1 << 20);
+    DistributedDataParallel(const DistributedDataParallel& orig) = delete;
+    virtual ~DistributedDataParallel();
+
+    void broadcast_parameters(int root=0);
+    void prepare();
+    void mark_ready(ILayer* pLayer);
+    void finish();
+
+    ProcessGroup* get_group(){ return m_pGroup; }
+    int get_num_buckets(){ return m_buckets.size(); }
+    string get_desc();
+
+protected:
+    struct Bucket {
+        vector<double_tensor*> grads;
+        size_t nelements;
+        int nlayers, pending;
+        bool ready;
+        vector<double> buffer;
+    };
+    void reduce_bucket(Bucket& bucket);
+    void reduce_sparse();
+    void comm_loop();
+
+private:
+    ProcessGroup* m_pGroup;
+    vector<Bucket> m_buckets;
+    unordered_map<ILayer*, int> m_layer_bucket;
+    vector<double_tensor*> m_params; //dense and sparse parameters, for broadcast
+    vector<SparseRowGrad*> m_sparse_grads;
+
+    //communication thread: reduces the buckets in index order once they are ready
+    thread m_comm_thread;
+    mutex m_mtx;
+    condition_variable m_cv_ready, m_cv_done;
+    bool m_bArmed, m_bStop;
+    int m_nNext; //the next bucket to reduce
+    exception_ptr m_error;
+};
+
+#endif /* DISTRIBUTEDDATAPARALLEL_H */
@@ -18,11 +18,17 @@
 #include "metrics/IMetrics.h"
 #include "loader/dataloader.h"
 #include "config/Config.h"
+#include "model/CheckpointWriter.h"
+#include <future>
+
+class ProcessGroup;
+class DistributedDataParallel;
 
 
 class IModel {
 public:
     IModel(string cfg_filename, string sModelName);
+    IModel(const IModel& orig);
     virtual ~IModel();
     
     //for the inference mode:
@@ -62,6 +68,71 @@ public:
             DataLoader<double, double>* pValidLoader,
             unsigned int nepoch=10,
             unsigned int verbose=1); //defined in this class
+    /*
+     * set_grad_accumulation: each batch of the train loader is split into nsteps
+     *  micro-batches; their gradients are accumulated (loss reduced by sum),
+     *  normalized by the sample counter and applied with one optimizer step.
+     *  + nsteps = 1: one step per micro-batch (the default)
+     *  + default value: config key grad_accum_steps
+     */
+    void set_grad_accumulation(int nsteps){ m_grad_accum_steps = (nsteps < 1)? 1 : nsteps; }
+    int get_grad_accumulation(){ return m_grad_accum_steps; }
+    /*
+     * set_pipeline: pipeline-parallel training (see PipelineSchedule): the layers are cut into
+     *  nstages stages, one thread each; each batch of the train loader is split into nmicro
+     *  micro-batches (nmicro <= 0: 4*nstages), their gradients are accumulated (loss reduced
+     *  by sum) and normalized, then applied with one optimizer step.
+     *  + nstages = 1: disabled (the default); it replaces grad_accum_steps when enabled;
+     *  + default values: config keys pipeline_stages, pipeline_micro_batches
+     */
+    void set_pipeline(int nstages, int nmicro=0){
+        m_pipeline_stages = (nstages < 1)? 1 : nstages;
+        m_pipeline_micro = (nmicro <= 0)? 4*m_pipeline_stages : nmicro;
+    }
+    int get_pipeline_stages(){ return m_pipeline_stages; }
+    /*
+     * set_distributed: data-parallel training over the ranks of pGroup (see
+     *  DistributedDataParallel): the parameters of rank 0 are broadcast, then fit averages
+     *  the gradients over the ranks before each optimizer step. Each rank must train on its
+     *  own shard (ShardedDataset) with the same number of batches.
+     *  + call it after compile, on every rank; pGroup is not owned (nullptr: disabled);
+     *  + config key dist_bucket_kb: the bucket size of the all-reduce (default 1024).
+     */
+    virtual void set_distributed(ProcessGroup* pGroup);
+    /*
+     * set_hogwild: asynchronous (Hogwild) training: fit runs nworkers threads per epoch; each
+     *  one pulls the next batch of the train loader and applies its own SGD update to the
+     *  shared parameters, without waiting for the others and without locks;
+     *  + nstripes > 0: each tensor is updated in nstripes stripes, each under a lock (rows for
+     *      row-sparse gradients): no lost update, at the cost of some contention;
+     *  + the update is plain SGD with the learning rate of the optimizer, whatever its type;
+     *      grad_accum_steps and the pipeline are not used in this mode;
+     *  + nworkers = 1: disabled (the default); config keys hogwild_workers, hogwild_stripes
+     */
+    void set_hogwild(int nworkers, int nstripes=0){
+        m_hogwild_workers = (nworkers < 1)? 1 : nworkers;
+        m_hogwild_stripes = (nstripes < 0)? 0 : nstripes;
+    }
+    int get_hogwild_workers(){ return m_hogwild_workers; }
+    /*
+     * set_async_validation: at the end of each epoch, fit evaluates a snapshot
+     *  (see snapshot()) of the model on a background thread while the next epoch trains;
+     *  the results are printed when ready, and drive the early stopping.
+     *  + default value: config key async_validation (0/1)
+     *  + early stopping: config key early_stop_patience (0: disabled); training stops
+     *      after that many validation results without a better accuracy.
+     */
+    void set_async_validation(bool async){ m_async_valid = async; }
+    //the validation results of the last fit, in epoch order (async or not)
+    vector<double_tensor> get_validation_history(){ return m_valid_history; }
+    /* snapshot: a copy of the model with the current weights, in inference mode;
+     *  it shares nothing with this model. nullptr: not supported by the model.
+     */
+    virtual IModel* snapshot(){ return nullptr; }
+    /* activation_report: a summary of the activation memory of the training steps,
+     *  printed at the end of fit (empty: nothing to report)
+     */
+    virtual string activation_report(){ return ""; }
     
     /*
      * Subclasses of IModel should:
@@ -92,10 +163,19 @@ public:
      *      * use the name created in layer's constructor. 
      */
     virtual bool load(string model_path, bool use_name_in_file=false)=0;
+    /* stage:
+     *  + copy the architecture and the learnable parameters into ckpt;
+     *  + used by fit to checkpoint the model without blocking on the disk.
+     */
+    virtual bool stage(Checkpoint& ckpt)=0;
     
 protected:
     virtual double_tensor forward(double_tensor X)=0;
     virtual void backward()=0;
+    /* forward_sparse: forward for a sparse (CSR) batch, see SparseTensorDataset;
+     *  models that can not take a sparse input keep this default (throws)
+     */
+    virtual double_tensor forward_sparse(const CSRMatrix<double>& X);
     
 protected:
     bool m_trainable; //TRUE: training; False: Inference
@@ -117,6 +197,22 @@ protected:
     void on_end_epoch();
     void on_begin_step(int batch_size);
     void on_end_step(double batch_loss);
+    double train_step(double_tensor& X, double_tensor& t);
+    double train_step(const CSRMatrix<double>& X, double_tensor& t);
+    double train_step_accumulated(double_tensor& X, double_tensor& t);
+    //train_step_pipelined: one optimizer step on (X, t) with the pipeline; default: throws
+    virtual double train_step_pipelined(double_tensor& X, double_tensor& t);
+    //train_epoch_async: one epoch on the train loader with the Hogwild workers; default: throws
+    virtual void train_epoch_async(DataLoader<double, double>* pLoader);
+    //the Hogwild workers: built by fit before the first epoch, released after the last one
+    virtual void build_async_workers(){};
+    virtual void release_async_workers(){};
+    //the pipeline (stage threads and queues): built by fit, released by on_end_training
+    virtual void build_pipeline(){};
+    virtual void release_pipeline(){};
+    void launch_validation();
+    void harvest_validation(bool wait);
+    void report_validation(int epoch, double_tensor metrics);
     //
     IOptimizer* m_pOptimizer;
     ILossLayer* m_pLossLayer; 
@@ -131,6 +227,22 @@ protected:
     double m_epoch_loss; //accumulated loss for epoch
     int m_curent_batch_size; //current batch-size
     int m_sample_counter; //total samples processed in epoch
+    //
+    CheckpointWriter* m_pCkptWriter; //nullptr: checkpointing is disabled
+    int m_ckpt_interval; //checkpoint every m_ckpt_interval epochs
+    int m_grad_accum_steps; //micro-batches per optimizer step
+    int m_pipeline_stages, m_pipeline_micro; //see set_pipeline
+    DistributedDataParallel* m_pDDP; //nullptr: not distributed
+    int m_hogwild_workers, m_hogwild_stripes; //see set_hogwild
+    //validation
+    bool m_async_valid; //true: validate snapshots on a background thread
+    std::future<double_tensor> m_valid_future; //pending validation (at most one)
+    int m_valid_epoch; //epoch of the pending validation
+    vector<double_tensor> m_valid_history; //see get_validation_history
+    int m_early_stop_patience; //0: no early stopping
+    double m_best_valid_acc;
+    int m_bad_valid_count; //results since the best one
+    bool m_stop_training;
 private:
 };
 
@@ -20,6 +20,10 @@
 #include "model/IModel.h"
 #include "config/Config.h"
 
+class SGDParamGroup; //see optim/SGDParamGroup.h
+class StripedLocks;
+class PipelineSchedule; //see model/PipelineSchedule.h
+
 class MLPClassifier: public IModel {
 public:
     MLPClassifier(string cfg_filename, string sModelName="MLPClassifier");
@@ -27,12 +31,19 @@ public:
     MLPClassifier(const MLPClassifier& orig);
     ~MLPClassifier();
     
-    //for the inference mode:
+    //for the inference mode: (const path, see infer)
+    const double_tensor& infer(const double_tensor& X, InferenceContext& ctx) const;
+    const double_tensor& infer(const CSRMatrix<double>& X, InferenceContext& ctx) const;
     double_tensor predict(double_tensor X, 
                 bool make_decision=false);
     double_tensor predict(
                 DataLoader<double, double>* pLoader,
                 bool make_decision=false);
+    void predict_topk(double_tensor X, int k,
+                ulong_tensor& indices, double_tensor& scores);
+    void predict_topk(
+                DataLoader<double, double>* pLoader, int k,
+                ulong_tensor& indices, double_tensor& scores);
     double_tensor evaluate(DataLoader<double, double>* pLoader);
     
     //for the training mode:
@@ -42,9 +53,28 @@ public:
                 IMetrics* pMetricLayer);
     bool save(string model_path="");
     bool load(string model_path, bool use_name_in_file=false);
+    bool stage(Checkpoint& ckpt);
+    IModel* snapshot();
     
     
     void set_working_mode(bool trainable);
+    /*
+     * set_recompute: activation checkpointing (recomputation) for training;
+     *  + layers_per_segment = k > 0: the layers are cut into segments of k layers; forward keeps
+     *      the input of each segment only, the layers of a segment (except the last one) cache
+     *      nothing; backward re-runs the forward of a segment from its input just before its
+     *      backward, then releases the caches of that segment;
+     *  + memory: the segment inputs + the caches of one segment, instead of the caches of all
+     *      the layers; compute: one more forward for the layers out of the last segment;
+     *  + k = 0: disabled (the default value: config key recompute_segment).
+     */
+    void set_recompute(int layers_per_segment){ m_recompute_segment = max(0, layers_per_segment); }
+    int get_recompute(){ return m_recompute_segment; }
+    //peak bytes of the activations kept for backward in a training step (since the last reset)
+    size_t get_peak_activation_bytes(){ return m_peak_act_bytes; }
+    void reset_activation_stats(){ m_peak_act_bytes = 0; m_recomputed_layers = 0; m_backward_steps = 0; }
+    string activation_report();
+    void set_distributed(ProcessGroup* pGroup);
     int get_num_classes(){
         FCLayer* pLayer = (FCLayer*)m_layers.get(m_layers.size() - 2); 
         return pLayer->getNout();
@@ -52,10 +82,42 @@ public:
 
 protected:
     double_tensor forward(double_tensor X);
+    const double_tensor& infer_layers(const double_tensor& X, InferenceContext& ctx,
+                                      bool stop_at_softmax, bool& softmax_skipped) const;
+    const double_tensor& infer_layers(const CSRMatrix<double>& X, InferenceContext& ctx,
+                                      bool stop_at_softmax, bool& softmax_skipped) const;
+    const double_tensor& infer_from(InferenceContext& ctx, int first, int ndim,
+                                    bool stop_at_softmax, bool& softmax_skipped) const;
+    FCLayer* sparse_input_layer() const;
+    double_tensor forward_sparse(const CSRMatrix<double>& X);
+    double_tensor forward_from(double_tensor X, int first);
+    double train_step_pipelined(double_tensor& X, double_tensor& t);
+    void train_epoch_async(DataLoader<double, double>* pLoader);
+    void build_async_workers();
+    void release_async_workers();
+    void build_pipeline();
+    void release_pipeline();
     void backward();
+    vector<ILayer*> layer_vector() const;
+    void track_activation_bytes();
     
 protected:
     DLinkedList<ILayer*> m_layers;
+    //activation checkpointing (see set_recompute)
+    int m_recompute_segment; //layers per segment, 0: disabled
+    int m_nFirst_Layer; //the first layer run by forward_from (1: the sparse input layer is apart)
+    vector<double_tensor> m_seg_inputs; //the inputs of the segments before the last one
+    size_t m_peak_act_bytes;
+    unsigned long long m_recomputed_layers, m_backward_steps;
+    //the Hogwild workers of the current fit (see build_async_workers)
+    struct AsyncWorker {
+        vector<ILayer*> layers;
+        vector<SGDParamGroup*> groups;
+        ILossLayer* pLoss;
+    };
+    vector<AsyncWorker> m_async_workers;
+    StripedLocks* m_pStripes; //nullptr: no stripes
+    PipelineSchedule* m_pPipeline; //the pipeline of the current fit (see build_pipeline)
     
 private:
 };
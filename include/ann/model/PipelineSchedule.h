@@ -0,0 +1,93 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.h to edit this template
+ */
+
+/*
+ * File:   PipelineSchedule.h
+ *
+ * Created on November 27, 2024, 9:30 AM
+ */
+
+#ifndef PIPELINESCHEDULE_H
+#define PIPELINESCHEDULE_H
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include "tensor/xtensor_lib.h"
+#include "layer/ILayer.h"
+#include "loss/ILossLayer.h"
+#include "metrics/IMetrics.h"
+#include "util/BoundedQueue.h"
+
+/*
+ * PipelineSchedule: pipeline-parallel training step (GPipe schedule) over a sequence of layers.
+ *  + the layers are cut into nstages contiguous stages of balanced cost (FC: Nin*Nout),
+ *      each stage is run by its own thread (stage 0: the calling thread); the threads of
+ *      the other stages and the queues are created by the first run and kept until the
+ *      schedule is deleted: a training step only wakes them up;
+ *  + run(X, t, nmicro): X is split into nmicro micro-batches; they flow stage to stage through
+ *      bounded queues: all the forwards (micro-batch 0 first), then all the backwards
+ *      (the last micro-batch first); a stage only touches its own layers, so the gradients
+ *      of each layer are accumulated over the micro-batches without locks;
+ *  + memory (re-materialization, as in GPipe): a stage keeps the input of each micro-batch,
+ *      its layers cache nothing in the forward phase; the backward of a micro-batch re-runs
+ *      the forward of the stage from its input first (the last micro-batch is not re-run);
+ *  + the loss layer (reduction: sum) and the metrics are used by the last stage only;
+ *      run returns the sum of the losses. zero_grad/normalize_grad/step: by the caller.
+ */
+class PipelineSchedule {
+public:
+    PipelineSchedule(vector<ILayer*> layers, int nstages);
+    PipelineSchedule(const PipelineSchedule& orig) = delete;
+    PipelineSchedule& operator=(const PipelineSchedule& orig) = delete;
+    virtual ~PipelineSchedule();
+
+    double run(const double_tensor& X, const double_tensor& t, int nmicro,
+               ILossLayer* pLossLayer, IMetrics* pMetricLayer);
+    int get_num_stages(){ return m_stages.size(); }
+    //begin of each stage (index in the layer sequence)
+    vector<int> get_boundaries(){ return m_boundaries; }
+    string get_desc();
+
+    static double layer_cost(ILayer* pLayer);
+
+protected:
+    void run_stage(int stage);
+    void stage_main(int stage);
+    void worker_loop(int stage);
+    double_tensor forward_stage(int stage, double_tensor X, bool cache);
+    void close_queues();
+
+private:
+    vector<vector<ILayer*>> m_stages;
+    vector<int> m_boundaries;
+    vector<double> m_costs;
+
+    //state of the current run
+    const double_tensor* m_pX;
+    const double_tensor* m_pT;
+    ILossLayer* m_pLossLayer;
+    IMetrics* m_pMetricLayer;
+    vector<size_t> m_micro_begin; //micro-batch m: rows [m_micro_begin[m], m_micro_begin[m + 1])
+    vector<unique_ptr<BoundedQueue<double_tensor>>> m_activations; //[s]: stage s-1 -> s
+    vector<unique_ptr<BoundedQueue<double_tensor>>> m_gradients; //[s]: stage s+1 -> s
+    vector<exception_ptr> m_errors; //[s]: thrown by stage s
+    double m_loss;
+
+    //the threads of stages 1..nstages-1: run m_generation is started when it changes
+    vector<thread> m_workers;
+    mutex m_mtx;
+    condition_variable m_cv_start, m_cv_done;
+    unsigned long long m_generation;
+    int m_nRunning; //stages of the current run not finished yet
+    bool m_bStop;
+};
+
+#endif /* PIPELINESCHEDULE_H */
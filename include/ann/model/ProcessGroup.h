@@ -0,0 +1,63 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.h to edit this template
+ */
+
+/*
+ * File:   ProcessGroup.h
+ *
+ * Created on November 28, 2024, 9:00 AM
+ */
+
+#ifndef PROCESSGROUP_H
+#define PROCESSGROUP_H
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+ * ProcessGroup: world_size processes (ranks) connected in a ring over TCP;
+ *  rank r listens on hosts[r]:base_port + r (that address only), sends to rank r+1 and
+ *  receives from rank r-1.
+ *  + hosts: a comma-separated list, one host per rank; a single host is used for all the
+ *      ranks (the default: 127.0.0.1, N processes on one machine);
+ *  + the constructor blocks until both neighbours are connected (or throws after timeout_s);
+ *  + every collective must be called by all the ranks, in the same order;
+ *  + from_env(): the group described by ANN_RANK, ANN_WORLD_SIZE, ANN_PORT (default 29500)
+ *      and ANN_HOSTS; nullptr if ANN_WORLD_SIZE is not set.
+ *
+ * Collectives (ring algorithms):
+ *  + allreduce_sum: reduce-scatter then all-gather, each rank sends 2*(N-1)/N of the data;
+ *      all the ranks get the same bits;
+ *  + broadcast: the data of root (bit for bit) on all the ranks, forwarded along the ring
+ *      in chunks; each rank but the last one sends the data once;
+ *  + allgather: the blob of each rank (any length), indexed by rank.
+ */
+class ProcessGroup {
+public:
+    ProcessGroup(int rank, int world_size, int base_port=29500,
+                 string hosts="127.0.0.1", int timeout_s=60);
+    ProcessGroup(const ProcessGroup& orig) = delete;
+    virtual ~ProcessGroup();
+    static ProcessGroup* from_env();
+
+    int rank(){ return m_nRank; }
+    int world_size(){ return m_nWorld; }
+    void allreduce_sum(double* data, size_t n);
+    void broadcast(double* data, size_t n, int root=0);
+    vector<vector<char>> allgather(const vector<char>& mine);
+    void barrier();
+    unsigned long long bytes_sent(){ return m_nBytes_Sent; }
+
+protected:
+    //sends nsend bytes to the next rank while receiving nrecv bytes from the previous one
+    void exchange(const void* send_buf, size_t nsend, void* recv_buf, size_t nrecv);
+
+private:
+    int m_nRank, m_nWorld;
+    int m_next_fd, m_prev_fd;
+    unsigned long long m_nBytes_Sent;
+    vector<double> m_recv_chunk;
+};
+
+#endif /* PROCESSGROUP_H */
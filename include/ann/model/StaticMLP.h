@@ -0,0 +1,580 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.h to edit this template
+ */
+
+/*
+ * File:   StaticMLP.h
+ *
+ * Created on November 23, 2024, 9:40 AM
+ */
+
+#ifndef STATICMLP_H
+#define STATICMLP_H
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include <filesystem> //require C++17
+namespace fs = std::filesystem;
+
+#include "tensor/xtensor_lib.h"
+#include "model/CheckpointWriter.h"
+#include "ann/functions.h"
+#include "sformat/fmt_lib.h"
+
+/*
+ * Layers of StaticMLP: the dimensions are template parameters, the parameters are std::array.
+ *  Every layer has:
+ *  + out_dim(in): the output width for the input width in (constexpr);
+ *  + forward<B, In>(X, Y): Y[B, out_dim(In)] from X[B, In];
+ *  + backward<B, In, NeedDX>(X, Y, DY, DX): DX[B, In] from DY[B, out_dim(In)], X and Y are the
+ *      cached input and output; learnable layers accumulate (+=) their gradients, like FCLayer;
+ *  + step(lr), zero_grad(): plain SGD, P -= lr*grad (the SGD optimizer);
+ *  + type_name(), desc(name), load(model_path, name), stage(ckpt, name): the checkpoint format
+ *      of MLPClassifier (arch.txt and <name>_W.npy/<name>_b.npy).
+ */
+struct StaticActivation{
+    static constexpr bool accepts(int in){ return in > 0; }
+    static constexpr int out_dim(int in){ return in; }
+    void step(double){}
+    void zero_grad(){}
+    void load(string, string){}
+    void stage(Checkpoint&, string) const{}
+};
+
+template<int Nin, int Nout, bool UseBias=true>
+class StaticFC{
+    static_assert((Nin > 0) && (Nout > 0), "StaticFC: Nin and Nout must be positive");
+public:
+    enum{ IN = Nin, OUT = Nout };
+    static constexpr bool accepts(int in){ return in == Nin; }
+    static constexpr int out_dim(int){ return Nout; }
+    static string type_name(){ return "FC"; }
+
+    StaticFC(){
+        init_weights();
+    }
+    //W ~ N(0, 1) from the xtensor random engine (FCLayer: from CounterRNG), b = 0
+    void init_weights(){
+        std::normal_distribution<double> normal(0.0, 1.0);
+        auto& engine = xt::random::get_default_random_engine();
+        for(int o=0; o < Nout; o++)
+            for(int i=0; i < Nin; i++) m_Wt[i*Nout + o] = normal(engine);
+        m_b.fill(0);
+        zero_grad();
+    }
+
+    //Y = X*W^T + b: y += x[i]*W^T[i, :], the inner loop runs over the outputs (independent sums)
+    template<int B, int In>
+    void forward(const double* X, double* Y) const{
+        for(int r=0; r < B; r++){
+            const double* x = X + r*Nin;
+            double acc[Nout]; //local: no aliasing with W, the loops below are vectorized
+            for(int o=0; o < Nout; o++) acc[o] = UseBias? m_b[o] : 0.0;
+            for(int i=0; i < Nin; i++){
+                const double* wt = m_Wt.data() + i*Nout;
+#pragma GCC unroll 64
+                for(int o=0; o < Nout; o++) acc[o] += x[i]*wt[o];
+            }
+            std::copy(acc, acc + Nout, Y + r*Nout);
+        }
+    }
+    //dW += DY^T*X, db += sum_rows(DY), DX = DY*W
+    template<int B, int In, bool NeedDX>
+    void backward(const double* X, const double*, const double* DY, double* DX){
+        for(int r=0; r < B; r++){
+            const double* x = X + r*Nin;
+            const double* dy = DY + r*Nout;
+            for(int i=0; i < Nin; i++){
+                double* gwt = m_gWt.data() + i*Nout;
+                for(int o=0; o < Nout; o++) gwt[o] += x[i]*dy[o];
+            }
+            if(UseBias) for(int o=0; o < Nout; o++) m_gb[o] += dy[o];
+        }
+        if(!NeedDX) return;
+        for(int r=0; r < B; r++){
+            const double* dy = DY + r*Nout;
+            double* dx = DX + r*Nin;
+            for(int i=0; i < Nin; i++) dx[i] = 0;
+            for(int o=0; o < Nout; o++)
+                for(int i=0; i < Nin; i++) dx[i] += dy[o]*m_Wt[i*Nout + o];
+        }
+    }
+    void step(double lr){
+        for(int idx=0; idx < Nout*Nin; idx++) m_Wt[idx] -= lr*m_gWt[idx];
+        if(UseBias) for(int o=0; o < Nout; o++) m_b[o] -= lr*m_gb[o];
+    }
+    void zero_grad(){
+        m_gWt.fill(0);
+        m_gb.fill(0);
+    }
+
+    string desc(string name) const{
+        return fmt::format("{:<10s}, {:<15s}: {:<4d}, {:<4d}, {:<4d}", "FC", name, Nin, Nout, UseBias);
+    }
+    /*
+     * load(model_path, name): <name>_W.npy must be [Nout, Nin], <name>_b.npy [Nout];
+     *  + a missing or mis-shaped weight file: exception (runtime_error);
+     *  + a missing bias file: the biases are 0 (like FCLayer).
+     */
+    void load(string model_path, string name){
+        string filename_w = model_path + "/" + name + "_W.npy";
+        string filename_b = model_path + "/" + name + "_b.npy";
+        if(!fs::exists(filename_w))
+            throw std::runtime_error(fmt::format("StaticFC: {:s}: not exist", filename_w));
+        double_tensor W = xt::load_npy<double>(filename_w);
+        bool valid = (W.dimension() == 2) && (W.shape()[0] == Nout) && (W.shape()[1] == Nin);
+        if(!valid)
+            throw std::runtime_error(fmt::format("StaticFC: {:s}: shape is not [{:d}, {:d}]", filename_w, Nout, Nin));
+        for(int o=0; o < Nout; o++)
+            for(int i=0; i < Nin; i++) m_Wt[i*Nout + o] = W(o, i);
+
+        m_b.fill(0);
+        if(UseBias){
+            if(!fs::exists(filename_b))
+                cerr << fmt::format("{:s}: not exist; so initialize biases with 0", filename_b) << endl;
+            else{
+                double_tensor b = xt::load_npy<double>(filename_b);
+                if((b.dimension() != 1) || (b.shape()[0] != Nout))
+                    throw std::runtime_error(fmt::format("StaticFC: {:s}: shape is not [{:d}]", filename_b, Nout));
+                std::copy(b.data(), b.data() + b.size(), m_b.begin());
+            }
+        }
+        zero_grad();
+    }
+    void stage(Checkpoint& ckpt, string name) const{
+        double_tensor W = empty_tensor({(size_t)Nout, (size_t)Nin});
+        for(int o=0; o < Nout; o++)
+            for(int i=0; i < Nin; i++) W(o, i) = m_Wt[i*Nout + o];
+        ckpt.add_tensor(name + "_W.npy", W);
+        if(UseBias){
+            double_tensor b = xt::adapt(m_b.data(), Nout, xt::no_ownership(), std::vector<size_t>{Nout});
+            ckpt.add_tensor(name + "_b.npy", b);
+        }
+    }
+
+private:
+    std::array<double, Nin*Nout> m_Wt; //Nin x Nout: W^T; W (Nout x Nin, as in FCLayer) in the .npy files
+    std::array<double, Nout> m_b;
+    std::array<double, Nin*Nout> m_gWt;
+    std::array<double, Nout> m_gb;
+};
+
+class StaticReLU: public StaticActivation{
+public:
+    static string type_name(){ return "ReLU"; }
+    template<int B, int In>
+    void forward(const double* X, double* Y) const{
+        for(int idx=0; idx < B*In; idx++) Y[idx] = (X[idx] > 0)? X[idx] : 0.0;
+    }
+    template<int B, int In, bool NeedDX>
+    void backward(const double* X, const double*, const double* DY, double* DX){
+        if(NeedDX) for(int idx=0; idx < B*In; idx++) DX[idx] = (X[idx] > 0)? DY[idx] : 0.0;
+    }
+    string desc(string name) const{ return fmt::format("{:<10s}, {:<15s}:", "ReLU", name); }
+};
+
+class StaticSigmoid: public StaticActivation{
+public:
+    static string type_name(){ return "Sigmoid"; }
+    template<int B, int In>
+    void forward(const double* X, double* Y) const{
+        for(int idx=0; idx < B*In; idx++) Y[idx] = 1.0/(1.0 + std::exp(-X[idx]));
+    }
+    template<int B, int In, bool NeedDX>
+    void backward(const double*, const double* Y, const double* DY, double* DX){
+        if(NeedDX) for(int idx=0; idx < B*In; idx++) DX[idx] = DY[idx]*Y[idx]*(1.0 - Y[idx]);
+    }
+    string desc(string name) const{ return fmt::format("{:<10s}, {:<15s}:", "Sigmoid", name); }
+};
+
+class StaticTanh: public StaticActivation{
+public:
+    static string type_name(){ return "Tanh"; }
+    template<int B, int In>
+    void forward(const double* X, double* Y) const{
+        for(int idx=0; idx < B*In; idx++) Y[idx] = std::tanh(X[idx]);
+    }
+    template<int B, int In, bool NeedDX>
+    void backward(const double*, const double* Y, const double* DY, double* DX){
+        if(NeedDX) for(int idx=0; idx < B*In; idx++) DX[idx] = DY[idx]*(1.0 - Y[idx]*Y[idx]);
+    }
+    string desc(string name) const{ return fmt::format("{:<10s}, {:<15s}:", "Tanh", name); }
+};
+
+//softmax along the last axis (axis = -1)
+class StaticSoftmax: public StaticActivation{
+public:
+    static string type_name(){ return "Softmax"; }
+    template<int B, int In>
+    void forward(const double* X, double* Y) const{
+        for(int r=0; r < B; r++){
+            const double* x = X + r*In;
+            double* y = Y + r*In;
+            double max = x[0];
+            for(int c=1; c < In; c++) max = (x[c] > max)? x[c] : max;
+            double sum = 0;
+            for(int c=0; c < In; c++){
+                y[c] = std::exp(x[c] - max);
+                sum += y[c];
+            }
+            for(int c=0; c < In; c++) y[c] /= sum;
+        }
+    }
+    //DX = Y*(DY - sum(DY*Y)), per row
+    template<int B, int In, bool NeedDX>
+    void backward(const double*, const double* Y, const double* DY, double* DX){
+        if(!NeedDX) return;
+        for(int r=0; r < B; r++){
+            const double* y = Y + r*In;
+            const double* dy = DY + r*In;
+            double dot = 0;
+            for(int c=0; c < In; c++) dot += dy[c]*y[c];
+            for(int c=0; c < In; c++) DX[r*In + c] = y[c]*(dy[c] - dot);
+        }
+    }
+    string desc(string name) const{ return fmt::format("{:<10s}, {:<15s}: {:4d}", "Softmax", name, -1); }
+};
+
+/*
+ * StaticChain<Layers...>: the widths of a chain of static layers, computed at compile time
+ *  + dims()[L]: the input width of layer L, dims()[NLAYERS]: the output width;
+ *  + offset(L): sum(dims()[0..L)), the position of the activation L in a Workspace.
+ */
+template<class... Layers>
+struct StaticChain{
+    enum{ NLAYERS = sizeof...(Layers) };
+    typedef typename std::tuple_element<0, std::tuple<Layers...>>::type First;
+
+    static constexpr std::array<int, NLAYERS + 1> dims(){
+        std::array<int, NLAYERS + 1> dims{};
+        dims[0] = First::IN;
+        int idx = 0;
+        ((dims[idx + 1] = Layers::out_dim(dims[idx]), idx++), ...);
+        return dims;
+    }
+    static constexpr bool valid(){
+        std::array<int, NLAYERS + 1> in = dims();
+        int idx = 0;
+        bool valid = true;
+        ((valid = valid && Layers::accepts(in[idx]), idx++), ...);
+        return valid;
+    }
+    static constexpr int offset(int L){
+        std::array<int, NLAYERS + 1> in = dims();
+        int sum = 0;
+        for(int idx=0; idx < L; idx++) sum += in[idx];
+        return sum;
+    }
+    static constexpr int max_dim(){
+        std::array<int, NLAYERS + 1> in = dims();
+        int max = 0;
+        for(int idx=0; idx <= NLAYERS; idx++) max = (in[idx] > max)? in[idx] : max;
+        return max;
+    }
+};
+
+/*
+ * StaticMLP<Layers...>: an MLP whose architecture is fixed at compile time, e.g. the model of
+ *  twoclasses.h:
+ *      StaticMLP<StaticFC<2, 50>, StaticReLU, StaticFC<50, 20>, StaticReLU,
+ *                StaticFC<20, 2>, StaticSoftmax> model;
+ *  + the first layer must be a StaticFC (it gives the input width); the widths of the other
+ *      layers are checked at compile time;
+ *  + the layers are a std::tuple and the chain is unrolled by templates: no ILayer, no virtual
+ *      call, all the loops have compile-time bounds;
+ *  + the activations and the gradients of a batch of B samples live in a Workspace<B>
+ *      (std::array, sized at compile time): predict/forward/train_step do not allocate;
+ *  + load/save use the checkpoint format of MLPClassifier: a folder saved by MLPClassifier
+ *      (arch.txt, <name>_W.npy, <name>_b.npy) is loaded into the StaticMLP of the same
+ *      architecture, and the other way round.
+ *  + memory: the model holds its parameters and their gradients inline (2*(Nin + 1)*Nout
+ *      doubles per StaticFC) and a Workspace<B> holds B*(ACT_SIZE + 2*MAX_DIM) doubles; beyond
+ *      a few hundred KB, create the model and the workspaces on the heap (new, make_unique),
+ *      not on the stack. predict(X, nsamples, Y) and predict_class allocate their workspace
+ *      on the heap; predict(x) keeps a Workspace<1> on the stack.
+ */
+template<class... Layers>
+class StaticMLP{
+    static_assert(sizeof...(Layers) > 0, "StaticMLP: at least one layer");
+public:
+    enum{ NLAYERS = sizeof...(Layers) };
+    typedef std::tuple<Layers...> LayerTuple;
+    template<int L> using Layer = typename std::tuple_element<L, LayerTuple>::type;
+
+    typedef StaticChain<Layers...> Chain;
+    static constexpr std::array<int, NLAYERS + 1> DIMS = Chain::dims();
+    static_assert(Chain::valid(), "StaticMLP: the output width of a layer is not the input width of the next one");
+    enum{ IN = DIMS[0], OUT = DIMS[NLAYERS], MAX_DIM = Chain::max_dim(), ACT_SIZE = Chain::offset(NLAYERS + 1) };
+
+    /*
+     * Workspace<B>: buffers of a batch of B samples
+     *  + act: the input and the output of every layer, [B, DIMS[L]] at offset B*sum(DIMS[0..L));
+     *      the backward pass reads the cached inputs/outputs from here;
+     *  + grad: two [B, MAX_DIM] buffers, DY and DX of the backward pass.
+     */
+    template<int B>
+    struct Workspace{
+        static_assert(B > 0, "StaticMLP::Workspace: B must be positive");
+        std::array<double, B*ACT_SIZE> act;
+        std::array<double, B*MAX_DIM> grad[2];
+
+        double* activation(int L){ return act.data() + B*offset(L); }
+        double* output(){ return activation(NLAYERS); }
+    };
+
+    StaticMLP(string sModelName="StaticMLP"): m_sModelName(sModelName){}
+
+    LayerTuple& layers(){ return m_layers; }
+    string get_name(){ return m_sModelName; }
+
+    /*
+     * forward<B>(ws, X): X is [B, IN] (row-major); returns the output [B, OUT] (in ws).
+     */
+    template<int B>
+    const double* forward(Workspace<B>& ws, const double* X) const{
+        std::copy(X, X + B*IN, ws.act.data());
+        forward_from<0, B>(ws);
+        return ws.output();
+    }
+
+    //predict(x): the output of one sample, on the stack
+    std::array<double, OUT> predict(const std::array<double, IN>& x) const{
+        Workspace<1> ws;
+        forward(ws, x.data());
+        std::array<double, OUT> y;
+        std::copy(ws.output(), ws.output() + OUT, y.begin());
+        return y;
+    }
+    //predict(X, nsamples, Y): Y [nsamples, OUT] from X [nsamples, IN], B samples at a time
+    template<int B=16>
+    void predict(const double* X, size_t nsamples, double* Y) const{
+        std::unique_ptr<Workspace<B>> pWs(new Workspace<B>());
+        Workspace<B>& ws = *pWs;
+        size_t row = 0;
+        for(; row + B <= nsamples; row += B){
+            forward(ws, X + row*IN);
+            std::copy(ws.output(), ws.output() + B*OUT, Y + row*OUT);
+        }
+        Workspace<1> ws1;
+        for(; row < nsamples; row++){
+            forward(ws1, X + row*IN);
+            std::copy(ws1.output(), ws1.output() + OUT, Y + row*OUT);
+        }
+    }
+    //predict_class(X, nsamples, labels): arg-max of the outputs
+    template<int B=16>
+    void predict_class(const double* X, size_t nsamples, ulong* labels) const{
+        std::unique_ptr<Workspace<B>> pWs(new Workspace<B>());
+        Workspace<B>& ws = *pWs;
+        size_t row = 0;
+        for(; row < nsamples; row += B){
+            size_t nrows = (row + B <= nsamples)? B : nsamples - row;
+            if(nrows == B) forward(ws, X + row*IN);
+            else{
+                std::copy(X + row*IN, X + (row + nrows)*IN, ws.act.data());
+                std::fill(ws.act.data() + nrows*IN, ws.act.data() + B*IN, 0.0);
+                forward_from<0, B>(ws);
+            }
+            for(size_t r=0; r < nrows; r++){
+                const double* y = ws.output() + r*OUT;
+                labels[row + r] = std::max_element(y, y + OUT) - y;
+            }
+        }
+    }
+
+    /*
+     * train_step<B>(ws, X, labels, lr): one SGD step on a batch of B samples
+     *  + the loss is the mean cross entropy of the output (the output layer is expected to be
+     *      a StaticSoftmax) and the class labels [B] (or the one-hot targets [B, OUT]);
+     *  + the gradient of the loss is the one of CrossEntropy: -(t/(y + 1e-7))/B;
+     *  + a label out of [0, OUT): exception (out_of_range), before anything is changed;
+     *  + returns the loss of the batch.
+     */
+    template<int B>
+    double train_step(Workspace<B>& ws, const double* X, const ulong* labels, double lr){
+        for(int r=0; r < B; r++){
+            if(labels[r] >= (ulong)OUT)
+                throw std::out_of_range(fmt::format("StaticMLP::train_step: label {:d} of sample {:d} is not a class index in [0, {:d})",
+                        labels[r], r, (int)OUT));
+        }
+        forward(ws, X);
+        const double* y = ws.output();
+        double* dy = ws.grad[0].data();
+        double loss = 0;
+        for(int idx=0; idx < B*OUT; idx++) dy[idx] = 0;
+        for(int r=0; r < B; r++){
+            ulong c = labels[r];
+            loss -= std::log(y[r*OUT + c] + EPSILON);
+            dy[r*OUT + c] = -(1.0/(y[r*OUT + c] + EPSILON))/B;
+        }
+        update(ws, lr);
+        return loss/B;
+    }
+    template<int B>
+    double train_step(Workspace<B>& ws, const double* X, const double* T, double lr){
+        forward(ws, X);
+        const double* y = ws.output();
+        double* dy = ws.grad[0].data();
+        double loss = 0;
+        for(int idx=0; idx < B*OUT; idx++){
+            if(T[idx] != 0) loss -= T[idx]*std::log(y[idx] + EPSILON);
+            dy[idx] = -(T[idx]/(y[idx] + EPSILON))/B;
+        }
+        update(ws, lr);
+        return loss/B;
+    }
+
+    /*
+     * load(model_path): reads model_path/arch.txt (as MLPClassifier::load)
+     *  + the layer types in arch.txt must be the ones of Layers..., else: exception;
+     *  + each layer loads its parameters with the layer name in arch.txt;
+     *      without arch.txt, the names are <type>_<position> (the default names of MLPClassifier).
+     */
+    bool load(string model_path){
+        try{
+            model_path = CheckpointWriter::resolve(model_path);
+            if(!fs::exists(model_path)){
+                cerr << fmt::format("{:s}: not exist.", model_path) << endl;
+                return false;
+            }
+            vector<string> names = layer_names();
+            string arch_file = model_path + "/" + "arch.txt";
+            ifstream datastream(arch_file);
+            if(datastream.is_open()){
+                vector<string> types = layer_types();
+                int count = 0;
+                string line;
+                while(getline(datastream, line)){
+                    line = trim(line);
+                    if((line.size() == 0) || (line[0] == '#')) continue;
+                    if(line.compare(0, 11, "model name:") == 0) continue;
+
+                    istringstream linestream(line);
+                    string first, type, name;
+                    getline(linestream, first, ':');
+                    istringstream partstream(first);
+                    getline(partstream, type, ',');
+                    getline(partstream, name, ',');
+                    type = trim(type);
+                    name = trim(name);
+                    if((count >= NLAYERS) || (type != types[count])){
+                        string message = fmt::format("{:s}: layer {:d} is \"{:s}\", expected \"{:s}\"",
+                                arch_file, count + 1, type, (count < NLAYERS)? types[count] : string("<none>"));
+                        throw std::runtime_error(message);
+                    }
+                    names[count++] = name;
+                }
+                if(count != NLAYERS)
+                    throw std::runtime_error(fmt::format("{:s}: {:d} layers, expected {:d}", arch_file, count, (int)NLAYERS));
+            }
+            load_layers<0>(model_path, names);
+            return true;
+        }
+        catch(exception& e){
+            cerr << fmt::format("StaticMLP::load: failed; model_path={:s}", model_path) << endl;
+            cerr << e.what() << endl;
+            return false;
+        }
+    }
+    bool save(string model_path){
+        try{
+            Checkpoint ckpt;
+            ckpt.add_arch("model name: " + m_sModelName);
+            stage_layers<0>(ckpt, layer_names());
+            return CheckpointWriter::commit(ckpt, model_path);
+        }
+        catch(exception& e){
+            cerr << fmt::format("StaticMLP::save: failed; model_path={:s}", model_path) << endl;
+            cerr << e.what() << endl;
+            return false;
+        }
+    }
+
+    string toString(){
+        stringstream os;
+        os << "model name: " << m_sModelName << endl;
+        vector<string> names = layer_names();
+        describe<0>(os, names);
+        return os.str();
+    }
+
+private:
+    static constexpr double EPSILON = 1e-7;
+
+    static constexpr int offset(int L){ return Chain::offset(L); }
+
+    template<int L, int B>
+    void forward_from(Workspace<B>& ws) const{
+        if constexpr(L < NLAYERS){
+            std::get<L>(m_layers).template forward<B, DIMS[L]>(
+                    ws.act.data() + B*offset(L), ws.act.data() + B*offset(L + 1));
+            forward_from<L + 1, B>(ws);
+        }
+    }
+    //the gradient of layer L's output is in ws.grad[(NLAYERS - 1 - L) % 2]
+    template<int L, int B>
+    void backward_from(Workspace<B>& ws){
+        if constexpr(L >= 0){
+            double* dy = ws.grad[(NLAYERS - 1 - L) % 2].data();
+            double* dx = ws.grad[(NLAYERS - L) % 2].data();
+            std::get<L>(m_layers).template backward<B, DIMS[L], (L > 0)>(
+                    ws.act.data() + B*offset(L), ws.act.data() + B*offset(L + 1), dy, dx);
+            backward_from<L - 1, B>(ws);
+        }
+    }
+    template<int B>
+    void update(Workspace<B>& ws, double lr){
+        std::apply([](auto&... layer){ (layer.zero_grad(), ...); }, m_layers);
+        backward_from<NLAYERS - 1, B>(ws);
+        std::apply([lr](auto&... layer){ (layer.step(lr), ...); }, m_layers);
+    }
+
+    static vector<string> layer_types(){
+        return vector<string>{Layers::type_name()...};
+    }
+    static vector<string> layer_names(){
+        vector<string> names = layer_types();
+        for(size_t idx=0; idx < names.size(); idx++) names[idx] += "_" + to_string(idx + 1);
+        return names;
+    }
+    template<int L>
+    void load_layers(string model_path, const vector<string>& names){
+        if constexpr(L < NLAYERS){
+            std::get<L>(m_layers).load(model_path, names[L]);
+            load_layers<L + 1>(model_path, names);
+        }
+    }
+    template<int L>
+    void stage_layers(Checkpoint& ckpt, const vector<string>& names) const{
+        if constexpr(L < NLAYERS){
+            ckpt.add_arch(std::get<L>(m_layers).desc(names[L]));
+            std::get<L>(m_layers).stage(ckpt, names[L]);
+            stage_layers<L + 1>(ckpt, names);
+        }
+    }
+    template<int L>
+    void describe(ostream& os, const vector<string>& names) const{
+        if constexpr(L < NLAYERS){
+            os << std::get<L>(m_layers).desc(names[L]) << endl;
+            describe<L + 1>(os, names);
+        }
+    }
+
+private:
+    string m_sModelName;
+    LayerTuple m_layers;
+};
+
+#endif /* STATICMLP_H */
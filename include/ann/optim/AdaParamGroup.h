@@ -20,15 +20,19 @@ public:
     AdaParamGroup(const AdaParamGroup& orig);
     virtual ~AdaParamGroup();
     
-    void register_param(string param_name, xt::xarray<double>* ptr_param, xt::xarray<double>* ptr_grad); //override
+    void register_param(string param_name, double_tensor* ptr_param, double_tensor* ptr_grad); //override
+    void register_sparse_param(string param_name, double_tensor* ptr_param, SparseRowGrad* ptr_grad);
     void register_sample_count(unsigned long long* pCounter);
     void zero_grad();
     void step(double lr);
+    void normalize_grad();
 
 protected:
-    xmap<string, xt::xarray<double>*>* m_pParams;
-    xmap<string, xt::xarray<double>*>* m_pGrads;
-    xmap<string, xt::xarray<double>*>* m_pSquaredGrads;
+    xmap<string, double_tensor*>* m_pParams;
+    xmap<string, double_tensor*>* m_pGrads;
+    xmap<string, double_tensor*>* m_pSparseParams;
+    xmap<string, SparseRowGrad*>* m_pSparseGrads;
+    xmap<string, double_tensor*>* m_pSquaredGrads;
     unsigned long long* m_pCounter;
     double m_decay;
 private:
@@ -27,7 +27,9 @@ public:
     virtual int num_group(){return m_pGroupMap->size(); }
     virtual void zero_grad();
     virtual void step();
+    virtual void normalize_grad();
     virtual IParamGroup* create_group(string name)=0;
+    double get_learning_rate(){ return m_fLearningRate; }
 
 protected:
     double m_fLearningRate;
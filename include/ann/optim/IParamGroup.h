@@ -17,16 +17,25 @@
 #include <string>
 using namespace std;
 #include "dsaheader.h"
+#include "optim/SparseRowGrad.h"
 
 class IParamGroup {
 public:
     IParamGroup(){};
     IParamGroup(const IParamGroup& orig){};
     virtual ~IParamGroup(){};
-    virtual void register_param(string param_name, xt::xarray<double>* ptr_param, xt::xarray<double>* ptr_grad)=0;
+    virtual void register_param(string param_name, double_tensor* ptr_param, double_tensor* ptr_grad)=0;
+    /* register_sparse_param: a [nrows, ncols] parameter with a row-sparse gradient (Embedding);
+     *  zero_grad/step/normalize_grad only touch the rows listed in *ptr_grad.
+     */
+    virtual void register_sparse_param(string param_name, double_tensor* ptr_param, SparseRowGrad* ptr_grad)=0;
     virtual void register_sample_count(unsigned long long* pCounter)=0;
     virtual void zero_grad()=0;
     virtual void step(double lr)=0;
+    /* normalize_grad: grad := grad/(*counter), counter: the registered sample counter;
+     *  used after accumulating sum-reduced gradients over micro-batches.
+     */
+    virtual void normalize_grad()=0;
 private:
 
 };
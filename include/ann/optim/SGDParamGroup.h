@@ -13,6 +13,25 @@
 #ifndef SGDPARAMGROUP_H
 #define SGDPARAMGROUP_H
 #include "optim/IParamGroup.h"
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/*
+ * StripedLocks: nlocks mutexes shared by the param groups of the Hogwild workers (see
+ *  IModel::set_hogwild); stripe s of a tensor is guarded by lock (hash(tensor) + s) % nlocks,
+ *  so two workers never update the same stripe at the same time.
+ */
+class StripedLocks {
+public:
+    StripedLocks(size_t nlocks): m_locks(max((size_t)1, nlocks)){}
+    size_t size(){ return m_locks.size(); }
+    std::mutex& get(const void* tensor, size_t stripe){
+        return m_locks[(std::hash<const void*>()(tensor) + stripe) % m_locks.size()];
+    }
+private:
+    std::vector<std::mutex> m_locks;
+};
 
 class SGDParamGroup: public IParamGroup {
 public:
@@ -20,15 +39,24 @@ public:
     SGDParamGroup(const SGDParamGroup& orig);
     virtual ~SGDParamGroup();
 
-    void register_param(string param_name, xt::xarray<double>* ptr_param, xt::xarray<double>* ptr_grad); //override
+    void register_param(string param_name, double_tensor* ptr_param, double_tensor* ptr_grad); //override
+    void register_sparse_param(string param_name, double_tensor* ptr_param, SparseRowGrad* ptr_grad);
     void register_sample_count(unsigned long long* pCounter);
     void zero_grad();
     void step(double lr);
+    void normalize_grad();
+    /* set_stripes: step updates each tensor stripe by stripe (pLocks->size() stripes),
+     *  under the lock of the stripe; nullptr (the default): lock-free updates
+     */
+    void set_stripes(StripedLocks* pLocks){ m_pStripes = pLocks; }
     
 protected:
-    xmap<string, xt::xarray<double>*>* m_pParams;
-    xmap<string, xt::xarray<double>*>* m_pGrads;
+    xmap<string, double_tensor*>* m_pParams;
+    xmap<string, double_tensor*>* m_pGrads;
+    xmap<string, double_tensor*>* m_pSparseParams;
+    xmap<string, SparseRowGrad*>* m_pSparseGrads;
     unsigned long long* m_pCounter;
+    StripedLocks* m_pStripes;
     
 private:
 };
@@ -0,0 +1,72 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.h to edit this template
+ */
+
+/*
+ * File:   SparseRowGrad.h
+ *
+ * Created on November 24, 2024, 9:20 AM
+ */
+
+#ifndef SPARSEROWGRAD_H
+#define SPARSEROWGRAD_H
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+/*
+ * SparseRowGrad: the gradient of a [nrows, ncols] parameter (an embedding table) that is
+ *  non-zero on a few rows only; it is kept as a list of (row-id, gradient row) pairs.
+ *  + row(r): the gradient row of r, appended (zero) the first time r is seen;
+ *      gradients are accumulated (+=) into it, across micro-batches, until clear();
+ *  + size(): the number of rows in the list; row_id(k), values(k): the k-th pair;
+ *  + clear(), scale(): O(size()*ncols); the table height only sizes the row -> slot index,
+ *      which is allocated once (resize) and reset entry by entry.
+ */
+class SparseRowGrad{
+public:
+    SparseRowGrad(): m_nRows(0), m_nCols(0){}
+
+    void resize(size_t nrows, size_t ncols){
+        m_nRows = nrows;
+        m_nCols = ncols;
+        m_rows.clear();
+        m_values.clear();
+        m_slots.assign(nrows, -1);
+    }
+    double* row(size_t r){
+        long slot = m_slots[r];
+        if(slot < 0){
+            slot = m_rows.size();
+            m_slots[r] = slot;
+            m_rows.push_back(r);
+            m_values.resize(m_values.size() + m_nCols, 0.0);
+        }
+        return m_values.data() + slot*m_nCols;
+    }
+    void clear(){
+        for(size_t r: m_rows) m_slots[r] = -1;
+        m_rows.clear();
+        m_values.clear();
+    }
+    void scale(double factor){
+        for(double& v: m_values) v *= factor;
+    }
+
+    size_t size() const { return m_rows.size(); }
+    size_t nrows() const { return m_nRows; }
+    size_t ncols() const { return m_nCols; }
+    size_t row_id(size_t k) const { return m_rows[k]; }
+    double* values(size_t k){ return m_values.data() + k*m_nCols; }
+    const double* values(size_t k) const { return m_values.data() + k*m_nCols; }
+
+private:
+    size_t m_nRows, m_nCols;
+    vector<size_t> m_rows;
+    vector<double> m_values; //size() x ncols
+    vector<long> m_slots; //row-id -> position in m_rows, -1: no gradient
+};
+
+#endif /* SPARSEROWGRAD_H */
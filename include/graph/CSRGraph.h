@@ -0,0 +1,244 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   CSRGraph.h
+ *
+ * Created on November 20, 2024, 9:30 AM
+ */
+
+#ifndef CSRGRAPH_H
+#define CSRGRAPH_H
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "graph/IGraph.h"
+#include "hash/xMap.h"
+#include "util/ThreadPool.h"
+using namespace std;
+
+/*
+ * CSRGraph: an immutable snapshot of a directed IGraph in compressed sparse row form.
+ *  + vertices get dense ids 0..n-1, in the order of pGraph->vertices(); vertex(id) and
+ *      index_of(vertex) convert between the two;
+ *  + out-edges of u: out_targets/out_weights[out_offsets[u] .. out_offsets[u+1]);
+ *  + in-edges of v: in_sources/in_weights[in_offsets[v] .. in_offsets[v+1]), built by
+ *      transposing the out-edges (getInwardEdges is not called);
+ *  + freeze(pGraph, hashCode, vertexEQ) reads the graph once; the snapshot does not follow
+ *      later changes of the graph.
+ *
+ * Algorithms (on the thread pool, see util/ThreadPool.h):
+ *  + bfs(source): hop distance of every vertex from source (-1: unreachable);
+ *      level-synchronous, the vertices of a frontier are expanded in parallel and claimed by CAS;
+ *  + connected_components(): component id of every vertex (the smallest vertex id in the
+ *      component), edges taken as undirected (weakly connected components);
+ *      lock-free union-find, the edges are processed in parallel;
+ *  + topological_sort(): vertex ids in a topological order (Kahn, one frontier at a time,
+ *      in-degrees decremented atomically; each frontier is sorted so that the order is
+ *      deterministic); throws std::runtime_error if the graph has a cycle.
+ */
+template<class T>
+class CSRGraph{
+public:
+    static CSRGraph<T>* freeze(IGraph<T>* pGraph, int (*hashCode)(T&, int), bool (*vertexEQ)(T&, T&)=0){
+        CSRGraph<T>* pCSR = new CSRGraph<T>(hashCode, vertexEQ);
+        DLinkedList<T> vertices = pGraph->vertices();
+        for(auto vertex: vertices){
+            pCSR->m_pIndex->put(vertex, pCSR->m_vertices.size());
+            pCSR->m_vertices.push_back(vertex);
+        }
+        int nvertices = pCSR->m_vertices.size();
+        pCSR->m_out_offsets.assign(nvertices + 1, 0);
+        for(int u=0; u < nvertices; u++){
+            DLinkedList<T> neighbors = pGraph->getOutwardEdges(pCSR->m_vertices[u]);
+            for(auto to: neighbors){
+                pCSR->m_out_targets.push_back(pCSR->m_pIndex->get(to));
+                pCSR->m_out_weights.push_back(pGraph->weight(pCSR->m_vertices[u], to));
+            }
+            pCSR->m_out_offsets[u + 1] = pCSR->m_out_targets.size();
+        }
+        pCSR->build_inward();
+        return pCSR;
+    }
+
+    CSRGraph(const CSRGraph<T>& graph) = delete;
+    CSRGraph<T>& operator=(const CSRGraph<T>& graph) = delete;
+    ~CSRGraph(){
+        delete m_pIndex;
+    }
+
+    int size(){ return m_vertices.size(); }
+    long edges(){ return m_out_targets.size(); }
+    T& vertex(int id){ return m_vertices[id]; }
+    int index_of(T vertex){
+        if(!m_pIndex->containsKey(vertex)) throw VertexNotFoundException("vertex");
+        return m_pIndex->get(vertex);
+    }
+    int outDegree(int u){ return m_out_offsets[u + 1] - m_out_offsets[u]; }
+    int inDegree(int v){ return m_in_offsets[v + 1] - m_in_offsets[v]; }
+
+    const int* out_offsets(){ return m_out_offsets.data(); }
+    const int* out_targets(){ return m_out_targets.data(); }
+    const float* out_weights(){ return m_out_weights.data(); }
+    const int* in_offsets(){ return m_in_offsets.data(); }
+    const int* in_sources(){ return m_in_sources.data(); }
+    const float* in_weights(){ return m_in_weights.data(); }
+
+    vector<int> bfs(int source){
+        int nvertices = size();
+        if((source < 0) || (source >= nvertices)) throw VertexNotFoundException("source");
+        unique_ptr<atomic<int>[]> level(new atomic<int>[nvertices]);
+        parallel_for(nvertices, [&](size_t begin, size_t end){
+            for(size_t v=begin; v < end; v++) level[v].store(-1, memory_order_relaxed);
+        });
+        level[source].store(0, memory_order_relaxed);
+
+        vector<int> frontier(1, source);
+        const int* offsets = m_out_offsets.data();
+        const int* targets = m_out_targets.data();
+        size_t avg_degree = 1 + m_out_targets.size()/max(1, nvertices);
+        for(int depth=1; !frontier.empty(); depth++){
+            //each chunk of the frontier collects the vertices it claimed; chunks are joined in order
+            vector<int> next = parallel_reduce(frontier.size(), vector<int>(),
+                [&](size_t begin, size_t end){
+                    vector<int> claimed;
+                    for(size_t idx=begin; idx < end; idx++){
+                        int u = frontier[idx];
+                        for(int e=offsets[u]; e < offsets[u + 1]; e++){
+                            int v = targets[e];
+                            int unvisited = -1;
+                            if((level[v].load(memory_order_relaxed) == -1) &&
+                               level[v].compare_exchange_strong(unvisited, depth, memory_order_relaxed))
+                                claimed.push_back(v);
+                        }
+                    }
+                    return claimed;
+                },
+                [](vector<int> a, const vector<int>& b){
+                    a.insert(a.end(), b.begin(), b.end());
+                    return a;
+                }, avg_degree);
+            frontier.swap(next);
+        }
+
+        vector<int> result(nvertices);
+        for(int v=0; v < nvertices; v++) result[v] = level[v].load(memory_order_relaxed);
+        return result;
+    }
+
+    vector<int> connected_components(){
+        int nvertices = size();
+        unique_ptr<atomic<int>[]> parent(new atomic<int>[nvertices]);
+        parallel_for(nvertices, [&](size_t begin, size_t end){
+            for(size_t v=begin; v < end; v++) parent[v].store(v, memory_order_relaxed);
+        });
+
+        const int* offsets = m_out_offsets.data();
+        const int* targets = m_out_targets.data();
+        size_t avg_degree = 1 + m_out_targets.size()/max(1, nvertices);
+        parallel_for(nvertices, [&](size_t begin, size_t end){
+            for(size_t u=begin; u < end; u++)
+                for(int e=offsets[u]; e < offsets[u + 1]; e++) unite(parent.get(), u, targets[e]);
+        }, avg_degree);
+
+        vector<int> component(nvertices);
+        parallel_for(nvertices, [&](size_t begin, size_t end){
+            for(size_t v=begin; v < end; v++) component[v] = find(parent.get(), v);
+        });
+        return component;
+    }
+
+    vector<int> topological_sort(){
+        int nvertices = size();
+        unique_ptr<atomic<int>[]> indegree(new atomic<int>[nvertices]);
+        vector<int> frontier;
+        for(int v=0; v < nvertices; v++){
+            indegree[v].store(inDegree(v), memory_order_relaxed);
+            if(inDegree(v) == 0) frontier.push_back(v);
+        }
+
+        const int* offsets = m_out_offsets.data();
+        const int* targets = m_out_targets.data();
+        size_t avg_degree = 1 + m_out_targets.size()/max(1, nvertices);
+        vector<int> order;
+        order.reserve(nvertices);
+        while(!frontier.empty()){
+            order.insert(order.end(), frontier.begin(), frontier.end());
+            vector<int> next = parallel_reduce(frontier.size(), vector<int>(),
+                [&](size_t begin, size_t end){
+                    vector<int> ready;
+                    for(size_t idx=begin; idx < end; idx++){
+                        int u = frontier[idx];
+                        for(int e=offsets[u]; e < offsets[u + 1]; e++)
+                            if(indegree[targets[e]].fetch_sub(1, memory_order_acq_rel) == 1) ready.push_back(targets[e]);
+                    }
+                    return ready;
+                },
+                [](vector<int> a, const vector<int>& b){
+                    a.insert(a.end(), b.begin(), b.end());
+                    return a;
+                }, avg_degree);
+            std::sort(next.begin(), next.end());
+            frontier.swap(next);
+        }
+        if((int)order.size() != nvertices) throw std::runtime_error("CSRGraph: the graph has a cycle, no topological order");
+        return order;
+    }
+
+private:
+    CSRGraph(int (*hashCode)(T&, int), bool (*vertexEQ)(T&, T&)){
+        m_pIndex = new xMap<T, int>(hashCode, 0.75f, 0, 0, vertexEQ);
+    }
+
+    //in-edges: counting sort of the out-edges by target
+    void build_inward(){
+        int nvertices = size();
+        m_in_offsets.assign(nvertices + 1, 0);
+        for(int target: m_out_targets) m_in_offsets[target + 1]++;
+        for(int v=0; v < nvertices; v++) m_in_offsets[v + 1] += m_in_offsets[v];
+        m_in_sources.resize(m_out_targets.size());
+        m_in_weights.resize(m_out_targets.size());
+        vector<int> cursor(m_in_offsets.begin(), m_in_offsets.end() - 1);
+        for(int u=0; u < nvertices; u++)
+            for(int e=m_out_offsets[u]; e < m_out_offsets[u + 1]; e++){
+                int pos = cursor[m_out_targets[e]]++;
+                m_in_sources[pos] = u;
+                m_in_weights[pos] = m_out_weights[e];
+            }
+    }
+
+    //union-find: a root always links to a smaller root, so the final root is the smallest id
+    static int find(atomic<int>* parent, int v){
+        while(true){
+            int p = parent[v].load(memory_order_relaxed);
+            if(p == v) return v;
+            int gp = parent[p].load(memory_order_relaxed);
+            if(gp != p) parent[v].compare_exchange_weak(p, gp, memory_order_relaxed); //path halving
+            v = gp;
+        }
+    }
+    static void unite(atomic<int>* parent, int u, int v){
+        while(true){
+            u = find(parent, u);
+            v = find(parent, v);
+            if(u == v) return;
+            if(u < v) std::swap(u, v);
+            int expected = u;
+            if(parent[u].compare_exchange_strong(expected, v, memory_order_relaxed)) return;
+        }
+    }
+
+private:
+    xMap<T, int>* m_pIndex;
+    vector<T> m_vertices;
+    vector<int> m_out_offsets, m_out_targets;
+    vector<float> m_out_weights;
+    vector<int> m_in_offsets, m_in_sources;
+    vector<float> m_in_weights;
+};
+
+#endif /* CSRGRAPH_H */
@@ -0,0 +1,146 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   DijkstraFinder.h
+ *
+ * Created on November 18, 2024, 2:40 PM
+ */
+
+#ifndef DIJKSTRAFINDER_H
+#define DIJKSTRAFINDER_H
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "graph/IGraph.h"
+#include "graph/CSRGraph.h"
+#include "heap/IndexedHeap.h"
+using namespace std;
+
+/*
+ * DijkstraFinder: single-source shortest paths (non-negative weights).
+ *  + compile(pGraph): freezes the graph into a CSRGraph (see graph/CSRGraph.h);
+ *      the graph is read once through IGraph (getOutwardEdges, weight).
+ *  + search(start): Dijkstra on the arrays with an IndexedHeap (4-ary, decrease-key);
+ *      then cost(v) and path(v) answer the queries for start.
+ *  + dijkstra(pGraph, start): compiles pGraph if it is not the compiled graph, searches,
+ *      and returns the paths to all the vertices reachable from start.
+ *  + compile again after changing the graph: the arrays are a snapshot.
+ *
+ * hashCode/vertexEQ: used to map vertices to their ids (as in xMap).
+ */
+template<class T>
+class DijkstraFinder: public IFinder<T>{
+public:
+    DijkstraFinder(int (*hashCode)(T&, int), bool (*vertexEQ)(T&, T&)=0){
+        this->hashCode = hashCode;
+        this->vertexEQ = vertexEQ;
+        m_pCSR = nullptr;
+        m_pGraph = nullptr;
+        m_source = -1;
+    }
+    DijkstraFinder(const DijkstraFinder<T>& finder) = delete;
+    DijkstraFinder<T>& operator=(const DijkstraFinder<T>& finder) = delete;
+    ~DijkstraFinder(){
+        if(m_pCSR != nullptr) delete m_pCSR;
+    }
+
+    void compile(IGraph<T>* pGraph){
+        CSRGraph<T>* pCSR = CSRGraph<T>::freeze(pGraph, hashCode, vertexEQ);
+        const float* weights = pCSR->out_weights();
+        for(long e=0; e < pCSR->edges(); e++)
+            if(weights[e] < 0){
+                delete pCSR;
+                throw std::invalid_argument("DijkstraFinder: negative edge weight");
+            }
+        if(m_pCSR != nullptr) delete m_pCSR;
+        m_pCSR = pCSR;
+        m_pGraph = pGraph;
+        m_source = -1;
+    }
+
+    void search(T start){
+        if(m_pCSR == nullptr) throw VertexNotFoundException("start vertex");
+        m_source = m_pCSR->index_of(start);
+        int nvertices = m_pCSR->size();
+        m_dist.resize(nvertices);
+        m_parent.resize(nvertices);
+        shortest_paths(nvertices, m_pCSR->out_offsets(), m_pCSR->out_targets(), m_pCSR->out_weights(),
+                       m_source, m_dist.data(), m_parent.data());
+    }
+    bool reachable(T vertex){
+        int idx = index_of(vertex);
+        return m_dist[idx] != numeric_limits<float>::infinity();
+    }
+    float cost(T vertex){
+        return m_dist[index_of(vertex)];
+    }
+    Path<T> path(T vertex){
+        Path<T> path;
+        int idx = index_of(vertex);
+        if(m_dist[idx] == numeric_limits<float>::infinity()) return path;
+        for(int cur=idx; cur >= 0; cur = m_parent[cur]) path.getPath().add(0, m_pCSR->vertex(cur));
+        path.setCost(m_dist[idx]);
+        return path;
+    }
+
+    DLinkedList<Path<T>> dijkstra(IGraph<T>* pGraph, T start){
+        if(pGraph != m_pGraph) compile(pGraph);
+        search(start);
+        DLinkedList<Path<T>> paths;
+        for(int idx=0; idx < m_pCSR->size(); idx++)
+            if(m_dist[idx] != numeric_limits<float>::infinity()) paths.add(path(m_pCSR->vertex(idx)));
+        return paths;
+    }
+
+    /*
+     * shortest_paths: Dijkstra on a graph given as CSR arrays (see CSRGraph)
+     *  + dist[v]: the cost from source to v (infinity if v is not reachable)
+     *  + parent[v]: the vertex before v on the path (-1 for source and unreachable vertices)
+     */
+    static void shortest_paths(int nvertices, const int* offsets, const int* targets,
+                               const float* weights, int source, float* dist, int* parent){
+        for(int v=0; v < nvertices; v++){
+            dist[v] = numeric_limits<float>::infinity();
+            parent[v] = -1;
+        }
+        IndexedHeap<float, 4> heap(nvertices);
+        dist[source] = 0;
+        heap.push(source, 0);
+        while(!heap.empty()){
+            int u = heap.pop();
+            float du = dist[u];
+            for(int e=offsets[u]; e < offsets[u + 1]; e++){
+                int v = targets[e];
+                float candidate = du + weights[e];
+                if(candidate < dist[v]){
+                    dist[v] = candidate;
+                    parent[v] = u;
+                    heap.push_or_decrease(v, candidate);
+                }
+            }
+        }
+    }
+
+private:
+    int index_of(T vertex){
+        if(m_pCSR == nullptr) throw VertexNotFoundException("vertex");
+        if(m_source < 0) throw std::logic_error("DijkstraFinder: call search first");
+        return m_pCSR->index_of(vertex);
+    }
+
+private:
+    int (*hashCode)(T&, int);
+    bool (*vertexEQ)(T&, T&);
+
+    IGraph<T>* m_pGraph;
+    CSRGraph<T>* m_pCSR;
+
+    int m_source;
+    vector<float> m_dist;
+    vector<int> m_parent;
+};
+
+#endif /* DIJKSTRAFINDER_H */
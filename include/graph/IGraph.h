@@ -128,6 +128,20 @@ public:
     void add(T item){
         this->path.add(item);
     }
+    //operator== and operator<< let DLinkedList<Path<T>> compare and print its items
+    friend ostream& operator<<(ostream& os, Path<T>& path){
+        return os << path.toString();
+    }
+    //same vertices, same cost
+    bool operator==(Path<T>& other){
+        if((cost != other.cost) || (path.size() != other.path.size())) return false;
+        typename DLinkedList<T>::Iterator it = other.path.begin();
+        for(auto item: path){
+            if(!(item == *it)) return false;
+            it++;
+        }
+        return true;
+    }
     string toString(string (*item2str)(T&)=0){
         stringstream os;
         os << this->path.toString(item2str)
@@ -142,6 +156,8 @@ public:
  */
 template<class T>
 class IFinder{
+public:
+    virtual ~IFinder(){};
     virtual DLinkedList<Path<T>> dijkstra(IGraph<T>* pGraph, T start)=0;
 };
 
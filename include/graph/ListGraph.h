@@ -0,0 +1,121 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   ListGraph.h
+ *
+ * Created on November 18, 2024, 4:20 PM
+ */
+
+#ifndef LISTGRAPH_H
+#define LISTGRAPH_H
+#include <sstream>
+#include <string>
+#include "graph/IGraph.h"
+#include "hash/xMap.h"
+using namespace std;
+
+/*
+ * ListGraph: a directed graph on linked lists (IGraph): vertices are looked up by xMap,
+ *  the out/in edges of each vertex are kept in DLinkedList.
+ *  For repeated traversals, freeze it into a CSRGraph.
+ */
+template<class T>
+class ListGraph: public IGraph<T>{
+private:
+    struct VertexNode{
+        T vertex;
+        DLinkedList<T> outward, inward;
+        DLinkedList<float> weights; //weights[i]: weight of the edge to outward[i]
+    };
+    xMap<T, VertexNode*>* m_pNodes;
+    DLinkedList<T> m_vertices;
+    string (*vertex2str)(T&);
+
+    VertexNode* node(T vertex){
+        if(!m_pNodes->containsKey(vertex)) throw VertexNotFoundException(vertex2str? vertex2str(vertex) : "?");
+        return m_pNodes->get(vertex);
+    }
+public:
+    ListGraph(int (*hashCode)(T&, int), string (*vertex2str)(T&)=0){
+        m_pNodes = new xMap<T, VertexNode*>(hashCode);
+        this->vertex2str = vertex2str;
+    }
+    ~ListGraph(){
+        clear();
+        delete m_pNodes;
+    }
+    void add(T vertex){
+        if(m_pNodes->containsKey(vertex)) return;
+        VertexNode* pNode = new VertexNode();
+        pNode->vertex = vertex;
+        m_pNodes->put(vertex, pNode);
+        m_vertices.add(vertex);
+    }
+    void remove(T vertex){
+        VertexNode* pNode = node(vertex);
+        DLinkedList<T> outward = pNode->outward, inward = pNode->inward;
+        for(auto to: outward) disconnect(vertex, to);
+        for(auto from: inward) disconnect(from, vertex);
+        m_pNodes->remove(vertex);
+        m_vertices.removeItem(vertex);
+        delete pNode;
+    }
+    bool contains(T vertex){ return m_pNodes->containsKey(vertex); }
+    void connect(T from, T to, float weight=0){
+        VertexNode* pFrom = node(from);
+        VertexNode* pTo = node(to);
+        int idx = pFrom->outward.indexOf(to);
+        if(idx >= 0){
+            pFrom->weights.removeAt(idx);
+            pFrom->weights.add(idx, weight);
+            return;
+        }
+        pFrom->outward.add(to);
+        pFrom->weights.add(weight);
+        pTo->inward.add(from);
+    }
+    void disconnect(T from, T to){
+        VertexNode* pFrom = node(from);
+        int idx = pFrom->outward.indexOf(to);
+        if(idx < 0) throw EdgeNotFoundException(vertex2str? vertex2str(from) + "->" + vertex2str(to) : "?");
+        pFrom->outward.removeAt(idx);
+        pFrom->weights.removeAt(idx);
+        node(to)->inward.removeItem(from);
+    }
+    bool connected(T from, T to){ return node(from)->outward.contains(to); }
+    float weight(T from, T to){
+        VertexNode* pFrom = node(from);
+        int idx = pFrom->outward.indexOf(to);
+        if(idx < 0) throw EdgeNotFoundException(vertex2str? vertex2str(from) + "->" + vertex2str(to) : "?");
+        return pFrom->weights.get(idx);
+    }
+    DLinkedList<T> getOutwardEdges(T from){ return node(from)->outward; }
+    DLinkedList<T> getInwardEdges(T to){ return node(to)->inward; }
+    int size(){ return m_vertices.size(); }
+    bool empty(){ return m_vertices.empty(); }
+    void clear(){
+        for(auto vertex: m_vertices) delete m_pNodes->get(vertex);
+        m_pNodes->clear();
+        m_vertices.clear();
+    }
+    int inDegree(T vertex){ return node(vertex)->inward.size(); }
+    int outDegree(T vertex){ return node(vertex)->outward.size(); }
+    DLinkedList<T> vertices(){ return m_vertices; }
+    string toString(){
+        stringstream os;
+        for(auto vertex: m_vertices){
+            VertexNode* pNode = node(vertex);
+            os << (vertex2str? vertex2str(vertex) : "?") << " ->";
+            int idx = 0;
+            for(auto to: pNode->outward)
+                os << " " << (vertex2str? vertex2str(to) : "?") << "(" << pNode->weights.get(idx++) << ")";
+            os << endl;
+        }
+        return os.str();
+    }
+};
+
+#endif /* LISTGRAPH_H */
@@ -0,0 +1,174 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   IndexedHeap.h
+ *
+ * Created on November 18, 2024, 10:15 AM
+ */
+
+#ifndef INDEXEDHEAP_H
+#define INDEXEDHEAP_H
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+ * IndexedHeap<K, D>: a D-ary min-heap of ids 0..capacity-1, each with a key of type K.
+ *  + position[id]: where id is stored in the heap (-1: not in the heap), so that
+ *      contains(id) is O(1) and decrease_key(id, key) is O(log_D n) (no search);
+ *  + D = 4 (default): a shallower tree than a binary heap; the 4 children of a node
+ *      are contiguous, so a reheap-down step reads one cache line of keys.
+ *  + ids and keys are stored side by side (struct Entry) to keep the comparisons local.
+ *
+ * Operations:
+ *  + push(id, key): id must not be in the heap
+ *  + pop(): removes and returns the id with the smallest key; top()/top_key() peek at it
+ *  + decrease_key(id, key): key must not be larger than the current key
+ *  + push_or_decrease(id, key): push if absent, decrease if key is smaller, else nothing;
+ *      returns true if the heap changed (the "relax" step of Dijkstra/Prim).
+ */
+template<class K, int D=4>
+class IndexedHeap{
+public:
+    IndexedHeap(int capacity=0){
+        reserve(capacity);
+    }
+
+    //ids can then be in [0, capacity)
+    void reserve(int capacity){
+        if(capacity > (int)m_position.size()) m_position.resize(capacity, -1);
+    }
+    int capacity(){ return m_position.size(); }
+    int size(){ return m_heap.size(); }
+    bool empty(){ return m_heap.empty(); }
+    bool contains(int id){
+        return (id >= 0) && (id < (int)m_position.size()) && (m_position[id] >= 0);
+    }
+    K key(int id){
+        if(!contains(id)) throw std::out_of_range("IndexedHeap: the id is not in the heap");
+        return m_heap[m_position[id]].key;
+    }
+
+    void push(int id, K key){
+        if((id < 0) || (id >= (int)m_position.size())) throw std::out_of_range("IndexedHeap: id is out of range");
+        if(m_position[id] >= 0) throw std::invalid_argument("IndexedHeap: the id is in the heap already");
+        m_heap.push_back(Entry{key, id});
+        m_position[id] = m_heap.size() - 1;
+        reheapUp(m_heap.size() - 1);
+    }
+    int top(){
+        if(m_heap.empty()) throw std::underflow_error("Calling to top with the empty heap.");
+        return m_heap[0].id;
+    }
+    K top_key(){
+        if(m_heap.empty()) throw std::underflow_error("Calling to top_key with the empty heap.");
+        return m_heap[0].key;
+    }
+    int pop(){
+        if(m_heap.empty()) throw std::underflow_error("Calling to pop with the empty heap.");
+        int id = m_heap[0].id;
+        m_position[id] = -1;
+        Entry last = m_heap.back();
+        m_heap.pop_back();
+        if(!m_heap.empty()){
+            m_heap[0] = last;
+            m_position[last.id] = 0;
+            reheapDown(0);
+        }
+        return id;
+    }
+    void decrease_key(int id, K key){
+        if(!contains(id)) throw std::out_of_range("IndexedHeap: the id is not in the heap");
+        int pos = m_position[id];
+        if(m_heap[pos].key < key) throw std::invalid_argument("IndexedHeap: decrease_key with a larger key");
+        m_heap[pos].key = key;
+        reheapUp(pos);
+    }
+    bool push_or_decrease(int id, K key){
+        if(!contains(id)){
+            push(id, key);
+            return true;
+        }
+        int pos = m_position[id];
+        if(!(key < m_heap[pos].key)) return false;
+        m_heap[pos].key = key;
+        reheapUp(pos);
+        return true;
+    }
+    void remove(int id){
+        if(!contains(id)) return;
+        int pos = m_position[id];
+        m_position[id] = -1;
+        Entry last = m_heap.back();
+        m_heap.pop_back();
+        if(pos < (int)m_heap.size()){
+            m_heap[pos] = last;
+            m_position[last.id] = pos;
+            reheapUp(pos);
+            reheapDown(m_position[last.id]);
+        }
+    }
+    void clear(){
+        for(Entry& entry: m_heap) m_position[entry.id] = -1;
+        m_heap.clear();
+    }
+
+    string toString(){
+        stringstream os;
+        os << "[";
+        for(size_t idx=0; idx < m_heap.size(); idx++){
+            if(idx > 0) os << ", ";
+            os << "(" << m_heap[idx].id << ", " << m_heap[idx].key << ")";
+        }
+        os << "]";
+        return os.str();
+    }
+
+private:
+    struct Entry{
+        K key;
+        int id;
+    };
+
+    void reheapUp(int pos){
+        Entry entry = m_heap[pos];
+        while(pos > 0){
+            int parent = (pos - 1)/D;
+            if(!(entry.key < m_heap[parent].key)) break;
+            m_heap[pos] = m_heap[parent];
+            m_position[m_heap[pos].id] = pos;
+            pos = parent;
+        }
+        m_heap[pos] = entry;
+        m_position[entry.id] = pos;
+    }
+    void reheapDown(int pos){
+        int count = m_heap.size();
+        Entry entry = m_heap[pos];
+        while(true){
+            int first = D*pos + 1;
+            if(first >= count) break;
+            int last = (first + D < count)? first + D : count;
+            int best = first;
+            for(int child=first + 1; child < last; child++)
+                if(m_heap[child].key < m_heap[best].key) best = child;
+            if(!(m_heap[best].key < entry.key)) break;
+            m_heap[pos] = m_heap[best];
+            m_position[m_heap[pos].id] = pos;
+            pos = best;
+        }
+        m_heap[pos] = entry;
+        m_position[entry.id] = pos;
+    }
+
+private:
+    vector<Entry> m_heap;
+    vector<int> m_position;
+};
+
+#endif /* INDEXEDHEAP_H */
@@ -6,6 +6,7 @@
 #define XARRAYLIST_H
 // #include "list/IList.h"
 #include "IList.h"
+#include "sorting/ISort.h"
 #include <memory.h>
 #include <sstream>
 #include <iostream>
@@ -57,6 +58,17 @@ public:
         this->deleteUserData = deleteUserData;
     }
 
+    // sort: sorts the items in place with any ISort backend (PDQSort, RadixSort, ParallelMergeSort, ...)
+    void sort(ISort<T> &sorter, int (*comparator)(T &, T &) = 0)
+    {
+        sorter.sort(data, count, comparator);
+    }
+    // getData: the items are contiguous in [getData(), getData() + size()), until the next add
+    T *getData()
+    {
+        return data;
+    }
+
     Iterator begin()
     {
         return Iterator(this, 0);
@@ -14,6 +14,7 @@
 #define DATALOADER_H
 #include "tensor/xtensor_lib.h"
 #include "loader/dataset.h"
+#include "util/CounterRNG.h"
 
 using namespace std;
 
@@ -30,6 +31,8 @@ private:
     int nbatch;
     ulong_tensor item_indices;
     int m_seed;
+    int m_epoch; //the epoch of the current order (see set_epoch)
+    uint64_t m_key; //the key of the order when seed < 0: drawn by the constructor
     XArrayList<Batch<DType, LType>> batches;
     
 public:
@@ -39,43 +42,53 @@ public:
                 : ptr_dataset(ptr_dataset), 
                 batch_size(batch_size), 
                 shuffle(shuffle),
+                drop_last(drop_last),
                 m_seed(seed){
-            nbatch = ptr_dataset->len()/batch_size;
-            item_indices = xt::arange(0, ptr_dataset->len());
-            int datasetsize = ptr_dataset->len();
-        this->shuffle = shuffle;
-        if (shuffle)
-        {
-            if (seed >= 0)
-                xt::random::seed(seed);
-            xt::random::shuffle(item_indices);
-        }
+        nbatch = ptr_dataset->len()/batch_size;
+        m_epoch = 0;
+        m_key = (seed >= 0)? 0 : draw_key();
+        item_indices = xt::arange(0, ptr_dataset->len());
+        if (shuffle) shuffle_indices();
+        build_batches();
+    }
+    virtual ~DataLoader(){}
+    
+    /*
+     * set_epoch: with shuffle, the order of the samples for the given epoch (the batches are
+     *  gathered again); fit calls it before each epoch (epoch 0: the order of the constructor).
+     *  The order is a function of (seed, epoch) only, see CounterRNG; seed < 0: of a key of the
+     *  loader (drawn from the xtensor random engine by the constructor) and the epoch.
+     */
+    void set_epoch(int epoch){
+        if (!shuffle || (epoch == m_epoch)) return;
+        m_epoch = epoch;
+        item_indices = xt::arange(0, ptr_dataset->len());
+        shuffle_indices();
+        batches.clear();
+        build_batches();
+    }
+    int get_epoch(){ return m_epoch; }
 
+protected:
+    void shuffle_indices(){
+        CounterRNG rng = (m_seed >= 0)? CounterRNG::for_seed(m_seed, m_epoch) :
+                         CounterRNG(m_key, m_epoch);
+        rng.shuffle(item_indices.data(), item_indices.size());
+    }
+    static uint64_t draw_key(){
+        auto& engine = xt::random::get_default_random_engine();
+        uint64_t high = engine();
+        return (high << 32) ^ engine();
+    }
+    void build_batches(){
+        int datasetsize = ptr_dataset->len();
         int remainder = datasetsize % batch_size;
 
         xt::svector<unsigned long> data_shape = ptr_dataset->get_data_shape();
 
         xt::svector<unsigned long> label_shape = ptr_dataset->get_label_shape();
 
-        xt::xarray<DType> all_data = xt::empty<DType>(data_shape);
-        xt::xarray<LType> all_label = xt::empty<LType>(label_shape);
-
-        for (int j = 0; j < datasetsize; j++)
-        {
-            int data_index = item_indices[j];
-
-            DataLabel<DType, LType> item = ptr_dataset->getitem(data_index);
-            view(all_data, j, xt::all()) = item.getData();
-            if (ptr_dataset->get_label_shape().size() != 0)
-            {
-                view(all_label, j, xt::all()) = item.getLabel();
-            }
-        }
-        if (ptr_dataset->get_label_shape().size() == 0)
-        {
-            all_label = ptr_dataset->getitem(0).getLabel();
-        }
-
+        //each batch is gathered from the dataset directly (one copy)
         for (int i = 0; i < nbatch; i++)
         {
             int first = i * batch_size;
@@ -90,29 +103,45 @@ public:
                 last = datasetsize;
             }
 
+            if (ptr_dataset->is_sparse())
+            {
+                //sparse rows: the batch holds a CSR matrix, O(nnz of the batch)
+                CSRMatrix<DType> data_batch(data_shape[1]);
+                aligned_tensor<LType> label_batch;
+                if (label_shape.size() != 0)
+                {
+                    xt::svector<unsigned long> label_batch_shape = label_shape;
+                    label_batch_shape[0] = last - first;
+                    label_batch = aligned_tensor<LType>::from_shape(label_batch_shape);
+                }
+                ptr_dataset->gather_sparse(item_indices.data() + first, last - first, data_batch, label_batch);
+                batches.add(Batch<DType, LType>(std::move(data_batch), label_batch));
+                continue;
+            }
+
             xt::svector<unsigned long> data_batch_shape = data_shape;
             data_batch_shape[0] = last - first;
-            xt::xarray<DType> data_batch = xt::empty<DType>(data_batch_shape);
-
-            xt::view(data_batch, xt::all()) = xt::view(all_data, xt::range(first, last));
+            aligned_tensor<DType> data_batch = aligned_tensor<DType>::from_shape(data_batch_shape);
 
             if (label_shape.size() != 0)
             {
+                //dense labels [N, ...] or sparse class indices [N]
                 xt::svector<unsigned long> label_batch_shape = label_shape;
                 label_batch_shape[0] = last - first;
-                xt::xarray<LType> label_batch = xt::empty<LType>(label_batch_shape);
-                xt::view(label_batch, xt::all()) = xt::view(all_label, xt::range(first, last));
+                aligned_tensor<LType> label_batch = aligned_tensor<LType>::from_shape(label_batch_shape);
+                ptr_dataset->gather(item_indices.data() + first, last - first, data_batch, label_batch);
                 batches.add(Batch<DType, LType>(data_batch, label_batch));
             }
             else
             {
-                xt::xarray<LType> empty_label;
+                aligned_tensor<LType> empty_label;
+                ptr_dataset->gather(item_indices.data() + first, last - first, data_batch, empty_label);
                 batches.add(Batch<DType, LType>(data_batch, empty_label));
             }
         }
     }
-    virtual ~DataLoader(){}
-    
+
+public:
     //New method: from V2: begin
     int get_batch_size(){ return batch_size; }
     int get_sample_count(){ return ptr_dataset->len(); }
@@ -13,46 +13,62 @@
 #ifndef DATASET_H
 #define DATASET_H
 #include "tensor/xtensor_lib.h"
+#include "tensor/csr_matrix.h"
 using namespace std;
 
 template <typename DType, typename LType>
 class DataLabel
 {
 private:
-    xt::xarray<DType> data;
-    xt::xarray<LType> label;
+    aligned_tensor<DType> data;
+    aligned_tensor<LType> label;
 
 public:
-    DataLabel(xt::xarray<DType> data, xt::xarray<LType> label) : data(data), label(label)
+    DataLabel(aligned_tensor<DType> data, aligned_tensor<LType> label) : data(data), label(label)
     {
     }
-    xt::xarray<DType> getData() const { return data; }
-    xt::xarray<LType> getLabel() const { return label; }
+    aligned_tensor<DType> getData() const { return data; }
+    aligned_tensor<LType> getLabel() const { return label; }
 };
 
+/* Batch: dense data (getData), or sparse data in CSR format (is_sparse, getSparseData)
+ *  from a sparse dataset; getData() of a sparse batch is empty.
+ */
 template <typename DType, typename LType>
 class Batch
 {
 private:
-    xt::xarray<DType> data;
-    xt::xarray<LType> label;
+    aligned_tensor<DType> data;
+    aligned_tensor<LType> label;
+    CSRMatrix<DType> sparse_data;
+    bool sparse = false;
 
 public:
     Batch() = default;
-    Batch(xt::xarray<DType> data, xt::xarray<LType> label) : data(data), label(label)
+    Batch(aligned_tensor<DType> data, aligned_tensor<LType> label) : data(data), label(label)
+    {
+    }
+    Batch(CSRMatrix<DType> sparse_data, aligned_tensor<LType> label)
+        : label(label), sparse_data(std::move(sparse_data)), sparse(true)
     {
     }
     virtual ~Batch() {}
-    xt::xarray<DType> &getData() { return data; }
-    xt::xarray<LType> &getLabel() { return label; }
+    aligned_tensor<DType> &getData() { return data; }
+    aligned_tensor<LType> &getLabel() { return label; }
+    CSRMatrix<DType> &getSparseData() { return sparse_data; }
+    bool is_sparse() const { return sparse; }
+    //number of samples in the batch
+    size_t size() const { return sparse? sparse_data.rows() : ((data.dimension() == 0)? 0 : data.shape()[0]); }
     bool operator==(const Batch<DType, LType> &other) const
     {
-        return (this->data == other.data) && (this->label == other.label);
+        return (this->sparse == other.sparse) && (this->data == other.data) &&
+               (this->sparse_data == other.sparse_data) && (this->label == other.label);
     }
     friend std::ostream &operator<<(std::ostream &os, const Batch<DType, LType> &batch)
     {
-        os << "Data:\n"
-           << batch.data << "\n";
+        os << "Data:\n";
+        if (batch.sparse) os << batch.sparse_data << "\n";
+        else os << batch.data << "\n";
         os << "Label:\n"
            << batch.label << "\n";
         return os;
@@ -71,6 +87,34 @@ public:
     virtual DataLabel<DType, LType> getitem(int index) = 0;
     virtual xt::svector<unsigned long> get_data_shape() = 0;
     virtual xt::svector<unsigned long> get_label_shape() = 0;
+    
+    /* gather: copies the items indices[0..count) into data and label, in that order
+     *  + data: [count, data_shape[1:]]; label: [count, label_shape[1:]]
+     *  + label_shape is empty (no label per item): label is not filled
+     *  + labels can be dense (e.g., one-hot rows) or sparse: a 1-D label tensor
+     *      holding one class index per item, label: [count]
+     *  + default: item by item, via getitem; subclasses can copy in bulk
+     */
+    virtual void gather(const unsigned long* indices, int count,
+                        aligned_tensor<DType>& data, aligned_tensor<LType>& label)
+    {
+        bool has_label = get_label_shape().size() != 0;
+        for (int k = 0; k < count; k++)
+        {
+            DataLabel<DType, LType> item = getitem(indices[k]);
+            xt::view(data, k) = item.getData();
+            if (has_label) xt::view(label, k) = item.getLabel();
+        }
+    }
+    /* is_sparse: true if the items are sparse rows, then DataLoader builds the batches
+     *  with gather_sparse (CSR data) instead of gather
+     */
+    virtual bool is_sparse() { return false; }
+    virtual void gather_sparse(const unsigned long* indices, int count,
+                               CSRMatrix<DType>& data, aligned_tensor<LType>& label)
+    {
+        throw std::logic_error("Dataset::gather_sparse: the dataset is not sparse");
+    }
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -78,8 +122,8 @@ template <typename DType, typename LType>
 class TensorDataset : public Dataset<DType, LType>
 {
 private:
-    xt::xarray<DType> data;
-    xt::xarray<LType> label;
+    aligned_tensor<DType> data;
+    aligned_tensor<LType> label;
     xt::svector<unsigned long> data_shape, label_shape;
 
 public:
@@ -88,14 +132,14 @@ public:
      * 1. data, label;
      * 2. data_shape, label_shape
      */
-    TensorDataset(xt::xarray<DType> data, xt::xarray<LType> label)
+    TensorDataset(aligned_tensor<DType> data, aligned_tensor<LType> label)
     {
         /* TODO: your code is here for the initialization
          */
-        this->data = data;
-        this->label = label;
-        label_shape = xt::svector<unsigned long>(label.shape().begin(), label.shape().end());
-        data_shape = xt::svector<unsigned long>(data.shape().begin(), data.shape().end());
+        this->data = std::move(data);
+        this->label = std::move(label);
+        label_shape = xt::svector<unsigned long>(this->label.shape().begin(), this->label.shape().end());
+        data_shape = xt::svector<unsigned long>(this->data.shape().begin(), this->data.shape().end());
     }
     /* len():
      *  return the size of dimension 0
@@ -118,8 +162,8 @@ public:
         {
             throw std::out_of_range("Index is out of range!");
         }
-        xt::xarray<DType> sample_data;
-        xt::xarray<LType> sample_label;
+        aligned_tensor<DType> sample_data;
+        aligned_tensor<LType> sample_label;
         if (label.shape().size() == 0)
         {
             sample_label = label;
@@ -151,6 +195,181 @@ public:
          */
         return label_shape;
     }
+    
+    /* gather: one memcpy per row of data and label (both are row-major)
+     */
+    void gather(const unsigned long* indices, int count,
+                aligned_tensor<DType>& data, aligned_tensor<LType>& label)
+    {
+        size_t data_row = (len() == 0)? 0 : this->data.size()/len();
+        bool has_label = label_shape.size() != 0;
+        size_t label_row = (has_label && (label_shape[0] != 0))? this->label.size()/label_shape[0] : 0;
+        for (int k = 0; k < count; k++)
+        {
+            if (indices[k] >= (unsigned long)len()) throw std::out_of_range("Index is out of range!");
+            std::copy_n(this->data.data() + indices[k]*data_row, data_row, data.data() + k*data_row);
+            if (has_label)
+                std::copy_n(this->label.data() + indices[k]*label_row, label_row, label.data() + k*label_row);
+        }
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* SparseTensorDataset: the data is a CSRMatrix [N, D] (one sparse row per item),
+ *  the label a tensor [N, ...] as in TensorDataset;
+ *  + memory: O(N + nnz) for the data;
+ *  + the batches of a DataLoader are sparse (Batch::is_sparse, getSparseData);
+ *  + getitem returns the item as a dense row [D] (for the item-by-item API).
+ */
+template <typename DType, typename LType>
+class SparseTensorDataset : public Dataset<DType, LType>
+{
+private:
+    CSRMatrix<DType> data;
+    aligned_tensor<LType> label;
+    xt::svector<unsigned long> data_shape, label_shape;
+
+public:
+    SparseTensorDataset(CSRMatrix<DType> data, aligned_tensor<LType> label)
+    {
+        this->data = std::move(data);
+        this->label = std::move(label);
+        if (this->label.dimension() != 0 && this->label.shape()[0] != this->data.rows())
+            throw std::invalid_argument("SparseTensorDataset: data and label have different numbers of rows");
+        label_shape = xt::svector<unsigned long>(this->label.shape().begin(), this->label.shape().end());
+        data_shape = xt::svector<unsigned long>{this->data.rows(), this->data.cols()};
+    }
+    int len()
+    {
+        return data.rows();
+    }
+    DataLabel<DType, LType> getitem(int index)
+    {
+        if (index < 0 || index >= len())
+        {
+            throw std::out_of_range("Index is out of range!");
+        }
+        aligned_tensor<DType> sample_data = xt::zeros<DType>({data.cols()});
+        for (size_t k = data.offsets()[index]; k < data.offsets()[index + 1]; k++)
+            sample_data(data.indices()[k]) = data.values()[k];
+        aligned_tensor<LType> sample_label;
+        if (label.shape().size() == 0) sample_label = label;
+        else sample_label = view(label, index);
+        return DataLabel<DType, LType>(sample_data, sample_label);
+    }
+    xt::svector<unsigned long> get_data_shape()
+    {
+        return data_shape;
+    }
+    xt::svector<unsigned long> get_label_shape()
+    {
+        return label_shape;
+    }
+    CSRMatrix<DType>& get_data() { return data; }
+
+    bool is_sparse() { return true; }
+    void gather(const unsigned long* indices, int count,
+                aligned_tensor<DType>& data, aligned_tensor<LType>& label)
+    {
+        //dense copy of the rows: for the callers that can not take CSR data
+        CSRMatrix<DType> rows(this->data.cols());
+        gather_sparse(indices, count, rows, label);
+        data = rows.to_dense();
+    }
+    /* gather_sparse: appends the rows of the items to data, O(nnz of the items)
+     */
+    void gather_sparse(const unsigned long* indices, int count,
+                       CSRMatrix<DType>& data, aligned_tensor<LType>& label)
+    {
+        bool has_label = label_shape.size() != 0;
+        size_t label_row = (has_label && (label_shape[0] != 0))? this->label.size()/label_shape[0] : 0;
+        size_t nnz = 0;
+        for (int k = 0; k < count; k++)
+        {
+            if (indices[k] >= (unsigned long)len()) throw std::out_of_range("Index is out of range!");
+            nnz += this->data.row_nnz(indices[k]);
+        }
+        data.reserve(count, nnz);
+        for (int k = 0; k < count; k++)
+        {
+            data.append_row(this->data, indices[k]);
+            if (has_label)
+                std::copy_n(this->label.data() + indices[k]*label_row, label_row, label.data() + k*label_row);
+        }
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* ShardedDataset: the shard of a dataset read by one rank of world_size (distributed
+ *  training): the items rank, rank + world_size, rank + 2*world_size, ...;
+ *  every shard has len()/world_size items (the tail is dropped), so that all the ranks
+ *  run the same number of batches. The base dataset is not owned.
+ */
+template <typename DType, typename LType>
+class ShardedDataset : public Dataset<DType, LType>
+{
+private:
+    Dataset<DType, LType>* ptr_base;
+    int rank, world_size;
+    int shard_len;
+    xt::svector<unsigned long> data_shape, label_shape;
+    vector<unsigned long> base_indices;
+
+public:
+    ShardedDataset(Dataset<DType, LType>* ptr_base, int rank, int world_size)
+        : ptr_base(ptr_base), rank(rank), world_size(world_size)
+    {
+        if (world_size < 1 || rank < 0 || rank >= world_size)
+            throw std::invalid_argument("ShardedDataset: invalid rank/world_size");
+        shard_len = ptr_base->len()/world_size;
+        data_shape = ptr_base->get_data_shape();
+        label_shape = ptr_base->get_label_shape();
+        if (data_shape.size() != 0) data_shape[0] = shard_len;
+        if (label_shape.size() != 0) label_shape[0] = shard_len;
+    }
+    int len()
+    {
+        return shard_len;
+    }
+    DataLabel<DType, LType> getitem(int index)
+    {
+        if (index < 0 || index >= len())
+        {
+            throw std::out_of_range("Index is out of range!");
+        }
+        return ptr_base->getitem(index*world_size + rank);
+    }
+    xt::svector<unsigned long> get_data_shape()
+    {
+        return data_shape;
+    }
+    xt::svector<unsigned long> get_label_shape()
+    {
+        return label_shape;
+    }
+    bool is_sparse() { return ptr_base->is_sparse(); }
+    void gather(const unsigned long* indices, int count,
+                aligned_tensor<DType>& data, aligned_tensor<LType>& label)
+    {
+        ptr_base->gather(to_base(indices, count), count, data, label);
+    }
+    void gather_sparse(const unsigned long* indices, int count,
+                       CSRMatrix<DType>& data, aligned_tensor<LType>& label)
+    {
+        ptr_base->gather_sparse(to_base(indices, count), count, data, label);
+    }
+
+private:
+    const unsigned long* to_base(const unsigned long* indices, int count)
+    {
+        base_indices.resize(count);
+        for (int k = 0; k < count; k++)
+        {
+            if (indices[k] >= (unsigned long)len()) throw std::out_of_range("Index is out of range!");
+            base_indices[k] = indices[k]*world_size + rank;
+        }
+        return base_indices.data();
+    }
 };
 
 #endif /* DATASET_H */
@@ -35,5 +35,22 @@ public:
         else return 0;
     }
 };
+
+/*
+ * ComparatorLess: adapts a comparator of ISort::sort (<0: lhs before rhs) to the
+ *  "less" functor used by the templated sorts (PDQSort, ParallelMergeSort).
+ *  Calls through the pointer can not be inlined: pass a functor to the templated
+ *  entry points (e.g. PDQSort<T>::sort(first, last, std::less<T>())) where it matters.
+ */
+template<class T>
+class ComparatorLess{
+public:
+    ComparatorLess(int (*comparator)(T&,T&)): comparator(comparator){}
+    bool operator()(T& lhs, T& rhs) const{
+        return comparator(lhs, rhs) < 0;
+    }
+private:
+    int (*comparator)(T&,T&);
+};
 #endif /* ISORT_H */
 
@@ -0,0 +1,371 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   PDQSort.h
+ *
+ * Created on November 21, 2024, 9:00 AM
+ */
+
+#ifndef PDQSORT_H
+#define PDQSORT_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include "sorting/ISort.h"
+using namespace std;
+
+/*
+ * PDQSort<T, Less>: pattern-defeating quicksort (introsort family, not stable).
+ *  + small ranges (< 24): insertion sort;
+ *  + pivot: median of 3, or the ninther (median of 3 medians) above 128 elements;
+ *  + already partitioned ranges are finished by a bounded insertion sort, so sorted,
+ *      reversed and "almost sorted" inputs are linear;
+ *  + many equal keys: when the pivot equals the element before the range, the
+ *      elements equal to it are put aside in one pass (partition_left);
+ *  + an unbalanced partition shuffles a few elements; after log2(n) of them the range
+ *      is heap sorted, so the worst case is O(n log n);
+ *  + arithmetic T with std::less/std::greater: block partitioning, the comparisons are
+ *      written to offset buffers instead of branching on them (no mispredictions).
+ *
+ * Entry points:
+ *  + sort(array, size, comparator): the ISort interface; comparator == 0 uses Less;
+ *  + PDQSort<T>::sort(first, last, less): any functor, inlined in the sort.
+ */
+template<class T, class Less=std::less<T>>
+class PDQSort: public ISort<T>{
+public:
+    PDQSort(Less less=Less()): less(less){}
+
+    void sort(T array[], int size, int (*comparator)(T&,T&) =0){
+        if(comparator == 0) sort(array, array + size, less);
+        else sort(array, array + size, ComparatorLess<T>(comparator));
+    }
+
+    template<class Cmp>
+    static void sort(T* first, T* last, Cmp less){
+        if(last - first < 2) return;
+        loop<Cmp, branchless<Cmp>()>(first, last, less, log2(last - first), true);
+    }
+
+private:
+    enum{
+        INSERTION_SORT_THRESHOLD = 24,
+        NINTHER_THRESHOLD = 128,
+        PARTIAL_INSERTION_SORT_LIMIT = 8,
+        BLOCK_SIZE = 64,
+        CACHELINE_SIZE = 64
+    };
+
+    template<class Cmp>
+    static constexpr bool branchless(){
+        return std::is_arithmetic<T>::value &&
+               (std::is_same<Cmp, std::less<T>>::value || std::is_same<Cmp, std::greater<T>>::value);
+    }
+    static int log2(ptrdiff_t n){
+        int result = 0;
+        while(n >>= 1) result++;
+        return result;
+    }
+
+    template<class Cmp>
+    static void insertion_sort(T* begin, T* end, Cmp& less){
+        if(begin == end) return;
+        for(T* cur=begin + 1; cur != end; cur++){
+            T* sift = cur;
+            T* sift_1 = cur - 1;
+            if(less(*sift, *sift_1)){
+                T tmp = std::move(*sift);
+                do{ *sift-- = std::move(*sift_1); }
+                while((sift != begin) && less(tmp, *--sift_1));
+                *sift = std::move(tmp);
+            }
+        }
+    }
+    //*(begin - 1) is not larger than any element of [begin, end): no bound check
+    template<class Cmp>
+    static void unguarded_insertion_sort(T* begin, T* end, Cmp& less){
+        if(begin == end) return;
+        for(T* cur=begin + 1; cur != end; cur++){
+            T* sift = cur;
+            T* sift_1 = cur - 1;
+            if(less(*sift, *sift_1)){
+                T tmp = std::move(*sift);
+                do{ *sift-- = std::move(*sift_1); }
+                while(less(tmp, *--sift_1));
+                *sift = std::move(tmp);
+            }
+        }
+    }
+    //gives up (returns false) after PARTIAL_INSERTION_SORT_LIMIT moves
+    template<class Cmp>
+    static bool partial_insertion_sort(T* begin, T* end, Cmp& less){
+        if(begin == end) return true;
+        size_t moves = 0;
+        for(T* cur=begin + 1; cur != end; cur++){
+            T* sift = cur;
+            T* sift_1 = cur - 1;
+            if(less(*sift, *sift_1)){
+                T tmp = std::move(*sift);
+                do{ *sift-- = std::move(*sift_1); }
+                while((sift != begin) && less(tmp, *--sift_1));
+                *sift = std::move(tmp);
+                moves += cur - sift;
+            }
+            if(moves > PARTIAL_INSERTION_SORT_LIMIT) return false;
+        }
+        return true;
+    }
+
+    template<class Cmp>
+    static void sort2(T* a, T* b, Cmp& less){
+        if(less(*b, *a)) std::iter_swap(a, b);
+    }
+    template<class Cmp>
+    static void sort3(T* a, T* b, T* c, Cmp& less){
+        sort2(a, b, less);
+        sort2(b, c, less);
+        sort2(a, b, less);
+    }
+
+    /*
+     * partition_right: pivot = *begin; afterwards [begin, pivot) < pivot <= [pivot + 1, end).
+     *  Needs an element >= pivot at the right of the range (the median selection puts one there).
+     *  Returns the pivot position and whether no element had to be swapped.
+     */
+    template<class Cmp>
+    static pair<T*, bool> partition_right(T* begin, T* end, Cmp& less){
+        T pivot(std::move(*begin));
+        T* first = begin;
+        T* last = end;
+        while(less(*++first, pivot));
+        if(first - 1 == begin) while((first < last) && !less(*--last, pivot));
+        else while(!less(*--last, pivot));
+
+        bool already_partitioned = first >= last;
+        while(first < last){
+            std::iter_swap(first, last);
+            while(less(*++first, pivot));
+            while(!less(*--last, pivot));
+        }
+        T* pivot_pos = first - 1;
+        *begin = std::move(*pivot_pos);
+        *pivot_pos = std::move(pivot);
+        return make_pair(pivot_pos, already_partitioned);
+    }
+
+    //moves num pairs first + offsets_l[i] <-> last - offsets_r[i]
+    static void swap_offsets(T* first, T* last, unsigned char* offsets_l, unsigned char* offsets_r,
+                             size_t num, bool use_swaps){
+        if(use_swaps){
+            //the two blocks are the same size: plain swaps keep the partition stable for the next round
+            for(size_t i=0; i < num; i++) std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+        }
+        else if(num > 0){
+            //one cycle of moves instead of num swaps
+            T* l = first + offsets_l[0];
+            T* r = last - offsets_r[0];
+            T tmp(std::move(*l));
+            *l = std::move(*r);
+            for(size_t i=1; i < num; i++){
+                l = first + offsets_l[i];
+                *r = std::move(*l);
+                r = last - offsets_r[i];
+                *l = std::move(*r);
+            }
+            *r = std::move(tmp);
+        }
+    }
+    static unsigned char* align_cacheline(unsigned char* p){
+        uintptr_t ip = reinterpret_cast<uintptr_t>(p);
+        ip = (ip + CACHELINE_SIZE - 1) & ~(uintptr_t)(CACHELINE_SIZE - 1);
+        return reinterpret_cast<unsigned char*>(ip);
+    }
+
+    /*
+     * partition_right_branchless: partition_right with block partitioning (BlockQuicksort):
+     *  the positions of misplaced elements of a block of BLOCK_SIZE on each side are
+     *  collected without branches, then swapped in one go.
+     */
+    template<class Cmp>
+    static pair<T*, bool> partition_right_branchless(T* begin, T* end, Cmp& less){
+        T pivot(std::move(*begin));
+        T* first = begin;
+        T* last = end;
+        while(less(*++first, pivot));
+        if(first - 1 == begin) while((first < last) && !less(*--last, pivot));
+        else while(!less(*--last, pivot));
+
+        bool already_partitioned = first >= last;
+        if(!already_partitioned){
+            std::iter_swap(first, last);
+            ++first;
+
+            unsigned char offsets_l_storage[BLOCK_SIZE + CACHELINE_SIZE];
+            unsigned char offsets_r_storage[BLOCK_SIZE + CACHELINE_SIZE];
+            unsigned char* offsets_l = align_cacheline(offsets_l_storage);
+            unsigned char* offsets_r = align_cacheline(offsets_r_storage);
+            T* offsets_l_base = first;
+            T* offsets_r_base = last;
+            size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+            while(first < last){
+                //refill the empty side(s); split the rest between both sides near the end
+                size_t num_unknown = last - first;
+                size_t left_split = (num_l == 0)? ((num_r == 0)? num_unknown/2 : num_unknown) : 0;
+                size_t right_split = (num_r == 0)? (num_unknown - left_split) : 0;
+
+                size_t nleft = std::min<size_t>(left_split, BLOCK_SIZE);
+                for(size_t i=0; i < nleft; i++){
+                    offsets_l[num_l] = i;
+                    num_l += !less(*first, pivot);
+                    ++first;
+                }
+                size_t nright = std::min<size_t>(right_split, BLOCK_SIZE);
+                for(size_t i=0; i < nright; ){
+                    offsets_r[num_r] = ++i;
+                    num_r += less(*--last, pivot);
+                }
+
+                size_t num = std::min(num_l, num_r);
+                swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r,
+                             num, num_l == num_r);
+                num_l -= num;
+                num_r -= num;
+                start_l += num;
+                start_r += num;
+                if(num_l == 0){
+                    start_l = 0;
+                    offsets_l_base = first;
+                }
+                if(num_r == 0){
+                    start_r = 0;
+                    offsets_r_base = last;
+                }
+            }
+
+            //one side may have leftovers: move them to the middle
+            if(num_l){
+                offsets_l += start_l;
+                while(num_l--) std::iter_swap(offsets_l_base + offsets_l[num_l], --last);
+                first = last;
+            }
+            if(num_r){
+                offsets_r += start_r;
+                while(num_r--){
+                    std::iter_swap(offsets_r_base - offsets_r[num_r], first);
+                    ++first;
+                }
+                last = first;
+            }
+        }
+        T* pivot_pos = first - 1;
+        *begin = std::move(*pivot_pos);
+        *pivot_pos = std::move(pivot);
+        return make_pair(pivot_pos, already_partitioned);
+    }
+
+    //pivot = *begin; afterwards [begin, pivot] == pivot < [pivot + 1, end)
+    template<class Cmp>
+    static T* partition_left(T* begin, T* end, Cmp& less){
+        T pivot(std::move(*begin));
+        T* first = begin;
+        T* last = end;
+        while(less(pivot, *--last));
+        if(last + 1 == end) while((first < last) && !less(pivot, *++first));
+        else while(!less(pivot, *++first));
+
+        while(first < last){
+            std::iter_swap(first, last);
+            while(less(pivot, *--last));
+            while(!less(pivot, *++first));
+        }
+        T* pivot_pos = last;
+        *begin = std::move(*pivot_pos);
+        *pivot_pos = std::move(pivot);
+        return pivot_pos;
+    }
+
+    //recurses on the left part, loops on the right part
+    template<class Cmp, bool Branchless>
+    static void loop(T* begin, T* end, Cmp& less, int bad_allowed, bool leftmost){
+        while(true){
+            ptrdiff_t size = end - begin;
+            if(size < INSERTION_SORT_THRESHOLD){
+                if(leftmost) insertion_sort(begin, end, less);
+                else unguarded_insertion_sort(begin, end, less);
+                return;
+            }
+
+            ptrdiff_t s2 = size/2;
+            if(size > NINTHER_THRESHOLD){
+                sort3(begin, begin + s2, end - 1, less);
+                sort3(begin + 1, begin + (s2 - 1), end - 2, less);
+                sort3(begin + 2, begin + (s2 + 1), end - 3, less);
+                sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), less);
+                std::iter_swap(begin, begin + s2);
+            }
+            else sort3(begin + s2, begin, end - 1, less);
+
+            //the pivot equals the element before the range: skip all the copies of it
+            if(!leftmost && !less(*(begin - 1), *begin)){
+                begin = partition_left(begin, end, less) + 1;
+                continue;
+            }
+
+            pair<T*, bool> part = Branchless? partition_right_branchless(begin, end, less)
+                                            : partition_right(begin, end, less);
+            T* pivot_pos = part.first;
+            bool already_partitioned = part.second;
+
+            ptrdiff_t l_size = pivot_pos - begin;
+            ptrdiff_t r_size = end - (pivot_pos + 1);
+            bool highly_unbalanced = (l_size < size/8) || (r_size < size/8);
+            if(highly_unbalanced){
+                if(--bad_allowed == 0){
+                    std::make_heap(begin, end, less);
+                    std::sort_heap(begin, end, less);
+                    return;
+                }
+                //break the pattern that led to the bad pivot
+                if(l_size >= INSERTION_SORT_THRESHOLD){
+                    std::iter_swap(begin, begin + l_size/4);
+                    std::iter_swap(pivot_pos - 1, pivot_pos - l_size/4);
+                    if(l_size > NINTHER_THRESHOLD){
+                        std::iter_swap(begin + 1, begin + (l_size/4 + 1));
+                        std::iter_swap(begin + 2, begin + (l_size/4 + 2));
+                        std::iter_swap(pivot_pos - 2, pivot_pos - (l_size/4 + 1));
+                        std::iter_swap(pivot_pos - 3, pivot_pos - (l_size/4 + 2));
+                    }
+                }
+                if(r_size >= INSERTION_SORT_THRESHOLD){
+                    std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size/4));
+                    std::iter_swap(end - 1, end - r_size/4);
+                    if(r_size > NINTHER_THRESHOLD){
+                        std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size/4));
+                        std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size/4));
+                        std::iter_swap(end - 2, end - (1 + r_size/4));
+                        std::iter_swap(end - 3, end - (2 + r_size/4));
+                    }
+                }
+            }
+            else if(already_partitioned && partial_insertion_sort(begin, pivot_pos, less)
+                                        && partial_insertion_sort(pivot_pos + 1, end, less))
+                return;
+
+            loop<Cmp, Branchless>(begin, pivot_pos, less, bad_allowed, leftmost);
+            begin = pivot_pos + 1;
+            leftmost = false;
+        }
+    }
+
+private:
+    Less less;
+};
+
+#endif /* PDQSORT_H */
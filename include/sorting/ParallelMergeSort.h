@@ -0,0 +1,113 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   ParallelMergeSort.h
+ *
+ * Created on November 21, 2024, 2:45 PM
+ */
+
+#ifndef PARALLELMERGESORT_H
+#define PARALLELMERGESORT_H
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "sorting/ISort.h"
+#include "sorting/PDQSort.h"
+#include "util/ThreadPool.h"
+using namespace std;
+
+/*
+ * ParallelMergeSort<T, Less>: merge sort on the thread pool, for large arrays.
+ *  + the array is cut into runs (a power of two, at least one per thread), the runs are
+ *      sorted with PDQSort in parallel;
+ *  + the runs are then merged pairwise, log2(runs) rounds, between the array and a buffer
+ *      of n items; each merge is split into pieces of equal output size (the split points
+ *      are found by binary search, "co-ranking"), so the last rounds, with few merges,
+ *      still use all the threads;
+ *  + below MIN_PARALLEL items, or with one thread, it is PDQSort.
+ *  Not stable: the runs are sorted by PDQSort.
+ *
+ * Entry points: as PDQSort (sort(array, size, comparator) and sort(first, last, less)).
+ */
+template<class T, class Less=std::less<T>>
+class ParallelMergeSort: public ISort<T>{
+public:
+    static const size_t MIN_PARALLEL = 1 << 16;
+
+    ParallelMergeSort(Less less=Less()): less(less){}
+
+    void sort(T array[], int size, int (*comparator)(T&,T&) =0){
+        if(comparator == 0) sort(array, array + size, less);
+        else sort(array, array + size, ComparatorLess<T>(comparator));
+    }
+
+    template<class Cmp>
+    static void sort(T* first, T* last, Cmp less){
+        size_t n = last - first;
+        ThreadPool& pool = ThreadPool::instance();
+        if((n < MIN_PARALLEL) || (pool.size() == 1)){
+            PDQSort<T>::sort(first, last, less);
+            return;
+        }
+
+        size_t nruns = 1;
+        while(nruns < pool.size()) nruns *= 2;
+        vector<size_t> bound(nruns + 1);
+        for(size_t r=0; r <= nruns; r++) bound[r] = n*r/nruns;
+        pool.run_chunks(nruns, [&](size_t r){
+            PDQSort<T>::sort(first + bound[r], first + bound[r + 1], less);
+        });
+
+        vector<T> buffer(n);
+        T* src = first;
+        T* dst = buffer.data();
+        for(size_t width=1; width < nruns; width *= 2){
+            //pieces of one merge: (pair, piece); pieces per merge so that there is work for every thread
+            size_t npairs = nruns/(2*width);
+            size_t npieces = std::max((size_t)1, pool.size()/npairs);
+            pool.run_chunks(npairs*npieces, [&](size_t task){
+                size_t pair = task/npieces, piece = task%npieces;
+                size_t lo = bound[2*pair*width], mid = bound[(2*pair + 1)*width], hi = bound[(2*pair + 2)*width];
+                T* a = src + lo;
+                T* b = src + mid;
+                size_t na = mid - lo, nb = hi - mid;
+                size_t k0 = (na + nb)*piece/npieces, k1 = (na + nb)*(piece + 1)/npieces;
+                size_t i0 = co_rank(k0, a, na, b, nb, less), i1 = co_rank(k1, a, na, b, nb, less);
+                std::merge(a + i0, a + i1, b + (k0 - i0), b + (k1 - i1), dst + lo + k0, less);
+            });
+            std::swap(src, dst);
+        }
+        if(src != first){
+            parallel_for(n, [&](size_t begin, size_t end){
+                std::move(src + begin, src + end, first + begin);
+            });
+        }
+    }
+
+private:
+    /*
+     * co_rank: the number i of items taken from a when the first k items of merge(a, b)
+     *  are output (the other k - i come from b; on ties a goes first, as in std::merge).
+     */
+    template<class Cmp>
+    static size_t co_rank(size_t k, T* a, size_t na, T* b, size_t nb, Cmp& less){
+        size_t lo = (k > nb)? k - nb : 0;
+        size_t hi = std::min(k, na);
+        //smallest i such that i == na, or j == 0, or b[j - 1] < a[i]
+        while(lo < hi){
+            size_t i = lo + (hi - lo)/2;
+            size_t j = k - i;
+            if((j == 0) || less(b[j - 1], a[i])) hi = i;
+            else lo = i + 1;
+        }
+        return lo;
+    }
+
+private:
+    Less less;
+};
+
+#endif /* PARALLELMERGESORT_H */
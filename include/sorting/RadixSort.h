@@ -0,0 +1,98 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   RadixSort.h
+ *
+ * Created on November 21, 2024, 11:20 AM
+ */
+
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "sorting/ISort.h"
+#include "sorting/PDQSort.h"
+using namespace std;
+
+/*
+ * RadixSort<T>: LSD radix sort of integral and floating-point keys (stable, O(n) per byte).
+ *  + each key is mapped to an unsigned integer with the same order
+ *      (signed: the sign bit is flipped; floating: negative keys have all bits flipped,
+ *      the others the sign bit), then sorted one byte at a time, lowest byte first;
+ *  + the histograms of all the bytes are built in one pass over the keys;
+ *      a byte that is the same for all keys is skipped (e.g. the high bytes of small ints);
+ *  + needs a buffer of n keys; -0.0 is placed before +0.0, NaNs after +inf (or before -inf
+ *      when the sign bit is set).
+ *
+ * sort(array, size, comparator): comparator 0 or SortSimpleOrder<T>::compare4Ascending sorts
+ *  ascending, SortSimpleOrder<T>::compare4Desending descending; any other comparator can not
+ *  be mapped to keys and falls back to PDQSort.
+ */
+template<class T>
+class RadixSort: public ISort<T>{
+    static_assert(std::is_integral<T>::value || std::is_floating_point<T>::value,
+                  "RadixSort: T must be an integral or floating-point type");
+public:
+    void sort(T array[], int size, int (*comparator)(T&,T&) =0){
+        if((comparator == 0) || (comparator == &SortSimpleOrder<T>::compare4Ascending))
+            sort(array, array + size, false);
+        else if(comparator == &SortSimpleOrder<T>::compare4Desending)
+            sort(array, array + size, true);
+        else PDQSort<T>().sort(array, size, comparator);
+    }
+
+    static void sort(T* first, T* last, bool descending=false){
+        T* array = first;
+        size_t size = last - first;
+        if(size < 2) return;
+        const int NBYTES = sizeof(T);
+        vector<size_t> counts(NBYTES*256, 0);
+        for(size_t idx=0; idx < size; idx++){
+            Key key = to_key(array[idx], descending);
+            for(int b=0; b < NBYTES; b++) counts[b*256 + ((key >> (8*b)) & 0xFF)]++;
+        }
+
+        vector<T> buffer(size);
+        T* src = array;
+        T* dst = buffer.data();
+        for(int b=0; b < NBYTES; b++){
+            size_t* count = counts.data() + b*256;
+            Key first_digit = (to_key(array[0], descending) >> (8*b)) & 0xFF;
+            if(count[first_digit] == size) continue;
+
+            size_t offset[256];
+            size_t sum = 0;
+            for(int d=0; d < 256; d++){
+                offset[d] = sum;
+                sum += count[d];
+            }
+            for(size_t idx=0; idx < size; idx++){
+                Key digit = (to_key(src[idx], descending) >> (8*b)) & 0xFF;
+                dst[offset[digit]++] = src[idx];
+            }
+            std::swap(src, dst);
+        }
+        if(src != array) memcpy(array, src, size*sizeof(T));
+    }
+
+private:
+    typedef typename std::conditional<sizeof(T) == 1, uint8_t,
+            typename std::conditional<sizeof(T) == 2, uint16_t,
+            typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type>::type>::type Key;
+
+    static Key to_key(T value, bool descending){
+        const Key SIGN = (Key)1 << (8*sizeof(T) - 1);
+        Key key;
+        memcpy(&key, &value, sizeof(T));
+        if(std::is_floating_point<T>::value) key ^= (key & SIGN)? (Key)~(Key)0 : SIGN;
+        else if(std::is_signed<T>::value) key ^= SIGN;
+        return descending? (Key)~key : key;
+    }
+};
+
+#endif /* RADIXSORT_H */
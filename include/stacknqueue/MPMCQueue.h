@@ -0,0 +1,225 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   MPMCQueue.h
+ *
+ * Created on November 16, 2024, 4:10 PM
+ */
+
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+using namespace std;
+#include "stacknqueue/IDeck.h"
+
+/*
+ * MPMCQueue: a bounded, lock-free FIFO for any number of producer and consumer threads.
+ *  + ring of capacity cells (rounded up to a power of 2); each cell has a sequence number
+ *      telling whose turn it is:
+ *          seq == pos      : free, the producer with ticket pos may write it;
+ *          seq == pos + 1  : written, the consumer with ticket pos may read it;
+ *      the reader frees the cell for the next lap with seq = pos + capacity.
+ *  + producers take tickets from m_enqueue_pos, consumers from m_dequeue_pos, by CAS;
+ *      nobody waits for a lock, and a slow thread only delays its own cell.
+ *  + try_push_n/try_pop_n take a run of consecutive tickets with one CAS.
+ *
+ * Thread-safe operations: try_push, try_push_n, push (waits for room), try_pop, try_pop_n,
+ *  pop (throws Underflow if empty), size and empty (a snapshot).
+ * peek, contains, remove, clear and toString walk the ring: call them while no other thread
+ *  uses the queue.
+ */
+template<class T>
+class MPMCQueue: public IDeck<T>{
+public:
+    MPMCQueue(size_t capacity=1024, bool (*itemEqual)(T&, T&)=0){
+        m_capacity = 2;
+        while(m_capacity < capacity) m_capacity <<= 1;
+        m_mask = m_capacity - 1;
+        m_cells = new Cell[m_capacity];
+        for(size_t pos=0; pos < m_capacity; pos++) m_cells[pos].seq.store(pos, memory_order_relaxed);
+        m_enqueue_pos.store(0);
+        m_dequeue_pos.store(0);
+        this->itemEqual = itemEqual;
+    }
+    MPMCQueue(const MPMCQueue<T>& queue) = delete;
+    MPMCQueue<T>& operator=(const MPMCQueue<T>& queue) = delete;
+    ~MPMCQueue(){
+        delete []m_cells;
+    }
+
+    bool try_push(const T& item){
+        size_t pos = m_enqueue_pos.load(memory_order_relaxed);
+        Cell* cell;
+        while(true){
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if(diff == 0){
+                if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            }
+            else if(diff < 0) return false; //full
+            else pos = m_enqueue_pos.load(memory_order_relaxed);
+        }
+        cell->data = item;
+        cell->seq.store(pos + 1, memory_order_release);
+        return true;
+    }
+    //pushes up to n items; returns the number of items pushed
+    size_t try_push_n(const T* items, size_t n){
+        size_t pos = m_enqueue_pos.load(memory_order_relaxed);
+        size_t count;
+        while(true){
+            //the run of free cells from pos: they stay free until their tickets are taken
+            count = 0;
+            while((count < n) && (count < m_capacity) &&
+                  (m_cells[(pos + count) & m_mask].seq.load(memory_order_acquire) == pos + count)) count++;
+            if(count == 0){
+                size_t seq = m_cells[pos & m_mask].seq.load(memory_order_acquire);
+                if((intptr_t)seq - (intptr_t)pos < 0) return 0; //full
+                pos = m_enqueue_pos.load(memory_order_relaxed);
+                continue;
+            }
+            if(m_enqueue_pos.compare_exchange_weak(pos, pos + count, memory_order_relaxed)) break;
+        }
+        for(size_t idx=0; idx < count; idx++){
+            Cell& cell = m_cells[(pos + idx) & m_mask];
+            cell.data = items[idx];
+            cell.seq.store(pos + idx + 1, memory_order_release);
+        }
+        return count;
+    }
+
+    bool try_pop(T& item){
+        size_t pos = m_dequeue_pos.load(memory_order_relaxed);
+        Cell* cell;
+        while(true){
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if(diff == 0){
+                if(m_dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            }
+            else if(diff < 0) return false; //empty
+            else pos = m_dequeue_pos.load(memory_order_relaxed);
+        }
+        item = std::move(cell->data);
+        cell->seq.store(pos + m_capacity, memory_order_release);
+        return true;
+    }
+    //pops up to n items; returns the number of items popped
+    size_t try_pop_n(T* items, size_t n){
+        size_t pos = m_dequeue_pos.load(memory_order_relaxed);
+        size_t count;
+        while(true){
+            count = 0;
+            while((count < n) && (count < m_capacity) &&
+                  (m_cells[(pos + count) & m_mask].seq.load(memory_order_acquire) == pos + count + 1)) count++;
+            if(count == 0){
+                size_t seq = m_cells[pos & m_mask].seq.load(memory_order_acquire);
+                if((intptr_t)seq - (intptr_t)(pos + 1) < 0) return 0; //empty
+                pos = m_dequeue_pos.load(memory_order_relaxed);
+                continue;
+            }
+            if(m_dequeue_pos.compare_exchange_weak(pos, pos + count, memory_order_relaxed)) break;
+        }
+        for(size_t idx=0; idx < count; idx++){
+            Cell& cell = m_cells[(pos + idx) & m_mask];
+            items[idx] = std::move(cell.data);
+            cell.seq.store(pos + idx + m_capacity, memory_order_release);
+        }
+        return count;
+    }
+
+    size_t capacity(){ return m_capacity; }
+
+    //Inherit from IDeck: BEGIN
+    void push(T item){
+        while(!try_push(item)) this_thread::yield();
+    }
+    T pop(){
+        T item;
+        if(!try_pop(item)) throw Underflow("MPMCQueue is empty");
+        return item;
+    }
+    T& peek(){
+        size_t pos = m_dequeue_pos.load(memory_order_acquire);
+        Cell& cell = m_cells[pos & m_mask];
+        if(cell.seq.load(memory_order_acquire) != pos + 1) throw Underflow("MPMCQueue is empty");
+        return cell.data;
+    }
+    bool empty(){
+        return size() == 0;
+    }
+    int size(){
+        size_t head = m_dequeue_pos.load(memory_order_acquire);
+        size_t tail = m_enqueue_pos.load(memory_order_acquire);
+        return (tail > head)? (int)(tail - head) : 0;
+    }
+    void clear(){
+        T item;
+        while(try_pop(item));
+    }
+    bool remove(T item){
+        size_t count = size();
+        bool found = false;
+        T current;
+        for(size_t idx=0; idx < count; idx++){
+            try_pop(current);
+            if(!found && equals(current, item)) found = true;
+            else try_push(current);
+        }
+        return found;
+    }
+    bool contains(T item){
+        size_t head = m_dequeue_pos.load(memory_order_acquire);
+        size_t tail = m_enqueue_pos.load(memory_order_acquire);
+        for(size_t pos=head; pos != tail; pos++)
+            if(equals(m_cells[pos & m_mask].data, item)) return true;
+        return false;
+    }
+    string toString(string (*item2str)(T&)=0 ){
+        stringstream os;
+        size_t head = m_dequeue_pos.load(memory_order_acquire);
+        size_t tail = m_enqueue_pos.load(memory_order_acquire);
+        os << "[";
+        for(size_t pos=head; pos != tail; pos++){
+            if(pos != head) os << ", ";
+            if(item2str != 0) os << item2str(m_cells[pos & m_mask].data);
+            else os << m_cells[pos & m_mask].data;
+        }
+        os << "]";
+        return os.str();
+    }
+    //Inherit from IDeck: END
+
+    void println(string (*item2str)(T&)=0 ){
+        cout << toString(item2str) << endl;
+    }
+
+private:
+    bool equals(T& lhs, T& rhs){
+        if(itemEqual == 0) return lhs == rhs;
+        else return itemEqual(lhs, rhs);
+    }
+
+private:
+    struct Cell{
+        atomic<size_t> seq;
+        T data;
+    };
+    Cell* m_cells;
+    size_t m_capacity, m_mask;
+    bool (*itemEqual)(T& lhs, T& rhs);
+
+    alignas(64) atomic<size_t> m_enqueue_pos;
+    alignas(64) atomic<size_t> m_dequeue_pos;
+};
+
+#endif /* MPMCQUEUE_H */
@@ -0,0 +1,193 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   SPSCQueue.h
+ *
+ * Created on November 16, 2024, 3:25 PM
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+using namespace std;
+#include "stacknqueue/IDeck.h"
+
+/*
+ * SPSCQueue: a bounded, lock-free FIFO for ONE producer thread and ONE consumer thread.
+ *  + ring buffer of capacity slots (rounded up to a power of 2);
+ *  + the producer owns tail, the consumer owns head; each side keeps a cached copy of
+ *      the other index and only reloads it when the ring looks full/empty;
+ *  + head and tail live on separate cache lines (no false sharing).
+ *
+ * Thread-safe operations:
+ *  + producer: try_push, try_push_n, push (waits for room)
+ *  + consumer: try_pop, try_pop_n, pop (throws Underflow if empty), peek
+ *  + any thread: size, empty (a snapshot)
+ * contains, remove, clear and toString walk the ring: call them while no other thread
+ *  uses the queue.
+ */
+template<class T>
+class SPSCQueue: public IDeck<T>{
+public:
+    SPSCQueue(size_t capacity=1024, bool (*itemEqual)(T&, T&)=0){
+        m_capacity = 1;
+        while(m_capacity < capacity) m_capacity <<= 1;
+        m_mask = m_capacity - 1;
+        m_buffer = new T[m_capacity];
+        m_head.store(0);
+        m_tail.store(0);
+        m_head_cache = 0;
+        m_tail_cache = 0;
+        this->itemEqual = itemEqual;
+    }
+    SPSCQueue(const SPSCQueue<T>& queue) = delete;
+    SPSCQueue<T>& operator=(const SPSCQueue<T>& queue) = delete;
+    ~SPSCQueue(){
+        delete []m_buffer;
+    }
+
+    //producer side
+    bool try_push(const T& item){
+        size_t tail = m_tail.load(memory_order_relaxed);
+        if(tail - m_head_cache == m_capacity){
+            m_head_cache = m_head.load(memory_order_acquire);
+            if(tail - m_head_cache == m_capacity) return false;
+        }
+        m_buffer[tail & m_mask] = item;
+        m_tail.store(tail + 1, memory_order_release);
+        return true;
+    }
+    //pushes up to n items with one publication; returns the number of items pushed
+    size_t try_push_n(const T* items, size_t n){
+        size_t tail = m_tail.load(memory_order_relaxed);
+        size_t room = m_capacity - (tail - m_head_cache);
+        if(room < n){
+            m_head_cache = m_head.load(memory_order_acquire);
+            room = m_capacity - (tail - m_head_cache);
+        }
+        size_t count = (n < room)? n : room;
+        for(size_t idx=0; idx < count; idx++) m_buffer[(tail + idx) & m_mask] = items[idx];
+        if(count > 0) m_tail.store(tail + count, memory_order_release);
+        return count;
+    }
+
+    //consumer side
+    bool try_pop(T& item){
+        size_t head = m_head.load(memory_order_relaxed);
+        if(head == m_tail_cache){
+            m_tail_cache = m_tail.load(memory_order_acquire);
+            if(head == m_tail_cache) return false;
+        }
+        item = std::move(m_buffer[head & m_mask]);
+        m_head.store(head + 1, memory_order_release);
+        return true;
+    }
+    //pops up to n items with one publication; returns the number of items popped
+    size_t try_pop_n(T* items, size_t n){
+        size_t head = m_head.load(memory_order_relaxed);
+        size_t avail = m_tail_cache - head;
+        if(avail < n){
+            m_tail_cache = m_tail.load(memory_order_acquire);
+            avail = m_tail_cache - head;
+        }
+        size_t count = (n < avail)? n : avail;
+        for(size_t idx=0; idx < count; idx++) items[idx] = std::move(m_buffer[(head + idx) & m_mask]);
+        if(count > 0) m_head.store(head + count, memory_order_release);
+        return count;
+    }
+
+    size_t capacity(){ return m_capacity; }
+
+    //Inherit from IDeck: BEGIN
+    void push(T item){
+        while(!try_push(item)) this_thread::yield();
+    }
+    T pop(){
+        T item;
+        if(!try_pop(item)) throw Underflow("SPSCQueue is empty");
+        return item;
+    }
+    T& peek(){
+        size_t head = m_head.load(memory_order_relaxed);
+        if(head == m_tail_cache){
+            m_tail_cache = m_tail.load(memory_order_acquire);
+            if(head == m_tail_cache) throw Underflow("SPSCQueue is empty");
+        }
+        return m_buffer[head & m_mask];
+    }
+    bool empty(){
+        return size() == 0;
+    }
+    int size(){
+        size_t head = m_head.load(memory_order_acquire);
+        size_t tail = m_tail.load(memory_order_acquire);
+        return (tail > head)? (int)(tail - head) : 0;
+    }
+    void clear(){
+        T item;
+        while(try_pop(item));
+    }
+    bool remove(T item){
+        size_t count = size();
+        bool found = false;
+        T current;
+        for(size_t idx=0; idx < count; idx++){
+            try_pop(current);
+            if(!found && equals(current, item)) found = true;
+            else try_push(current);
+        }
+        return found;
+    }
+    bool contains(T item){
+        size_t head = m_head.load(memory_order_acquire);
+        size_t tail = m_tail.load(memory_order_acquire);
+        for(size_t pos=head; pos != tail; pos++)
+            if(equals(m_buffer[pos & m_mask], item)) return true;
+        return false;
+    }
+    string toString(string (*item2str)(T&)=0 ){
+        stringstream os;
+        size_t head = m_head.load(memory_order_acquire);
+        size_t tail = m_tail.load(memory_order_acquire);
+        os << "[";
+        for(size_t pos=head; pos != tail; pos++){
+            if(pos != head) os << ", ";
+            if(item2str != 0) os << item2str(m_buffer[pos & m_mask]);
+            else os << m_buffer[pos & m_mask];
+        }
+        os << "]";
+        return os.str();
+    }
+    //Inherit from IDeck: END
+
+    void println(string (*item2str)(T&)=0 ){
+        cout << toString(item2str) << endl;
+    }
+
+private:
+    bool equals(T& lhs, T& rhs){
+        if(itemEqual == 0) return lhs == rhs;
+        else return itemEqual(lhs, rhs);
+    }
+
+private:
+    T* m_buffer;
+    size_t m_capacity, m_mask;
+    bool (*itemEqual)(T& lhs, T& rhs);
+
+    //consumer: head and its copy of tail
+    alignas(64) atomic<size_t> m_head;
+    size_t m_tail_cache;
+    //producer: tail and its copy of head
+    alignas(64) atomic<size_t> m_tail;
+    size_t m_head_cache;
+};
+
+#endif /* SPSCQUEUE_H */
@@ -0,0 +1,126 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   csr_matrix.h
+ *
+ * Created on November 25, 2024, 9:10 AM
+ */
+
+#ifndef CSR_MATRIX_H
+#define CSR_MATRIX_H
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "tensor/xtensor_lib.h"
+using namespace std;
+
+/*
+ * CSRMatrix<T>: a [nrows, ncols] matrix in compressed sparse row format
+ *  + offsets [nrows + 1]: the non-zeros of row r are at [offsets[r], offsets[r + 1]);
+ *  + indices [nnz]: their column indices (uint32, ascending within a row);
+ *  + values [nnz]: their values.
+ *  The memory is O(nrows + nnz); rows are appended with add_row/append_row.
+ */
+template<class T>
+class CSRMatrix{
+public:
+    explicit CSRMatrix(size_t ncols=0): m_nCols(ncols){
+        check_cols(ncols);
+        m_offsets.push_back(0);
+    }
+
+    //from_dense: X [nrows, ...] is seen as [nrows, X.size()/nrows]; the zeros are dropped
+    static CSRMatrix<T> from_dense(const aligned_tensor<T>& X){
+        size_t nrows = (X.dimension() == 0)? 1 : X.shape()[0];
+        size_t ncols = (nrows == 0)? 0 : X.size()/nrows;
+        CSRMatrix<T> M(ncols);
+        const T* x = X.data();
+        for(size_t r=0; r < nrows; r++){
+            for(size_t c=0; c < ncols; c++){
+                if(x[r*ncols + c] == T(0)) continue;
+                M.m_indices.push_back(c);
+                M.m_values.push_back(x[r*ncols + c]);
+            }
+            M.m_offsets.push_back(M.m_values.size());
+        }
+        return M;
+    }
+    aligned_tensor<T> to_dense() const{
+        aligned_tensor<T> X = xt::zeros<T>({rows(), m_nCols});
+        for(size_t r=0; r < rows(); r++)
+            for(size_t k=m_offsets[r]; k < m_offsets[r + 1]; k++) X(r, m_indices[k]) = m_values[k];
+        return X;
+    }
+
+    //add_row: appends a row with the nnz entries (indices[k], values[k]); indices ascending
+    void add_row(const unsigned long* indices, const T* values, size_t nnz){
+        for(size_t k=0; k < nnz; k++){
+            if(indices[k] >= m_nCols) throw std::out_of_range("CSRMatrix::add_row: column index is out of range!");
+            m_indices.push_back(indices[k]);
+            m_values.push_back(values[k]);
+        }
+        m_offsets.push_back(m_values.size());
+    }
+    //append_row: appends row r of other (same number of columns)
+    void append_row(const CSRMatrix<T>& other, size_t r){
+        if(r >= other.rows()) throw std::out_of_range("CSRMatrix::append_row: row is out of range!");
+        m_indices.insert(m_indices.end(), other.m_indices.begin() + other.m_offsets[r],
+                         other.m_indices.begin() + other.m_offsets[r + 1]);
+        m_values.insert(m_values.end(), other.m_values.begin() + other.m_offsets[r],
+                        other.m_values.begin() + other.m_offsets[r + 1]);
+        m_offsets.push_back(m_values.size());
+    }
+    //slice_rows: the rows [begin, end)
+    CSRMatrix<T> slice_rows(size_t begin, size_t end) const{
+        CSRMatrix<T> M(m_nCols);
+        M.reserve(end - begin, m_offsets[end] - m_offsets[begin]);
+        for(size_t r=begin; r < end; r++) M.append_row(*this, r);
+        return M;
+    }
+    void reserve(size_t nrows, size_t nnz){
+        m_offsets.reserve(m_offsets.size() + nrows);
+        m_indices.reserve(m_indices.size() + nnz);
+        m_values.reserve(m_values.size() + nnz);
+    }
+    void clear(){
+        m_offsets.assign(1, 0);
+        m_indices.clear();
+        m_values.clear();
+    }
+
+    size_t rows() const { return m_offsets.size() - 1; }
+    size_t cols() const { return m_nCols; }
+    size_t nnz() const { return m_values.size(); }
+    size_t row_nnz(size_t r) const { return m_offsets[r + 1] - m_offsets[r]; }
+    const size_t* offsets() const { return m_offsets.data(); }
+    const uint32_t* indices() const { return m_indices.data(); }
+    const T* values() const { return m_values.data(); }
+    T* values(){ return m_values.data(); }
+
+    bool operator==(const CSRMatrix<T>& other) const{
+        return (m_nCols == other.m_nCols) && (m_offsets == other.m_offsets) &&
+               (m_indices == other.m_indices) && (m_values == other.m_values);
+    }
+    friend std::ostream& operator<<(std::ostream& os, const CSRMatrix<T>& M){
+        os << "CSR [" << M.rows() << ", " << M.cols() << "], nnz=" << M.nnz();
+        return os;
+    }
+
+private:
+    static void check_cols(size_t ncols){
+        if(ncols > (size_t)std::numeric_limits<uint32_t>::max())
+            throw std::length_error("CSRMatrix: too many columns for 32-bit indices");
+    }
+
+private:
+    size_t m_nCols;
+    vector<size_t> m_offsets;
+    vector<uint32_t> m_indices;
+    vector<T> m_values;
+};
+
+#endif /* CSR_MATRIX_H */
@@ -0,0 +1,86 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   tensor_allocator.h
+ *
+ * Created on December 4, 2024, 10:20 AM
+ */
+
+#ifndef TENSOR_ALLOCATOR_H
+#define TENSOR_ALLOCATOR_H
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <string>
+using namespace std;
+
+/*
+ * TensorMemory: the memory of the tensor buffers (see TensorAllocator)
+ *  + every buffer starts on a cache line (ALIGNMENT = 64 bytes): aligned SIMD loads, and no
+ *      false sharing between the first elements of two buffers;
+ *  + huge pages (Linux, transparent huge pages): a buffer of at least huge_page_min_bytes
+ *      is aligned on 2 MB and advised with madvise(MADV_HUGEPAGE), so the kernel can back
+ *      it with huge pages (fewer TLB misses on large weights and activations);
+ *  + configure(huge_pages, min_kb): config keys tensor_huge_pages (0/1, default 0) and
+ *      tensor_huge_page_min_kb (default 4096), see IModel;
+ *  + stats(): counters since the start of the process (or reset_stats), thread-safe.
+ */
+class TensorMemory {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+    struct Stats {
+        unsigned long long allocations, deallocations, huge_page_allocations;
+        unsigned long long bytes_allocated; //total requested
+        long long bytes_live, bytes_peak; //requested, not freed yet
+    };
+
+    static void configure(bool huge_pages, size_t huge_page_min_kb=4096);
+    static void* allocate(size_t bytes);
+    static void deallocate(void* p, size_t bytes);
+    static Stats stats();
+    static void reset_stats();
+    static string get_desc();
+
+private:
+    static atomic<bool> m_huge_pages;
+    static atomic<size_t> m_huge_page_min_bytes;
+    static atomic<unsigned long long> m_allocations, m_deallocations, m_huge_page_allocations, m_bytes_allocated;
+    static atomic<long long> m_bytes_live, m_bytes_peak;
+};
+
+/*
+ * TensorAllocator<T>: the allocator of the tensors of the library (see aligned_tensor in
+ *  xtensor_lib.h): stateless, all instances are equal; the memory comes from TensorMemory.
+ */
+template<class T>
+class TensorAllocator {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    TensorAllocator() noexcept {}
+    template<class U>
+    TensorAllocator(const TensorAllocator<U>&) noexcept {}
+    template<class U>
+    struct rebind { typedef TensorAllocator<U> other; };
+
+    T* allocate(size_t n){
+        if(n > size_t(-1)/sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(TensorMemory::allocate(n*sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        TensorMemory::deallocate(p, n*sizeof(T));
+    }
+};
+
+template<class T, class U>
+bool operator==(const TensorAllocator<T>&, const TensorAllocator<U>&) noexcept { return true; }
+template<class T, class U>
+bool operator!=(const TensorAllocator<T>&, const TensorAllocator<U>&) noexcept { return false; }
+
+#endif /* TENSOR_ALLOCATOR_H */
@@ -28,19 +28,35 @@ using namespace std;
 #include "tensor/xtensor/xsort.hpp"
 #include "tensor/xtensor/xarray.hpp"
 #include "tensor/xtensor/xnpy.hpp"
+#include "tensor/tensor_allocator.h"
 #include <ctime>
 
 typedef unsigned long ulong;
+/*
+ * aligned_tensor<T>: xt::xarray on TensorAllocator (64-byte aligned buffers, huge pages for
+ *  the large ones, allocation stats: see TensorMemory); the tensors of the ANN library.
+ *  empty_tensor: an uninitialized double_tensor (xt::empty would allocate an std::allocator
+ *  array, then copy it).
+ */
+template<class T>
+using aligned_tensor = xt::xarray<T, XTENSOR_DEFAULT_LAYOUT, TensorAllocator<T>>;
 typedef xt::xarray<ulong> ulong_tensor;
-typedef xt::xarray<double> double_tensor;
+typedef aligned_tensor<double> double_tensor;
+
+template<class S>
+double_tensor empty_tensor(const S& shape){ return double_tensor::from_shape(shape); }
+template<class I, size_t L>
+double_tensor empty_tensor(const I (&shape)[L]){
+    return double_tensor::from_shape(xt::svector<size_t>(std::begin(shape), std::end(shape)));
+}
 
 
 
 string shape2str(xt::svector<unsigned long> vec);
 int positive_index(int idx, int size);
-xt::xarray<double> outer_stack(xt::xarray<double> X, xt::xarray<double>  Y);
-xt::xarray<double> diag_stack(xt::xarray<double> X);
-xt::xarray<double> matmul_on_stack(xt::xarray<double> X, xt::xarray<double>  Y);
+double_tensor outer_stack(double_tensor X, double_tensor  Y);
+double_tensor diag_stack(double_tensor X);
+double_tensor matmul_on_stack(double_tensor X, double_tensor  Y);
 
 
 #endif /* XTENSOR_LIB_H */
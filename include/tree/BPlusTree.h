@@ -0,0 +1,642 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   BPlusTree.h
+ *
+ * Created on November 22, 2024, 10:00 AM
+ */
+
+#ifndef BPLUSTREE_H
+#define BPLUSTREE_H
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+#include "tree/IBST.h"
+#include "ann/kernels/vecmath.h"
+using namespace std;
+
+/*
+ * bptree::count_less(keys, count, capacity, key): the number of keys[0..count) less than key,
+ *  i.e., the position of key in a sorted node (lower bound).
+ *  + signed 32/64-bit integers, float and double: 8 or 16 keys per compare (AVX2/AVX-512,
+ *      selected by simd_level()); the slots keys[count..capacity) must hold the largest
+ *      value of K (BPlusTree keeps them so), they are compared too and never counted;
+ *  + other K: a branch-free loop over the keys with operator<.
+ */
+namespace bptree{
+#if ANN_HAVE_X86
+    ANN_TARGET_AVX512 inline int count_less_avx512(const int32_t* keys, int count, int capacity, int32_t key){
+        __m512i k = _mm512_set1_epi32(key);
+        int rank = 0, i = 0;
+        for(; (i < count) && (i + 16 <= capacity); i += 16)
+            rank += __builtin_popcount(_mm512_cmplt_epi32_mask(_mm512_loadu_si512(keys + i), k));
+        for(; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+    ANN_TARGET_AVX512 inline int count_less_avx512(const int64_t* keys, int count, int capacity, int64_t key){
+        __m512i k = _mm512_set1_epi64(key);
+        int rank = 0, i = 0;
+        for(; (i < count) && (i + 8 <= capacity); i += 8)
+            rank += __builtin_popcount(_mm512_cmplt_epi64_mask(_mm512_loadu_si512(keys + i), k));
+        for(; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+    ANN_TARGET_AVX512 inline int count_less_avx512(const float* keys, int count, int capacity, float key){
+        __m512 k = _mm512_set1_ps(key);
+        int rank = 0, i = 0;
+        for(; (i < count) && (i + 16 <= capacity); i += 16)
+            rank += __builtin_popcount(_mm512_cmp_ps_mask(_mm512_loadu_ps(keys + i), k, _CMP_LT_OQ));
+        for(; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+    ANN_TARGET_AVX512 inline int count_less_avx512(const double* keys, int count, int capacity, double key){
+        __m512d k = _mm512_set1_pd(key);
+        int rank = 0, i = 0;
+        for(; (i < count) && (i + 8 <= capacity); i += 8)
+            rank += __builtin_popcount(_mm512_cmp_pd_mask(_mm512_loadu_pd(keys + i), k, _CMP_LT_OQ));
+        for(; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+
+    ANN_TARGET_AVX2 inline int count_less_avx2(const int32_t* keys, int count, int capacity, int32_t key){
+        __m256i k = _mm256_set1_epi32(key);
+        int rank = 0, i = 0;
+        for(; (i < count) && (i + 8 <= capacity); i += 8){
+            __m256i less = _mm256_cmpgt_epi32(k, _mm256_loadu_si256((const __m256i*)(keys + i)));
+            rank += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(less)));
+        }
+        for(; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+    ANN_TARGET_AVX2 inline int count_less_avx2(const int64_t* keys, int count, int capacity, int64_t key){
+        __m256i k = _mm256_set1_epi64x(key);
+        int rank = 0, i = 0;
+        for(; (i < count) && (i + 4 <= capacity); i += 4){
+            __m256i less = _mm256_cmpgt_epi64(k, _mm256_loadu_si256((const __m256i*)(keys + i)));
+            rank += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(less)));
+        }
+        for(; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+    ANN_TARGET_AVX2 inline int count_less_avx2(const float* keys, int count, int capacity, float key){
+        __m256 k = _mm256_set1_ps(key);
+        int rank = 0, i = 0;
+        for(; (i < count) && (i + 8 <= capacity); i += 8)
+            rank += __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(keys + i), k, _CMP_LT_OQ)));
+        for(; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+    ANN_TARGET_AVX2 inline int count_less_avx2(const double* keys, int count, int capacity, double key){
+        __m256d k = _mm256_set1_pd(key);
+        int rank = 0, i = 0;
+        for(; (i < count) && (i + 4 <= capacity); i += 4)
+            rank += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(keys + i), k, _CMP_LT_OQ)));
+        for(; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+
+    template<class S>
+    inline int count_less_simd(const S* keys, int count, int capacity, S key){
+        SimdLevel level = simd_level();
+        if(level == SIMD_AVX512) return count_less_avx512(keys, count, capacity, key);
+        if(level == SIMD_AVX2) return count_less_avx2(keys, count, capacity, key);
+        int rank = 0;
+        for(int i=0; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+#endif
+
+    //the keys with a SIMD path; their unused slots are padded with pad_key<K>()
+    template<class K>
+    struct has_simd{
+        static const bool value = std::is_same<K, float>::value || std::is_same<K, double>::value ||
+            (std::is_integral<K>::value && std::is_signed<K>::value && ((sizeof(K) == 4) || (sizeof(K) == 8)));
+    };
+    template<class K>
+    inline K pad_key(){
+        if(std::numeric_limits<K>::has_infinity) return std::numeric_limits<K>::infinity();
+        return std::numeric_limits<K>::max();
+    }
+
+    template<class K>
+    inline int count_less(const K* keys, int count, int capacity, const K& key){
+#if ANN_HAVE_X86
+        if constexpr(std::is_same<K, float>::value || std::is_same<K, double>::value)
+            return count_less_simd(keys, count, capacity, key);
+        else if constexpr(has_simd<K>::value && (sizeof(K) == 4))
+            return count_less_simd((const int32_t*)keys, count, capacity, (int32_t)key);
+        else if constexpr(has_simd<K>::value && (sizeof(K) == 8))
+            return count_less_simd((const int64_t*)keys, count, capacity, (int64_t)key);
+#endif
+        int rank = 0;
+        for(int i=0; i < count; i++) rank += (keys[i] < key);
+        return rank;
+    }
+
+    /*
+     * NodePool: fixed-size blocks cut from 2 MB chunks; released blocks are reused (free list).
+     *  The chunks are 2 MB aligned and advised for transparent huge pages: the nodes of a
+     *  tree sit on few pages, so a lookup takes few TLB misses.
+     */
+    class NodePool{
+    public:
+        static const size_t CHUNK_BYTES = 1 << 21;
+
+        NodePool(size_t block_bytes){
+            m_block_bytes = (block_bytes + 63) & ~(size_t)63;
+            m_used = CHUNK_BYTES;
+            m_free = nullptr;
+        }
+        NodePool(const NodePool& pool) = delete;
+        NodePool& operator=(const NodePool& pool) = delete;
+        ~NodePool(){
+            clear();
+        }
+
+        void* allocate(){
+            if(m_free != nullptr){
+                void* block = m_free;
+                m_free = *(void**)m_free;
+                return block;
+            }
+            if(m_used + m_block_bytes > CHUNK_BYTES){
+                void* chunk = aligned_alloc(CHUNK_BYTES, CHUNK_BYTES);
+                if(chunk == nullptr) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+                madvise(chunk, CHUNK_BYTES, MADV_HUGEPAGE);
+#endif
+                m_chunks.push_back((char*)chunk);
+                m_used = 0;
+            }
+            void* block = m_chunks.back() + m_used;
+            m_used += m_block_bytes;
+            return block;
+        }
+        void release(void* block){
+            *(void**)block = m_free;
+            m_free = block;
+        }
+        //releases all the blocks at once
+        void clear(){
+            for(char* chunk: m_chunks) free(chunk);
+            m_chunks.clear();
+            m_used = CHUNK_BYTES;
+            m_free = nullptr;
+        }
+
+    private:
+        size_t m_block_bytes;
+        vector<char*> m_chunks;
+        size_t m_used;
+        void* m_free;
+    };
+}
+
+/*
+ * BPlusTree<K, V, B>: a B+-tree implementing IBST.
+ *  + every node holds up to B keys in one aligned array (B*sizeof(K) = 256 bytes by default:
+ *      4 cache lines, a few SIMD compares per node, see bptree::count_less);
+ *      a lookup touches height() nodes instead of log2(n) pointer-chased nodes;
+ *  + the values are in the leaves only; inner nodes hold separators and B + 1 children
+ *      (child i: separator[i-1] <= key < separator[i]);
+ *  + the leaves are chained both ways: ascendingList/descendingList and range scans
+ *      (range, scan) walk the chain, no recursion;
+ *  + the nodes come from per-tree pools of 2 MB chunks (bptree::NodePool);
+ *  + add splits full nodes on the way down; remove borrows from or merges with a sibling
+ *      when a node falls under B/2 keys; add with an existing key replaces its value.
+ */
+template<class K>
+struct BPlusTreeOrder{
+    static const int value = (256/sizeof(K) >= 8)? (int)(256/sizeof(K)) : 8;
+};
+
+template<class K, class V, int B=BPlusTreeOrder<K>::value>
+class BPlusTree: public IBST<K, V>{
+    static_assert(B >= 4, "BPlusTree: B must be at least 4");
+public:
+    BPlusTree(): m_leaves(sizeof(Leaf)), m_inners(sizeof(Inner)){
+        m_pRoot = nullptr;
+        m_count = 0;
+    }
+    BPlusTree(const BPlusTree<K, V, B>& tree) = delete;
+    BPlusTree<K, V, B>& operator=(const BPlusTree<K, V, B>& tree) = delete;
+    ~BPlusTree(){
+        clear();
+    }
+
+    void add(K key, V value=0){
+        if(m_pRoot == nullptr) m_pRoot = new_leaf();
+        if(m_pRoot->count == B){
+            Inner* root = new_inner();
+            root->children[0] = m_pRoot;
+            split_child(root, 0);
+            m_pRoot = root;
+        }
+        Node* node = m_pRoot;
+        while(!node->leaf){
+            Inner* inner = static_cast<Inner*>(node);
+            int idx = child_index(inner, key);
+            if(inner->children[idx]->count == B){
+                split_child(inner, idx);
+                if(!(key < inner->keys[idx])) idx++;
+            }
+            node = inner->children[idx];
+        }
+
+        Leaf* leaf = static_cast<Leaf*>(node);
+        int pos = position(leaf, key);
+        if((pos < leaf->count) && !(key < leaf->keys[pos])){
+            leaf->values[pos] = value;
+            return;
+        }
+        for(int i=leaf->count; i > pos; i--){
+            leaf->keys[i] = leaf->keys[i - 1];
+            leaf->values[i] = leaf->values[i - 1];
+        }
+        leaf->keys[pos] = key;
+        leaf->values[pos] = value;
+        leaf->count++;
+        m_count++;
+    }
+
+    V remove(K key, bool* success=0){
+        bool found = false;
+        V value = V();
+        if(m_pRoot != nullptr){
+            value = remove_from(m_pRoot, key, found);
+            if(!m_pRoot->leaf && (m_pRoot->count == 0)){
+                Node* old = m_pRoot;
+                m_pRoot = static_cast<Inner*>(old)->children[0];
+                free_node(old);
+            }
+        }
+        if(found) m_count--;
+        if(success != 0) *success = found;
+        return value;
+    }
+
+    V search(K key, bool& found){
+        found = false;
+        if(m_pRoot == nullptr) return V();
+        Node* node = m_pRoot;
+        while(!node->leaf){
+            Inner* inner = static_cast<Inner*>(node);
+            node = inner->children[child_index(inner, key)];
+        }
+        Leaf* leaf = static_cast<Leaf*>(node);
+        int pos = position(leaf, key);
+        if((pos < leaf->count) && !(key < leaf->keys[pos])){
+            found = true;
+            return leaf->values[pos];
+        }
+        return V();
+    }
+
+    int size(){ return m_count; }
+    int height(){
+        int levels = 0;
+        for(Node* node=m_pRoot; node != nullptr; levels++){
+            if(node->leaf) node = nullptr;
+            else node = static_cast<Inner*>(node)->children[0];
+        }
+        return levels;
+    }
+    void clear(){
+        if(m_pRoot != nullptr) free_subtree(m_pRoot);
+        m_leaves.clear();
+        m_inners.clear();
+        m_pRoot = nullptr;
+        m_count = 0;
+    }
+    bool empty(){ return m_count == 0; }
+
+    DLinkedList<V> ascendingList(){
+        DLinkedList<V> list;
+        for(Leaf* leaf=leftmost(); leaf != nullptr; leaf = leaf->next)
+            for(int i=0; i < leaf->count; i++) list.add(leaf->values[i]);
+        return list;
+    }
+    DLinkedList<V> descendingList(){
+        DLinkedList<V> list;
+        for(Leaf* leaf=rightmost(); leaf != nullptr; leaf = leaf->prev)
+            for(int i=leaf->count - 1; i >= 0; i--) list.add(leaf->values[i]);
+        return list;
+    }
+
+    /*
+     * scan(lo, hi, fn): calls fn(key, value) for the keys in [lo, hi], in ascending order;
+     *  fn returns false to stop early. range(lo, hi): the values of the same keys.
+     */
+    template<class Fn>
+    void scan(K lo, K hi, Fn fn){
+        if(m_pRoot == nullptr) return;
+        Node* node = m_pRoot;
+        while(!node->leaf){
+            Inner* inner = static_cast<Inner*>(node);
+            node = inner->children[child_index(inner, lo)];
+        }
+        Leaf* leaf = static_cast<Leaf*>(node);
+        int pos = position(leaf, lo);
+        for(; leaf != nullptr; leaf = leaf->next, pos = 0)
+            for(; pos < leaf->count; pos++){
+                if(hi < leaf->keys[pos]) return;
+                if(!fn(leaf->keys[pos], leaf->values[pos])) return;
+            }
+    }
+    DLinkedList<V> range(K lo, K hi){
+        DLinkedList<V> list;
+        scan(lo, hi, [&list](K&, V& value){
+            list.add(value);
+            return true;
+        });
+        return list;
+    }
+
+    //one line per level: inner nodes show their separators, leaves their entries
+    string toString(string (*entry2str)(K&, V&)=0, bool /*avl*/=false){
+        stringstream os;
+        if(m_pRoot == nullptr) return "";
+        vector<Node*> level(1, m_pRoot);
+        while(!level.empty()){
+            vector<Node*> next;
+            for(auto node: level){
+                os << "[";
+                for(int i=0; i < node->count; i++){
+                    if(i > 0) os << ", ";
+                    if(node->leaf && (entry2str != 0))
+                        os << entry2str(node->keys[i], static_cast<Leaf*>(node)->values[i]);
+                    else os << node->keys[i];
+                }
+                os << "]";
+                if(!node->leaf)
+                    for(int i=0; i <= node->count; i++) next.push_back(static_cast<Inner*>(node)->children[i]);
+            }
+            os << endl;
+            level.swap(next);
+        }
+        return os.str();
+    }
+    void println(string (*entry2str)(K&, V&)=0){
+        cout << toString(entry2str) << endl;
+    }
+
+private:
+    struct Node{
+        alignas(64) K keys[B];
+        int count;
+        bool leaf;
+    };
+    struct Leaf: Node{
+        V values[B];
+        Leaf* prev;
+        Leaf* next;
+    };
+    struct Inner: Node{
+        Node* children[B + 1];
+    };
+    enum{ MIN_KEYS = B/2 };
+
+    static void pad(Node* node){
+        if constexpr(bptree::has_simd<K>::value)
+            for(int i=node->count; i < B; i++) node->keys[i] = bptree::pad_key<K>();
+    }
+    Leaf* new_leaf(){
+        Leaf* leaf = new (m_leaves.allocate()) Leaf();
+        leaf->count = 0;
+        leaf->leaf = true;
+        leaf->prev = leaf->next = nullptr;
+        pad(leaf);
+        return leaf;
+    }
+    Inner* new_inner(){
+        Inner* inner = new (m_inners.allocate()) Inner();
+        inner->count = 0;
+        inner->leaf = false;
+        pad(inner);
+        return inner;
+    }
+    void free_node(Node* node){
+        if(node->leaf){
+            static_cast<Leaf*>(node)->~Leaf();
+            m_leaves.release(node);
+        }
+        else{
+            static_cast<Inner*>(node)->~Inner();
+            m_inners.release(node);
+        }
+    }
+    void free_subtree(Node* node){
+        if(!node->leaf){
+            Inner* inner = static_cast<Inner*>(node);
+            for(int i=0; i <= inner->count; i++) free_subtree(inner->children[i]);
+        }
+        free_node(node);
+    }
+    /*
+     * position: the number of keys of node less than key.
+     *  The key lines are prefetched together, so their misses overlap; padded nodes are
+     *  compared whole (the padding is never counted), so the search does not wait for count.
+     */
+    static int position(Node* node, const K& key){
+        for(size_t line=0; line < sizeof(node->keys); line += 64)
+            __builtin_prefetch((const char*)node->keys + line);
+        return bptree::count_less(node->keys, bptree::has_simd<K>::value? B : node->count, B, key);
+    }
+    //the child to follow for key: the number of separators <= key
+    static int child_index(Inner* inner, const K& key){
+        int idx = position(inner, key);
+        if((idx < inner->count) && !(key < inner->keys[idx])) idx++;
+        return idx;
+    }
+    Leaf* leftmost(){
+        Node* node = m_pRoot;
+        if(node == nullptr) return nullptr;
+        while(!node->leaf) node = static_cast<Inner*>(node)->children[0];
+        return static_cast<Leaf*>(node);
+    }
+    Leaf* rightmost(){
+        Node* node = m_pRoot;
+        if(node == nullptr) return nullptr;
+        while(!node->leaf){
+            Inner* inner = static_cast<Inner*>(node);
+            node = inner->children[inner->count];
+        }
+        return static_cast<Leaf*>(node);
+    }
+
+    //parent->children[idx] is full and parent is not: split it in two halves
+    void split_child(Inner* parent, int idx){
+        Node* child = parent->children[idx];
+        int mid = B/2;
+        K separator;
+        Node* sibling;
+        if(child->leaf){
+            Leaf* left = static_cast<Leaf*>(child);
+            Leaf* right = new_leaf();
+            for(int i=mid; i < B; i++){
+                right->keys[i - mid] = left->keys[i];
+                right->values[i - mid] = left->values[i];
+            }
+            right->count = B - mid;
+            left->count = mid;
+            right->next = left->next;
+            if(right->next != nullptr) right->next->prev = right;
+            left->next = right;
+            right->prev = left;
+            separator = right->keys[0];
+            sibling = right;
+        }
+        else{
+            Inner* left = static_cast<Inner*>(child);
+            Inner* right = new_inner();
+            separator = left->keys[mid];
+            for(int i=mid + 1; i < B; i++) right->keys[i - mid - 1] = left->keys[i];
+            for(int i=mid + 1; i <= B; i++) right->children[i - mid - 1] = left->children[i];
+            right->count = B - mid - 1;
+            left->count = mid;
+            sibling = right;
+        }
+        pad(child);
+
+        for(int i=parent->count; i > idx; i--){
+            parent->keys[i] = parent->keys[i - 1];
+            parent->children[i + 1] = parent->children[i];
+        }
+        parent->keys[idx] = separator;
+        parent->children[idx + 1] = sibling;
+        parent->count++;
+    }
+
+    V remove_from(Node* node, K& key, bool& found){
+        if(node->leaf){
+            Leaf* leaf = static_cast<Leaf*>(node);
+            int pos = position(leaf, key);
+            if((pos >= leaf->count) || (key < leaf->keys[pos])) return V();
+            found = true;
+            V value = leaf->values[pos];
+            for(int i=pos + 1; i < leaf->count; i++){
+                leaf->keys[i - 1] = leaf->keys[i];
+                leaf->values[i - 1] = leaf->values[i];
+            }
+            leaf->count--;
+            pad(leaf);
+            return value;
+        }
+        Inner* inner = static_cast<Inner*>(node);
+        int idx = child_index(inner, key);
+        V value = remove_from(inner->children[idx], key, found);
+        if(found && (inner->children[idx]->count < MIN_KEYS)) rebalance(inner, idx);
+        return value;
+    }
+
+    //parent->children[idx] has too few keys: borrow one from a sibling, or merge with it
+    void rebalance(Inner* parent, int idx){
+        if((idx > 0) && (parent->children[idx - 1]->count > MIN_KEYS)) borrow_from_left(parent, idx);
+        else if((idx < parent->count) && (parent->children[idx + 1]->count > MIN_KEYS)) borrow_from_right(parent, idx);
+        else if(idx > 0) merge(parent, idx - 1);
+        else merge(parent, idx);
+    }
+    static void borrow_from_left(Inner* parent, int idx){
+        Node* left = parent->children[idx - 1];
+        Node* child = parent->children[idx];
+        if(child->leaf){
+            Leaf* l = static_cast<Leaf*>(left);
+            Leaf* c = static_cast<Leaf*>(child);
+            for(int i=c->count; i > 0; i--){
+                c->keys[i] = c->keys[i - 1];
+                c->values[i] = c->values[i - 1];
+            }
+            c->keys[0] = l->keys[l->count - 1];
+            c->values[0] = l->values[l->count - 1];
+            parent->keys[idx - 1] = c->keys[0];
+        }
+        else{
+            Inner* l = static_cast<Inner*>(left);
+            Inner* c = static_cast<Inner*>(child);
+            for(int i=c->count; i > 0; i--) c->keys[i] = c->keys[i - 1];
+            for(int i=c->count + 1; i > 0; i--) c->children[i] = c->children[i - 1];
+            c->keys[0] = parent->keys[idx - 1];
+            c->children[0] = l->children[l->count];
+            parent->keys[idx - 1] = l->keys[l->count - 1];
+        }
+        left->count--;
+        child->count++;
+        pad(left);
+    }
+    static void borrow_from_right(Inner* parent, int idx){
+        Node* child = parent->children[idx];
+        Node* right = parent->children[idx + 1];
+        if(child->leaf){
+            Leaf* c = static_cast<Leaf*>(child);
+            Leaf* r = static_cast<Leaf*>(right);
+            c->keys[c->count] = r->keys[0];
+            c->values[c->count] = r->values[0];
+            for(int i=1; i < r->count; i++){
+                r->keys[i - 1] = r->keys[i];
+                r->values[i - 1] = r->values[i];
+            }
+            parent->keys[idx] = r->keys[0];
+        }
+        else{
+            Inner* c = static_cast<Inner*>(child);
+            Inner* r = static_cast<Inner*>(right);
+            c->keys[c->count] = parent->keys[idx];
+            c->children[c->count + 1] = r->children[0];
+            parent->keys[idx] = r->keys[0];
+            for(int i=1; i < r->count; i++) r->keys[i - 1] = r->keys[i];
+            for(int i=1; i <= r->count; i++) r->children[i - 1] = r->children[i];
+        }
+        child->count++;
+        right->count--;
+        pad(right);
+    }
+    //merges parent->children[idx + 1] into parent->children[idx]
+    void merge(Inner* parent, int idx){
+        Node* left = parent->children[idx];
+        Node* right = parent->children[idx + 1];
+        if(left->leaf){
+            Leaf* l = static_cast<Leaf*>(left);
+            Leaf* r = static_cast<Leaf*>(right);
+            for(int i=0; i < r->count; i++){
+                l->keys[l->count + i] = r->keys[i];
+                l->values[l->count + i] = r->values[i];
+            }
+            l->count += r->count;
+            l->next = r->next;
+            if(l->next != nullptr) l->next->prev = l;
+            free_node(r);
+        }
+        else{
+            Inner* l = static_cast<Inner*>(left);
+            Inner* r = static_cast<Inner*>(right);
+            l->keys[l->count] = parent->keys[idx];
+            for(int i=0; i < r->count; i++) l->keys[l->count + 1 + i] = r->keys[i];
+            for(int i=0; i <= r->count; i++) l->children[l->count + 1 + i] = r->children[i];
+            l->count += r->count + 1;
+            free_node(r);
+        }
+
+        for(int i=idx + 1; i < parent->count; i++){
+            parent->keys[i - 1] = parent->keys[i];
+            parent->children[i] = parent->children[i + 1];
+        }
+        parent->count--;
+        pad(parent);
+    }
+
+private:
+    bptree::NodePool m_leaves, m_inners;
+    Node* m_pRoot;
+    int m_count;
+};
+
+#endif /* BPLUSTREE_H */
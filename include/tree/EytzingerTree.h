@@ -0,0 +1,181 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   EytzingerTree.h
+ *
+ * Created on November 22, 2024, 3:30 PM
+ */
+
+#ifndef EYTZINGERTREE_H
+#define EYTZINGERTREE_H
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tree/IBST.h"
+using namespace std;
+
+/*
+ * EytzingerTree<K, V>: a read-optimised, static IBST for bulk-built lookup tables.
+ *  + the keys are stored as an implicit complete BST in BFS order (Eytzinger layout):
+ *      the children of slot k are 2k and 2k + 1, slot 1 is the root; no pointers;
+ *  + search is branch-free (k = 2k + (key[k] < key)) and prefetches the slots four levels
+ *      down, which share a cache line: the memory latency of a level overlaps the next ones;
+ *      the values are kept in the same slot order, so a hit costs one more load;
+ *  + the entries are also kept sorted: ascendingList/descendingList/range are array walks;
+ *  + build(keys, values, n) bulk-loads the table (O(n log n)); add/remove are O(n) and
+ *      only mark the layout stale, it is rebuilt by the next search.
+ *      A stale tree is rebuilt inside search: do not search concurrently after an update.
+ *  + duplicate keys: the last value wins.
+ */
+template<class K, class V>
+class EytzingerTree: public IBST<K, V>{
+public:
+    EytzingerTree(){
+        m_stale = false;
+        m_layout.resize(1);
+        m_slot_values.resize(1);
+    }
+    EytzingerTree(K* keys, V* values, int n): EytzingerTree(){
+        build(keys, values, n);
+    }
+
+    void build(K* keys, V* values, int n){
+        vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [keys](int a, int b){ return keys[a] < keys[b]; });
+        m_keys.clear();
+        m_values.clear();
+        for(int idx: order){
+            V value = (values == nullptr)? V() : values[idx];
+            if(!m_keys.empty() && !(m_keys.back() < keys[idx])) m_values.back() = value;
+            else{
+                m_keys.push_back(keys[idx]);
+                m_values.push_back(value);
+            }
+        }
+        layout();
+    }
+
+    void add(K key, V value=0){
+        int pos = lower_bound(key);
+        if((pos < (int)m_keys.size()) && !(key < m_keys[pos])){
+            m_values[pos] = value;
+            return;
+        }
+        m_keys.insert(m_keys.begin() + pos, key);
+        m_values.insert(m_values.begin() + pos, value);
+        m_stale = true;
+    }
+    V remove(K key, bool* success=0){
+        int pos = lower_bound(key);
+        bool found = (pos < (int)m_keys.size()) && !(key < m_keys[pos]);
+        V value = V();
+        if(found){
+            value = m_values[pos];
+            m_keys.erase(m_keys.begin() + pos);
+            m_values.erase(m_values.begin() + pos);
+            m_stale = true;
+        }
+        if(success != 0) *success = found;
+        return value;
+    }
+    V search(K key, bool& found){
+        if(m_stale) layout();
+        size_t n = m_keys.size();
+        const K* slots = m_layout.data();
+        size_t k = 1;
+        while(k <= n){
+            __builtin_prefetch(slots + k*PREFETCH_STRIDE);
+            k = 2*k + (slots[k] < key);
+        }
+        //the lower bound is where the last left turn was taken: drop the trailing right turns (1-bits) and that turn
+        k >>= __builtin_ffsll(~k);
+        found = (k != 0) && !(key < slots[k]);
+        return found? m_slot_values[k] : V();
+    }
+
+    int size(){ return m_keys.size(); }
+    int height(){
+        int levels = 0;
+        for(size_t n=m_keys.size(); n > 0; n >>= 1) levels++;
+        return levels;
+    }
+    void clear(){
+        m_keys.clear();
+        m_values.clear();
+        layout();
+    }
+    bool empty(){ return m_keys.empty(); }
+
+    DLinkedList<V> ascendingList(){
+        DLinkedList<V> list;
+        for(size_t idx=0; idx < m_values.size(); idx++) list.add(m_values[idx]);
+        return list;
+    }
+    DLinkedList<V> descendingList(){
+        DLinkedList<V> list;
+        for(size_t idx=m_values.size(); idx > 0; idx--) list.add(m_values[idx - 1]);
+        return list;
+    }
+    //the values of the keys in [lo, hi], ascending
+    DLinkedList<V> range(K lo, K hi){
+        DLinkedList<V> list;
+        for(size_t idx=lower_bound(lo); (idx < m_keys.size()) && !(hi < m_keys[idx]); idx++)
+            list.add(m_values[idx]);
+        return list;
+    }
+
+    //the slots in layout order: "key" or the entry2str of the entry
+    string toString(string (*entry2str)(K&, V&)=0, bool /*avl*/=false){
+        if(m_stale) layout();
+        stringstream os;
+        os << "[";
+        for(size_t k=1; k < m_layout.size(); k++){
+            if(k > 1) os << ", ";
+            if(entry2str != 0) os << entry2str(m_layout[k], m_slot_values[k]);
+            else os << m_layout[k];
+        }
+        os << "]";
+        return os.str();
+    }
+    void println(string (*entry2str)(K&, V&)=0){
+        cout << toString(entry2str) << endl;
+    }
+
+private:
+    //slots k*PREFETCH_STRIDE.. hold the 16 descendants of k four levels down (one cache line for 4-byte keys)
+    enum{ PREFETCH_STRIDE = 16 };
+
+    int lower_bound(const K& key){
+        return std::lower_bound(m_keys.begin(), m_keys.end(), key) - m_keys.begin();
+    }
+    void layout(){
+        size_t n = m_keys.size();
+        m_layout.assign(n + 1, K());
+        m_slot_values.assign(n + 1, V());
+        fill(0, 1);
+        m_stale = false;
+    }
+    //in-order traversal of the implicit tree (depth log2(n)), filled from the sorted keys
+    size_t fill(size_t next, size_t k){
+        if(k >= m_layout.size()) return next;
+        next = fill(next, 2*k);
+        m_layout[k] = m_keys[next];
+        m_slot_values[k] = m_values[next];
+        return fill(next + 1, 2*k + 1);
+    }
+
+private:
+    vector<K> m_keys;
+    vector<V> m_values;
+    vector<K> m_layout;
+    vector<V> m_slot_values;
+    bool m_stale;
+};
+
+#endif /* EYTZINGERTREE_H */
@@ -0,0 +1,72 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   BoundedQueue.h
+ *
+ * Created on November 27, 2024, 9:05 AM
+ */
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+using namespace std;
+
+/*
+ * BoundedQueue<T>: a FIFO between threads holding at most capacity items;
+ *  + push blocks while the queue is full, pop blocks while it is empty;
+ *  + close(): wakes up every waiting thread; push then returns false, and pop returns false
+ *      once the queue is empty (a failed producer closes its queues: no consumer waits forever).
+ */
+template<class T>
+class BoundedQueue{
+public:
+    BoundedQueue(size_t capacity=1): m_nCapacity((capacity == 0)? 1 : capacity), m_bClosed(false){}
+
+    bool push(T item){
+        unique_lock<mutex> lock(m_mtx);
+        m_not_full.wait(lock, [this](){ return m_bClosed || (m_items.size() < m_nCapacity); });
+        if(m_bClosed) return false;
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    }
+    bool pop(T& item){
+        unique_lock<mutex> lock(m_mtx);
+        m_not_empty.wait(lock, [this](){ return m_bClosed || !m_items.empty(); });
+        if(m_items.empty()) return false;
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return true;
+    }
+    void close(){
+        lock_guard<mutex> lock(m_mtx);
+        m_bClosed = true;
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+    size_t size(){
+        lock_guard<mutex> lock(m_mtx);
+        return m_items.size();
+    }
+    //reopen: an empty, open queue again (no thread may be waiting on it)
+    void reopen(){
+        lock_guard<mutex> lock(m_mtx);
+        m_items.clear();
+        m_bClosed = false;
+    }
+
+private:
+    size_t m_nCapacity;
+    bool m_bClosed;
+    deque<T> m_items;
+    mutex m_mtx;
+    condition_variable m_not_full, m_not_empty;
+};
+
+#endif /* BOUNDEDQUEUE_H */
@@ -0,0 +1,156 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   CounterRNG.h
+ *
+ * Created on December 3, 2024, 8:40 AM
+ */
+
+#ifndef COUNTERRNG_H
+#define COUNTERRNG_H
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "util/ThreadPool.h"
+
+/*
+ * Philox4x32: the Philox-4x32-10 block function (Salmon et al., "Parallel random numbers:
+ *  as easy as 1, 2, 3", SC'11): 4 random 32-bit words from a 128-bit counter and a 64-bit key.
+ */
+class Philox4x32 {
+public:
+    typedef array<uint32_t, 4> Block;
+    static Block block(Block ctr, array<uint32_t, 2> key){
+        for(int round=0; round < 10; round++){
+            if(round > 0){
+                key[0] += 0x9E3779B9u;
+                key[1] += 0xBB67AE85u;
+            }
+            uint64_t p0 = (uint64_t)0xD2511F53u*ctr[0];
+            uint64_t p1 = (uint64_t)0xCD9E8D57u*ctr[2];
+            ctr = {(uint32_t)(p1 >> 32) ^ ctr[1] ^ key[0], (uint32_t)p1,
+                   (uint32_t)(p0 >> 32) ^ ctr[3] ^ key[1], (uint32_t)p0};
+        }
+        return ctr;
+    }
+};
+
+/*
+ * CounterRNG: random numbers as a pure function of (key, stream, index), on Philox4x32;
+ *  + the n-th number of a stream does not depend on the numbers drawn before it, in this
+ *      stream or elsewhere: the fill functions run in parallel and give the same bits
+ *      whatever the number of threads;
+ *  + keys: for_name(name) = the global seed mixed with a name (a standalone layer: its name),
+ *      for_position(seed, k) = a seed mixed with a position (the k-th layer of a model),
+ *      for_seed(seed) = an explicit seed (a DataLoader); the stream tells the uses of a
+ *      key apart (the epoch of a shuffle, the step of a dropout);
+ *  + the global seed: set_global_seed (default 0x2024).
+ */
+class CounterRNG {
+public:
+    CounterRNG(uint64_t key, uint64_t stream=0): m_key(key), m_stream(stream){}
+    static CounterRNG for_name(const string& name, uint64_t stream=0){
+        //FNV-1a: the same key on every platform
+        uint64_t h = 0xcbf29ce484222325ull;
+        for(unsigned char c: name) h = (h ^ c)*0x100000001b3ull;
+        return CounterRNG(mix(global_seed() ^ h), stream);
+    }
+    static CounterRNG for_seed(uint64_t seed, uint64_t stream=0){
+        return CounterRNG(mix(seed), stream);
+    }
+    static CounterRNG for_position(uint64_t seed, uint64_t position, uint64_t stream=0){
+        return CounterRNG(mix(mix(seed) + position), stream);
+    }
+    static uint64_t global_seed(){ return seed_ref(); }
+    static void set_global_seed(uint64_t seed){ seed_ref() = seed; }
+
+    //counter: (index, stream)
+    Philox4x32::Block block(uint64_t index) const{
+        return Philox4x32::block({(uint32_t)index, (uint32_t)(index >> 32), (uint32_t)m_stream, (uint32_t)(m_stream >> 32)},
+                                 {(uint32_t)m_key, (uint32_t)(m_key >> 32)});
+    }
+    //uniform in [0, 1), 53 bits
+    double uniform(uint64_t index) const{
+        Philox4x32::Block b = block(index);
+        return to_unit(b[0], b[1]);
+    }
+    //an integer in [0, n): the high word of a 64x64-bit product (bias < n/2^64)
+    uint64_t below(uint64_t index, uint64_t n) const{
+        Philox4x32::Block b = block(index);
+        uint64_t r = ((uint64_t)b[1] << 32) | b[0];
+        return (uint64_t)(((unsigned __int128)r*n) >> 64);
+    }
+    //standard normal: Box-Muller; the numbers 2k and 2k+1 come from block k
+    double normal(uint64_t index) const{
+        double z[2];
+        normal_pair(index/2, z);
+        return z[index % 2];
+    }
+    void fill_uniform(double* out, size_t n) const{
+        parallel_for(n, [&](size_t begin, size_t end){
+            for(size_t i=begin; i < end; i++) out[i] = uniform(i);
+        }, 8);
+    }
+    void fill_normal(double* out, size_t n) const{
+        //chunks of even length: each block gives a pair
+        parallel_for(n, [&](size_t begin, size_t end){
+            double z[2];
+            for(size_t i=begin; i < end; i += 2){
+                normal_pair(i/2, z);
+                out[i] = z[0];
+                if(i + 1 < end) out[i + 1] = z[1];
+            }
+        }, 32, 2);
+    }
+    /* shuffle: Fisher-Yates; the draws (swap of i with j in [0, i]) are computed in parallel,
+     *  the swaps run in order
+     */
+    template<class T>
+    void shuffle(T* data, size_t n) const{
+        if(n < 2) return;
+        vector<uint64_t> draws(n);
+        parallel_for(n, [&](size_t begin, size_t end){
+            for(size_t i=begin; i < end; i++) draws[i] = below(i, i + 1);
+        }, 8);
+        for(size_t i=n - 1; i > 0; i--) std::swap(data[i], data[draws[i]]);
+    }
+    uint64_t key() const{ return m_key; }
+    uint64_t stream() const{ return m_stream; }
+
+private:
+    static uint64_t& seed_ref(){
+        static uint64_t seed = 0x2024;
+        return seed;
+    }
+    //splitmix64 finalizer: nearby seeds give unrelated keys
+    static uint64_t mix(uint64_t x){
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27))*0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+    static double to_unit(uint32_t lo, uint32_t hi){
+        uint64_t bits = (((uint64_t)hi << 32) | lo) >> 11;
+        return bits*(1.0/9007199254740992.0);
+    }
+    void normal_pair(uint64_t k, double* z) const{
+        Philox4x32::Block b = block(k);
+        double u1 = 1.0 - to_unit(b[0], b[1]); //(0, 1]: log(u1) is finite
+        double u2 = to_unit(b[2], b[3]);
+        double r = std::sqrt(-2.0*std::log(u1));
+        z[0] = r*std::cos(2*M_PI*u2);
+        z[1] = r*std::sin(2*M_PI*u2);
+    }
+
+    uint64_t m_key, m_stream;
+};
+
+#endif /* COUNTERRNG_H */
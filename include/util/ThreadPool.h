@@ -0,0 +1,324 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.h to edit this template
+ */
+
+/*
+ * File:   ThreadPool.h
+ *
+ * Created on November 8, 2024, 9:12 PM
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/*
+ * ThreadPool: the work-stealing pool shared by the library.
+ *  + ThreadPool::instance(): the pool; it is created on first use with
+ *      hardware_concurrency() threads, the calling thread included.
+ *  + ThreadPool::configure(num_threads, threshold): resizes the pool
+ *      (num_threads <= 0: hardware_concurrency()); threshold is the amount of work
+ *      (elements) below which parallel_for/parallel_reduce run on the calling thread.
+ *      Config keys: num_threads, parallel_threshold; call it once at startup (see program.cpp).
+ *      The threshold is always updated; the size is not changed while tasks are running
+ *      (returns false): a call of run_chunks/submit that starts during a resize runs on
+ *      the calling thread instead.
+ *  + each worker owns a deque: it pops its own tasks from the back and steals
+ *      from the front of the other deques when it runs out of work.
+ *
+ * parallel_for(n, fn, cost, align):
+ *  + calls fn(begin, end) on disjoint chunks covering [0, n)
+ *  + runs in parallel if n*cost >= threshold; chunk boundaries are multiples of align
+ *  + the calling thread takes chunks too, so nested calls do not deadlock
+ * parallel_reduce(n, identity, map, combine, cost):
+ *  + map(begin, end) -> T for each chunk; partial results are combined in chunk order;
+ *  + the chunks only depend on n, cost and the threshold (not on the number of threads):
+ *      the result is the same, bit for bit, for any pool size and scheduling.
+ */
+class ThreadPool {
+public:
+    static ThreadPool& instance(){
+        static ThreadPool pool(0);
+        return pool;
+    }
+    static bool configure(int num_threads, size_t threshold=DEFAULT_THRESHOLD){
+        ThreadPool& pool = instance();
+        pool.m_threshold = max((size_t)1, threshold);
+        size_t nthreads = (num_threads > 0)? num_threads : hardware_threads();
+        if(nthreads == pool.size()) return true;
+
+        static mutex configure_mtx;
+        lock_guard<mutex> lock(configure_mtx);
+        //m_resizing is set before m_active is read, m_active before m_resizing (see ActiveScope):
+        //either the resize sees the caller, or the caller sees the resize
+        pool.m_resizing = true;
+        if(pool.m_active.load() != 0){
+            pool.m_resizing = false;
+            return false;
+        }
+        pool.stop();
+        pool.start(nthreads);
+        pool.m_resizing = false;
+        return true;
+    }
+    static constexpr size_t DEFAULT_THRESHOLD = 1 << 16;
+
+    ThreadPool(int num_threads){
+        m_threshold = DEFAULT_THRESHOLD;
+        start((num_threads > 0)? num_threads : hardware_threads());
+    }
+    ThreadPool(const ThreadPool& orig) = delete;
+    ThreadPool& operator=(const ThreadPool& orig) = delete;
+    virtual ~ThreadPool(){
+        stop();
+    }
+
+    //number of threads working on parallel_for, the caller included
+    size_t size(){ return m_nthreads.load(memory_order_relaxed); }
+    size_t threshold(){ return m_threshold.load(memory_order_relaxed); }
+
+    void submit(function<void()> task){
+        ActiveScope scope(*this);
+        if(!scope.entered() || m_workers.empty()){
+            task();
+            return;
+        }
+        size_t idx;
+        if((tl_owner() == this) && (tl_index() >= 0)) idx = tl_index();
+        else idx = m_next_queue.fetch_add(1)%m_queues.size();
+        {
+            lock_guard<mutex> lock(m_queues[idx]->mtx);
+            m_queues[idx]->tasks.push_back(std::move(task));
+        }
+        {
+            lock_guard<mutex> lock(m_wake_mtx);
+            m_pending++;
+        }
+        m_wake.notify_one();
+    }
+
+    //runs fn(chunk_idx) for chunk_idx in [0, nchunks) on the pool and the calling thread
+    void run_chunks(size_t nchunks, const function<void(size_t)>& fn){
+        if(nchunks == 0) return;
+        ActiveScope scope(*this);
+        if((nchunks == 1) || !scope.entered() || m_workers.empty()){
+            for(size_t c=0; c < nchunks; c++) fn(c);
+            return;
+        }
+        shared_ptr<ChunkState> state = make_shared<ChunkState>(nchunks, &fn);
+        size_t nhelpers = min(m_workers.size(), nchunks - 1);
+        for(size_t h=0; h < nhelpers; h++) submit([state](){ state->run(); });
+        state->run();
+        state->wait();
+        if(state->error) rethrow_exception(state->error);
+    }
+
+    template<class Fn>
+    void parallel_for(size_t n, Fn fn, size_t cost=1, size_t align=1){
+        if(n == 0) return;
+        size_t nchunks = num_chunks(n, cost);
+        if(nchunks <= 1){
+            fn((size_t)0, n);
+            return;
+        }
+        size_t chunk = (n + nchunks - 1)/nchunks;
+        chunk = ((chunk + align - 1)/align)*align;
+        nchunks = (n + chunk - 1)/chunk;
+        run_chunks(nchunks, [&](size_t c){
+            fn(c*chunk, min(n, (c + 1)*chunk));
+        });
+    }
+
+    template<class T, class Map, class Combine>
+    T parallel_reduce(size_t n, T identity, Map map, Combine combine, size_t cost=1){
+        if(n == 0) return identity;
+        size_t nchunks = num_reduce_chunks(n, cost);
+        if(nchunks <= 1) return combine(identity, map((size_t)0, n));
+        size_t chunk = (n + nchunks - 1)/nchunks;
+        nchunks = (n + chunk - 1)/chunk;
+        vector<T> partials(nchunks, identity);
+        run_chunks(nchunks, [&](size_t c){
+            partials[c] = map(c*chunk, min(n, (c + 1)*chunk));
+        });
+        T result = identity;
+        for(size_t c=0; c < nchunks; c++) result = combine(result, partials[c]);
+        return result;
+    }
+
+private:
+    //ActiveScope: marks a caller that uses the workers and queues; entered() is false during a resize
+    class ActiveScope{
+    public:
+        ActiveScope(ThreadPool& pool): m_pool(pool){
+            m_pool.m_active++;
+            m_bEntered = !m_pool.m_resizing.load();
+        }
+        ~ActiveScope(){ m_pool.m_active--; }
+        bool entered(){ return m_bEntered; }
+    private:
+        ThreadPool& m_pool;
+        bool m_bEntered;
+    };
+    struct WorkQueue{
+        mutex mtx;
+        deque<function<void()>> tasks;
+    };
+    struct ChunkState{
+        ChunkState(size_t nchunks, const function<void(size_t)>* pFn):
+            nchunks(nchunks), next(0), done(0), pFn(pFn){}
+        //pFn is only used after a chunk was taken: the owner waits for it
+        void run(){
+            while(true){
+                size_t c = next.fetch_add(1);
+                if(c >= nchunks) return;
+                try{
+                    (*pFn)(c);
+                }
+                catch(...){
+                    lock_guard<mutex> lock(mtx);
+                    if(!error) error = current_exception();
+                }
+                if(done.fetch_add(1) + 1 == nchunks){
+                    lock_guard<mutex> lock(mtx);
+                    finished.notify_all();
+                }
+            }
+        }
+        void wait(){
+            unique_lock<mutex> lock(mtx);
+            finished.wait(lock, [this](){ return done.load() == nchunks; });
+        }
+        size_t nchunks;
+        atomic<size_t> next, done;
+        const function<void(size_t)>* pFn;
+        mutex mtx;
+        condition_variable finished;
+        exception_ptr error;
+    };
+
+    static size_t hardware_threads(){
+        size_t n = thread::hardware_concurrency();
+        return (n == 0)? 1 : n;
+    }
+    static ThreadPool*& tl_owner(){
+        static thread_local ThreadPool* owner = nullptr;
+        return owner;
+    }
+    static int& tl_index(){
+        static thread_local int index = -1;
+        return index;
+    }
+
+    size_t num_chunks(size_t n, size_t cost){
+        size_t threshold = m_threshold.load(memory_order_relaxed);
+        if((size() == 1) || (n*cost < threshold)) return 1;
+        //a few chunks per thread: stealing evens out the slow ones
+        size_t min_items = max((size_t)1, threshold/(8*cost));
+        return max((size_t)1, min(4*size(), n/min_items));
+    }
+    //the chunks of parallel_reduce: as num_chunks, without the pool size
+    size_t num_reduce_chunks(size_t n, size_t cost){
+        size_t threshold = m_threshold.load(memory_order_relaxed);
+        if(n*cost < threshold) return 1;
+        size_t min_items = max((size_t)1, threshold/(8*cost));
+        return max((size_t)1, min(MAX_REDUCE_CHUNKS, n/min_items));
+    }
+    static constexpr size_t MAX_REDUCE_CHUNKS = 256;
+
+    void start(size_t nthreads){
+        m_stop = false;
+        m_pending = 0;
+        m_queues.clear();
+        //nthreads - 1 workers, one deque each; the caller is the last thread
+        for(size_t idx=0; idx + 1 < nthreads; idx++) m_queues.push_back(unique_ptr<WorkQueue>(new WorkQueue()));
+        for(size_t idx=0; idx + 1 < nthreads; idx++) m_workers.push_back(thread(&ThreadPool::worker_loop, this, (int)idx));
+        m_nthreads = nthreads;
+    }
+    void stop(){
+        {
+            lock_guard<mutex> lock(m_wake_mtx);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for(auto& worker: m_workers) worker.join();
+        m_workers.clear();
+        m_nthreads = 1;
+    }
+
+    bool pop_task(int idx, function<void()>& task){
+        {
+            WorkQueue& own = *m_queues[idx];
+            lock_guard<mutex> lock(own.mtx);
+            if(!own.tasks.empty()){
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for(size_t k=1; k < m_queues.size(); k++){
+            WorkQueue& victim = *m_queues[(idx + k)%m_queues.size()];
+            lock_guard<mutex> lock(victim.mtx);
+            if(!victim.tasks.empty()){
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+    void worker_loop(int idx){
+        tl_owner() = this;
+        tl_index() = idx;
+        function<void()> task;
+        while(true){
+            if(pop_task(idx, task)){
+                {
+                    lock_guard<mutex> lock(m_wake_mtx);
+                    m_pending--;
+                }
+                task();
+                task = nullptr;
+                continue;
+            }
+            unique_lock<mutex> lock(m_wake_mtx);
+            m_wake.wait(lock, [this](){ return m_stop || (m_pending > 0); });
+            if(m_stop && (m_pending == 0)) return;
+        }
+    }
+
+private:
+    vector<unique_ptr<WorkQueue>> m_queues;
+    vector<thread> m_workers;
+    atomic<size_t> m_next_queue{0};
+    mutex m_wake_mtx;
+    condition_variable m_wake;
+    size_t m_pending;
+    bool m_stop;
+    atomic<size_t> m_threshold;
+    atomic<size_t> m_nthreads{1};
+    atomic<size_t> m_active{0}; //callers inside run_chunks/submit
+    atomic<bool> m_resizing{false};
+};
+
+template<class Fn>
+void parallel_for(size_t n, Fn fn, size_t cost=1, size_t align=1){
+    ThreadPool::instance().parallel_for(n, fn, cost, align);
+}
+
+template<class T, class Map, class Combine>
+T parallel_reduce(size_t n, T identity, Map map, Combine combine, size_t cost=1){
+    return ThreadPool::instance().parallel_reduce(n, identity, map, combine, cost);
+}
+
+#endif /* THREADPOOL_H */
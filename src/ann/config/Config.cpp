@@ -77,6 +77,15 @@ string Config::get(string key, string def_value){
     }
     return value;
 }
+int Config::get_int(string key, int def_value){
+    string value = get(key, "");
+    try{
+        return stoi(value);
+    }
+    catch(std::exception& e){
+        return def_value;
+    }
+}
 string Config::get_new_checkpoint(string model_name){
     string model_root = get("model_root", "./models");
     string ckpt_name = get("ckpt_name", "checkpoint");
@@ -86,22 +95,36 @@ string Config::get_new_checkpoint(string model_name){
     
     //find the largest idx
     int largest = 0;
-    for (const auto & entry : fs::directory_iterator(model_path)){
-        if(entry.is_directory()){
-            string path = entry.path().string();
-            string ckpt_idx_str = path.substr(path.rfind("-") + 1);
-            int ckpt_idx;
-            try{
-                ckpt_idx = stoi(ckpt_idx_str);
-            }
-            catch(std::invalid_argument& e){
-                //cout << "invalid_argument" << endl;
-                ckpt_idx = -1;
-            }
-            if(largest < ckpt_idx) largest = ckpt_idx;
-        }
+    xvector<int> indices = get_checkpoint_indices(model_name);
+    for(auto ckpt_idx: indices){
+        if(largest < ckpt_idx) largest = ckpt_idx;
     }
     int next_idx = largest + 1;
     string ckpt_folder = ckpt_name + "-" + to_string(next_idx);
     return fs::path(model_path) / fs::path(ckpt_folder);
+}
+/*
+ * get_checkpoint_indices(model_name):
+ *  + return the indices k of all folders named "<ckpt_name>-k" in model_root/model_name.
+ *  + other folders (e.g., the temporary ".<ckpt_name>-k.tmp" of an unfinished write) are skipped.
+ */
+xvector<int> Config::get_checkpoint_indices(string model_name){
+    string model_root = get("model_root", "./models");
+    string ckpt_name = get("ckpt_name", "checkpoint");
+    fs::path model_path = fs::path(model_root) / fs::path(model_name);
+    string prefix = ckpt_name + "-";
+    
+    xvector<int> indices;
+    if(!fs::exists(model_path)) return indices;
+    for (const auto & entry : fs::directory_iterator(model_path)){
+        if(!entry.is_directory()) continue;
+        string folder = entry.path().filename().string();
+        if(folder.compare(0, prefix.size(), prefix) != 0) continue;
+        
+        string ckpt_idx_str = folder.substr(prefix.size());
+        bool numeric = (ckpt_idx_str.size() > 0) && 
+                std::all_of(ckpt_idx_str.begin(), ckpt_idx_str.end(), ::isdigit);
+        if(numeric) indices.add(stoi(ckpt_idx_str));
+    }
+    return indices;
 }
\ No newline at end of file
@@ -20,51 +20,65 @@ DSFactory::DSFactory(string cfg_filename) {
 
 DSFactory::DSFactory(const DSFactory& orig) {}
 
+/*
+ * make_labels: the label tensor of a dataset from its class column t: [N]
+ *  + config "sparse_labels: 1" => t itself (class indices, [N]); the loss gathers
+ *      -log(y[t]) and the metrics skip the argmax;
+ *  + otherwise (default) => one-hot rows, [N, nclasses].
+ * Either way, each class must be an integer in [0, nclasses), else: std::out_of_range.
+ */
+double_tensor DSFactory::make_labels(double_tensor t, int nclasses) {
+  ulong_tensor y = label_indices(t, nclasses);
+  if (m_pConfig->get_int("sparse_labels", 0) != 0) return t;
+  return onehot_enc(y, nclasses);
+}
+
 DSFactory::~DSFactory() {
   if (m_pConfig != nullptr) delete m_pConfig;
 }
 
-xmap<string, TensorDataset<double, double>*>* DSFactory::get_datasets_3cc() {
-  // prepare the path to files
-  string ds_name = "3c-classification";
+/*
+ * get_datasets: the train/valid/test datasets of <dataset_root>/<ds_name>
+ *  + files: <prefix>_train.npy, <prefix>_valid.npy, <prefix>_test.npy, where prefix is
+ *      ds_name up to the first '-' (e.g., "2c-classification" => "2c");
+ *  + tables: [N, nfeatures + 1]; the last column is the class, the others are features;
+ *  + ds_name empty => config "dataset_name"; nclasses <= 0 => 1 + the largest train class.
+ *
+ * Features are normalized with mu/sigma of the train split (see estimate_params): they are
+ *  estimated in one pass, saved as <prefix>_mu.npy and <prefix>_sigma.npy next to the data
+ *  and loaded from there on the next runs, unless the train file is newer
+ *  (config "reuse_stats: 0" always estimates them again).
+ */
+xmap<string, TensorDataset<double, double>*>* DSFactory::get_datasets(string ds_name, int nclasses) {
+  if (ds_name.empty()) ds_name = m_pConfig->get("dataset_name", "");
+  if (ds_name.empty()) throw std::runtime_error("DSFactory: no dataset_name in the configuration");
+  string prefix = ds_name.substr(0, ds_name.find('-'));
   string dataset_root = m_pConfig->get("dataset_root", "datasets");
   fs::path dataset_path = fs::path(dataset_root) / fs::path(ds_name);
-  string train_file = (dataset_path / fs::path("3c_train.npy")).string();
-  string valid_file = (dataset_path / fs::path("3c_valid.npy")).string();
-  string test_file = (dataset_path / fs::path("3c_test.npy")).string();
-
-  // load data from files
-  //  tables: the first two columns are data (i.e., x and y) and the last is
-  //  target
-  xt::xarray<double> train_table = xt::load_npy<double>(train_file);
-  xt::xarray<double> valid_table = xt::load_npy<double>(valid_file);
-  xt::xarray<double> test_table = xt::load_npy<double>(test_file);
-
-  xt::xarray<double> mu, sigma;
-  estimate_params(xt::view(train_table, xt::all(), xt::range(0, 2)), mu, sigma);
-
-  cout << shape2str(train_table.shape()) << endl;
-  xt::xarray<double> X_train =
-      normalize(xt::view(train_table, xt::all(), xt::range(0, 2)), mu, sigma);
-  xt::xarray<double> t_train = xt::view(train_table, xt::all(), -1);
-  xt::xarray<double> T_train = onehot_enc(xt::cast<unsigned long>(t_train), 3);
-
-  xt::xarray<double> X_valid =
-      normalize(xt::view(valid_table, xt::all(), xt::range(0, 2)), mu, sigma);
-  xt::xarray<double> t_valid = xt::view(valid_table, xt::all(), -1);
-  xt::xarray<double> T_valid = onehot_enc(xt::cast<unsigned long>(t_valid), 3);
-
-  xt::xarray<double> X_test =
-      normalize(xt::view(test_table, xt::all(), xt::range(0, 2)), mu, sigma);
-  xt::xarray<double> t_test = xt::view(test_table, xt::all(), -1);
-  xt::xarray<double> T_test = onehot_enc(xt::cast<unsigned long>(t_test), 3);
-
-  TensorDataset<double, double>* train_ds =
-      new TensorDataset<double, double>(X_train, T_train);
+  string train_file = (dataset_path / fs::path(prefix + "_train.npy")).string();
+  string valid_file = (dataset_path / fs::path(prefix + "_valid.npy")).string();
+  string test_file = (dataset_path / fs::path(prefix + "_test.npy")).string();
+
+  double_tensor train_table = xt::load_npy<double>(train_file);
+  if (train_table.dimension() != 2 || train_table.shape()[1] < 2)
+    throw std::runtime_error("DSFactory: " + train_file + " is not a [N, nfeatures + 1] table");
+  size_t nfeatures = train_table.shape()[1] - 1;
+
+  double_tensor mu, sigma;
+  load_stats(dataset_path, prefix, train_file, train_table, mu, sigma);
+  if (nclasses <= 0) {
+    double max_class = 0;
+    for (size_t r = 0; r < train_table.shape()[0]; r++)
+      max_class = std::max(max_class, train_table(r, nfeatures));
+    nclasses = (int)max_class + 1;
+  }
+
+  TensorDataset<double, double>* train_ds = make_dataset(train_table, mu, sigma, nclasses);
+  train_table = double_tensor();
   TensorDataset<double, double>* valid_ds =
-      new TensorDataset<double, double>(X_valid, T_valid);
+      make_dataset(xt::load_npy<double>(valid_file), mu, sigma, nclasses);
   TensorDataset<double, double>* test_ds =
-      new TensorDataset<double, double>(X_test, T_test);
+      make_dataset(xt::load_npy<double>(test_file), mu, sigma, nclasses);
 
   xmap<string, TensorDataset<double, double>*>* pMap =
       new xmap<string, TensorDataset<double, double>*>(
@@ -78,57 +92,62 @@ xmap<string, TensorDataset<double, double>*>* DSFactory::get_datasets_3cc() {
   return pMap;
 }
 
+xmap<string, TensorDataset<double, double>*>* DSFactory::get_datasets_3cc() {
+  return get_datasets("3c-classification", 3);
+}
+
 xmap<string, TensorDataset<double, double>*>* DSFactory::get_datasets_2cc() {
-  // prepare the path to files
-  string ds_name = "2c-classification";
-  string dataset_root = m_pConfig->get("dataset_root", "datasets");
-  fs::path dataset_path = fs::path(dataset_root) / fs::path(ds_name);
-  string train_file = (dataset_path / fs::path("2c_train.npy")).string();
-  string valid_file = (dataset_path / fs::path("2c_valid.npy")).string();
-  string test_file = (dataset_path / fs::path("2c_test.npy")).string();
-
-  // load data from files
-  //  tables: the first two columns are data (i.e., x and y) and the last is
-  //  target
-  xt::xarray<double> train_table = xt::load_npy<double>(train_file);
-  xt::xarray<double> valid_table = xt::load_npy<double>(valid_file);
-  xt::xarray<double> test_table = xt::load_npy<double>(test_file);
-
-  xt::xarray<double> mu, sigma;
-  estimate_params(xt::view(train_table, xt::all(), xt::range(0, 2)), mu, sigma);
-
-  cout << shape2str(train_table.shape()) << endl;
-  xt::xarray<double> X_train =
-      normalize(xt::view(train_table, xt::all(), xt::range(0, 2)), mu, sigma);
-  xt::xarray<double> t_train = xt::view(train_table, xt::all(), -1);
-  xt::xarray<double> T_train = onehot_enc(xt::cast<unsigned long>(t_train), 2);
-
-  xt::xarray<double> X_valid =
-      normalize(xt::view(valid_table, xt::all(), xt::range(0, 2)), mu, sigma);
-  xt::xarray<double> t_valid = xt::view(valid_table, xt::all(), -1);
-  cout << t_valid << endl;
-  xt::xarray<double> T_valid = onehot_enc(xt::cast<unsigned long>(t_valid), 2);
-
-  xt::xarray<double> X_test =
-      normalize(xt::view(test_table, xt::all(), xt::range(0, 2)), mu, sigma);
-  xt::xarray<double> t_test = xt::view(test_table, xt::all(), -1);
-  xt::xarray<double> T_test = onehot_enc(xt::cast<unsigned long>(t_test), 2);
-
-  TensorDataset<double, double>* train_ds =
-      new TensorDataset<double, double>(X_train, T_train);
-  TensorDataset<double, double>* valid_ds =
-      new TensorDataset<double, double>(X_valid, T_valid);
-  TensorDataset<double, double>* test_ds =
-      new TensorDataset<double, double>(X_test, T_test);
+  return get_datasets("2c-classification", 2);
+}
 
-  xmap<string, TensorDataset<double, double>*>* pMap =
-      new xmap<string, TensorDataset<double, double>*>(
-          &stringHash,
-          0.75,  // load-factor
-          0,     // value-comparator: use ==
-          xmap<string, TensorDataset<double, double>*>::freeValue);
-  pMap->put("train_ds", train_ds);
-  pMap->put("valid_ds", valid_ds);
-  pMap->put("test_ds", test_ds);
-  return pMap;
-}
\ No newline at end of file
+/*
+ * load_stats: mu/sigma of the features of train_table (loaded from train_file),
+ *  from the saved files if they are usable; otherwise estimated from the table and saved.
+ */
+void DSFactory::load_stats(fs::path dataset_path, string prefix, string train_file,
+                           const double_tensor& train_table,
+                           double_tensor& mu, double_tensor& sigma) {
+  size_t nfeatures = train_table.shape()[1] - 1;
+  string mu_file = (dataset_path / fs::path(prefix + "_mu.npy")).string();
+  string sigma_file = (dataset_path / fs::path(prefix + "_sigma.npy")).string();
+
+  bool reuse = (m_pConfig->get_int("reuse_stats", 1) != 0) &&
+               fs::exists(mu_file) && fs::exists(sigma_file) &&
+               (fs::last_write_time(mu_file) >= fs::last_write_time(train_file)) &&
+               (fs::last_write_time(sigma_file) >= fs::last_write_time(train_file));
+  if (reuse) {
+    mu = xt::load_npy<double>(mu_file);
+    sigma = xt::load_npy<double>(sigma_file);
+    if (mu.size() == nfeatures && (sigma.size() == 1 || sigma.size() == nfeatures)) return;
+  }
+
+  estimate_params(train_table.data(), train_table.shape()[0], nfeatures,
+                  train_table.shape()[1], mu, sigma);
+  try {
+    xt::dump_npy(mu_file, mu);
+    xt::dump_npy(sigma_file, sigma);
+  } catch (std::exception& e) {
+    cerr << "DSFactory: cannot save the feature statistics (" << e.what() << ")" << endl;
+  }
+}
+
+/*
+ * make_dataset: normalizes the feature columns of table straight into the data tensor
+ *  (one pass, no intermediate copies) and takes the last column as the labels.
+ */
+TensorDataset<double, double>* DSFactory::make_dataset(const double_tensor& table,
+                                                       const double_tensor& mu,
+                                                       const double_tensor& sigma,
+                                                       int nclasses) {
+  size_t nrows = table.shape()[0];
+  size_t ncols = table.shape()[1];
+  size_t nfeatures = ncols - 1;
+  if (mu.size() != nfeatures)
+    throw std::runtime_error("DSFactory: the tables do not have the same number of features");
+
+  double_tensor X = empty_tensor({nrows, nfeatures});
+  normalize_rows(table.data(), ncols, X.data(), nrows, nfeatures, mu, sigma);
+  double_tensor t = empty_tensor({nrows});
+  for (size_t r = 0; r < nrows; r++) t[r] = table.data()[r * ncols + nfeatures];
+  return new TensorDataset<double, double>(std::move(X), make_labels(t, nclasses));
+}
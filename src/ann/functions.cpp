@@ -1,49 +1,164 @@
 #include "ann/functions.h"
+#include "kernels/softmax.h"
+#include "util/ThreadPool.h"
+#include "heap/Heap.h"
 #include <cinttypes>
 #include <cstdint>
 #include <cstdio>
+#include <cmath>
 #include <limits>
 
 
 
-xt::xarray<double> softmax(xt::xarray<double> X, int axis){
-    xt::svector<unsigned long> shape = X.shape();
-    axis = positive_index(axis, shape.size());
-    shape[axis] = 1;
-    
-    xt::xarray<double> Xmax = xt::amax(X, axis);
-    X = xt::exp(X - Xmax.reshape(shape));
-    xt::xarray<double> SX = xt::sum(X, -1); SX = SX.reshape(shape);
-    X = X/SX;
-    
+/*
+ * softmax_view: the sizes [outer, len, inner] of X seen around the softmax axis
+ */
+static void softmax_view(double_tensor& X, int& axis, size_t& outer, size_t& len, size_t& inner){
+    axis = positive_index(axis, X.dimension());
+    outer = 1; inner = 1;
+    for(int d=0; d < axis; d++) outer *= X.shape()[d];
+    len = X.shape()[axis];
+    for(int d=axis + 1; d < (int)X.dimension(); d++) inner *= X.shape()[d];
+}
+
+double_tensor softmax(double_tensor X, int axis){
+    //X is a copy: normalize it in place
+    size_t outer, len, inner;
+    softmax_view(X, axis, outer, len, inner);
+    softmax_forward(X.data(), X.data(), outer, len, inner);
     return X;
 }
 
 /*
  */
-double cross_entropy(xt::xarray<double> Ypred, xt::xarray<double> Ygt, bool mean_reduced){
+double cross_entropy(double_tensor Ypred, double_tensor Ygt, bool mean_reduced){
     int nsamples = Ypred.shape()[0];
-    xt::xarray<double> logYpred = xt::log(Ypred + 1e-7);
-    xt::xarray<double> R = -Ygt * logYpred;
-    R = xt::sum(R, -1);
+    const double* y = Ypred.data();
+    const double* t = Ygt.data();
+    double sum = parallel_reduce(Ypred.size(), 0.0, [&](size_t begin, size_t end){
+        double partial = 0;
+        for(size_t idx=begin; idx < end; idx++)
+            if(t[idx] != 0) partial -= t[idx]*std::log(y[idx] + 1e-7);
+        return partial;
+    }, std::plus<double>());
     
-    xt::xarray<double>  sum = xt::sum(R);
-    if(mean_reduced) return (sum/nsamples)[0];
-    else return sum[0];
+    if(mean_reduced) return sum/nsamples;
+    else return sum;
 }
 
 /*
  */
-double cross_entropy(xt::xarray<double> Ypred, xt::xarray<unsigned long> ygt, bool mean_reduced){
+double cross_entropy(double_tensor Ypred, xt::xarray<unsigned long> ygt, bool mean_reduced){
+    int nsamples = Ypred.shape()[0];
     int nclasses = Ypred.shape()[1];
-    xt::xarray<double> Ytarget = onehot_enc(ygt, nclasses);
+    const double* y = Ypred.data();
+    for(int r=0; r < nsamples; r++){
+        if(ygt[r] >= (unsigned long)nclasses)
+            throw std::out_of_range("cross_entropy: label " + to_string(ygt[r]) + " of sample " +
+                    to_string(r) + " is not a class index in [0, " + to_string(nclasses) + ")");
+    }
+    double sum = parallel_reduce(nsamples, 0.0, [&](size_t begin, size_t end){
+        double partial = 0;
+        for(size_t r=begin; r < end; r++) partial -= std::log(y[r*nclasses + ygt[r]] + 1e-7);
+        return partial;
+    }, std::plus<double>());
     
-    return cross_entropy(Ypred, Ytarget, mean_reduced);
+    if(mean_reduced) return sum/nsamples;
+    else return sum;
+}
+
+/*
+ * ScoredClass: a candidate of topk_rows; the heap keeps the worst candidate on top:
+ *  the lowest score, and the larger index among equal scores (as argmax, ties go to the first class).
+ */
+struct ScoredClass{
+    double score;
+    unsigned long index;
+};
+static int worse_first(ScoredClass& lhs, ScoredClass& rhs){
+    if(lhs.score < rhs.score) return -1;
+    if(lhs.score > rhs.score) return 1;
+    if(lhs.index > rhs.index) return -1;
+    if(lhs.index < rhs.index) return 1;
+    return 0;
+}
+//Heap<T> also needs the relational operators and operator<< (for toString)
+static bool operator<(const ScoredClass& lhs, const ScoredClass& rhs){
+    return (lhs.score < rhs.score) || ((lhs.score == rhs.score) && (lhs.index > rhs.index));
+}
+static bool operator>(const ScoredClass& lhs, const ScoredClass& rhs){ return rhs < lhs; }
+static ostream& operator<<(ostream& os, const ScoredClass& item){
+    return os << "(" << item.index << ", " << item.score << ")";
 }
 
-xt::xarray<double> onehot_enc(xt::xarray<unsigned long> x, int nclasses){
+/*
+ * topk_rows: the k largest values of each row of Z ([nrows, nclasses]), in decreasing order
+ *  + indices, scores: [nrows, k] (k <= nclasses); k = 0: nothing is written
+ *  + apply_softmax: the scores are softmax(Z[r])[index]; the max and the sum of the softmax
+ *      are computed online in the same pass that selects the candidates, so the
+ *      probabilities of the other classes are never formed.
+ *  + selection: a heap of k candidates per row, O(nclasses*log(k)), no sort of the row.
+ */
+void topk_rows(const double* Z, size_t nrows, size_t nclasses, size_t k, bool apply_softmax,
+               unsigned long* indices, double* scores){
+    if(k == 0) return; //[nrows, 0]: no candidate to select (and no heap to peek at)
+    parallel_for(nrows, [&](size_t begin, size_t end){
+        Heap<ScoredClass> heap(&worse_first);
+        for(size_t r=begin; r < end; r++){
+            const double* z = Z + r*nclasses;
+            double m = -std::numeric_limits<double>::max(), s = 0;
+            for(size_t c=0; c < nclasses; c++){
+                if(apply_softmax){
+                    if(z[c] > m){
+                        s = s*std::exp(m - z[c]) + 1;
+                        m = z[c];
+                    }
+                    else s += std::exp(z[c] - m);
+                }
+                if((size_t)heap.size() < k) heap.push(ScoredClass{z[c], c});
+                else if(z[c] > heap.peek().score){
+                    heap.pop();
+                    heap.push(ScoredClass{z[c], c});
+                }
+            }
+            //the worst candidate comes out first
+            for(size_t pos=k; pos > 0; pos--){
+                ScoredClass item = heap.pop();
+                indices[r*k + pos - 1] = item.index;
+                scores[r*k + pos - 1] = apply_softmax? std::exp(item.score - m)/s : item.score;
+            }
+        }
+    }, nclasses);
+}
+
+/*
+ * label_indices: the class index of each sample
+ *  + t: [N] (sparse labels, class indices stored as doubles) => cast, no search;
+ *      each label must be an integer in [0, nclasses) (nclasses = 0: no upper bound),
+ *      else: std::out_of_range;
+ *  + t: [N, C] (dense, one-hot/probabilities) => argmax along the classes.
+ */
+ulong_tensor label_indices(const double_tensor& t, size_t nclasses){
+    if(t.dimension() != 1) return xt::argmax(t, 1);
+    ulong_tensor y = xt::empty<unsigned long>({t.shape()[0]});
+    for(size_t r=0; r < t.size(); r++){
+        double label = t[r];
+        //written so that NaN fails too
+        bool valid = (label >= 0) && (label == std::floor(label)) &&
+                     ((nclasses == 0) || (label < (double)nclasses));
+        if(!valid){
+            string range = (nclasses == 0)? string("[0, inf)") : "[0, " + to_string(nclasses) + ")";
+            throw std::out_of_range("label_indices: label " + to_string(label) + " of sample " +
+                    to_string(r) + " is not a class index in " + range);
+        }
+        y[r] = (unsigned long)label;
+    }
+    return y;
+}
+
+double_tensor onehot_enc(xt::xarray<unsigned long> x, int nclasses){
     int nsamples = x.shape()[0];
-    xt::xarray<double> Y = xt::zeros<double>({nsamples, nclasses});
+    double_tensor Y = xt::zeros<double>({nsamples, nclasses});
     for(int r=0; r < nsamples; r++){
         int c = x[r];
         xt:view(Y, r, c) = 1.0;
@@ -84,13 +199,141 @@ string to_lower(const string& str){
     return lowercase;
 }
 
-void estimate_params(xt::xarray<double> X, xt::xarray<double>& mu, xt::xarray<double>& sigma){
-    mu = xt::mean(X, 0);
-    sigma = xt::stddev(X, 0);
-    return;
+/*
+ * scale_inplace: X := factor*X
+ */
+void scale_inplace(double_tensor& X, double factor){
+    double* x = X.data();
+    parallel_for(X.size(), [&](size_t begin, size_t end){
+        for(size_t idx=begin; idx < end; idx++) x[idx] *= factor;
+    });
+}
+
+/*
+ * sum_rows: sum over axis 0 of a 2D tensor [nrows, ncols];
+ *      blocks of rows are summed on the thread pool, then the partial sums are added.
+ */
+double_tensor sum_rows(const double_tensor& X){
+    size_t nrows = X.shape()[0];
+    size_t ncols = X.size()/max((size_t)1, nrows);
+    const double* x = X.data();
+    vector<double> sums = parallel_reduce(nrows, vector<double>(ncols, 0.0), 
+        [&](size_t begin, size_t end){
+            vector<double> partial(ncols, 0.0);
+            for(size_t r=begin; r < end; r++)
+                for(size_t c=0; c < ncols; c++) partial[c] += x[r*ncols + c];
+            return partial;
+        },
+        [](vector<double> a, const vector<double>& b){
+            for(size_t c=0; c < a.size(); c++) a[c] += b[c];
+            return a;
+        }, ncols);
+    return xt::adapt(sums, vector<size_t>{ncols});
+}
+
+/*
+ * fill_zeros: X := zeros(shape); X is reused (filled on the thread pool) if it has the shape already
+ */
+void fill_zeros(double_tensor& X, const double_tensor::shape_type& shape){
+    if(X.shape() != shape){
+        X = xt::zeros<double>(shape);
+        return;
+    }
+    double* x = X.data();
+    parallel_for(X.size(), [&](size_t begin, size_t end){
+        std::fill(x + begin, x + end, 0.0);
+    });
+}
+
+/*
+ * ColumnMoments: count, per-column mean and sum of squared deviations (M2) of a block of rows.
+ *  + add_row: Welford's update, one row at a time;
+ *  + merge: Chan's formula for two blocks, so that the blocks can be summarized in parallel.
+ */
+struct ColumnMoments{
+    double count;
+    vector<double> mean, M2;
+    ColumnMoments(size_t ncols=0): count(0), mean(ncols, 0.0), M2(ncols, 0.0){}
+    void add_row(const double* x){
+        count += 1;
+        for(size_t c=0; c < mean.size(); c++){
+            double delta = x[c] - mean[c];
+            mean[c] += delta/count;
+            M2[c] += delta*(x[c] - mean[c]);
+        }
+    }
+    static ColumnMoments merge(ColumnMoments a, const ColumnMoments& b){
+        if(b.count == 0) return a;
+        if(a.count == 0) return b;
+        double count = a.count + b.count;
+        for(size_t c=0; c < a.mean.size(); c++){
+            double delta = b.mean[c] - a.mean[c];
+            a.mean[c] += delta*b.count/count;
+            a.M2[c] += b.M2[c] + delta*delta*a.count*b.count/count;
+        }
+        a.count = count;
+        return a;
+    }
+};
+
+/*
+ * estimate_params: one parallel pass over the rows of X ([nrows, ncols], row stride ld)
+ *  + mu: per-column mean
+ *  + sigma: (population) standard deviation over all the elements, a 0-D tensor,
+ *      as xt::stddev(X, 0) gives; it is derived from the per-column moments.
+ */
+void estimate_params(const double* X, size_t nrows, size_t ncols, size_t ld,
+                     double_tensor& mu, double_tensor& sigma){
+    ColumnMoments moments = parallel_reduce(nrows, ColumnMoments(ncols),
+        [&](size_t begin, size_t end){
+            ColumnMoments partial(ncols);
+            for(size_t r=begin; r < end; r++) partial.add_row(X + r*ld);
+            return partial;
+        },
+        &ColumnMoments::merge, ncols);
+    
+    mu = xt::adapt(moments.mean, vector<size_t>{ncols});
+    double n = (double)nrows*ncols;
+    double mean = 0;
+    for(size_t c=0; c < ncols; c++) mean += moments.mean[c];
+    mean /= ncols;
+    double M2 = 0;
+    for(size_t c=0; c < ncols; c++)
+        M2 += moments.M2[c] + nrows*(moments.mean[c] - mean)*(moments.mean[c] - mean);
+    sigma = double_tensor(std::sqrt(M2/n));
+}
+void estimate_params(double_tensor X, double_tensor& mu, double_tensor& sigma){
+    if((X.dimension() != 2) || (X.size() == 0)){
+        mu = xt::mean(X, 0);
+        sigma = xt::stddev(X, 0);
+        return;
+    }
+    estimate_params(X.data(), X.shape()[0], X.shape()[1], X.shape()[1], mu, sigma);
+}
+
+/*
+ * normalize_rows: Y[r, c] = (X[r, c] - mu[c])/sigma[c] for the rows of X ([nrows, ncols], row stride ldx);
+ *  + Y is [nrows, ncols], contiguous; Y may be X (in place, ldx == ncols)
+ *  + sigma: per-column ([ncols]) or one value for all the columns
+ */
+void normalize_rows(const double* X, size_t ldx, double* Y, size_t nrows, size_t ncols,
+                    const double_tensor& mu, const double_tensor& sigma){
+    const double* m = mu.data();
+    const double* s = sigma.data();
+    size_t s_stride = (sigma.size() == 1)? 0 : 1;
+    parallel_for(nrows, [&](size_t begin, size_t end){
+        for(size_t r=begin; r < end; r++)
+            for(size_t c=0; c < ncols; c++) Y[r*ncols + c] = (X[r*ldx + c] - m[c])/s[c*s_stride];
+    }, ncols);
 }
-xt::xarray<double> normalize(xt::xarray<double> X, xt::xarray<double> mu, xt::xarray<double> sigma){
-    return (X - mu)/sigma;
+double_tensor normalize(double_tensor X, double_tensor mu, double_tensor sigma){
+    if((X.dimension() != 2) || (mu.size() != X.shape()[1]) || 
+       ((sigma.size() != X.shape()[1]) && (sigma.size() != 1)))
+        return (X - mu)/sigma;
+    //X is a copy: normalize it in place
+    size_t ncols = X.shape()[1];
+    normalize_rows(X.data(), ncols, X.data(), X.shape()[0], ncols, mu, sigma);
+    return X;
 }
 
 
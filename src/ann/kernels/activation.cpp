@@ -0,0 +1,321 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.cc to edit this template
+ */
+
+/*
+ * File:   activation.cpp
+ *
+ * Created on November 4, 2024, 8:41 PM
+ */
+
+#include "kernels/activation.h"
+#include "kernels/vecmath.h"
+#include "util/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+namespace {
+    //polynomial for tanh near 0, where (1 - e)/(1 + e) loses relative precision
+    const double TANH_SMALL = 0.01;
+    const double TANH_C3 = -1.0/3;
+    const double TANH_C5 = 2.0/15;
+    const double TANH_C7 = -17.0/315;
+    const double TANH_C9 = 62.0/2835;
+
+    ///////////////////////////////////////////////////////////////////
+    // Scalar: the reference and the fallback; also handles the tails
+    ///////////////////////////////////////////////////////////////////
+    void relu_forward_scalar(double* X, size_t first, size_t last, uint64_t* mask){
+        for(size_t word=first/64; word*64 < last; word++){
+            size_t begin = word*64;
+            size_t end = min(last, begin + 64);
+            uint64_t bits = 0;
+            for(size_t idx=begin; idx < end; idx++){
+                bool keep = (X[idx] >= 0);
+                bits |= uint64_t(keep) << (idx - begin);
+                if(!keep) X[idx] = 0.0;
+            }
+            if(mask != nullptr) mask[word] = bits;
+        }
+    }
+    void relu_backward_scalar(double* DY, size_t first, size_t last, const uint64_t* mask){
+        for(size_t idx=first; idx < last; idx++){
+            bool keep = (mask[idx/64] >> (idx%64)) & 1;
+            if(!keep) DY[idx] = 0.0;
+        }
+    }
+    void sigmoid_forward_scalar(double* X, size_t first, size_t last){
+        for(size_t idx=first; idx < last; idx++) X[idx] = 1.0/(1.0 + std::exp(-X[idx]));
+    }
+    void sigmoid_backward_scalar(double* DY, const double* Y, size_t first, size_t last){
+        for(size_t idx=first; idx < last; idx++) DY[idx] *= Y[idx]*(1.0 - Y[idx]);
+    }
+    void tanh_forward_scalar(double* X, size_t first, size_t last){
+        for(size_t idx=first; idx < last; idx++) X[idx] = std::tanh(X[idx]);
+    }
+    void tanh_backward_scalar(double* DY, const double* Y, size_t first, size_t last){
+        for(size_t idx=first; idx < last; idx++) DY[idx] *= 1.0 - Y[idx]*Y[idx];
+    }
+
+#if ANN_HAVE_X86
+    ///////////////////////////////////////////////////////////////////
+    // AVX2: 4 doubles per register
+    ///////////////////////////////////////////////////////////////////
+    ANN_TARGET_AVX2 void relu_forward_avx2(double* X, size_t n, uint64_t* mask){
+        const __m256d zero = _mm256_setzero_pd();
+        size_t nfull = n/64;
+        for(size_t word=0; word < nfull; word++){
+            double* px = X + word*64;
+            uint64_t bits = 0;
+            for(int k=0; k < 16; k++){
+                __m256d x = _mm256_loadu_pd(px + 4*k);
+                __m256d keep = _mm256_cmp_pd(x, zero, _CMP_GE_OQ);
+                _mm256_storeu_pd(px + 4*k, _mm256_and_pd(x, keep));
+                bits |= uint64_t(_mm256_movemask_pd(keep)) << (4*k);
+            }
+            if(mask != nullptr) mask[word] = bits;
+        }
+        relu_forward_scalar(X, nfull*64, n, mask);
+    }
+    ANN_TARGET_AVX2 void relu_backward_avx2(double* DY, size_t n, const uint64_t* mask){
+        const __m256i lanes = _mm256_set_epi64x(8, 4, 2, 1);
+        size_t nfull = n/64;
+        for(size_t word=0; word < nfull; word++){
+            double* pdy = DY + word*64;
+            uint64_t bits = mask[word];
+            for(int k=0; k < 16; k++){
+                __m256i b = _mm256_set1_epi64x((bits >> (4*k)) & 0xF);
+                __m256i keep = _mm256_cmpeq_epi64(_mm256_and_si256(b, lanes), lanes);
+                __m256d dy = _mm256_loadu_pd(pdy + 4*k);
+                _mm256_storeu_pd(pdy + 4*k, _mm256_and_pd(dy, _mm256_castsi256_pd(keep)));
+            }
+        }
+        relu_backward_scalar(DY, nfull*64, n, mask);
+    }
+    ANN_TARGET_AVX2 void sigmoid_forward_avx2(double* X, size_t n){
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d sign = _mm256_set1_pd(-0.0);
+        size_t idx = 0;
+        for(; idx + 4 <= n; idx += 4){
+            __m256d x = _mm256_loadu_pd(X + idx);
+            __m256d e = exp_avx2(_mm256_xor_pd(x, sign));
+            _mm256_storeu_pd(X + idx, _mm256_div_pd(one, _mm256_add_pd(one, e)));
+        }
+        sigmoid_forward_scalar(X, idx, n);
+    }
+    ANN_TARGET_AVX2 void sigmoid_backward_avx2(double* DY, const double* Y, size_t n){
+        size_t idx = 0;
+        for(; idx + 4 <= n; idx += 4){
+            __m256d y = _mm256_loadu_pd(Y + idx);
+            __m256d dy = _mm256_loadu_pd(DY + idx);
+            __m256d d = _mm256_fnmadd_pd(y, y, y); //y - y*y
+            _mm256_storeu_pd(DY + idx, _mm256_mul_pd(dy, d));
+        }
+        sigmoid_backward_scalar(DY, Y, idx, n);
+    }
+    ANN_TARGET_AVX2 void tanh_forward_avx2(double* X, size_t n){
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d sign = _mm256_set1_pd(-0.0);
+        const __m256d small = _mm256_set1_pd(TANH_SMALL);
+        size_t idx = 0;
+        for(; idx + 4 <= n; idx += 4){
+            __m256d x = _mm256_loadu_pd(X + idx);
+            __m256d a = _mm256_andnot_pd(sign, x); //|x|
+            //tanh(|x|) = (1 - e)/(1 + e), e = exp(-2|x|)
+            __m256d e = exp_avx2(_mm256_mul_pd(a, _mm256_set1_pd(-2.0)));
+            __m256d t = _mm256_div_pd(_mm256_sub_pd(one, e), _mm256_add_pd(one, e));
+            //near 0: odd Taylor polynomial
+            __m256d a2 = _mm256_mul_pd(a, a);
+            __m256d p = _mm256_fmadd_pd(_mm256_set1_pd(TANH_C9), a2, _mm256_set1_pd(TANH_C7));
+            p = _mm256_fmadd_pd(p, a2, _mm256_set1_pd(TANH_C5));
+            p = _mm256_fmadd_pd(p, a2, _mm256_set1_pd(TANH_C3));
+            p = _mm256_fmadd_pd(p, a2, one);
+            p = _mm256_mul_pd(p, a);
+            t = _mm256_blendv_pd(t, p, _mm256_cmp_pd(a, small, _CMP_LT_OQ));
+            //restore the sign of x
+            _mm256_storeu_pd(X + idx, _mm256_or_pd(t, _mm256_and_pd(x, sign)));
+        }
+        tanh_forward_scalar(X, idx, n);
+    }
+    ANN_TARGET_AVX2 void tanh_backward_avx2(double* DY, const double* Y, size_t n){
+        const __m256d one = _mm256_set1_pd(1.0);
+        size_t idx = 0;
+        for(; idx + 4 <= n; idx += 4){
+            __m256d y = _mm256_loadu_pd(Y + idx);
+            __m256d dy = _mm256_loadu_pd(DY + idx);
+            __m256d d = _mm256_fnmadd_pd(y, y, one); //1 - y*y
+            _mm256_storeu_pd(DY + idx, _mm256_mul_pd(dy, d));
+        }
+        tanh_backward_scalar(DY, Y, idx, n);
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // AVX-512: 8 doubles per register
+    ///////////////////////////////////////////////////////////////////
+    ANN_TARGET_AVX512 void relu_forward_avx512(double* X, size_t n, uint64_t* mask){
+        const __m512d zero = _mm512_setzero_pd();
+        size_t nfull = n/64;
+        for(size_t word=0; word < nfull; word++){
+            double* px = X + word*64;
+            uint64_t bits = 0;
+            for(int k=0; k < 8; k++){
+                __m512d x = _mm512_loadu_pd(px + 8*k);
+                __mmask8 keep = _mm512_cmp_pd_mask(x, zero, _CMP_GE_OQ);
+                _mm512_storeu_pd(px + 8*k, _mm512_maskz_mov_pd(keep, x));
+                bits |= uint64_t(keep) << (8*k);
+            }
+            if(mask != nullptr) mask[word] = bits;
+        }
+        relu_forward_scalar(X, nfull*64, n, mask);
+    }
+    ANN_TARGET_AVX512 void relu_backward_avx512(double* DY, size_t n, const uint64_t* mask){
+        size_t nfull = n/64;
+        for(size_t word=0; word < nfull; word++){
+            double* pdy = DY + word*64;
+            uint64_t bits = mask[word];
+            for(int k=0; k < 8; k++){
+                __mmask8 keep = (__mmask8)(bits >> (8*k));
+                __m512d dy = _mm512_loadu_pd(pdy + 8*k);
+                _mm512_storeu_pd(pdy + 8*k, _mm512_maskz_mov_pd(keep, dy));
+            }
+        }
+        relu_backward_scalar(DY, nfull*64, n, mask);
+    }
+    ANN_TARGET_AVX512 void sigmoid_forward_avx512(double* X, size_t n){
+        const __m512d one = _mm512_set1_pd(1.0);
+        const __m512d minus_one = _mm512_set1_pd(-1.0);
+        size_t idx = 0;
+        for(; idx + 8 <= n; idx += 8){
+            __m512d x = _mm512_loadu_pd(X + idx);
+            __m512d e = exp_avx512(_mm512_mul_pd(x, minus_one));
+            _mm512_storeu_pd(X + idx, _mm512_div_pd(one, _mm512_add_pd(one, e)));
+        }
+        sigmoid_forward_scalar(X, idx, n);
+    }
+    ANN_TARGET_AVX512 void sigmoid_backward_avx512(double* DY, const double* Y, size_t n){
+        size_t idx = 0;
+        for(; idx + 8 <= n; idx += 8){
+            __m512d y = _mm512_loadu_pd(Y + idx);
+            __m512d dy = _mm512_loadu_pd(DY + idx);
+            __m512d d = _mm512_fnmadd_pd(y, y, y);
+            _mm512_storeu_pd(DY + idx, _mm512_mul_pd(dy, d));
+        }
+        sigmoid_backward_scalar(DY, Y, idx, n);
+    }
+    ANN_TARGET_AVX512 void tanh_forward_avx512(double* X, size_t n){
+        const __m512d one = _mm512_set1_pd(1.0);
+        const __m512d small = _mm512_set1_pd(TANH_SMALL);
+        size_t idx = 0;
+        for(; idx + 8 <= n; idx += 8){
+            __m512d x = _mm512_loadu_pd(X + idx);
+            __m512d a = _mm512_abs_pd(x);
+            __m512d e = exp_avx512(_mm512_mul_pd(a, _mm512_set1_pd(-2.0)));
+            __m512d t = _mm512_div_pd(_mm512_sub_pd(one, e), _mm512_add_pd(one, e));
+            __m512d a2 = _mm512_mul_pd(a, a);
+            __m512d p = _mm512_fmadd_pd(_mm512_set1_pd(TANH_C9), a2, _mm512_set1_pd(TANH_C7));
+            p = _mm512_fmadd_pd(p, a2, _mm512_set1_pd(TANH_C5));
+            p = _mm512_fmadd_pd(p, a2, _mm512_set1_pd(TANH_C3));
+            p = _mm512_fmadd_pd(p, a2, one);
+            p = _mm512_mul_pd(p, a);
+            t = _mm512_mask_mov_pd(t, _mm512_cmp_pd_mask(a, small, _CMP_LT_OQ), p);
+            //restore the sign of x: |t| has a clear sign bit
+            __m512i sign = _mm512_and_epi64(_mm512_castpd_si512(x), _mm512_set1_epi64(0x8000000000000000LL));
+            _mm512_storeu_pd(X + idx, _mm512_castsi512_pd(_mm512_or_epi64(_mm512_castpd_si512(t), sign)));
+        }
+        tanh_forward_scalar(X, idx, n);
+    }
+    ANN_TARGET_AVX512 void tanh_backward_avx512(double* DY, const double* Y, size_t n){
+        const __m512d one = _mm512_set1_pd(1.0);
+        size_t idx = 0;
+        for(; idx + 8 <= n; idx += 8){
+            __m512d y = _mm512_loadu_pd(Y + idx);
+            __m512d dy = _mm512_loadu_pd(DY + idx);
+            __m512d d = _mm512_fnmadd_pd(y, y, one);
+            _mm512_storeu_pd(DY + idx, _mm512_mul_pd(dy, d));
+        }
+        tanh_backward_scalar(DY, Y, idx, n);
+    }
+#endif
+}
+
+///////////////////////////////////////////////////////////////////
+// Dispatchers: large buffers are split into chunks on the thread pool;
+// ReLU chunks start on a mask word (64 values)
+///////////////////////////////////////////////////////////////////
+namespace {
+    void relu_forward_chunk(double* X, size_t n, uint64_t* mask){
+#if ANN_HAVE_X86
+        if(simd_level() == SIMD_AVX512) return relu_forward_avx512(X, n, mask);
+        if(simd_level() == SIMD_AVX2) return relu_forward_avx2(X, n, mask);
+#endif
+        relu_forward_scalar(X, 0, n, mask);
+    }
+    void relu_backward_chunk(double* DY, size_t n, const uint64_t* mask){
+#if ANN_HAVE_X86
+        if(simd_level() == SIMD_AVX512) return relu_backward_avx512(DY, n, mask);
+        if(simd_level() == SIMD_AVX2) return relu_backward_avx2(DY, n, mask);
+#endif
+        relu_backward_scalar(DY, 0, n, mask);
+    }
+    void sigmoid_forward_chunk(double* X, size_t n){
+#if ANN_HAVE_X86
+        if(simd_level() == SIMD_AVX512) return sigmoid_forward_avx512(X, n);
+        if(simd_level() == SIMD_AVX2) return sigmoid_forward_avx2(X, n);
+#endif
+        sigmoid_forward_scalar(X, 0, n);
+    }
+    void sigmoid_backward_chunk(double* DY, const double* Y, size_t n){
+#if ANN_HAVE_X86
+        if(simd_level() == SIMD_AVX512) return sigmoid_backward_avx512(DY, Y, n);
+        if(simd_level() == SIMD_AVX2) return sigmoid_backward_avx2(DY, Y, n);
+#endif
+        sigmoid_backward_scalar(DY, Y, 0, n);
+    }
+    void tanh_forward_chunk(double* X, size_t n){
+#if ANN_HAVE_X86
+        if(simd_level() == SIMD_AVX512) return tanh_forward_avx512(X, n);
+        if(simd_level() == SIMD_AVX2) return tanh_forward_avx2(X, n);
+#endif
+        tanh_forward_scalar(X, 0, n);
+    }
+    void tanh_backward_chunk(double* DY, const double* Y, size_t n){
+#if ANN_HAVE_X86
+        if(simd_level() == SIMD_AVX512) return tanh_backward_avx512(DY, Y, n);
+        if(simd_level() == SIMD_AVX2) return tanh_backward_avx2(DY, Y, n);
+#endif
+        tanh_backward_scalar(DY, Y, 0, n);
+    }
+}
+
+void relu_forward(double* X, size_t n, uint64_t* mask){
+    parallel_for(n, [&](size_t begin, size_t end){
+        relu_forward_chunk(X + begin, end - begin, (mask != nullptr)? mask + begin/64 : nullptr);
+    }, 1, 64);
+}
+void relu_backward(double* DY, size_t n, const uint64_t* mask){
+    parallel_for(n, [&](size_t begin, size_t end){
+        relu_backward_chunk(DY + begin, end - begin, mask + begin/64);
+    }, 1, 64);
+}
+void sigmoid_forward(double* X, size_t n){
+    parallel_for(n, [&](size_t begin, size_t end){
+        sigmoid_forward_chunk(X + begin, end - begin);
+    });
+}
+void sigmoid_backward(double* DY, const double* Y, size_t n){
+    parallel_for(n, [&](size_t begin, size_t end){
+        sigmoid_backward_chunk(DY + begin, Y + begin, end - begin);
+    });
+}
+void tanh_forward(double* X, size_t n){
+    parallel_for(n, [&](size_t begin, size_t end){
+        tanh_forward_chunk(X + begin, end - begin);
+    });
+}
+void tanh_backward(double* DY, const double* Y, size_t n){
+    parallel_for(n, [&](size_t begin, size_t end){
+        tanh_backward_chunk(DY + begin, Y + begin, end - begin);
+    });
+}
@@ -0,0 +1,351 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.cc to edit this template
+ */
+
+/*
+ * File:   gemm.cpp
+ *
+ * Created on November 10, 2024, 4:05 PM
+ */
+
+#include "kernels/gemm.h"
+#include "kernels/vecmath.h"
+#include "util/ThreadPool.h"
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+/*
+ * Blocking (as in BLIS/GotoBLAS):
+ *  for jc (NC columns of C):
+ *    for pc (KC of the inner dimension): pack op(B)[pc, jc] into panels of NR columns
+ *                                        pack op(A)[:, pc] into panels of MR rows
+ *      for each block of MC rows x group of NR-panels (one task on the thread pool):
+ *        for jr (panel of B, stays in L1):
+ *          for ir (panel of A, the MC x KC block stays in L2):
+ *            micro-kernel: MR x NR tile of C += alpha*A_panel*B_panel, in registers
+ * Panels are zero-padded to MR/NR, so the micro-kernels always compute full tiles;
+ * the edges of C are written through a small tile buffer.
+ */
+namespace {
+    template<class T>
+    struct GemmConfig{
+        size_t MR, NR, MC, KC, NC;
+        void (*kernel)(size_t kc, const T* a, const T* b, T* C, size_t ldc, T alpha, size_t mr, size_t nr);
+    };
+
+    //C[mr x nr] += alpha*tile, tile: row stride NR
+    template<class T>
+    void add_tile(const T* tile, size_t NR, T* C, size_t ldc, T alpha, size_t mr, size_t nr){
+        for(size_t i=0; i < mr; i++)
+            for(size_t j=0; j < nr; j++) C[i*ldc + j] += alpha*tile[i*NR + j];
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Micro-kernels
+    ///////////////////////////////////////////////////////////////////
+    template<class T, size_t MR, size_t NR>
+    void kernel_scalar(size_t kc, const T* a, const T* b, T* C, size_t ldc, T alpha, size_t mr, size_t nr){
+        T acc[MR*NR] = {0};
+        for(size_t k=0; k < kc; k++){
+            for(size_t i=0; i < MR; i++)
+                for(size_t j=0; j < NR; j++) acc[i*NR + j] += a[i]*b[j];
+            a += MR;
+            b += NR;
+        }
+        add_tile(acc, NR, C, ldc, alpha, mr, nr);
+    }
+
+#if ANN_HAVE_X86
+    //double, 6 x 8: 12 accumulators
+    ANN_TARGET_AVX2 void dgemm_kernel_avx2(size_t kc, const double* a, const double* b,
+            double* C, size_t ldc, double alpha, size_t mr, size_t nr){
+        __m256d c[6][2];
+#pragma GCC unroll 6
+        for(int i=0; i < 6; i++){ c[i][0] = _mm256_setzero_pd(); c[i][1] = _mm256_setzero_pd(); }
+        for(size_t k=0; k < kc; k++){
+            __m256d b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b + 4);
+#pragma GCC unroll 6
+            for(int i=0; i < 6; i++){
+                __m256d ai = _mm256_broadcast_sd(a + i);
+                c[i][0] = _mm256_fmadd_pd(ai, b0, c[i][0]);
+                c[i][1] = _mm256_fmadd_pd(ai, b1, c[i][1]);
+            }
+            a += 6;
+            b += 8;
+        }
+        __m256d va = _mm256_set1_pd(alpha);
+        if((mr == 6) && (nr == 8)){
+#pragma GCC unroll 6
+            for(int i=0; i < 6; i++){
+                double* ci = C + i*ldc;
+                _mm256_storeu_pd(ci, _mm256_fmadd_pd(va, c[i][0], _mm256_loadu_pd(ci)));
+                _mm256_storeu_pd(ci + 4, _mm256_fmadd_pd(va, c[i][1], _mm256_loadu_pd(ci + 4)));
+            }
+            return;
+        }
+        double tile[6*8];
+        for(int i=0; i < 6; i++){
+            _mm256_storeu_pd(tile + i*8, c[i][0]);
+            _mm256_storeu_pd(tile + i*8 + 4, c[i][1]);
+        }
+        add_tile(tile, 8, C, ldc, alpha, mr, nr);
+    }
+
+    //float, 6 x 16: 12 accumulators
+    ANN_TARGET_AVX2 void sgemm_kernel_avx2(size_t kc, const float* a, const float* b,
+            float* C, size_t ldc, float alpha, size_t mr, size_t nr){
+        __m256 c[6][2];
+#pragma GCC unroll 6
+        for(int i=0; i < 6; i++){ c[i][0] = _mm256_setzero_ps(); c[i][1] = _mm256_setzero_ps(); }
+        for(size_t k=0; k < kc; k++){
+            __m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8);
+#pragma GCC unroll 6
+            for(int i=0; i < 6; i++){
+                __m256 ai = _mm256_broadcast_ss(a + i);
+                c[i][0] = _mm256_fmadd_ps(ai, b0, c[i][0]);
+                c[i][1] = _mm256_fmadd_ps(ai, b1, c[i][1]);
+            }
+            a += 6;
+            b += 16;
+        }
+        __m256 va = _mm256_set1_ps(alpha);
+        if((mr == 6) && (nr == 16)){
+#pragma GCC unroll 6
+            for(int i=0; i < 6; i++){
+                float* ci = C + i*ldc;
+                _mm256_storeu_ps(ci, _mm256_fmadd_ps(va, c[i][0], _mm256_loadu_ps(ci)));
+                _mm256_storeu_ps(ci + 8, _mm256_fmadd_ps(va, c[i][1], _mm256_loadu_ps(ci + 8)));
+            }
+            return;
+        }
+        float tile[6*16];
+        for(int i=0; i < 6; i++){
+            _mm256_storeu_ps(tile + i*16, c[i][0]);
+            _mm256_storeu_ps(tile + i*16 + 8, c[i][1]);
+        }
+        add_tile(tile, 16, C, ldc, alpha, mr, nr);
+    }
+
+    //double, 8 x 24: 24 accumulators
+    ANN_TARGET_AVX512 void dgemm_kernel_avx512(size_t kc, const double* a, const double* b,
+            double* C, size_t ldc, double alpha, size_t mr, size_t nr){
+        __m512d c[8][3];
+#pragma GCC unroll 8
+        for(int i=0; i < 8; i++){
+            c[i][0] = _mm512_setzero_pd(); c[i][1] = _mm512_setzero_pd(); c[i][2] = _mm512_setzero_pd();
+        }
+        for(size_t k=0; k < kc; k++){
+            __m512d b0 = _mm512_loadu_pd(b), b1 = _mm512_loadu_pd(b + 8), b2 = _mm512_loadu_pd(b + 16);
+#pragma GCC unroll 8
+            for(int i=0; i < 8; i++){
+                __m512d ai = _mm512_set1_pd(a[i]);
+                c[i][0] = _mm512_fmadd_pd(ai, b0, c[i][0]);
+                c[i][1] = _mm512_fmadd_pd(ai, b1, c[i][1]);
+                c[i][2] = _mm512_fmadd_pd(ai, b2, c[i][2]);
+            }
+            a += 8;
+            b += 24;
+        }
+        __m512d va = _mm512_set1_pd(alpha);
+        if((mr == 8) && (nr == 24)){
+#pragma GCC unroll 8
+            for(int i=0; i < 8; i++){
+                double* ci = C + i*ldc;
+                _mm512_storeu_pd(ci, _mm512_fmadd_pd(va, c[i][0], _mm512_loadu_pd(ci)));
+                _mm512_storeu_pd(ci + 8, _mm512_fmadd_pd(va, c[i][1], _mm512_loadu_pd(ci + 8)));
+                _mm512_storeu_pd(ci + 16, _mm512_fmadd_pd(va, c[i][2], _mm512_loadu_pd(ci + 16)));
+            }
+            return;
+        }
+        double tile[8*24];
+        for(int i=0; i < 8; i++){
+            _mm512_storeu_pd(tile + i*24, c[i][0]);
+            _mm512_storeu_pd(tile + i*24 + 8, c[i][1]);
+            _mm512_storeu_pd(tile + i*24 + 16, c[i][2]);
+        }
+        add_tile(tile, 24, C, ldc, alpha, mr, nr);
+    }
+
+    //float, 8 x 48: 24 accumulators
+    ANN_TARGET_AVX512 void sgemm_kernel_avx512(size_t kc, const float* a, const float* b,
+            float* C, size_t ldc, float alpha, size_t mr, size_t nr){
+        __m512 c[8][3];
+#pragma GCC unroll 8
+        for(int i=0; i < 8; i++){
+            c[i][0] = _mm512_setzero_ps(); c[i][1] = _mm512_setzero_ps(); c[i][2] = _mm512_setzero_ps();
+        }
+        for(size_t k=0; k < kc; k++){
+            __m512 b0 = _mm512_loadu_ps(b), b1 = _mm512_loadu_ps(b + 16), b2 = _mm512_loadu_ps(b + 32);
+#pragma GCC unroll 8
+            for(int i=0; i < 8; i++){
+                __m512 ai = _mm512_set1_ps(a[i]);
+                c[i][0] = _mm512_fmadd_ps(ai, b0, c[i][0]);
+                c[i][1] = _mm512_fmadd_ps(ai, b1, c[i][1]);
+                c[i][2] = _mm512_fmadd_ps(ai, b2, c[i][2]);
+            }
+            a += 8;
+            b += 48;
+        }
+        __m512 va = _mm512_set1_ps(alpha);
+        if((mr == 8) && (nr == 48)){
+#pragma GCC unroll 8
+            for(int i=0; i < 8; i++){
+                float* ci = C + i*ldc;
+                _mm512_storeu_ps(ci, _mm512_fmadd_ps(va, c[i][0], _mm512_loadu_ps(ci)));
+                _mm512_storeu_ps(ci + 16, _mm512_fmadd_ps(va, c[i][1], _mm512_loadu_ps(ci + 16)));
+                _mm512_storeu_ps(ci + 32, _mm512_fmadd_ps(va, c[i][2], _mm512_loadu_ps(ci + 32)));
+            }
+            return;
+        }
+        float tile[8*48];
+        for(int i=0; i < 8; i++){
+            _mm512_storeu_ps(tile + i*48, c[i][0]);
+            _mm512_storeu_ps(tile + i*48 + 16, c[i][1]);
+            _mm512_storeu_ps(tile + i*48 + 32, c[i][2]);
+        }
+        add_tile(tile, 48, C, ldc, alpha, mr, nr);
+    }
+#endif
+
+    template<class T>
+    GemmConfig<T> select_config();
+
+    template<>
+    GemmConfig<double> select_config<double>(){
+#if ANN_HAVE_X86
+        if(simd_level() == SIMD_AVX512) return {8, 24, 128, 256, 4080, &dgemm_kernel_avx512};
+        if(simd_level() == SIMD_AVX2) return {6, 8, 96, 256, 4096, &dgemm_kernel_avx2};
+#endif
+        return {4, 4, 64, 256, 4096, &kernel_scalar<double, 4, 4>};
+    }
+    template<>
+    GemmConfig<float> select_config<float>(){
+#if ANN_HAVE_X86
+        if(simd_level() == SIMD_AVX512) return {8, 48, 128, 256, 4080, &sgemm_kernel_avx512};
+        if(simd_level() == SIMD_AVX2) return {6, 16, 96, 256, 4096, &sgemm_kernel_avx2};
+#endif
+        return {4, 4, 64, 256, 4096, &kernel_scalar<float, 4, 4>};
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Packing
+    ///////////////////////////////////////////////////////////////////
+    //panels [ir, ir + MR) of op(A)[i0:, p0:p0+kc]: MR values per k, zero-padded
+    template<class T>
+    void pack_A(bool transA, const T* A, size_t lda, size_t M, size_t p0, size_t kc,
+            size_t MR, size_t panel_begin, size_t panel_end, T* buf){
+        for(size_t panel=panel_begin; panel < panel_end; panel++){
+            size_t i0 = panel*MR;
+            size_t mr = min(MR, M - i0);
+            T* dst = buf + panel*MR*kc;
+            for(size_t k=0; k < kc; k++){
+                for(size_t i=0; i < mr; i++)
+                    dst[k*MR + i] = transA? A[(p0 + k)*lda + i0 + i] : A[(i0 + i)*lda + p0 + k];
+                for(size_t i=mr; i < MR; i++) dst[k*MR + i] = 0;
+            }
+        }
+    }
+    //panels [jr, jr + NR) of op(B)[p0:p0+kc, j0:j0+nc]: NR values per k, zero-padded
+    template<class T>
+    void pack_B(bool transB, const T* B, size_t ldb, size_t j0, size_t nc, size_t p0, size_t kc,
+            size_t NR, size_t panel_begin, size_t panel_end, T* buf){
+        for(size_t panel=panel_begin; panel < panel_end; panel++){
+            size_t jr = panel*NR;
+            size_t nr = min(NR, nc - jr);
+            T* dst = buf + panel*NR*kc;
+            for(size_t k=0; k < kc; k++){
+                for(size_t j=0; j < nr; j++)
+                    dst[k*NR + j] = transB? B[(j0 + jr + j)*ldb + p0 + k] : B[(p0 + k)*ldb + j0 + jr + j];
+                for(size_t j=nr; j < NR; j++) dst[k*NR + j] = 0;
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Driver
+    ///////////////////////////////////////////////////////////////////
+    template<class T>
+    void gemm_driver(bool transA, bool transB, size_t M, size_t N, size_t K,
+            T alpha, const T* A, size_t lda, const T* B, size_t ldb, T beta, T* C, size_t ldc){
+        if((M == 0) || (N == 0)) return;
+        //C := beta*C
+        if(beta != T(1)){
+            parallel_for(M, [&](size_t begin, size_t end){
+                for(size_t i=begin; i < end; i++){
+                    T* ci = C + i*ldc;
+                    if(beta == T(0)) std::fill(ci, ci + N, T(0));
+                    else for(size_t j=0; j < N; j++) ci[j] *= beta;
+                }
+            }, N);
+        }
+        if((K == 0) || (alpha == T(0))) return;
+
+        const GemmConfig<T> cfg = select_config<T>(); //per call: follows set_simd_level
+        const size_t MR = cfg.MR, NR = cfg.NR, MC = cfg.MC;
+        //reused between calls; only this thread fills them, the tasks read them
+        static thread_local vector<T> bufA, bufB;
+        size_t npanels_A = (M + MR - 1)/MR;
+        size_t nblocks = (M + MC - 1)/MC;
+        size_t nthreads = ThreadPool::instance().size();
+
+        for(size_t j0=0; j0 < N; j0 += cfg.NC){
+            size_t nc = min(cfg.NC, N - j0);
+            size_t npanels_B = (nc + NR - 1)/NR;
+            //split the B panels into groups too when there are few row blocks
+            size_t ngroups = 1;
+            if(nthreads > 1) ngroups = min(npanels_B, max((size_t)1, (4*nthreads + nblocks - 1)/nblocks));
+            size_t group_size = (npanels_B + ngroups - 1)/ngroups;
+            ngroups = (npanels_B + group_size - 1)/group_size;
+
+            for(size_t p0=0; p0 < K; p0 += cfg.KC){
+                size_t kc = min(cfg.KC, K - p0);
+                bufA.resize(npanels_A*MR*kc);
+                bufB.resize(npanels_B*NR*kc);
+                T* pA = bufA.data();
+                T* pB = bufB.data();
+                parallel_for(npanels_A, [&](size_t begin, size_t end){
+                    pack_A(transA, A, lda, M, p0, kc, MR, begin, end, pA);
+                }, MR*kc);
+                parallel_for(npanels_B, [&](size_t begin, size_t end){
+                    pack_B(transB, B, ldb, j0, nc, p0, kc, NR, begin, end, pB);
+                }, NR*kc);
+
+                //one task: rows [ib*MC, ib*MC + MC) x panels of group jg
+                size_t task_flops = min(M, MC)*group_size*NR*kc;
+                parallel_for(nblocks*ngroups, [&](size_t begin, size_t end){
+                    for(size_t task=begin; task < end; task++){
+                        size_t ib = task/ngroups, jg = task%ngroups;
+                        size_t i_begin = ib*MC, i_end = min(M, i_begin + MC);
+                        size_t panel_begin = jg*group_size;
+                        size_t panel_end = min(npanels_B, panel_begin + group_size);
+                        for(size_t panel=panel_begin; panel < panel_end; panel++){
+                            size_t jr = panel*NR;
+                            size_t nr = min(NR, nc - jr);
+                            const T* b = pB + panel*NR*kc;
+                            for(size_t ir=i_begin; ir < i_end; ir += MR){
+                                size_t mr = min(MR, M - ir);
+                                const T* a = pA + (ir/MR)*MR*kc;
+                                cfg.kernel(kc, a, b, C + ir*ldc + j0 + jr, ldc, alpha, mr, nr);
+                            }
+                        }
+                    }
+                }, task_flops);
+            }
+        }
+    }
+}
+
+void gemm(bool transA, bool transB, size_t M, size_t N, size_t K,
+          double alpha, const double* A, size_t lda,
+          const double* B, size_t ldb,
+          double beta, double* C, size_t ldc){
+    gemm_driver<double>(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+void gemm(bool transA, bool transB, size_t M, size_t N, size_t K,
+          float alpha, const float* A, size_t lda,
+          const float* B, size_t ldb,
+          float beta, float* C, size_t ldc){
+    gemm_driver<float>(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
@@ -0,0 +1,249 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.cc to edit this template
+ */
+
+/*
+ * File:   softmax.cpp
+ *
+ * Created on November 6, 2024, 7:55 PM
+ */
+
+#include "kernels/softmax.h"
+#include "kernels/vecmath.h"
+#include "util/ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+using namespace std;
+
+/*
+ * Online update of (m, s) with a new value x, one exp per value:
+ *      e = exp(min(x, m) - max(x, m))
+ *      x >  m: s = s*e + 1, m = x
+ *      x <= m: s = s + e
+ * m starts at -DBL_MAX (not -inf) so that -inf inputs contribute 0 instead of NaN.
+ */
+namespace {
+    const size_t COL_BLOCK = 256; //columns per block when the axis is strided
+
+    inline void online_scalar(double x, double& m, double& s){
+        double e = std::exp(std::min(x, m) - std::max(x, m));
+        if(x > m){ s = s*e + 1.0; m = x; }
+        else s += e;
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Scalar
+    ///////////////////////////////////////////////////////////////////
+    void row_stats_scalar(const double* x, size_t len, double& m, double& s){
+        for(size_t idx=0; idx < len; idx++) online_scalar(x[idx], m, s);
+    }
+    void softmax_rows_scalar(const double* X, double* Y, size_t nrows, size_t len){
+        for(size_t r=0; r < nrows; r++){
+            const double* x = X + r*len;
+            double* y = Y + r*len;
+            double m = -DBL_MAX, s = 0.0;
+            row_stats_scalar(x, len, m, s);
+            double inv = 1.0/s;
+            for(size_t idx=0; idx < len; idx++) y[idx] = std::exp(x[idx] - m)*inv;
+        }
+    }
+    //columns [c0, c1) of one [len, inner] slice
+    void softmax_cols_scalar(const double* X, double* Y, size_t len, size_t inner,
+            size_t c0, size_t c1, double* m, double* s){
+        for(size_t c=c0; c < c1; c++){ m[c - c0] = -DBL_MAX; s[c - c0] = 0.0; }
+        for(size_t k=0; k < len; k++){
+            const double* x = X + k*inner;
+            for(size_t c=c0; c < c1; c++) online_scalar(x[c], m[c - c0], s[c - c0]);
+        }
+        for(size_t c=c0; c < c1; c++) s[c - c0] = 1.0/s[c - c0]; //inverse
+        for(size_t k=0; k < len; k++){
+            const double* x = X + k*inner;
+            double* y = Y + k*inner;
+            for(size_t c=c0; c < c1; c++) y[c] = std::exp(x[c] - m[c - c0])*s[c - c0];
+        }
+    }
+
+#if ANN_HAVE_X86
+    ///////////////////////////////////////////////////////////////////
+    // AVX2
+    ///////////////////////////////////////////////////////////////////
+    ANN_TARGET_AVX2 inline void online_avx2(__m256d x, __m256d& m, __m256d& s){
+        __m256d e = exp_avx2(_mm256_sub_pd(_mm256_min_pd(x, m), _mm256_max_pd(x, m)));
+        __m256d gt = _mm256_cmp_pd(x, m, _CMP_GT_OQ);
+        __m256d s_gt = _mm256_fmadd_pd(s, e, _mm256_set1_pd(1.0));
+        s = _mm256_blendv_pd(_mm256_add_pd(s, e), s_gt, gt);
+        m = _mm256_max_pd(m, x);
+    }
+    ANN_TARGET_AVX2 void softmax_rows_avx2(const double* X, double* Y, size_t nrows, size_t len){
+        size_t nvec = (len/4)*4;
+        for(size_t r=0; r < nrows; r++){
+            const double* x = X + r*len;
+            double* y = Y + r*len;
+            //pass 1: per-lane (m, s), merged into one (m, s)
+            __m256d vm = _mm256_set1_pd(-DBL_MAX), vs = _mm256_setzero_pd();
+            for(size_t idx=0; idx < nvec; idx += 4) online_avx2(_mm256_loadu_pd(x + idx), vm, vs);
+            double lm[4], ls[4];
+            _mm256_storeu_pd(lm, vm); _mm256_storeu_pd(ls, vs);
+            double m = std::max(std::max(lm[0], lm[1]), std::max(lm[2], lm[3]));
+            double s = 0.0;
+            for(int l=0; l < 4; l++) s += ls[l]*std::exp(lm[l] - m);
+            row_stats_scalar(x + nvec, len - nvec, m, s);
+
+            //pass 2
+            size_t idx = 0;
+            double inv = 1.0/s;
+            __m256d vmax = _mm256_set1_pd(m), vinv = _mm256_set1_pd(inv);
+            for(; idx < nvec; idx += 4){
+                __m256d e = exp_avx2(_mm256_sub_pd(_mm256_loadu_pd(x + idx), vmax));
+                _mm256_storeu_pd(y + idx, _mm256_mul_pd(e, vinv));
+            }
+            for(; idx < len; idx++) y[idx] = std::exp(x[idx] - m)*inv;
+        }
+    }
+    ANN_TARGET_AVX2 void softmax_cols_avx2(const double* X, double* Y, size_t len, size_t inner,
+            size_t c0, size_t c1, double* m, double* s){
+        size_t nvec = c0 + ((c1 - c0)/4)*4;
+        for(size_t c=c0; c < nvec; c += 4){
+            _mm256_storeu_pd(m + c - c0, _mm256_set1_pd(-DBL_MAX));
+            _mm256_storeu_pd(s + c - c0, _mm256_setzero_pd());
+        }
+        for(size_t k=0; k < len; k++){
+            const double* x = X + k*inner;
+            for(size_t c=c0; c < nvec; c += 4){
+                __m256d vm = _mm256_loadu_pd(m + c - c0), vs = _mm256_loadu_pd(s + c - c0);
+                online_avx2(_mm256_loadu_pd(x + c), vm, vs);
+                _mm256_storeu_pd(m + c - c0, vm); _mm256_storeu_pd(s + c - c0, vs);
+            }
+        }
+        for(size_t c=c0; c < nvec; c++) s[c - c0] = 1.0/s[c - c0];
+        for(size_t k=0; k < len; k++){
+            const double* x = X + k*inner;
+            double* y = Y + k*inner;
+            for(size_t c=c0; c < nvec; c += 4){
+                __m256d vx = _mm256_loadu_pd(x + c);
+                __m256d vs = _mm256_loadu_pd(s + c - c0);
+                __m256d e = exp_avx2(_mm256_sub_pd(vx, _mm256_loadu_pd(m + c - c0)));
+                _mm256_storeu_pd(y + c, _mm256_mul_pd(e, vs));
+            }
+        }
+        if(nvec < c1) softmax_cols_scalar(X, Y, len, inner, nvec, c1, m + nvec - c0, s + nvec - c0);
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // AVX-512
+    ///////////////////////////////////////////////////////////////////
+    ANN_TARGET_AVX512 inline void online_avx512(__m512d x, __m512d& m, __m512d& s){
+        __m512d e = exp_avx512(_mm512_sub_pd(_mm512_min_pd(x, m), _mm512_max_pd(x, m)));
+        __mmask8 gt = _mm512_cmp_pd_mask(x, m, _CMP_GT_OQ);
+        __m512d s_gt = _mm512_fmadd_pd(s, e, _mm512_set1_pd(1.0));
+        s = _mm512_mask_mov_pd(_mm512_add_pd(s, e), gt, s_gt);
+        m = _mm512_max_pd(m, x);
+    }
+    ANN_TARGET_AVX512 void softmax_rows_avx512(const double* X, double* Y, size_t nrows, size_t len){
+        size_t nvec = (len/8)*8;
+        for(size_t r=0; r < nrows; r++){
+            const double* x = X + r*len;
+            double* y = Y + r*len;
+            __m512d vm = _mm512_set1_pd(-DBL_MAX), vs = _mm512_setzero_pd();
+            for(size_t idx=0; idx < nvec; idx += 8) online_avx512(_mm512_loadu_pd(x + idx), vm, vs);
+            double m = _mm512_reduce_max_pd(vm);
+            double s = _mm512_reduce_add_pd(_mm512_mul_pd(vs, exp_avx512(_mm512_sub_pd(vm, _mm512_set1_pd(m)))));
+            row_stats_scalar(x + nvec, len - nvec, m, s);
+
+            size_t idx = 0;
+            double inv = 1.0/s;
+            __m512d vmax = _mm512_set1_pd(m), vinv = _mm512_set1_pd(inv);
+            for(; idx < nvec; idx += 8){
+                __m512d e = exp_avx512(_mm512_sub_pd(_mm512_loadu_pd(x + idx), vmax));
+                _mm512_storeu_pd(y + idx, _mm512_mul_pd(e, vinv));
+            }
+            for(; idx < len; idx++) y[idx] = std::exp(x[idx] - m)*inv;
+        }
+    }
+    ANN_TARGET_AVX512 void softmax_cols_avx512(const double* X, double* Y, size_t len, size_t inner,
+            size_t c0, size_t c1, double* m, double* s){
+        size_t nvec = c0 + ((c1 - c0)/8)*8;
+        for(size_t c=c0; c < nvec; c += 8){
+            _mm512_storeu_pd(m + c - c0, _mm512_set1_pd(-DBL_MAX));
+            _mm512_storeu_pd(s + c - c0, _mm512_setzero_pd());
+        }
+        for(size_t k=0; k < len; k++){
+            const double* x = X + k*inner;
+            for(size_t c=c0; c < nvec; c += 8){
+                __m512d vm = _mm512_loadu_pd(m + c - c0), vs = _mm512_loadu_pd(s + c - c0);
+                online_avx512(_mm512_loadu_pd(x + c), vm, vs);
+                _mm512_storeu_pd(m + c - c0, vm); _mm512_storeu_pd(s + c - c0, vs);
+            }
+        }
+        for(size_t c=c0; c < nvec; c++) s[c - c0] = 1.0/s[c - c0];
+        for(size_t k=0; k < len; k++){
+            const double* x = X + k*inner;
+            double* y = Y + k*inner;
+            for(size_t c=c0; c < nvec; c += 8){
+                __m512d vx = _mm512_loadu_pd(x + c);
+                __m512d vs = _mm512_loadu_pd(s + c - c0);
+                __m512d e = exp_avx512(_mm512_sub_pd(vx, _mm512_loadu_pd(m + c - c0)));
+                _mm512_storeu_pd(y + c, _mm512_mul_pd(e, vs));
+            }
+        }
+        if(nvec < c1) softmax_cols_scalar(X, Y, len, inner, nvec, c1, m + nvec - c0, s + nvec - c0);
+    }
+#endif
+
+    void softmax_dispatch(const double* X, double* Y, size_t outer, size_t len, size_t inner){
+        if((outer == 0) || (len == 0) || (inner == 0)) return;
+        SimdLevel level = simd_level();
+        //rows (or [len, inner] slices) are independent: split them on the thread pool
+        parallel_for(outer, [&](size_t o_begin, size_t o_end){
+            if(inner == 1){
+                const double* x = X + o_begin*len;
+                double* y = Y + o_begin*len;
+#if ANN_HAVE_X86
+                if(level == SIMD_AVX512) return softmax_rows_avx512(x, y, o_end - o_begin, len);
+                if(level == SIMD_AVX2) return softmax_rows_avx2(x, y, o_end - o_begin, len);
+#endif
+                return softmax_rows_scalar(x, y, o_end - o_begin, len);
+            }
+            //strided axis: blocks of COL_BLOCK columns, their (m, s) stay in L1
+            double m[COL_BLOCK], s[COL_BLOCK];
+            for(size_t o=o_begin; o < o_end; o++){
+                const double* x = X + o*len*inner;
+                double* y = Y + o*len*inner;
+                for(size_t c0=0; c0 < inner; c0 += COL_BLOCK){
+                    size_t c1 = std::min(inner, c0 + COL_BLOCK);
+#if ANN_HAVE_X86
+                    if(level == SIMD_AVX512){
+                        softmax_cols_avx512(x, y, len, inner, c0, c1, m, s);
+                        continue;
+                    }
+                    if(level == SIMD_AVX2){
+                        softmax_cols_avx2(x, y, len, inner, c0, c1, m, s);
+                        continue;
+                    }
+#endif
+                    softmax_cols_scalar(x, y, len, inner, c0, c1, m, s);
+                }
+            }
+        }, len*inner);
+    }
+}
+
+void softmax_forward(const double* X, double* Y, size_t outer, size_t len, size_t inner){
+    softmax_dispatch(X, Y, outer, len, inner);
+}
+
+void softmax_backward(const double* Y, double* DY, size_t outer, size_t len, size_t inner){
+    parallel_for(outer, [&](size_t o_begin, size_t o_end){
+        for(size_t o=o_begin; o < o_end; o++){
+            const double* y = Y + o*len*inner;
+            double* dy = DY + o*len*inner;
+            for(size_t c=0; c < inner; c++){
+                double dot = 0.0;
+                for(size_t k=0; k < len; k++) dot += dy[k*inner + c]*y[k*inner + c];
+                for(size_t k=0; k < len; k++) dy[k*inner + c] = y[k*inner + c]*(dy[k*inner + c] - dot);
+            }
+        }
+    }, len*inner);
+}
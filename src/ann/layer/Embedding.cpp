@@ -0,0 +1,224 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.cc to edit this template
+ */
+
+/*
+ * File:   Embedding.cpp
+ *
+ * Created on November 24, 2024, 10:05 AM
+ */
+
+#include "layer/Embedding.h"
+#include "ann/functions.h"
+#include "model/CheckpointWriter.h"
+#include "util/ThreadPool.h"
+#include "util/CounterRNG.h"
+#include "sformat/fmt_lib.h"
+#include <sstream>
+#include <exception>
+#include <filesystem> //require C++17
+namespace fs = std::filesystem;
+using namespace std;
+
+Embedding::Embedding(int Nvocab, int Ndim) {
+    m_pShared = nullptr;
+    this->m_nNvocab = Nvocab;
+    this->m_nNdim = Ndim;
+    m_sName = "Embedding_" + to_string(++m_unLayer_idx);
+    m_unSample_Counter = 0;
+
+    init_weights();
+    m_bRandom_Init = true;
+}
+
+Embedding::Embedding(string sParams, string filename_w, string sName){
+    m_pShared = nullptr;
+    //update name
+    if(trim(sName).size() != 0) this->m_sName = sName;
+    else m_sName = "Embedding_" + to_string(++m_unLayer_idx);
+    m_unSample_Counter = 0;
+
+    //parse sParams to get Nvocab, Ndim
+    try{
+        char delimiter=',';
+        istringstream param_stream(sParams);
+        int nparams[] = {0, 0}; //for: Nvocab, Ndim
+        string sparam;
+        int idx=0;
+        while((idx < 2) && getline(param_stream, sparam, delimiter)) nparams[idx++] = stoi(sparam);
+        if(idx < 2) throw std::runtime_error("Embedding's parameters: must specify Nvocab and Ndim");
+        this->m_nNvocab = nparams[0];
+        this->m_nNdim = nparams[1];
+
+        if(!fs::exists(filename_w)){
+            string message = fmt::format("{:s}: not exist; so initialize weights with random numbers", filename_w);
+            cout << message << endl;
+            init_weights();
+            m_bRandom_Init = (trim(sName).size() == 0); //an explicit name keeps its key
+        }
+        else{
+            double_tensor W = xt::load_npy<double>(filename_w);
+            bool valid = (W.dimension() == 2) &&
+                         (W.shape()[0] == (size_t)m_nNvocab) &&
+                         (W.shape()[1] == (size_t)m_nNdim);
+            if(!valid){
+                throw std::runtime_error("Embedding::Weights: shape from data file is not the same with the specification");
+            }
+            set_weights(W);
+        }
+    }
+    catch(exception& e){
+        string message = fmt::format(
+                            string("\tsParams: \"{:s}\";\r\n") +
+                            string("\tfilename_w: \"{:s}\";\r\n") +
+                            string("\tsName(layer-name):\"{:s}\""),
+                            sParams, filename_w, sName);
+        cerr << "In Embedding:Embedding(.,.,.), with the following info:" << endl;
+        cout << message << endl;
+        cerr << "-------EXCEPTION: BEGIN-------" << endl;
+        cerr << "\t" << e.what() << endl;
+        cerr << "-------EXCEPTION: END-------" << endl;
+        throw; //re-throw to the caller
+    }
+}
+
+void Embedding::init_weights(){
+    //N(0, 1), keyed by the layer name (see FCLayer::init_weights); the caller sets m_bRandom_Init
+    double_tensor W = empty_tensor({(size_t)m_nNvocab, (size_t)m_nNdim});
+    CounterRNG::for_name(m_sName).fill_normal(W.data(), W.size());
+    set_weights(W);
+}
+
+void Embedding::set_weights(double_tensor W){
+    this->m_aWeights = W;
+    this->m_bRandom_Init = false;
+    this->m_nNvocab = W.shape()[0];
+    this->m_nNdim = W.shape()[1];
+    m_grad_W.resize(m_nNvocab, m_nNdim);
+}
+
+Embedding::Embedding(const Embedding& orig): ILayer(orig) {
+    m_pShared = nullptr;
+    m_bRandom_Init = false;
+    m_nNvocab = orig.m_nNvocab;
+    m_nNdim = orig.m_nNdim;
+    m_aWeights = orig.weights();
+    m_grad_W.resize(m_nNvocab, m_nNdim);
+    m_unSample_Counter = 0;
+}
+
+Embedding::~Embedding() {
+}
+
+/*
+ * output_shape: X [...] -> [N, Ndim] (X is 1D) or [N, k*Ndim] (X is [N, k])
+ */
+xt::svector<size_t> Embedding::output_shape(const double_tensor& X) const {
+    size_t nrows = (X.dimension() == 0)? 1 : X.shape()[0];
+    size_t ncolumns = (nrows == 0)? 0 : X.size()/nrows;
+    return xt::svector<size_t>{nrows, ncolumns*m_nNdim};
+}
+
+/*
+ * gather: Y[p, :] = W[X[p], :], p: the ids of X in row-major order
+ */
+void Embedding::gather(const double_tensor& X, double_tensor& Y) const {
+    const double* ids = X.data();
+    const double* w = weights().data();
+    double* y = Y.data();
+    size_t ndim = m_nNdim, nvocab = m_nNvocab;
+    for(size_t p=0; p < X.size(); p++){
+        if(!(ids[p] >= 0) || (ids[p] >= nvocab)){
+            string message = fmt::format("Embedding::forward: id {} is out of [0, {:d})", ids[p], nvocab);
+            throw std::out_of_range(message);
+        }
+    }
+    parallel_for(X.size(), [&](size_t begin, size_t end){
+        for(size_t p=begin; p < end; p++){
+            const double* row = w + (size_t)ids[p]*ndim;
+            std::copy(row, row + ndim, y + p*ndim);
+        }
+    }, ndim);
+}
+
+double_tensor Embedding::forward(double_tensor X) {
+    //gather validates the ids: a throwing call leaves the caches untouched
+    double_tensor Y = empty_tensor(output_shape(X));
+    gather(X, Y);
+    //ids are cached (as integers) for backward in training mode
+    if (m_trainable) {
+        m_cached_ids.resize(X.size());
+        for(size_t p=0; p < X.size(); p++) m_cached_ids[p] = (size_t)X.data()[p];
+        m_cached_shape = xt::svector<size_t>(X.shape().begin(), X.shape().end());
+    }
+    return Y;
+}
+void Embedding::infer(InferenceContext& ctx) const {
+    double_tensor& X = ctx.current();
+    gather(X, ctx.next(output_shape(X)));
+    ctx.advance();
+}
+double_tensor Embedding::backward(double_tensor DY) {
+    size_t npositions = m_cached_ids.size();
+    if (DY.size() != npositions*m_nNdim)
+        throw std::runtime_error("Embedding::backward: no cached ids for DY; call forward in training mode first.");
+    if (m_grad_W.nrows() != (size_t)m_nNvocab) m_grad_W.resize(m_nNvocab, m_nNdim);
+
+    // dW[id, :] += DY[p, :] for the positions p of id: the rows of the batch only
+    const double* dy = DY.data();
+    size_t ndim = m_nNdim;
+    for(size_t p=0; p < npositions; p++){
+        double* g = m_grad_W.row(m_cached_ids[p]);
+        const double* dy_row = dy + p*ndim;
+        for(size_t c=0; c < ndim; c++) g[c] += dy_row[c];
+    }
+    m_unSample_Counter += (m_cached_shape.size() == 0)? 1 : m_cached_shape[0];
+
+    return xt::zeros<double>(m_cached_shape);
+}
+
+void Embedding::share_params(ILayer* pMaster){
+    Embedding* pEmbedding = dynamic_cast<Embedding*>(pMaster);
+    if((pEmbedding == nullptr) || (pEmbedding->m_nNvocab != m_nNvocab) || (pEmbedding->m_nNdim != m_nNdim))
+        throw std::invalid_argument("Embedding::share_params: the master is not an Embedding of the same shape");
+    m_pShared = (pEmbedding->m_pShared == nullptr)? pEmbedding : pEmbedding->m_pShared;
+    m_aWeights = double_tensor();
+}
+
+//reseed_params: the table drawn again from rng if it is still that of init_weights (see FCLayer)
+void Embedding::reseed_params(const CounterRNG& rng){
+    if(!m_bRandom_Init) return;
+    rng.fill_normal(weights().data(), weights().size());
+}
+
+int Embedding::register_params(IParamGroup* ptr_group){
+    ptr_group->register_sparse_param("weights", &weights(), &m_grad_W);
+    ptr_group->register_sample_count(&m_unSample_Counter);
+    return 1;
+}
+
+string Embedding::get_desc(){
+    string desc = fmt::format("{:<10s}, {:<15s}: {:<4d}, {:<4d}",
+                    "Embedding", this->getname(),
+                    this->m_nNvocab, this->m_nNdim);
+    return desc;
+}
+void Embedding::save(string model_path){
+    string filename_w = model_path + "/" + this->getname() + "_W.npy";
+    xt::dump_npy(filename_w, m_aWeights);
+}
+void Embedding::stage(Checkpoint& ckpt){
+    ckpt.add_tensor(this->getname() + "_W.npy", m_aWeights);
+}
+void Embedding::load(string model_path, string layer_name){
+    layer_name = trim(layer_name);
+    if(layer_name.size() == 0) layer_name = this->getname();
+    string filename_w = model_path + "/" + layer_name + "_W.npy";
+    if(!fs::exists(filename_w)){
+        string message = fmt::format("{:s}: weight-file does not exist.", filename_w);
+        throw std::runtime_error(message);
+    }
+    set_weights(xt::load_npy<double>(filename_w));
+    m_unSample_Counter = 0;
+}
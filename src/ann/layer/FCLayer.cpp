@@ -12,6 +12,10 @@
 
 #include "layer/FCLayer.h"
 #include "ann/functions.h"
+#include "model/CheckpointWriter.h"
+#include "kernels/gemm.h"
+#include "util/ThreadPool.h"
+#include "util/CounterRNG.h"
 #include "sformat/fmt_lib.h"
 #include <sstream>
 #include <exception>
@@ -20,16 +24,21 @@ namespace fs = std::filesystem;
 using namespace std;
 
 FCLayer::FCLayer(int Nin, int Nout, bool use_bias) {
+    m_pShared = nullptr;
     this->m_nNin = Nin;
     this->m_nNout = Nout;
     this->m_bUse_Bias = use_bias;
     m_sName = "FC_" + to_string(++m_unLayer_idx);
     m_unSample_Counter = 0;
+    m_bSparse_Input = false;
     
     init_weights();
+    m_bRandom_Init = true;
 }
 
 FCLayer::FCLayer(string sParams, string filename_w, string filename_b, string sName){
+    m_pShared = nullptr;
+    m_bRandom_Init = false;
     //update name
     if(trim(sName).size() != 0) this->m_sName = sName;
     else m_sName = "FC_" + to_string(++m_unLayer_idx);
@@ -59,6 +68,7 @@ FCLayer::FCLayer(string sParams, string filename_w, string filename_b, string sN
         this->m_nNout = nparams[1];
         this->m_bUse_Bias = nparams[2];
         this->m_unSample_Counter = 0;
+        this->m_bSparse_Input = false;
 
         
         bool weight_file_invalid = !fs::exists(filename_w);
@@ -70,8 +80,10 @@ FCLayer::FCLayer(string sParams, string filename_w, string filename_b, string sN
             cout << message << endl;
             
             //initialize
-            this->m_aWeights = xt::random::randn<double>({m_nNout, m_nNin});
+            this->m_aWeights = empty_tensor({m_nNout, m_nNin});
+            CounterRNG::for_name(m_sName).fill_normal(m_aWeights.data(), m_aWeights.size());
             this->m_aGrad_W = xt::zeros<double>({m_nNout, m_nNin});
+            this->m_bRandom_Init = (trim(sName).size() == 0); //an explicit name keeps its key
         }
         else{
             //DO LOADING WEIGHTS when the file are valid
@@ -124,8 +136,14 @@ FCLayer::FCLayer(string sParams, string filename_w, string filename_b, string sN
     }
 }
 
+/*
+ * init_weights: W ~ N(0, 1) from the CounterRNG keyed by the layer name: the weights depend on
+ *  the global seed and the name only (not on the random numbers drawn before), in parallel;
+ *  in a model, the key of the model replaces that of the default name (see reseed_params)
+ */
 void FCLayer::init_weights(){
-    this->m_aWeights = xt::random::randn<double>({m_nNout, m_nNin});
+    this->m_aWeights = empty_tensor({m_nNout, m_nNin});
+    CounterRNG::for_name(m_sName).fill_normal(m_aWeights.data(), m_aWeights.size());
     this->m_aGrad_W = xt::zeros<double>({m_nNout, m_nNin});
     
     if(m_bUse_Bias){
@@ -135,55 +153,199 @@ void FCLayer::init_weights(){
     }
 }
 
-FCLayer::FCLayer(const FCLayer& orig) {
-    m_sName = "FC_" + to_string(++m_unLayer_idx);
+FCLayer::FCLayer(const FCLayer& orig): ILayer(orig) {
+    m_pShared = nullptr;
+    m_bRandom_Init = false;
+    m_nNin = orig.m_nNin;
+    m_nNout = orig.m_nNout;
+    m_bUse_Bias = orig.m_bUse_Bias;
+    m_aWeights = orig.weights();
+    m_aBias = orig.bias();
+    m_aGrad_W = xt::zeros<double>({m_nNout, m_nNin});
+    if(m_bUse_Bias) m_aGrad_b = xt::zeros<double>({m_nNout});
+    m_unSample_Counter = 0;
+    m_bSparse_Input = false;
 }
 
 FCLayer::~FCLayer() {
 }
 
-xt::xarray<double> FCLayer::forward(xt::xarray<double> X) {
+double_tensor FCLayer::forward(double_tensor X) {
     //YOUR CODE IS HERE
     // Assigns X to m_aCached_X if in training mode
-    if (m_trainable) m_aCached_X = X;
+    if (m_trainable){
+        m_aCached_X = X;
+        m_bSparse_Input = false;
+    }
 
-    // Calculate Y = X*W^T + b
-    // (1) Calculate X*W^T and assign it to the matrix res
-    xt::xarray<double> res = xt::linalg::dot(X, xt::transpose(m_aWeights));
+    // Calculate Y = X*W^T + b; X: [..., Nin] is seen as [nrows, Nin]
+    xt::svector<size_t> shape(X.shape().begin(), X.shape().end());
+    shape.back() = m_nNout;
+    double_tensor res = empty_tensor(shape);
+    affine(X, res);
+    return res;
+}
+void FCLayer::infer(InferenceContext& ctx) const {
+    double_tensor& X = ctx.current();
+    xt::svector<size_t> shape(X.shape().begin(), X.shape().end());
+    shape.back() = m_nNout;
+    affine(X, ctx.next(shape));
+    ctx.advance();
+}
+/*
+ * affine: Y = X*W^T + b, Y is allocated by the caller ([..., Nout])
+ */
+void FCLayer::affine(const double_tensor& X, double_tensor& Y) const {
+    size_t nrows = X.size()/m_nNin;
+    // (1) Calculate X*W^T: W is read as transposed by the GEMM, not materialized
+    gemm(false, true, nrows, m_nNout, m_nNin,
+         1.0, X.data(), m_nNin,
+         weights().data(), m_nNin,
+         0.0, Y.data(), m_nNout);
 
     // (2) If bias is used, plus b
     if (m_bUse_Bias) {
-        res += m_aBias;
+        double* y = Y.data();
+        const double* b = bias().data();
+        size_t nout = m_nNout;
+        parallel_for(nrows, [&](size_t begin, size_t end){
+            for(size_t r=begin; r < end; r++)
+                for(size_t c=0; c < nout; c++) y[r*nout + c] += b[c];
+        }, nout);
     }
-
+}
+double_tensor FCLayer::forward(const CSRMatrix<double>& X) {
+    if (X.cols() != (size_t)m_nNin)
+        throw std::runtime_error("FCLayer::forward: the sparse input does not have Nin columns");
+    if (m_trainable){
+        m_cached_sparse_X = X;
+        m_bSparse_Input = true;
+    }
+    double_tensor res = empty_tensor({X.rows(), (size_t)m_nNout});
+    affine(X, res);
     return res;
 }
-xt::xarray<double> FCLayer::backward(xt::xarray<double> DY) {
-    //YOUR CODE IS HERE
-    if (m_bUse_Bias) m_aGrad_b = xt::sum(DY, {0});  // !mean or sum
+void FCLayer::infer(const CSRMatrix<double>& X, InferenceContext& ctx) const {
+    if (X.cols() != (size_t)m_nNin)
+        throw std::runtime_error("FCLayer::infer: the sparse input does not have Nin columns");
+    affine(X, ctx.next(xt::svector<size_t>{X.rows(), (size_t)m_nNout}));
+    ctx.advance();
+}
+/*
+ * affine (sparse X): Y[r, o] = b[o] + sum_k X[r, c_k]*W[o, c_k], over the non-zeros of row r only
+ */
+void FCLayer::affine(const CSRMatrix<double>& X, double_tensor& Y) const {
+    const size_t* offsets = X.offsets();
+    const uint32_t* indices = X.indices();
+    const double* values = X.values();
+    const double* w = weights().data();
+    const double* b = m_bUse_Bias? bias().data() : nullptr;
+    double* y = Y.data();
+    size_t nin = m_nNin, nout = m_nNout;
+    size_t row_cost = nout*(1 + X.nnz()/max((size_t)1, X.rows()));
+    parallel_for(X.rows(), [&](size_t begin, size_t end){
+        for(size_t r=begin; r < end; r++){
+            for(size_t o=0; o < nout; o++){
+                const double* w_row = w + o*nin;
+                double sum = (b != nullptr)? b[o] : 0.0;
+                for(size_t k=offsets[r]; k < offsets[r + 1]; k++) sum += values[k]*w_row[indices[k]];
+                y[r*nout + o] = sum;
+            }
+        }
+    }, row_cost);
+}
+/*
+ * backward_sparse: dW += DY^T*X with X the cached CSR input, db += sum_rows(DY);
+ *  the rows o of dW are split between the threads (no two threads write the same row)
+ */
+double_tensor FCLayer::backward_sparse(double_tensor& DY) {
+    const CSRMatrix<double>& X = m_cached_sparse_X;
+    size_t nrows = X.rows(), nin = m_nNin, nout = m_nNout;
+    if (DY.size() != nrows*nout)
+        throw std::runtime_error("FCLayer::backward: DY does not match the cached sparse input.");
+    if (m_bUse_Bias){
+        if (m_aGrad_b.size() != nout) m_aGrad_b = xt::zeros<double>({nout});
+        m_aGrad_b += sum_rows(DY.reshape({nrows, nout}));
+    }
+    m_unSample_Counter += nrows;
 
-    m_unSample_Counter += DY.shape()[0];
+    if (m_aGrad_W.size() != nout*nin) m_aGrad_W = xt::zeros<double>({nout, nin});
+    const size_t* offsets = X.offsets();
+    const uint32_t* indices = X.indices();
+    const double* values = X.values();
+    const double* dy = DY.data();
+    double* gw = m_aGrad_W.data();
+    parallel_for(nout, [&](size_t begin, size_t end){
+        for(size_t r=0; r < nrows; r++){
+            for(size_t o=begin; o < end; o++){
+                double d = dy[r*nout + o];
+                if(d == 0) continue;
+                double* gw_row = gw + o*nin;
+                for(size_t k=offsets[r]; k < offsets[r + 1]; k++) gw_row[indices[k]] += d*values[k];
+            }
+        }
+    }, 1 + X.nnz());
 
-    m_aGrad_W = xt::zeros<double>({static_cast<size_t>(DY.shape()[0]), static_cast<size_t>(m_nNout), static_cast<size_t>(m_nNin)});
+    // no DX: a sparse input comes from the data, not from a layer
+    return double_tensor();
+}
 
-    for (size_t i = 0; i < DY.shape()[0] ; ++i) {
-        auto i_DY = xt::view(DY, i);
-        auto i_X = xt::view(m_aCached_X, i);
-        xt::view(m_aGrad_W, i) = xt::linalg::outer(i_DY, xt::transpose(i_X));
+double_tensor FCLayer::backward(double_tensor DY) {
+    //YOUR CODE IS HERE
+    if (m_bSparse_Input) return backward_sparse(DY);
+    size_t nrows = DY.size()/m_nNout;
+    if (m_aCached_X.size() != nrows*m_nNin)
+        throw std::runtime_error("FCLayer::backward: no cached input for DY; call forward in training mode first.");
+    // Gradients are accumulated (+=): zero_grad clears them, and a logical batch
+    // can be processed as several micro-batches (see IModel::fit)
+    if (m_bUse_Bias){
+        if (m_aGrad_b.size() != (size_t)m_nNout) m_aGrad_b = xt::zeros<double>({(size_t)m_nNout});
+        m_aGrad_b += sum_rows(DY.reshape({nrows, (size_t)m_nNout}));  // !mean or sum
     }
 
-    m_aGrad_W = xt::sum(m_aGrad_W, {0}); 
+    m_unSample_Counter += nrows;
+
+    // dW += DY^T*X: [Nout, nrows] x [nrows, Nin]
+    if (m_aGrad_W.size() != (size_t)(m_nNout*m_nNin)) m_aGrad_W = xt::zeros<double>({(size_t)m_nNout, (size_t)m_nNin});
+    gemm(true, false, m_nNout, m_nNin, nrows,
+         1.0, DY.data(), m_nNout,
+         m_aCached_X.data(), m_nNin,
+         1.0, m_aGrad_W.data(), m_nNin);
 
-    xt::xarray<double> res = xt::linalg::dot(DY, m_aWeights);
+    // dX = DY*W: [nrows, Nout] x [Nout, Nin]
+    xt::svector<size_t> shape(m_aCached_X.shape().begin(), m_aCached_X.shape().end());
+    double_tensor res = empty_tensor(shape);
+    gemm(false, false, nrows, m_nNin, m_nNout,
+         1.0, DY.data(), m_nNout,
+         weights().data(), m_nNin,
+         0.0, res.data(), m_nNin);
     
     return res;
 }
 
+void FCLayer::share_params(ILayer* pMaster){
+    FCLayer* pFC = dynamic_cast<FCLayer*>(pMaster);
+    if((pFC == nullptr) || (pFC->m_nNin != m_nNin) || (pFC->m_nNout != m_nNout) || (pFC->m_bUse_Bias != m_bUse_Bias))
+        throw std::invalid_argument("FCLayer::share_params: the master is not an FC layer of the same shape");
+    m_pShared = (pFC->m_pShared == nullptr)? pFC : pFC->m_pShared;
+    m_aWeights = double_tensor();
+    m_aBias = double_tensor();
+}
+
+/*
+ * reseed_params: W drawn again from rng (b stays 0) if it is still that of init_weights;
+ *  the weights that were set, loaded, cloned or keyed by an explicit name are kept
+ */
+void FCLayer::reseed_params(const CounterRNG& rng){
+    if(!m_bRandom_Init) return;
+    rng.fill_normal(weights().data(), weights().size());
+}
+
 int FCLayer::register_params(IParamGroup* ptr_group){
-    ptr_group->register_param("weights", &m_aWeights, &m_aGrad_W);
+    ptr_group->register_param("weights", &weights(), &m_aGrad_W);
     int count = 1;
     if(m_bUse_Bias){
-        ptr_group->register_param("bias", &m_aBias, &m_aGrad_b);
+        ptr_group->register_param("bias", &bias(), &m_aGrad_b);
         count += 1;
     }
     ptr_group->register_sample_count(&m_unSample_Counter);
@@ -205,6 +367,12 @@ void FCLayer::save(string model_path){
         xt::dump_npy(filename_b, m_aBias);
     }
 }
+void FCLayer::stage(Checkpoint& ckpt){
+    ckpt.add_tensor(this->getname() + "_W.npy", m_aWeights);
+    if(m_bUse_Bias){
+        ckpt.add_tensor(this->getname() + "_b.npy", m_aBias);
+    }
+}
 /*
  * load(string model_path, string layer_name)
  *  + model_path: folder that contains the models' data files: arch.txt and others.
@@ -259,6 +427,8 @@ void FCLayer::load(string model_path, string layer_name){
         }
         
         m_unSample_Counter = 0;
+        m_bSparse_Input = false;
+        m_bRandom_Init = false;
     }
     catch(exception& e){
         cout << e.what() << endl;
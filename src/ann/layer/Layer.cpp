@@ -17,6 +17,8 @@ ILayer::ILayer() {
 }
 
 ILayer::ILayer(const ILayer& orig) {
+    this->m_trainable = orig.m_trainable;
+    this->m_sName = orig.m_sName; //a copy keeps the name (no new index)
 }
 
 ILayer::~ILayer() {
@@ -13,33 +13,44 @@
 #include "layer/ReLU.h"
 #include "sformat/fmt_lib.h"
 #include "ann/functions.h"
+#include "kernels/activation.h"
 
 ReLU::ReLU(string name) {
     if(trim(name).size() != 0) m_sName = name;
     else m_sName = "ReLU_" + to_string(++m_unLayer_idx);
 }
 
-ReLU::ReLU(const ReLU& orig) {
-    m_sName = "ReLU_" + to_string(++m_unLayer_idx);
+ReLU::ReLU(const ReLU& orig): ILayer(orig) {
 }
 
 ReLU::~ReLU() {
 }
 
-xt::xarray<double> ReLU::forward(xt::xarray<double> X) {
+double_tensor ReLU::forward(double_tensor X) {
     //YOUR CODE IS HERE
-    // Create a mask M (m_aMask). If a value in X is >= 0 then the corresponding value in M is true and otherwise
-    m_aMask = (X >= 0);
-    // Calculate Y = M ⊙ X (⊙: element-wise multiplication)
-    xt::xarray<double> res = xt::where(m_aMask, X, 0.0);
-    return res;
+    // Y = M ⊙ X, computed in place on X (X is passed by value);
+    // the mask M (X >= 0) is kept as a bitmask for backward, only in training mode
+    uint64_t* mask = nullptr;
+    if (m_trainable) {
+        size_t nwords = relu_mask_words(X.size());
+        if (m_aMask.size() != nwords) m_aMask.resize({nwords});
+        mask = m_aMask.data();
+    }
+    relu_forward(X.data(), X.size(), mask);
+    return X;
 }
-xt::xarray<double> ReLU::backward(xt::xarray<double> DY) {
+void ReLU::infer(InferenceContext& ctx) const {
+    double_tensor& X = ctx.current();
+    relu_forward(X.data(), X.size(), nullptr);
+}
+double_tensor ReLU::backward(double_tensor DY) {
     //YOUR CODE IS HERE
-    // Using the cached mask M (m_aMask), DX is calculate using DX = M ⊙ DY
-    xt::xarray<double> DX = m_aMask * DY;
-
-    return DX;
+    // Using the cached mask M (m_aMask), DX is calculate using DX = M ⊙ DY (in place on DY)
+    if (m_aMask.size() != relu_mask_words(DY.size())) {
+        throw std::runtime_error("ReLU::backward: no mask for DY; call forward in training mode first.");
+    }
+    relu_backward(DY.data(), DY.size(), m_aMask.data());
+    return DY;
 }
 
 string ReLU::get_desc(){
@@ -13,27 +13,37 @@
 #include "layer/Sigmoid.h"
 #include "sformat/fmt_lib.h"
 #include "ann/functions.h"
+#include "kernels/activation.h"
 
 Sigmoid::Sigmoid(string name) {
     if(trim(name).size() != 0) m_sName = name;
     else m_sName = "Sigmoid_" + to_string(++m_unLayer_idx);
 }
 
-Sigmoid::Sigmoid(const Sigmoid& orig) {
-    m_sName = "Sigmoid_" + to_string(++m_unLayer_idx);
+Sigmoid::Sigmoid(const Sigmoid& orig): ILayer(orig) {
 }
 
 Sigmoid::~Sigmoid() {
 }
-xt::xarray<double> Sigmoid::forward(xt::xarray<double> X) {
+double_tensor Sigmoid::forward(double_tensor X) {
     //YOUR CODE IS HERE
-    m_aCached_Y = 1 / (1+ exp(-X));
-    return m_aCached_Y;
+    // Y = 1/(1 + exp(-X)), in place on X
+    sigmoid_forward(X.data(), X.size());
+    if (m_trainable) m_aCached_Y = X;
+    return X;
 }
-xt::xarray<double> Sigmoid::backward(xt::xarray<double> DY) {
+void Sigmoid::infer(InferenceContext& ctx) const {
+    double_tensor& X = ctx.current();
+    sigmoid_forward(X.data(), X.size());
+}
+double_tensor Sigmoid::backward(double_tensor DY) {
     //YOUR CODE IS HERE
-    xt::xarray<double> DX = DY * m_aCached_Y * (1 - m_aCached_Y);
-    return DX;
+    // DX = DY ⊙ Y ⊙ (1 - Y), in place on DY
+    if (m_aCached_Y.size() != DY.size()) {
+        throw std::runtime_error("Sigmoid::backward: no cached Y for DY; call forward in training mode first.");
+    }
+    sigmoid_backward(DY.data(), m_aCached_Y.data(), DY.size());
+    return DY;
 }
 
 string Sigmoid::get_desc(){
@@ -12,6 +12,7 @@
 
 #include "layer/Softmax.h"
 #include "ann/functions.h"
+#include "kernels/softmax.h"
 #include "sformat/fmt_lib.h"
 #include <filesystem> //require C++17
 namespace fs = std::filesystem;
@@ -21,36 +22,45 @@ Softmax::Softmax(int axis, string name): m_nAxis(axis) {
     else m_sName = "Softmax_" + to_string(++m_unLayer_idx);
 }
 
-Softmax::Softmax(const Softmax& orig) {
+Softmax::Softmax(const Softmax& orig): ILayer(orig), m_nAxis(orig.m_nAxis) {
 }
 
 Softmax::~Softmax() {
 }
 
-xt::xarray<double> Softmax::forward(xt::xarray<double> X) {
+double_tensor Softmax::forward(double_tensor X) {
     //YOUR CODE IS HERE
-    m_aCached_Y = softmax(X, m_nAxis);
+    X = softmax(X, m_nAxis);
+    if(m_trainable) m_aCached_Y = X;
 
-    return m_aCached_Y;
+    return X;
 }
-xt::xarray<double> Softmax::backward(xt::xarray<double> DY) {
+void Softmax::infer(InferenceContext& ctx) const {
+    double_tensor& X = ctx.current();
+    size_t outer, len, inner;
+    axis_view(X, outer, len, inner);
+    softmax_forward(X.data(), X.data(), outer, len, inner);
+}
+double_tensor Softmax::backward(double_tensor DY) {
     //YOUR CODE IS HERE
-    xt::xarray<double> DZ = xt::zeros<double>(DY.shape());
-
-    for (size_t i = 0; i < DY.shape()[0]; ++i) {
-        xt::xarray<double> i_DY = xt::view(DY, i);
-        xt::xarray<double> i_Y = xt::view(m_aCached_Y, i);
-
-        xt::xarray<double> diag_Y = xt::diag(i_Y);
-
-        xt::xarray<double> outer_product = xt::linalg::outer(i_Y, xt::transpose(i_Y));
-
-        xt::xarray<double> Jacobian = diag_Y - outer_product;
-
-        xt::view(DZ, i) = xt::linalg::dot(Jacobian, i_DY);
-    }
+    if(m_aCached_Y.size() != DY.size())
+        throw std::runtime_error("Softmax::backward: no cached output for DY; call forward in training mode first.");
+    size_t outer, len, inner;
+    axis_view(DY, outer, len, inner);
+    
+    //DY is a copy: DZ = J^T.DY is computed in place
+    softmax_backward(m_aCached_Y.data(), DY.data(), outer, len, inner);
+    return DY;
+}
 
-    return DZ;
+/*
+ * axis_view: the sizes [outer, len, inner] of X seen around the softmax axis
+ */
+void Softmax::axis_view(const double_tensor& X, size_t& outer, size_t& len, size_t& inner) const {
+    int axis = positive_index(m_nAxis, X.dimension());
+    outer = 1; inner = 1; len = X.shape()[axis];
+    for(int d=0; d < axis; d++) outer *= X.shape()[d];
+    for(int d=axis + 1; d < (int)X.dimension(); d++) inner *= X.shape()[d];
 }
 
 string Softmax::get_desc(){
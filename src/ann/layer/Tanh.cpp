@@ -13,28 +13,38 @@
 #include "layer/Tanh.h"
 #include "sformat/fmt_lib.h"
 #include "ann/functions.h"
+#include "kernels/activation.h"
 
 Tanh::Tanh(string name) {
     if(trim(name).size() != 0) m_sName = name;
     else m_sName = "Tanh_" + to_string(++m_unLayer_idx);
 }
 
-Tanh::Tanh(const Tanh& orig) {
-    m_sName = "Tanh_" + to_string(++m_unLayer_idx);
+Tanh::Tanh(const Tanh& orig): ILayer(orig) {
 }
 
 Tanh::~Tanh() {
 }
 
-xt::xarray<double> Tanh::forward(xt::xarray<double> X) {
+double_tensor Tanh::forward(double_tensor X) {
     //YOUR CODE IS HERE
-    m_aCached_Y = (exp(X) - exp(-X)) / (exp(X) + exp(-X));
-    return m_aCached_Y;
+    // Y = tanh(X), in place on X
+    tanh_forward(X.data(), X.size());
+    if (m_trainable) m_aCached_Y = X;
+    return X;
 }
-xt::xarray<double> Tanh::backward(xt::xarray<double> DY) {
+void Tanh::infer(InferenceContext& ctx) const {
+    double_tensor& X = ctx.current();
+    tanh_forward(X.data(), X.size());
+}
+double_tensor Tanh::backward(double_tensor DY) {
     //YOUR CODE IS HERE
-    xt::xarray<double> DX = DY * (1 - m_aCached_Y * m_aCached_Y);
-    return DX;
+    // DX = DY ⊙ (1 - Y ⊙ Y), in place on DY
+    if (m_aCached_Y.size() != DY.size()) {
+        throw std::runtime_error("Tanh::backward: no cached Y for DY; call forward in training mode first.");
+    }
+    tanh_backward(DY.data(), m_aCached_Y.data(), DY.size());
+    return DY;
 }
 
 string Tanh::get_desc(){
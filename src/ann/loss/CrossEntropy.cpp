@@ -12,6 +12,7 @@
 
 #include "loss/CrossEntropy.h"
 #include "ann/functions.h"
+#include "util/ThreadPool.h"
 
 CrossEntropy::CrossEntropy(LossReduction reduction): ILossLayer(reduction){
     
@@ -24,33 +25,46 @@ ILossLayer(orig){
 CrossEntropy::~CrossEntropy() {
 }
 
-double CrossEntropy::forward(xt::xarray<double> X, xt::xarray<double> t){
+double CrossEntropy::forward(double_tensor X, double_tensor t){
     //YOUR CODE IS HERE
+    // sum(-t_i . log(y_i)) over the classes, mean (or sum for REDUCE_SUM) over the batch
+    // sparse labels (t: [N], class indices): -log(y[t]) is gathered per sample;
+    // they are validated (integers in [0, C)) before anything is cached, backward relies on it
+    if(t.dimension() == 1){
+        ulong_tensor labels = label_indices(t, X.size()/X.shape()[0]);
+        m_aCached_Ypred = X;
+        m_aYtarget = t;
+        return cross_entropy(X, labels, m_eReduction != REDUCE_SUM);
+    }
     m_aCached_Ypred = X;
     m_aYtarget = t;
-
-    // Calculate log(y_i)
-    auto log_yi = xt::log(X + 1e-7);
-
-    // Calculate the element-wise product t_i . log(y_i)
-    auto product = t * log_yi;
-
-    // Check if product has more than one dimension before applying axis
-    double CE;
-    if (product.dimension() > 1) {
-        CE = -xt::mean(xt::sum(product, {1}))();  // Sum across classes and mean across batch
-    } else {
-        CE = -xt::mean(product)();  // No axis specified if 1D
-    }
-
-    return CE;
+    return cross_entropy(X, t, m_eReduction != REDUCE_SUM);
 }
-xt::xarray<double> CrossEntropy::backward() {
+double_tensor CrossEntropy::backward() {
     //YOUR CODE IS HERE
     const double EPSILON = 1e-7;
-    int N_norm = m_aCached_Ypred.shape()[0];
+    int N_norm = (m_eReduction == REDUCE_SUM)? 1 : m_aCached_Ypred.shape()[0];
 
-    // Compute the gradient according to the formula
-    xt::xarray<double> gradient = - (m_aYtarget / (m_aCached_Ypred + EPSILON)) / N_norm;
+    // Compute the gradient according to the formula: -(t/(Y + eps))/N; N = 1 for REDUCE_SUM
+    double_tensor gradient = empty_tensor(m_aCached_Ypred.shape());
+    const double* y = m_aCached_Ypred.data();
+    const double* t = m_aYtarget.data();
+    double* g = gradient.data();
+    if(m_aYtarget.dimension() == 1){
+        // sparse labels: only the target class of each row has a nonzero gradient
+        size_t nclasses = m_aCached_Ypred.size()/m_aCached_Ypred.shape()[0];
+        parallel_for(m_aCached_Ypred.shape()[0], [&](size_t begin, size_t end){
+            for(size_t r=begin; r < end; r++){
+                double* g_row = g + r*nclasses;
+                std::fill(g_row, g_row + nclasses, 0.0);
+                size_t c = (size_t)t[r]; //validated by forward
+                g_row[c] = -(1.0/(y[r*nclasses + c] + EPSILON))/N_norm;
+            }
+        }, nclasses);
+        return gradient;
+    }
+    parallel_for(gradient.size(), [&](size_t begin, size_t end){
+        for(size_t idx=begin; idx < end; idx++) g[idx] = -(t[idx]/(y[idx] + EPSILON))/N_norm;
+    });
     return gradient;
 }
\ No newline at end of file
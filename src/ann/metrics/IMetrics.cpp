@@ -20,7 +20,7 @@ IMetrics::IMetrics(const IMetrics& orig) {
 
 IMetrics::~IMetrics() {
 }
-double IMetrics::evaluate(xt::xarray<double> pred, xt::xarray<double> target){
+double IMetrics::evaluate(double_tensor pred, double_tensor target){
     return 0;
 }
 
@@ -0,0 +1,193 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.cc to edit this template
+ */
+
+/*
+ * File:   CheckpointWriter.cpp
+ *
+ * Created on November 2, 2024, 9:12 PM
+ */
+
+#include "model/CheckpointWriter.h"
+#include "sformat/fmt_lib.h"
+#include <algorithm>
+#include <vector>
+#include <filesystem> //require C++17
+namespace fs = std::filesystem;
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    /*
+     * write_synced: write data to filename, then flush it to the disk (fsync)
+     * so that a crash after the rename can not leave a truncated file behind.
+     */
+    void write_synced(string filename, const string& data){
+        int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0){
+            throw std::runtime_error(filename + ": can not open for writing.");
+        }
+        size_t written = 0;
+        while(written < data.size()){
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if(n < 0){
+                ::close(fd);
+                throw std::runtime_error(filename + ": write failed.");
+            }
+            written += n;
+        }
+        ::fsync(fd);
+        ::close(fd);
+    }
+    void sync_folder(string folder){
+        int fd = ::open(folder.c_str(), O_RDONLY | O_DIRECTORY);
+        if(fd < 0) return;
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+CheckpointWriter::CheckpointWriter(Config* pConfig, string model_name, int keep_last):
+    m_pConfig(pConfig), m_sModelName(model_name), m_nKeepLast(keep_last){
+    m_pPending = nullptr;
+    m_bWriting = false;
+    m_bStop = false;
+    m_worker = thread(&CheckpointWriter::run, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cond.notify_all();
+    if(m_worker.joinable()) m_worker.join();
+    if(m_pPending != nullptr) delete m_pPending;
+}
+
+void CheckpointWriter::submit(Checkpoint* pCkpt){
+    Checkpoint* pDropped = nullptr;
+    {
+        unique_lock<mutex> lock(m_mutex);
+        pDropped = m_pPending;
+        m_pPending = pCkpt;
+    }
+    m_cond.notify_all();
+    if(pDropped != nullptr){
+        cout << "CheckpointWriter: writer is busy; an older checkpoint is skipped." << endl;
+        delete pDropped;
+    }
+}
+
+void CheckpointWriter::flush(){
+    unique_lock<mutex> lock(m_mutex);
+    m_cond.wait(lock, [this]{ return (m_pPending == nullptr) && !m_bWriting; });
+}
+
+string CheckpointWriter::last_checkpoint(){
+    unique_lock<mutex> lock(m_mutex);
+    return m_sLastCheckpoint;
+}
+
+void CheckpointWriter::run(){
+    while(true){
+        Checkpoint* pCkpt = nullptr;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]{ return m_bStop || (m_pPending != nullptr); });
+            //on stop: still write the pending checkpoint (the last state of training)
+            if(m_pPending == nullptr) return;
+            pCkpt = m_pPending;
+            m_pPending = nullptr;
+            m_bWriting = true;
+        }
+
+        string model_path = m_pConfig->get_new_checkpoint(m_sModelName);
+        string arch_file = m_pConfig->get("arch_file", "arch.txt");
+        bool done = commit(*pCkpt, model_path, arch_file);
+        delete pCkpt;
+        if(done) apply_retention();
+
+        {
+            unique_lock<mutex> lock(m_mutex);
+            if(done) m_sLastCheckpoint = model_path;
+            m_bWriting = false;
+        }
+        m_cond.notify_all();
+    }
+}
+
+bool CheckpointWriter::commit(Checkpoint& ckpt, string model_path, string arch_file){
+    fs::path final_path = fs::path(model_path);
+    fs::path parent = final_path.parent_path();
+    string folder = final_path.filename().string();
+    fs::path tmp_path = parent / fs::path("." + folder + ".tmp");
+    fs::path old_path = parent / fs::path("." + folder + ".old");
+    try{
+        if(!parent.empty()) fs::create_directories(parent);
+        fs::remove_all(tmp_path); //left by an interrupted write
+        fs::create_directories(tmp_path);
+
+        write_synced((tmp_path / fs::path(arch_file)).string(), ckpt.get_arch());
+        for(int idx=0; idx < ckpt.size(); idx++){
+            string filename = (tmp_path / fs::path(ckpt.get_filename(idx))).string();
+            write_synced(filename, xt::dump_npy(ckpt.get_tensor(idx)));
+        }
+        sync_folder(tmp_path.string());
+
+        //swap the new folder in; the old one is removed only when the new one is in place
+        bool replace = fs::exists(final_path);
+        if(replace){
+            fs::remove_all(old_path);
+            fs::rename(final_path, old_path);
+        }
+        fs::rename(tmp_path, final_path);
+        if(!parent.empty()) sync_folder(parent.string());
+        //also the .old folder left by an interrupted commit: final_path is complete again
+        fs::remove_all(old_path);
+        return true;
+    }
+    catch(exception& e){
+        string message = fmt::format("CheckpointWriter::commit: failed; model_path={:s}",
+                model_path);
+        cerr << message << endl;
+        cerr << e.what() << endl;
+        std::error_code ec;
+        fs::remove_all(tmp_path, ec);
+        return false;
+    }
+}
+
+string CheckpointWriter::resolve(string model_path){
+    fs::path final_path = fs::path(model_path);
+    if(fs::exists(final_path)) return model_path;
+    fs::path old_path = final_path.parent_path() /
+            fs::path("." + final_path.filename().string() + ".old");
+    if(fs::exists(old_path)){
+        cout << model_path << ": not exist; loading the previous copy " << old_path.string() << endl;
+        return old_path.string();
+    }
+    return model_path;
+}
+
+void CheckpointWriter::apply_retention(){
+    if(m_nKeepLast <= 0) return;
+    xvector<int> indices = m_pConfig->get_checkpoint_indices(m_sModelName);
+    int nremove = indices.size() - m_nKeepLast;
+    if(nremove <= 0) return;
+
+    vector<int> sorted;
+    sorted.reserve(indices.size());
+    for(int idx=0; idx < indices.size(); idx++) sorted.push_back(indices.get(idx));
+    std::sort(sorted.begin(), sorted.end());
+
+    string model_root = m_pConfig->get("model_root", "./models");
+    string ckpt_name = m_pConfig->get("ckpt_name", "checkpoint");
+    for(int idx=0; idx < nremove; idx++){
+        fs::path ckpt_path = fs::path(model_root) / fs::path(m_sModelName) /
+                fs::path(ckpt_name + "-" + to_string(sorted[idx]));
+        std::error_code ec;
+        fs::remove_all(ckpt_path, ec);
+    }
+}
@@ -0,0 +1,218 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.cc to edit this template
+ */
+
+/*
+ * File:   DistributedDataParallel.cpp
+ *
+ * Created on November 28, 2024, 2:15 PM
+ */
+
+#include "model/DistributedDataParallel.h"
+#include "optim/IParamGroup.h"
+#include "sformat/fmt_lib.h"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    /* GradCollector: the IParamGroup given to register_params, to read the parameters and
+     *  gradients of a layer
+     */
+    class GradCollector: public IParamGroup {
+    public:
+        void register_param(string param_name, double_tensor* ptr_param, double_tensor* ptr_grad){
+            params.push_back(ptr_param);
+            grads.push_back(ptr_grad);
+        }
+        void register_sparse_param(string param_name, double_tensor* ptr_param, SparseRowGrad* ptr_grad){
+            params.push_back(ptr_param);
+            sparse_grads.push_back(ptr_grad);
+        }
+        void register_sample_count(unsigned long long* pCounter){}
+        void zero_grad(){}
+        void step(double lr){}
+        void normalize_grad(){}
+
+        vector<double_tensor*> params, grads;
+        vector<SparseRowGrad*> sparse_grads;
+    };
+}
+
+DistributedDataParallel::DistributedDataParallel(ProcessGroup* pGroup, vector<ILayer*> layers, size_t bucket_bytes){
+    m_pGroup = pGroup;
+    m_bArmed = false;
+    m_bStop = false;
+    m_nNext = 0;
+    size_t bucket_elements = max((size_t)1, bucket_bytes/sizeof(double));
+
+    //buckets in backward order: the gradients of the last layers are ready first
+    for(auto it=layers.rbegin(); it != layers.rend(); ++it){
+        ILayer* pLayer = *it;
+        if(!pLayer->has_learnable_param()) continue;
+        GradCollector collector;
+        pLayer->register_params(&collector);
+        m_params.insert(m_params.end(), collector.params.begin(), collector.params.end());
+        m_sparse_grads.insert(m_sparse_grads.end(), collector.sparse_grads.begin(), collector.sparse_grads.end());
+        if(collector.grads.size() == 0) continue;
+
+        size_t nelements = 0;
+        for(auto pGrad: collector.grads) nelements += pGrad->size();
+        bool new_bucket = m_buckets.empty() || (m_buckets.back().nelements >= bucket_elements);
+        if(new_bucket) m_buckets.push_back(Bucket{{}, 0, 0, 0, false, {}});
+        Bucket& bucket = m_buckets.back();
+        bucket.grads.insert(bucket.grads.end(), collector.grads.begin(), collector.grads.end());
+        bucket.nelements += nelements;
+        bucket.nlayers += 1;
+        m_layer_bucket[pLayer] = m_buckets.size() - 1;
+    }
+    broadcast_parameters(0);
+    if(m_pGroup->world_size() > 1) m_comm_thread = thread(&DistributedDataParallel::comm_loop, this);
+}
+
+DistributedDataParallel::~DistributedDataParallel(){
+    {
+        lock_guard<mutex> lock(m_mtx);
+        m_bStop = true;
+    }
+    m_cv_ready.notify_all();
+    if(m_comm_thread.joinable()) m_comm_thread.join();
+}
+
+void DistributedDataParallel::broadcast_parameters(int root){
+    for(auto pParam: m_params) m_pGroup->broadcast(pParam->data(), pParam->size(), root);
+}
+
+void DistributedDataParallel::prepare(){
+    if(m_pGroup->world_size() == 1) return;
+    lock_guard<mutex> lock(m_mtx);
+    for(auto& bucket: m_buckets){
+        bucket.pending = bucket.nlayers;
+        bucket.ready = false;
+    }
+    m_nNext = 0;
+    m_bArmed = true;
+}
+
+void DistributedDataParallel::mark_ready(ILayer* pLayer){
+    if(!m_bArmed) return;
+    auto it = m_layer_bucket.find(pLayer);
+    if(it == m_layer_bucket.end()) return;
+    lock_guard<mutex> lock(m_mtx);
+    Bucket& bucket = m_buckets[it->second];
+    if(--bucket.pending == 0){
+        bucket.ready = true;
+        m_cv_ready.notify_one();
+    }
+}
+
+void DistributedDataParallel::finish(){
+    if(m_pGroup->world_size() == 1) return;
+    if(m_bArmed){
+        unique_lock<mutex> lock(m_mtx);
+        for(auto& bucket: m_buckets) bucket.ready = true; //layers without backward in this step
+        m_cv_ready.notify_one();
+        m_cv_done.wait(lock, [this](){ return m_nNext == (int)m_buckets.size(); });
+        m_bArmed = false;
+        if(m_error){
+            exception_ptr error = m_error;
+            m_error = nullptr;
+            rethrow_exception(error);
+        }
+    }
+    else{
+        for(auto& bucket: m_buckets) reduce_bucket(bucket);
+    }
+    reduce_sparse();
+}
+
+void DistributedDataParallel::comm_loop(){
+    while(true){
+        int idx;
+        {
+            unique_lock<mutex> lock(m_mtx);
+            m_cv_ready.wait(lock, [this](){
+                return m_bStop || (m_bArmed && (m_nNext < (int)m_buckets.size()) && m_buckets[m_nNext].ready);
+            });
+            if(m_bStop) return;
+            idx = m_nNext;
+        }
+        try{
+            if(!m_error) reduce_bucket(m_buckets[idx]);
+        }
+        catch(...){
+            m_error = current_exception();
+        }
+        {
+            lock_guard<mutex> lock(m_mtx);
+            m_nNext += 1;
+        }
+        m_cv_done.notify_all();
+    }
+}
+
+//reduce_bucket: pack, all-reduce, average, unpack
+void DistributedDataParallel::reduce_bucket(Bucket& bucket){
+    bucket.buffer.resize(bucket.nelements);
+    double* p = bucket.buffer.data();
+    for(auto pGrad: bucket.grads){
+        std::copy(pGrad->data(), pGrad->data() + pGrad->size(), p);
+        p += pGrad->size();
+    }
+    size_t n = p - bucket.buffer.data();
+    m_pGroup->allreduce_sum(bucket.buffer.data(), n);
+    double scale = 1.0/m_pGroup->world_size();
+    p = bucket.buffer.data();
+    for(auto pGrad: bucket.grads){
+        double* g = pGrad->data();
+        for(size_t i=0; i < pGrad->size(); i++) g[i] = p[i]*scale;
+        p += pGrad->size();
+    }
+}
+
+/*
+ * reduce_sparse: each rank sends [nrows, row ids, values] of each sparse gradient;
+ *  the rows of all the ranks are then summed in rank order (the same bits on every rank)
+ */
+void DistributedDataParallel::reduce_sparse(){
+    for(auto pGrad: m_sparse_grads){
+        size_t ncols = pGrad->ncols();
+        uint64_t nrows = pGrad->size();
+        vector<char> mine(sizeof(uint64_t) + nrows*(sizeof(uint64_t) + ncols*sizeof(double)));
+        char* p = mine.data();
+        memcpy(p, &nrows, sizeof(uint64_t));
+        p += sizeof(uint64_t);
+        for(size_t k=0; k < nrows; k++){
+            uint64_t row = pGrad->row_id(k);
+            memcpy(p, &row, sizeof(uint64_t));
+            memcpy(p + sizeof(uint64_t), pGrad->values(k), ncols*sizeof(double));
+            p += sizeof(uint64_t) + ncols*sizeof(double);
+        }
+        vector<vector<char>> blobs = m_pGroup->allgather(mine);
+
+        double scale = 1.0/m_pGroup->world_size();
+        pGrad->clear();
+        for(auto& blob: blobs){
+            const char* q = blob.data();
+            uint64_t count;
+            memcpy(&count, q, sizeof(uint64_t));
+            q += sizeof(uint64_t);
+            for(size_t k=0; k < count; k++){
+                uint64_t row;
+                memcpy(&row, q, sizeof(uint64_t));
+                const double* values = (const double*)(q + sizeof(uint64_t));
+                double* g = pGrad->row(row);
+                for(size_t c=0; c < ncols; c++) g[c] += values[c]*scale;
+                q += sizeof(uint64_t) + ncols*sizeof(double);
+            }
+        }
+    }
+}
+
+string DistributedDataParallel::get_desc(){
+    string desc = fmt::format("DDP rank {:d}/{:d}: {:d} bucket(s)", m_pGroup->rank(),
+                              m_pGroup->world_size(), m_buckets.size());
+    for(auto& bucket: m_buckets) desc += fmt::format(" [{:d} layer(s), {:d} values]", bucket.nlayers, bucket.nelements);
+    if(m_sparse_grads.size() != 0) desc += fmt::format(", {:d} sparse gradient(s)", m_sparse_grads.size());
+    return desc;
+}
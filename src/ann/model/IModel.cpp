@@ -6,14 +6,53 @@
 #include "model/IModel.h"
 #include "config/Config.h"
 #include "sformat/fmt_lib.h"
+#include "model/DistributedDataParallel.h"
 
 IModel::IModel(string cfg_filename, string sModelName): 
     m_cfg_filename(cfg_filename), m_sModelName(sModelName){
     //Create configuration object
     m_pConfig = new Config(cfg_filename);
+    //the tensor buffers: huge pages for those of at least tensor_huge_page_min_kb (see TensorMemory)
+    TensorMemory::configure(m_pConfig->get_int("tensor_huge_pages", 0) != 0,
+            m_pConfig->get_int("tensor_huge_page_min_kb", 4096));
+    m_pCkptWriter = nullptr;
+    m_ckpt_interval = 0;
+    set_grad_accumulation(m_pConfig->get_int("grad_accum_steps", 1));
+    set_pipeline(m_pConfig->get_int("pipeline_stages", 1), m_pConfig->get_int("pipeline_micro_batches", 0));
+    set_hogwild(m_pConfig->get_int("hogwild_workers", 1), m_pConfig->get_int("hogwild_stripes", 0));
+    set_async_validation(m_pConfig->get_int("async_validation", 0) != 0);
+    m_early_stop_patience = 0;
+    m_stop_training = false;
+    m_pDDP = nullptr;
+}
+
+/*
+ * the copy has the configuration only: no optimizer, loss, metrics or checkpoint writer
+ */
+IModel::IModel(const IModel& orig):
+    m_cfg_filename(orig.m_cfg_filename), m_sModelName(orig.m_sModelName){
+    m_trainable = false;
+    m_pConfig = new Config(m_cfg_filename);
+    m_pOptimizer = nullptr;
+    m_pLossLayer = nullptr;
+    m_pMetricLayer = nullptr;
+    m_pCkptWriter = nullptr;
+    m_ckpt_interval = 0;
+    m_grad_accum_steps = orig.m_grad_accum_steps;
+    m_pipeline_stages = orig.m_pipeline_stages;
+    m_pipeline_micro = orig.m_pipeline_micro;
+    m_hogwild_workers = orig.m_hogwild_workers;
+    m_hogwild_stripes = orig.m_hogwild_stripes;
+    m_async_valid = orig.m_async_valid;
+    m_early_stop_patience = 0;
+    m_stop_training = false;
+    m_pDDP = nullptr;
 }
 
 IModel::~IModel(){
+    if(m_valid_future.valid()) m_valid_future.wait();
+    if(m_pCkptWriter != nullptr) delete m_pCkptWriter;
+    if(m_pDDP != nullptr) delete m_pDDP;
     if(m_pConfig != nullptr) delete m_pConfig;
 }
 
@@ -23,46 +62,145 @@ void IModel::fit(DataLoader<double, double>* pTrainLoader,
          unsigned int verbose){
     //
     on_begin_training(pTrainLoader, pValidLoader, nepoch, verbose);
+    //the replicas of the Hogwild workers: once per fit, reused by every epoch
+    if(m_hogwild_workers > 1) build_async_workers();
+    //the pipeline: its stage threads are kept alive from one step to the next
+    else if(m_pipeline_stages > 1) build_pipeline();
 
-    for(int epoch=1; epoch <= nepoch; epoch++){
+    for(int epoch=1; (epoch <= nepoch) && !m_stop_training; epoch++){
         on_begin_epoch();
         m_pMetricLayer->reset_metrics();
+        pTrainLoader->set_epoch(epoch - 1); //a new order of the samples per epoch (with shuffle)
+        if(m_hogwild_workers > 1){
+            train_epoch_async(pTrainLoader);
+            on_end_epoch();
+            continue;
+        }
         
         for(auto batch: *pTrainLoader){
-            double_tensor X = batch.getData();
             double_tensor t = batch.getLabel();
-            on_begin_step(X.shape()[0]);
+            on_begin_step(batch.size());
             
-            //(0) Set gradient buffer to zeros
-            //YOUR CODE IS HERE
-            m_pOptimizer->zero_grad();
+            double batch_loss;
+            if(batch.is_sparse()){
+                //one step for the whole batch: its activations are O(nnz + batch*Nout)
+                on_end_step(train_step(batch.getSparseData(), t));
+                continue;
+            }
+            double_tensor X = batch.getData();
+            if(m_pipeline_stages > 1) batch_loss = train_step_pipelined(X, t);
+            else if(m_grad_accum_steps > 1) batch_loss = train_step_accumulated(X, t);
+            else batch_loss = train_step(X, t);
             
-            //(1) FORWARD-Pass
-            //YOUR CODE IS HERE
-            double_tensor Y = this->forward(X);
+            on_end_step(batch_loss);
+        }//for-each batch: end
+        on_end_epoch();
+    }//for-epoch: end
+    if(m_hogwild_workers > 1) release_async_workers();
+    on_end_training();
+}
 
-            double batch_loss = m_pLossLayer->forward(Y, t);
+/*
+ * train_step: one optimizer step on the batch (X, t); returns the batch loss
+ */
+double IModel::train_step(double_tensor& X, double_tensor& t){
+    //(0) Set gradient buffer to zeros
+    m_pOptimizer->zero_grad();
 
-            //(2) BACKWARD-Pass
-            //YOUR CODE IS HERE
-            this->backward();
-            
-            //(3) UPDATE learnable parameters
-            //YOUR CODE IS HERE
-            m_pOptimizer->step();
+    //(1) FORWARD-Pass
+    double_tensor Y = this->forward(X);
+
+    double batch_loss = m_pLossLayer->forward(Y, t);
+
+    //(2) BACKWARD-Pass
+    if(m_pDDP != nullptr) m_pDDP->prepare(); //buckets are reduced during backward
+    this->backward();
+
+    //(3) UPDATE learnable parameters
+    if(m_pDDP != nullptr) m_pDDP->finish();
+    m_pOptimizer->step();
+
+    //Record the performance for each batch
+    ulong_tensor y_true = label_indices(t, Y.shape()[1]);
+    ulong_tensor y_pred = xt::argmax(Y, 1);
+
+    m_pMetricLayer->accumulate(y_true, y_pred);
+    return batch_loss;
+}
+
+/*
+ * train_step (sparse batch): as train_step, the first layer gets X in CSR format
+ */
+double IModel::train_step(const CSRMatrix<double>& X, double_tensor& t){
+    m_pOptimizer->zero_grad();
+    double_tensor Y = this->forward_sparse(X);
+    double batch_loss = m_pLossLayer->forward(Y, t);
+    if(m_pDDP != nullptr) m_pDDP->prepare();
+    this->backward();
+    if(m_pDDP != nullptr) m_pDDP->finish();
+    m_pOptimizer->step();
+
+    ulong_tensor y_true = label_indices(t, Y.shape()[1]);
+    ulong_tensor y_pred = xt::argmax(Y, 1);
+    m_pMetricLayer->accumulate(y_true, y_pred);
+    return batch_loss;
+}
+
+void IModel::set_distributed(ProcessGroup* pGroup){
+    throw std::runtime_error(m_sModelName + ": this model does not support distributed training");
+}
+
+double IModel::train_step_pipelined(double_tensor& X, double_tensor& t){
+    throw std::runtime_error(m_sModelName + ": this model does not support pipeline-parallel training");
+}
+
+void IModel::train_epoch_async(DataLoader<double, double>* pLoader){
+    throw std::runtime_error(m_sModelName + ": this model does not support asynchronous (Hogwild) training");
+}
+
+double_tensor IModel::forward_sparse(const CSRMatrix<double>& X){
+    throw std::runtime_error(m_sModelName + ": this model does not take sparse (CSR) inputs");
+}
+
+/*
+ * train_step_accumulated: one optimizer step on the batch (X, t), computed as
+ *  m_grad_accum_steps micro-batches; only one micro-batch of activations is alive at a time.
+ *  + the loss is reduced by sum, so the layers accumulate sum-gradients;
+ *  + normalize_grad divides them by the sample counters (= the batch size).
+ */
+double IModel::train_step_accumulated(double_tensor& X, double_tensor& t){
+    size_t nsamples = X.shape()[0];
+    size_t micro_size = (nsamples + m_grad_accum_steps - 1)/m_grad_accum_steps;
+    LossReduction reduction = m_pLossLayer->get_reduction();
+    m_pLossLayer->set_reduction(REDUCE_SUM);
+
+    m_pOptimizer->zero_grad();
+    double loss_sum = 0;
+    try{
+        for(size_t begin=0; begin < nsamples; begin += micro_size){
+            size_t end = min(nsamples, begin + micro_size);
+            double_tensor X_micro = xt::view(X, xt::range(begin, end));
+            double_tensor t_micro = xt::view(t, xt::range(begin, end));
             
-            //Record the performance for each batch
-            ulong_tensor y_true = xt::argmax(t, 1);
-            ulong_tensor y_pred = xt::argmax(Y, 1);
+            double_tensor Y = this->forward(X_micro);
+            loss_sum += m_pLossLayer->forward(Y, t_micro);
+            this->backward();
 
+            ulong_tensor y_true = label_indices(t_micro, Y.shape()[1]);
+            ulong_tensor y_pred = xt::argmax(Y, 1);
             m_pMetricLayer->accumulate(y_true, y_pred);
+        }
+    }
+    catch(...){
+        m_pLossLayer->set_reduction(reduction);
+        throw;
+    }
+    m_pOptimizer->normalize_grad();
+    if(m_pDDP != nullptr) m_pDDP->finish();
+    m_pOptimizer->step();
 
-            
-            on_end_step(batch_loss);
-        }//for-each batch: end
-        on_end_epoch();
-    }//for-epoch: end
-    on_end_training();
+    m_pLossLayer->set_reduction(reduction);
+    return loss_sum/nsamples;
 }
 
 //Method for doing the logging
@@ -77,10 +215,34 @@ void IModel::on_begin_training(
     this->m_verbose = verbose;
     
     this->m_current_epoch = 0;
+    
+    //periodic checkpointing: ckpt_interval (in epochs; 0 = disabled), ckpt_keep
+    this->m_ckpt_interval = m_pConfig->get_int("ckpt_interval", 0);
+    if((m_ckpt_interval > 0) && (m_pCkptWriter == nullptr)){
+        int keep_last = m_pConfig->get_int("ckpt_keep", 3);
+        m_pCkptWriter = new CheckpointWriter(m_pConfig, m_sModelName, keep_last);
+    }
+    //validation and early stopping
+    this->m_early_stop_patience = m_pConfig->get_int("early_stop_patience", 0);
+    this->m_best_valid_acc = -1;
+    this->m_bad_valid_count = 0;
+    this->m_stop_training = false;
+    this->m_valid_history.clear();
     set_working_mode(true); //to training mode
     cout << "Start the training ..." << endl;
 }
 void IModel::on_end_training(){
+    harvest_validation(true); //the last epoch's results
+    release_pipeline();
+    string report = this->activation_report();
+    if((m_verbose > 0) && (report.size() != 0)) cout << report << endl;
+    if(m_verbose > 1) cout << TensorMemory::get_desc() << endl;
+    if(m_pCkptWriter != nullptr){
+        m_pCkptWriter->flush(); //the last checkpoint must be on disk
+        cout << "Last checkpoint: " << m_pCkptWriter->last_checkpoint() << endl;
+        delete m_pCkptWriter;
+        m_pCkptWriter = nullptr;
+    }
     set_working_mode(false); //to inference mode
     cout << "End the training ..." << endl;
 }
@@ -91,8 +253,17 @@ void IModel::on_begin_epoch(){
     this->m_sample_counter = 0; //reset
 }
 void IModel::on_end_epoch(){
-    cout << "Validation results: " << endl;
-    cout << this->evaluate(m_pValidLoader) << endl;
+    if(m_async_valid) launch_validation();
+    else report_validation(m_current_epoch, this->evaluate(m_pValidLoader));
+    
+    bool ckpt_due = (m_pCkptWriter != nullptr) && 
+                    (m_current_epoch % m_ckpt_interval == 0);
+    if(ckpt_due){
+        //copy the weights here; serialisation happens on the writer's thread
+        Checkpoint* pCkpt = new Checkpoint();
+        if(this->stage(*pCkpt)) m_pCkptWriter->submit(pCkpt);
+        else delete pCkpt;
+    }
 }
 void IModel::on_begin_step(int batch_size){
     this->m_current_batch += 1; //the first batch: 1
@@ -101,6 +272,7 @@ void IModel::on_begin_step(int batch_size){
     
 }
 void IModel::on_end_step(double batch_loss){
+    harvest_validation(false);
     this->m_epoch_loss += m_curent_batch_size * batch_loss;
     const double_tensor train_metrics = m_pMetricLayer->get_metrics();
     
@@ -109,4 +281,65 @@ void IModel::on_end_step(double batch_loss){
             batch_loss, m_epoch_loss/m_sample_counter,
             train_metrics[ulong(ACCURACY)]);
     cout << message << endl;
-}
\ No newline at end of file
+}
+
+/*
+ * launch_validation: evaluates a snapshot of the current weights on a background thread;
+ *  a previous validation still running is waited for first (one snapshot alive at a time).
+ *  Falls back to the synchronous evaluation if the model has no snapshot.
+ */
+void IModel::launch_validation(){
+    harvest_validation(true);
+    IModel* pSnapshot = this->snapshot();
+    if(pSnapshot == nullptr){
+        report_validation(m_current_epoch, this->evaluate(m_pValidLoader));
+        return;
+    }
+    DataLoader<double, double>* pLoader = m_pValidLoader;
+    m_valid_epoch = m_current_epoch;
+    m_valid_future = std::async(std::launch::async, [pSnapshot, pLoader](){
+        double_tensor metrics;
+        try{
+            metrics = pSnapshot->evaluate(pLoader);
+        }
+        catch(...){
+            delete pSnapshot;
+            throw;
+        }
+        delete pSnapshot;
+        return metrics;
+    });
+}
+
+/*
+ * harvest_validation: reports the pending validation if it is ready (or waits for it)
+ */
+void IModel::harvest_validation(bool wait){
+    if(!m_valid_future.valid()) return;
+    if(!wait && (m_valid_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) return;
+    try{
+        report_validation(m_valid_epoch, m_valid_future.get());
+    }
+    catch(exception& e){
+        cerr << "Validation of epoch " << m_valid_epoch << " failed: " << e.what() << endl;
+    }
+}
+
+void IModel::report_validation(int epoch, double_tensor metrics){
+    cout << "Validation results (epoch " << epoch << "): " << endl;
+    cout << metrics << endl;
+    m_valid_history.push_back(metrics);
+    if(m_early_stop_patience <= 0) return;
+    
+    double accuracy = metrics[ulong(ACCURACY)];
+    if(accuracy > m_best_valid_acc){
+        m_best_valid_acc = accuracy;
+        m_bad_valid_count = 0;
+    }
+    else if(++m_bad_valid_count >= m_early_stop_patience){
+        if(!m_stop_training)
+            cout << fmt::format("Early stopping: no better validation accuracy than {:.4f} in {:d} results",
+                    m_best_valid_acc, m_bad_valid_count) << endl;
+        m_stop_training = true;
+    }
+}
@@ -24,7 +24,15 @@ namespace fs = std::filesystem;
 #include "layer/Sigmoid.h"
 #include "layer/Tanh.h"
 #include "layer/Softmax.h"
+#include "layer/Embedding.h"
 #include "metrics/ClassMetrics.h"
+#include "model/PipelineSchedule.h"
+#include "model/DistributedDataParallel.h"
+#include "optim/SGDParamGroup.h"
+#include "util/CounterRNG.h"
+#include <exception>
+#include <mutex>
+#include <thread>
 
 
 
@@ -32,6 +40,11 @@ namespace fs = std::filesystem;
 //Constructors and Destructors
 MLPClassifier::MLPClassifier(string cfg_filename, string sModelName):
     IModel(cfg_filename, sModelName){
+    set_recompute(m_pConfig->get_int("recompute_segment", 0));
+    m_nFirst_Layer = 0;
+    m_pStripes = nullptr;
+    m_pPipeline = nullptr;
+    reset_activation_stats();
 }
 MLPClassifier::MLPClassifier(
     string cfg_filename, string sModelName,
@@ -39,31 +52,111 @@ MLPClassifier::MLPClassifier(
     IModel(cfg_filename, sModelName){
     //layer to m_layers:
     for(int idx=0; idx < size; idx++) m_layers.add(seq[idx]);
+    //the random initial weights: keyed by the seed of the model (config key init_seed, default:
+    //the global seed) and the position of the layer, not by the layers created before it
+    int seed = m_pConfig->get_int("init_seed", -1);
+    uint64_t key = (seed >= 0)? (uint64_t)seed : CounterRNG::global_seed();
+    for(int idx=0; idx < size; idx++) seq[idx]->reseed_params(CounterRNG::for_position(key, idx));
+    set_recompute(m_pConfig->get_int("recompute_segment", 0));
+    m_nFirst_Layer = 0;
+    m_pStripes = nullptr;
+    m_pPipeline = nullptr;
+    reset_activation_stats();
 }
 
 MLPClassifier::MLPClassifier(const MLPClassifier& orig):
-    IModel(orig.m_cfg_filename, orig.m_sModelName){
-    //copy list (in the assignment operator of DLinkedList)
-    m_layers = orig.m_layers; 
+    IModel(orig){
+    //deep copy: the copy owns its layers
+    DLinkedList<ILayer*>& layers = const_cast<DLinkedList<ILayer*>&>(orig.m_layers);
+    for(auto pLayer: layers) m_layers.add(pLayer->clone());
+    this->set_working_mode(orig.m_trainable);
+    m_recompute_segment = orig.m_recompute_segment;
+    m_nFirst_Layer = 0;
+    m_pStripes = nullptr;
+    m_pPipeline = nullptr;
+    reset_activation_stats();
+}
+
+IModel* MLPClassifier::snapshot(){
+    MLPClassifier* pCopy = new MLPClassifier(*this);
+    pCopy->set_working_mode(false);
+    return pCopy;
 }
 
 MLPClassifier::~MLPClassifier() {
+    release_async_workers(); //left by a fit that threw
+    release_pipeline();
     for(auto ptr_layer: m_layers) delete ptr_layer;
 }
 
 //for the inference mode: begin
+/*
+ * infer: the output of the network for X on the const path (see ILayer::infer);
+ *  + the model is only read: threads can share one model, one InferenceContext each;
+ *  + the result lives in ctx, it is valid until the next call with ctx.
+ */
+const double_tensor& MLPClassifier::infer(const double_tensor& X, InferenceContext& ctx) const{
+    bool softmax_skipped;
+    return this->infer_layers(X, ctx, false, softmax_skipped);
+}
+
+/*
+ * infer_layers: runs the layers on ctx; with stop_at_softmax, the final Softmax layer is skipped
+ *  if it normalizes the last axis (softmax_skipped = true), and the result is the logits.
+ */
+const double_tensor& MLPClassifier::infer_layers(const double_tensor& X, InferenceContext& ctx,
+                                                 bool stop_at_softmax, bool& softmax_skipped) const{
+    ctx.load(X);
+    return this->infer_from(ctx, 0, X.dimension(), stop_at_softmax, softmax_skipped);
+}
+
+/*
+ * infer_layers (sparse X): the first layer (FC) computes its output from the CSR rows,
+ *  the other layers run as for a dense input [nrows, Nin].
+ */
+const double_tensor& MLPClassifier::infer(const CSRMatrix<double>& X, InferenceContext& ctx) const{
+    bool softmax_skipped;
+    return this->infer_layers(X, ctx, false, softmax_skipped);
+}
+const double_tensor& MLPClassifier::infer_layers(const CSRMatrix<double>& X, InferenceContext& ctx,
+                                                 bool stop_at_softmax, bool& softmax_skipped) const{
+    sparse_input_layer()->infer(X, ctx);
+    return this->infer_from(ctx, 1, 2, stop_at_softmax, softmax_skipped);
+}
+
+//infer_from: runs the layers from index first on ctx; ndim: the rank of the model input
+const double_tensor& MLPClassifier::infer_from(InferenceContext& ctx, int first, int ndim,
+                                               bool stop_at_softmax, bool& softmax_skipped) const{
+    softmax_skipped = false;
+    DLinkedList<ILayer*>& layers = const_cast<DLinkedList<ILayer*>&>(m_layers);
+    int idx = 0, nlayers = layers.size();
+    for (auto layer : layers) {
+        idx++;
+        if (idx <= first) continue;
+        if (stop_at_softmax && (idx == nlayers) && (layer->get_type() == LayerType::SOFTMAX) &&
+            (positive_index(((Softmax*)layer)->get_axis(), ndim) == ndim - 1)) {
+            softmax_skipped = true;
+            break;
+        }
+        layer->infer(ctx);
+    }
+    return ctx.current();
+}
+
+//sparse_input_layer: the first layer, which must be an FCLayer to take CSR inputs
+FCLayer* MLPClassifier::sparse_input_layer() const{
+    DLinkedList<ILayer*>& layers = const_cast<DLinkedList<ILayer*>&>(m_layers);
+    if((layers.size() == 0) || (layers.get(0)->get_type() != LayerType::FC))
+        throw std::runtime_error("MLPClassifier: a sparse (CSR) input needs an FCLayer as the first layer");
+    return (FCLayer*)layers.get(0);
+}
+
 double_tensor MLPClassifier::predict(double_tensor X, bool make_decision){
-    //SWITCH to inference mode
-    bool old_mode = this->m_trainable;
-    this->set_working_mode(false);
-    
-    //DO the inference
+    //DO the inference: on the const path, the working mode of the layers is not changed
     
     //YOUR CODE IS HERE
-    double_tensor Y = this->forward(X);
-    
-    //RESTORE the previous mode
-    this->set_working_mode(old_mode);
+    InferenceContext ctx;
+    const double_tensor& Y = this->infer(X, ctx);
     
     //RETURN
     if(make_decision) return Y;
@@ -73,71 +166,87 @@ double_tensor MLPClassifier::predict(double_tensor X, bool make_decision){
 double_tensor MLPClassifier::predict(
     DataLoader<double, double>* pLoader,
     bool make_decision){
-    bool old_mode = this->m_trainable;
-    this->set_working_mode(false);
-    
     double_tensor results;
-    bool first_batch = true;
     
     cout << "Prediction: Started" << endl;
     string info = fmt::format("{:<6s}/{:<12s}|{:<50s}\n",
                     "Batch", "Total Batch", "Num. of samples processed");
     cout << info;
     
-    int total_batch = pLoader->get_total_batch(); 
-    int batch_idx = 1;  
     unsigned long long nsamples = 0;
     results = xt::zeros<double>({pLoader->get_sample_count(), get_num_classes()});
+    InferenceContext ctx;
     for(auto batch: *pLoader){
         //YOUR CODE IS HERE
-        double_tensor X = batch.getData();
-
-        double_tensor Y = this->forward(X);
-
-        // if (first_batch) {
-        //     results = Y;
-        //     first_batch = false;
-        // } else {
-        //     results = xt::concatenate(xt::xtuple(results, Y), 0);
-        // }
-        for (int i = 0; i < Y.shape()[0]; i++) {
-            xt::view(results, nsamples + i, xt::all()) = xt::view(Y, i, xt::all());
-        }
+        const double_tensor& Y = batch.is_sparse()? this->infer(batch.getSparseData(), ctx)
+                                                   : this->infer(batch.getData(), ctx);
+        std::copy(Y.data(), Y.data() + Y.size(), results.data() + nsamples*Y.shape()[1]);
         nsamples += Y.shape()[0];
     }
     cout << "Prediction: End" << endl;
     
-    //restore the old mode
-    this->set_working_mode(old_mode);
-    
     if(make_decision) return results;
     else return xt::argmax(results, -1);
 }
 
 
+/*
+ * predict_topk: the k most probable classes of each sample and their probabilities,
+ *  indices, scores: [nsamples, k], best class first (k is clipped to the number of classes).
+ *  The final softmax is fused with the selection (see topk_rows): only the logits of a batch
+ *  are kept, never the probability matrix.
+ */
+void MLPClassifier::predict_topk(double_tensor X, int k,
+                                 ulong_tensor& indices, double_tensor& scores){
+    InferenceContext ctx;
+    bool softmax_skipped;
+    const double_tensor& Z = this->infer_layers(X, ctx, true, softmax_skipped);
+    size_t nrows = Z.shape()[0];
+    size_t nclasses = Z.size()/max((size_t)1, nrows);
+    k = max(0, min(k, (int)nclasses));
+    indices = xt::empty<unsigned long>({nrows, (size_t)k});
+    scores = empty_tensor({nrows, (size_t)k});
+    topk_rows(Z.data(), nrows, nclasses, k, softmax_skipped, indices.data(), scores.data());
+}
+
+void MLPClassifier::predict_topk(
+    DataLoader<double, double>* pLoader, int k,
+    ulong_tensor& indices, double_tensor& scores){
+    k = max(0, min(k, get_num_classes()));
+    size_t nsamples = pLoader->get_sample_count();
+    indices = xt::empty<unsigned long>({nsamples, (size_t)k});
+    scores = empty_tensor({nsamples, (size_t)k});
+    size_t row = 0;
+    InferenceContext ctx;
+    for(auto batch: *pLoader){
+        bool softmax_skipped;
+        const double_tensor& Z = batch.is_sparse()?
+                    this->infer_layers(batch.getSparseData(), ctx, true, softmax_skipped) :
+                    this->infer_layers(batch.getData(), ctx, true, softmax_skipped);
+        size_t nrows = Z.shape()[0];
+        topk_rows(Z.data(), nrows, Z.size()/max((size_t)1, nrows), k, softmax_skipped,
+                  indices.data() + row*k, scores.data() + row*k);
+        row += nrows;
+    }
+}
+
 double_tensor MLPClassifier::evaluate(DataLoader<double, double>* pLoader){
-    bool old_mode = this->m_trainable;
-    this->set_working_mode(false);
-    
     ClassMetrics meter(this->get_num_classes());
     meter.reset_metrics();
     
     //YOUR CODE IS HERE
+    InferenceContext ctx;
     for (auto batch : *pLoader) {
-        double_tensor X = batch.getData();
-        double_tensor t = batch.getLabel();
-
-        double_tensor Y = this->forward(X);
+        const double_tensor& Y = batch.is_sparse()? this->infer(batch.getSparseData(), ctx)
+                                                   : this->infer(batch.getData(), ctx);
 
-        ulong_tensor y_true = xt::argmax(t, 1);
+        ulong_tensor y_true = label_indices(batch.getLabel(), Y.shape()[1]);
         ulong_tensor y_pred = xt::argmax(Y, 1);
 
         meter.accumulate(y_true, y_pred);
     }
 
     double_tensor metrics = meter.get_metrics();
-    //
-    this->set_working_mode(old_mode);
     return metrics;
 }
 //for the inference mode:end
@@ -172,20 +281,243 @@ void MLPClassifier::set_working_mode(bool trainable){
 //protected: for the training mode: begin
 double_tensor MLPClassifier::forward(double_tensor X){
     //YOUR CODE IS HERE
-    for (auto layer : m_layers) {
+    return this->forward_from(X, 0);
+}
+double_tensor MLPClassifier::forward_sparse(const CSRMatrix<double>& X){
+    double_tensor Y = sparse_input_layer()->forward(X);
+    return this->forward_from(Y, 1);
+}
+
+/*
+ * forward_from: runs the layers from index first; with recompute (training mode), the segments
+ *  before the last one run without caches, and only their inputs are kept in m_seg_inputs.
+ */
+double_tensor MLPClassifier::forward_from(double_tensor X, int first){
+    vector<ILayer*> layers = layer_vector();
+    int nlayers = layers.size();
+    int k = m_recompute_segment;
+    bool recompute = m_trainable && (k > 0);
+    int last_segment = recompute? (nlayers - 1 - first)/k : 0;
+    m_nFirst_Layer = first;
+    m_seg_inputs.clear();
+    for (int idx = first; idx < nlayers; idx++) {
+        ILayer* layer = layers[idx];
+        if (!recompute || ((idx - first)/k == last_segment)) {
+            X = layer->forward(X);
+            continue;
+        }
+        if ((idx - first) % k == 0) m_seg_inputs.push_back(X);
+        layer->release_cache(); //from the previous step
+        layer->set_working_mode(false);
         X = layer->forward(X);
+        layer->set_working_mode(true);
     }
-
+    if (m_trainable) track_activation_bytes();
     return X;
 }
 void MLPClassifier::backward(){
     //YOUR CODE IS HERE
     double_tensor DY = m_pLossLayer->backward();
+    vector<ILayer*> layers = layer_vector();
+    int nlayers = layers.size();
+    int first = m_nFirst_Layer;
+    int k = m_recompute_segment;
+
+    // segments: [first + s*k, first + (s + 1)*k); only the last one has its caches
+    int nsegments = m_seg_inputs.size() + 1;
+    for (int s = nsegments - 1; s >= 0; s--) {
+        int begin = (nsegments == 1)? first : first + s*k;
+        int end = (s == nsegments - 1)? nlayers : begin + k;
+        if (s < nsegments - 1) {
+            //recompute the forward of the segment, with caches, from its input
+            double_tensor X = std::move(m_seg_inputs[s]);
+            m_seg_inputs.pop_back();
+            for (int idx = begin; idx < end; idx++) X = layers[idx]->forward(X);
+            m_recomputed_layers += end - begin;
+            track_activation_bytes();
+        }
+        for (int idx = end - 1; idx >= begin; idx--) {
+            DY = layers[idx]->backward(DY);
+            if (m_pDDP != nullptr) m_pDDP->mark_ready(layers[idx]);
+        }
+        if (s < nsegments - 1)
+            for (int idx = begin; idx < end; idx++) layers[idx]->release_cache();
+    }
+    // the sparse input layer (see forward_sparse)
+    for (int idx = first - 1; idx >= 0; idx--) {
+        DY = layers[idx]->backward(DY);
+        if (m_pDDP != nullptr) m_pDDP->mark_ready(layers[idx]);
+    }
+    m_backward_steps += 1;
+}
+
+/*
+ * train_step_pipelined: one optimizer step on (X, t), the GPipe schedule of PipelineSchedule
+ *  over m_pipeline_stages stages and m_pipeline_micro micro-batches (see IModel::set_pipeline)
+ */
+double MLPClassifier::train_step_pipelined(double_tensor& X, double_tensor& t){
+    if(m_pPipeline == nullptr) build_pipeline(); //called out of fit
+    LossReduction reduction = m_pLossLayer->get_reduction();
+    m_pLossLayer->set_reduction(REDUCE_SUM);
+
+    m_pOptimizer->zero_grad();
+    double loss_sum;
+    try{
+        loss_sum = m_pPipeline->run(X, t, m_pipeline_micro, m_pLossLayer, m_pMetricLayer);
+    }
+    catch(...){
+        m_pLossLayer->set_reduction(reduction);
+        throw;
+    }
+    m_pOptimizer->normalize_grad();
+    if(m_pDDP != nullptr) m_pDDP->finish();
+    m_pOptimizer->step();
+
+    m_pLossLayer->set_reduction(reduction);
+    return loss_sum/X.shape()[0];
+}
+
+/*
+ * build_pipeline: the stages of the layers, once per fit; the stage threads are started by
+ *  the first step and wait for the next one until release_pipeline.
+ */
+void MLPClassifier::build_pipeline(){
+    release_pipeline();
+    m_pPipeline = new PipelineSchedule(layer_vector(), m_pipeline_stages);
+}
+
+void MLPClassifier::release_pipeline(){
+    if(m_pPipeline != nullptr) delete m_pPipeline;
+    m_pPipeline = nullptr;
+}
+
+/*
+ * build_async_workers: the Hogwild workers (see IModel::set_hogwild), once per fit; each one
+ *  has replicas of the layers (share_params: the parameters are those of this model, the
+ *  caches and the gradients are the replica's), a loss and one SGDParamGroup per learnable
+ *  layer. The parameters copied by clone are dropped by share_params, once per fit.
+ */
+void MLPClassifier::build_async_workers(){
+    release_async_workers();
+    vector<ILayer*> masters = layer_vector();
+    if(m_hogwild_stripes > 0) m_pStripes = new StripedLocks(m_hogwild_stripes);
+    m_async_workers.resize(m_hogwild_workers);
+    for(auto& worker: m_async_workers){
+        for(auto pMaster: masters){
+            ILayer* pLayer = pMaster->clone();
+            pLayer->share_params(pMaster);
+            pLayer->set_working_mode(true);
+            worker.layers.push_back(pLayer);
+            if(!pLayer->has_learnable_param()) continue;
+            SGDParamGroup* pGroup = new SGDParamGroup();
+            pLayer->register_params(pGroup);
+            pGroup->set_stripes(m_pStripes);
+            worker.groups.push_back(pGroup);
+        }
+        worker.pLoss = m_pLossLayer->clone();
+    }
+}
 
-    for (auto bit = m_layers.bbegin(); bit != m_layers.bend(); ++bit) {  // !Khac Quoc
-        ILayer* layer = *bit;
-        DY = layer->backward(DY);
+void MLPClassifier::release_async_workers(){
+    for(auto& worker: m_async_workers){
+        for(auto pLayer: worker.layers) delete pLayer;
+        for(auto pGroup: worker.groups) delete pGroup;
+        delete worker.pLoss;
     }
+    m_async_workers.clear();
+    if(m_pStripes != nullptr) delete m_pStripes;
+    m_pStripes = nullptr;
+}
+
+/*
+ * train_epoch_async: one epoch with the Hogwild workers (built by fit, see build_async_workers);
+ *  a worker takes the next batch under a mutex, then runs forward, backward and the update
+ *  without any lock; the metrics and the logging of the step are serialized.
+ */
+void MLPClassifier::train_epoch_async(DataLoader<double, double>* pLoader){
+    if(m_pDDP != nullptr)
+        throw std::runtime_error(m_sModelName + ": Hogwild training can not be combined with distributed training");
+    if(m_async_workers.size() != (size_t)m_hogwild_workers) build_async_workers(); //called out of fit
+    vector<AsyncWorker>& workers = m_async_workers;
+
+    double lr = m_pOptimizer->get_learning_rate();
+    auto it = pLoader->begin(), end = pLoader->end();
+    mutex mtx;
+    exception_ptr error;
+    auto run = [&](AsyncWorker& worker){
+        try{
+            while(true){
+                Batch<double, double>* pBatch;
+                {
+                    lock_guard<mutex> lock(mtx);
+                    if(!(it != end) || error) return;
+                    pBatch = &(*it);
+                    ++it;
+                }
+                for(auto pGroup: worker.groups) pGroup->zero_grad();
+                double_tensor t = pBatch->getLabel();
+                double_tensor Y;
+                size_t first = 0;
+                if(pBatch->is_sparse()){
+                    if(worker.layers[0]->get_type() != LayerType::FC)
+                        throw std::runtime_error("MLPClassifier: a sparse (CSR) input needs an FCLayer as the first layer");
+                    Y = ((FCLayer*)worker.layers[0])->forward(pBatch->getSparseData());
+                    first = 1;
+                }
+                else Y = pBatch->getData();
+                for(size_t idx=first; idx < worker.layers.size(); idx++) Y = worker.layers[idx]->forward(Y);
+                double batch_loss = worker.pLoss->forward(Y, t);
+                double_tensor DY = worker.pLoss->backward();
+                for(size_t idx=worker.layers.size(); idx > 0; idx--) DY = worker.layers[idx - 1]->backward(DY);
+                for(auto pGroup: worker.groups) pGroup->step(lr);
+
+                ulong_tensor y_true = label_indices(t, Y.shape()[1]);
+                ulong_tensor y_pred = xt::argmax(Y, 1);
+                lock_guard<mutex> lock(mtx);
+                m_pMetricLayer->accumulate(y_true, y_pred);
+                on_begin_step(pBatch->size());
+                on_end_step(batch_loss);
+            }
+        }
+        catch(...){
+            lock_guard<mutex> lock(mtx);
+            if(!error) error = current_exception();
+        }
+    };
+    vector<thread> threads;
+    for(size_t w=1; w < workers.size(); w++) threads.push_back(thread(run, std::ref(workers[w])));
+    run(workers[0]);
+    for(auto& th: threads) th.join();
+    if(error) rethrow_exception(error);
+}
+
+void MLPClassifier::set_distributed(ProcessGroup* pGroup){
+    if(m_pDDP != nullptr) delete m_pDDP;
+    m_pDDP = nullptr;
+    if(pGroup == nullptr) return;
+    size_t bucket_bytes = (size_t)m_pConfig->get_int("dist_bucket_kb", 1024)*1024;
+    m_pDDP = new DistributedDataParallel(pGroup, layer_vector(), bucket_bytes);
+}
+
+vector<ILayer*> MLPClassifier::layer_vector() const{
+    DLinkedList<ILayer*>& layers = const_cast<DLinkedList<ILayer*>&>(m_layers);
+    vector<ILayer*> result;
+    for (auto layer : layers) result.push_back(layer);
+    return result;
+}
+//track_activation_bytes: the activations held now (segment inputs + layer caches) -> the peak
+void MLPClassifier::track_activation_bytes(){
+    size_t bytes = 0;
+    for (auto& X : m_seg_inputs) bytes += X.size()*sizeof(double);
+    for (auto layer : m_layers) bytes += layer->cache_bytes();
+    m_peak_act_bytes = max(m_peak_act_bytes, bytes);
+}
+string MLPClassifier::activation_report(){
+    if (m_recompute_segment <= 0) return "";
+    double recomputed = (m_backward_steps == 0)? 0 : (double)m_recomputed_layers/m_backward_steps;
+    return fmt::format("Activation checkpointing: {:d} layers/segment; peak activations: {:.1f} KB/step; "
+                       "recomputed layer forwards: {:.1f}/step",
+                       m_recompute_segment, m_peak_act_bytes/1024.0, recomputed);
 }
 //protected: for the training mode: end
 
@@ -193,44 +525,23 @@ void MLPClassifier::backward(){
 /*
  * save(string base_path):
  *  + base_path: 
- 
+ *  + the model is written to a temporary folder first, then renamed to
+ *      model_path; so an existing model_path survives a failed save.
  */
 bool MLPClassifier::save(string model_path){
     try{
         //prepare folder and file names
         model_path = trim(model_path);
-        if(fs::exists(model_path)){
-            //USE the specified path
-            fs::remove_all(model_path); //remove all files related
-        }
-        else{
+        if(!fs::exists(model_path)){
             //USE the DEFAULT path
             model_path = m_pConfig->get_new_checkpoint(this->m_sModelName);
-
         }
         cout << model_path << ": creation" << endl;
-        fs::create_directories(model_path);
-        string arch_file =  (fs::path(model_path)/
-                            fs::path(m_pConfig->get("arch_file", "arch.txt"))).string();
-
-        //open stream   
-        ofstream datastream(arch_file);
-        if(!datastream.is_open()){
-            cerr << arch_file << ": couldn't open for writing" << endl;
-            throw "Model architecture file '" + arch_file + "': can not open for writing.";
-        }
-        //write header
-        //write data
-        datastream << "model name: " << this->m_sModelName << endl;
-        for(auto pLayer: m_layers){
-            string desc = pLayer->get_desc();
-            datastream << desc << endl;
-            pLayer->save(model_path);
-        }
-
-        //close stream
-        datastream.close();
-        return true;
+        
+        Checkpoint ckpt;
+        stage(ckpt);
+        string arch_file = m_pConfig->get("arch_file", "arch.txt");
+        return CheckpointWriter::commit(ckpt, model_path, arch_file);
     }
     catch(exception& e){
         string message = fmt::format("MLPClassifier::save: failed; model_path={:s}",
@@ -241,8 +552,18 @@ bool MLPClassifier::save(string model_path){
     }
 }
 
+bool MLPClassifier::stage(Checkpoint& ckpt){
+    ckpt.add_arch("model name: " + this->m_sModelName);
+    for(auto pLayer: m_layers){
+        ckpt.add_arch(pLayer->get_desc());
+        pLayer->stage(ckpt);
+    }
+    return true;
+}
+
 bool MLPClassifier::load(string model_path,  bool use_name_in_file){
     try{
+        model_path = CheckpointWriter::resolve(model_path);
         //verify the existing of model_path
         if(!fs::exists(model_path)){
             string message = fmt::format("{:s}: not exist.", model_path); 
@@ -294,6 +615,10 @@ bool MLPClassifier::load(string model_path,  bool use_name_in_file){
                 //note:: b_file: may not be used in FCLayer
                  m_layers.add(new FCLayer(trim(second), w_file, b_file, new_name));
             }
+            if(layer_type.compare("Embedding") == 0){
+                string w_file = model_path + "/" + layer_name + "_W.npy";
+                m_layers.add(new Embedding(trim(second), w_file, new_name));
+            }
             if(layer_type.compare("ReLU") == 0){
                 m_layers.add(new ReLU(new_name) );
             }
@@ -0,0 +1,230 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.cc to edit this template
+ */
+
+/*
+ * File:   PipelineSchedule.cpp
+ *
+ * Created on November 27, 2024, 9:30 AM
+ */
+
+#include "model/PipelineSchedule.h"
+#include "layer/FCLayer.h"
+#include "layer/Embedding.h"
+#include "ann/functions.h"
+#include "sformat/fmt_lib.h"
+#include <exception>
+#include <limits>
+#include <thread>
+
+/*
+ * the stages minimize the cost of the most expensive stage (linear partition, O(nstages*n^2))
+ */
+PipelineSchedule::PipelineSchedule(vector<ILayer*> layers, int nstages){
+    int n = layers.size();
+    if(n == 0) throw std::invalid_argument("PipelineSchedule: no layers");
+    nstages = max(1, min(nstages, n));
+
+    vector<double> prefix(n + 1, 0.0);
+    for(int i=0; i < n; i++) prefix[i + 1] = prefix[i] + layer_cost(layers[i]);
+    const double inf = std::numeric_limits<double>::infinity();
+    //best[k][i]: the first i layers in k stages; cut[k][i]: the begin of the k-th stage
+    vector<vector<double>> best(nstages + 1, vector<double>(n + 1, inf));
+    vector<vector<int>> cut(nstages + 1, vector<int>(n + 1, 0));
+    best[0][0] = 0;
+    for(int k=1; k <= nstages; k++){
+        for(int i=k; i <= n; i++){
+            for(int j=k - 1; j < i; j++){
+                double cost = max(best[k - 1][j], prefix[i] - prefix[j]);
+                if(cost < best[k][i]){
+                    best[k][i] = cost;
+                    cut[k][i] = j;
+                }
+            }
+        }
+    }
+    m_boundaries.assign(nstages, 0);
+    for(int k=nstages, i=n; k >= 1; k--){
+        m_boundaries[k - 1] = cut[k][i];
+        i = cut[k][i];
+    }
+    for(int k=0; k < nstages; k++){
+        int end = (k + 1 < nstages)? m_boundaries[k + 1] : n;
+        m_stages.push_back(vector<ILayer*>(layers.begin() + m_boundaries[k], layers.begin() + end));
+        m_costs.push_back(prefix[end] - prefix[m_boundaries[k]]);
+    }
+    for(int s=0; s < nstages; s++){
+        //capacity 2: a stage can run one micro-batch ahead of its neighbour
+        m_activations.push_back(unique_ptr<BoundedQueue<double_tensor>>(new BoundedQueue<double_tensor>(2)));
+        m_gradients.push_back(unique_ptr<BoundedQueue<double_tensor>>(new BoundedQueue<double_tensor>(2)));
+    }
+    m_errors.resize(nstages);
+    m_generation = 0;
+    m_nRunning = 0;
+    m_bStop = false;
+}
+
+PipelineSchedule::~PipelineSchedule(){
+    {
+        lock_guard<mutex> lock(m_mtx);
+        m_bStop = true;
+    }
+    m_cv_start.notify_all();
+    for(auto& worker: m_workers) worker.join();
+}
+
+double PipelineSchedule::layer_cost(ILayer* pLayer){
+    if(pLayer->get_type() == LayerType::FC){
+        FCLayer* pFC = (FCLayer*)pLayer;
+        return (double)pFC->getNin()*pFC->getNout() + pFC->getNout();
+    }
+    if(pLayer->get_type() == LayerType::EMBEDDING) return ((Embedding*)pLayer)->getNdim();
+    return 1.0; //element-wise layers
+}
+
+string PipelineSchedule::get_desc(){
+    string desc;
+    for(size_t s=0; s < m_stages.size(); s++){
+        desc += fmt::format("stage {:d}: layers [{:d}, {:d}), cost {:.0f}\n", s, m_boundaries[s],
+                            m_boundaries[s] + m_stages[s].size(), m_costs[s]);
+    }
+    return desc;
+}
+
+double PipelineSchedule::run(const double_tensor& X, const double_tensor& t, int nmicro,
+                             ILossLayer* pLossLayer, IMetrics* pMetricLayer){
+    size_t nsamples = X.shape()[0];
+    nmicro = max(1, min(nmicro, (int)nsamples));
+    m_pX = &X;
+    m_pT = &t;
+    m_pLossLayer = pLossLayer;
+    m_pMetricLayer = pMetricLayer;
+    m_loss = 0;
+    m_micro_begin.clear();
+    for(int m=0; m <= nmicro; m++) m_micro_begin.push_back(nsamples*m/nmicro);
+
+    int nstages = m_stages.size();
+    //the queues of a run that threw may be closed or hold tensors: every stage is idle here
+    for(int s=0; s < nstages; s++){
+        m_activations[s]->reopen();
+        m_gradients[s]->reopen();
+        m_errors[s] = nullptr;
+    }
+    for(int s=m_workers.size() + 1; s < nstages; s++) //the first run
+        m_workers.push_back(thread(&PipelineSchedule::worker_loop, this, s));
+    {
+        lock_guard<mutex> lock(m_mtx);
+        m_nRunning = nstages - 1;
+        m_generation += 1;
+    }
+    m_cv_start.notify_all();
+    stage_main(0);
+    {
+        unique_lock<mutex> lock(m_mtx);
+        m_cv_done.wait(lock, [this](){ return m_nRunning == 0; });
+    }
+    for(auto& error: m_errors) if(error) rethrow_exception(error);
+    return m_loss;
+}
+
+void PipelineSchedule::stage_main(int s){
+    try{
+        run_stage(s);
+    }
+    catch(...){
+        m_errors[s] = current_exception();
+        close_queues();
+    }
+}
+
+void PipelineSchedule::worker_loop(int s){
+    unsigned long long done = 0; //the last run of this stage
+    while(true){
+        {
+            unique_lock<mutex> lock(m_mtx);
+            m_cv_start.wait(lock, [&](){ return m_bStop || (m_generation != done); });
+            if(m_bStop) return;
+            done = m_generation;
+        }
+        stage_main(s);
+        lock_guard<mutex> lock(m_mtx);
+        if(--m_nRunning == 0) m_cv_done.notify_all();
+    }
+}
+
+void PipelineSchedule::close_queues(){
+    for(auto& queue: m_activations) queue->close();
+    for(auto& queue: m_gradients) queue->close();
+}
+
+/*
+ * forward_stage: cache = false: the layers of the stage cache nothing (training flag off)
+ */
+double_tensor PipelineSchedule::forward_stage(int stage, double_tensor X, bool cache){
+    for(auto layer: m_stages[stage]){
+        if(cache) X = layer->forward(X);
+        else{
+            layer->set_working_mode(false);
+            X = layer->forward(X);
+            layer->set_working_mode(true);
+        }
+    }
+    return X;
+}
+
+void PipelineSchedule::run_stage(int s){
+    int nstages = m_stages.size();
+    int nmicro = m_micro_begin.size() - 1;
+    bool first = (s == 0), last = (s == nstages - 1);
+    vector<double_tensor> inputs(nmicro);
+    auto labels = [&](int m){
+        return double_tensor(xt::view(*m_pT, xt::range(m_micro_begin[m], m_micro_begin[m + 1])));
+    };
+    auto receive = [&](BoundedQueue<double_tensor>& queue, double_tensor& tensor){
+        if(!queue.pop(tensor)) throw std::runtime_error("PipelineSchedule: aborted by another stage");
+    };
+
+    //forward phase: micro-batches 0, 1, ..., nmicro-1
+    for(int m=0; m < nmicro; m++){
+        double_tensor X;
+        if(first) X = xt::view(*m_pX, xt::range(m_micro_begin[m], m_micro_begin[m + 1]));
+        else receive(*m_activations[s], X);
+        bool cache = (m == nmicro - 1); //the first one of the backward phase
+        if(!cache) inputs[m] = X;
+        double_tensor Y = forward_stage(s, X, cache);
+        if(!last){
+            if(!m_activations[s + 1]->push(std::move(Y)))
+                throw std::runtime_error("PipelineSchedule: aborted by another stage");
+        }
+        else{
+            if(cache) inputs[m] = Y; //kept for the loss
+            ulong_tensor y_true = label_indices(labels(m), Y.shape()[1]);
+            ulong_tensor y_pred = xt::argmax(Y, 1);
+            m_pMetricLayer->accumulate(y_true, y_pred);
+        }
+    }
+
+    //backward phase: micro-batches nmicro-1, ..., 0
+    for(int m=nmicro - 1; m >= 0; m--){
+        double_tensor Y;
+        if(m == nmicro - 1){
+            if(last) Y = std::move(inputs[m]);
+        }
+        else Y = forward_stage(s, std::move(inputs[m]), true); //re-materialization
+        inputs[m] = double_tensor();
+
+        double_tensor DY;
+        if(last){
+            m_loss += m_pLossLayer->forward(Y, labels(m));
+            DY = m_pLossLayer->backward();
+        }
+        else receive(*m_gradients[s], DY);
+        for(auto it=m_stages[s].rbegin(); it != m_stages[s].rend(); ++it) DY = (*it)->backward(DY);
+        if(!first){
+            if(!m_gradients[s - 1]->push(std::move(DY)))
+                throw std::runtime_error("PipelineSchedule: aborted by another stage");
+        }
+    }
+    for(auto layer: m_stages[s]) layer->release_cache();
+}
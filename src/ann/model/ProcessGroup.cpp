@@ -0,0 +1,287 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/class.cc to edit this template
+ */
+
+/*
+ * File:   ProcessGroup.cpp
+ *
+ * Created on November 28, 2024, 9:00 AM
+ */
+
+#include "model/ProcessGroup.h"
+#include "sformat/fmt_lib.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    void socket_error(string what){
+        throw std::runtime_error(fmt::format("ProcessGroup: {:s}: {:s}", what, strerror(errno)));
+    }
+    void set_nodelay(int fd){
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    void send_all(int fd, const void* buf, size_t n){
+        const char* p = (const char*)buf;
+        while(n > 0){
+            ssize_t k = send(fd, p, n, MSG_NOSIGNAL);
+            if(k < 0){
+                if(errno == EINTR) continue;
+                socket_error("send");
+            }
+            p += k;
+            n -= k;
+        }
+    }
+    void recv_all(int fd, void* buf, size_t n){
+        char* p = (char*)buf;
+        while(n > 0){
+            ssize_t k = recv(fd, p, n, 0);
+            if(k == 0) throw std::runtime_error("ProcessGroup: connection closed by the peer");
+            if(k < 0){
+                if(errno == EINTR) continue;
+                socket_error("recv");
+            }
+            p += k;
+            n -= k;
+        }
+    }
+    //the IPv4 address of host (a name or a dotted address); false if it does not resolve
+    bool resolve_host(const string& host, int port, sockaddr_in& addr){
+        addrinfo hints, *result = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        if(getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &result) != 0) return false;
+        memcpy(&addr, result->ai_addr, sizeof(addr));
+        freeaddrinfo(result);
+        return true;
+    }
+}
+
+ProcessGroup::ProcessGroup(int rank, int world_size, int base_port, string hosts, int timeout_s){
+    if((world_size < 1) || (rank < 0) || (rank >= world_size))
+        throw std::invalid_argument(fmt::format("ProcessGroup: invalid rank {:d} of {:d}", rank, world_size));
+    m_nRank = rank;
+    m_nWorld = world_size;
+    m_next_fd = m_prev_fd = -1;
+    m_nBytes_Sent = 0;
+    if(world_size == 1) return;
+
+    vector<string> host_list;
+    istringstream host_stream(hosts);
+    string host;
+    while(getline(host_stream, host, ',')) if(host.size() != 0) host_list.push_back(host);
+    if(host_list.size() == 0) host_list.push_back("127.0.0.1");
+    auto host_of = [&](int r){ return host_list[(host_list.size() == 1)? 0 : r % host_list.size()]; };
+
+    //(1) listen on hosts[rank]:base_port + rank, not on all the interfaces
+    sockaddr_in addr;
+    if(!resolve_host(host_of(rank), base_port + rank, addr))
+        throw std::runtime_error(fmt::format("ProcessGroup: rank {:d}: can not resolve {:s}", rank, host_of(rank)));
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(listen_fd < 0) socket_error("socket");
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if(bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0){
+        close(listen_fd);
+        socket_error(fmt::format("bind {:s}:{:d}", host_of(rank), base_port + rank));
+    }
+    if(listen(listen_fd, 4) < 0){
+        close(listen_fd);
+        socket_error("listen");
+    }
+
+    //(2) connect to the next rank: retried until it listens
+    int next = (rank + 1) % world_size;
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(timeout_s);
+    string port = to_string(base_port + next);
+    while(m_next_fd < 0){
+        sockaddr_in next_addr;
+        if(resolve_host(host_of(next), base_port + next, next_addr)){
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            if((fd >= 0) && (connect(fd, (sockaddr*)&next_addr, sizeof(next_addr)) == 0)) m_next_fd = fd;
+            else if(fd >= 0) close(fd);
+        }
+        if(m_next_fd >= 0) break;
+        if(chrono::steady_clock::now() > deadline){
+            close(listen_fd);
+            throw std::runtime_error(fmt::format("ProcessGroup: rank {:d} can not connect to rank {:d} ({:s}:{:s})",
+                                                 rank, next, host_of(next), port));
+        }
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+    set_nodelay(m_next_fd);
+    int32_t my_rank = rank;
+    send_all(m_next_fd, &my_rank, sizeof(my_rank));
+
+    //(3) accept the previous rank
+    pollfd pfd = {listen_fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeout_s*1000);
+    if(ready <= 0){
+        close(listen_fd);
+        throw std::runtime_error(fmt::format("ProcessGroup: rank {:d}: no connection from the previous rank", rank));
+    }
+    m_prev_fd = accept(listen_fd, nullptr, nullptr);
+    close(listen_fd);
+    if(m_prev_fd < 0) socket_error("accept");
+    set_nodelay(m_prev_fd);
+    int32_t prev_rank;
+    recv_all(m_prev_fd, &prev_rank, sizeof(prev_rank));
+    if(prev_rank != (rank + world_size - 1) % world_size)
+        throw std::runtime_error(fmt::format("ProcessGroup: rank {:d} was connected by rank {:d}", rank, prev_rank));
+}
+
+ProcessGroup::~ProcessGroup(){
+    if(m_next_fd >= 0) close(m_next_fd);
+    if(m_prev_fd >= 0) close(m_prev_fd);
+}
+
+ProcessGroup* ProcessGroup::from_env(){
+    const char* world = getenv("ANN_WORLD_SIZE");
+    if(world == nullptr) return nullptr;
+    const char* rank = getenv("ANN_RANK");
+    const char* port = getenv("ANN_PORT");
+    const char* hosts = getenv("ANN_HOSTS");
+    return new ProcessGroup((rank == nullptr)? 0 : atoi(rank), atoi(world),
+                            (port == nullptr)? 29500 : atoi(port),
+                            (hosts == nullptr)? "127.0.0.1" : hosts);
+}
+
+/*
+ * exchange: full duplex with poll; a blocking send of a large chunk could otherwise wait
+ *  for the next rank, itself blocked on its own send (every rank sends at the same time).
+ */
+void ProcessGroup::exchange(const void* send_buf, size_t nsend, void* recv_buf, size_t nrecv){
+    const char* ps = (const char*)send_buf;
+    char* pr = (char*)recv_buf;
+    m_nBytes_Sent += nsend;
+    while((nsend > 0) || (nrecv > 0)){
+        pollfd pfds[2];
+        int nfds = 0;
+        int send_idx = -1, recv_idx = -1;
+        if(nsend > 0){
+            pfds[nfds] = {m_next_fd, POLLOUT, 0};
+            send_idx = nfds++;
+        }
+        if(nrecv > 0){
+            pfds[nfds] = {m_prev_fd, POLLIN, 0};
+            recv_idx = nfds++;
+        }
+        if(poll(pfds, nfds, -1) < 0){
+            if(errno == EINTR) continue;
+            socket_error("poll");
+        }
+        if((send_idx >= 0) && (pfds[send_idx].revents & (POLLOUT | POLLERR | POLLHUP))){
+            ssize_t k = send(m_next_fd, ps, nsend, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if(k < 0){
+                if((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) socket_error("send");
+            }
+            else{
+                ps += k;
+                nsend -= k;
+            }
+        }
+        if((recv_idx >= 0) && (pfds[recv_idx].revents & (POLLIN | POLLERR | POLLHUP))){
+            ssize_t k = recv(m_prev_fd, pr, nrecv, MSG_DONTWAIT);
+            if(k == 0) throw std::runtime_error("ProcessGroup: connection closed by the previous rank");
+            if(k < 0){
+                if((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) socket_error("recv");
+            }
+            else{
+                pr += k;
+                nrecv -= k;
+            }
+        }
+    }
+}
+
+/*
+ * allreduce_sum: chunk c = [n*c/N, n*(c+1)/N);
+ *  + reduce-scatter, step k: send chunk (r-k), receive chunk (r-k-1) and add it;
+ *      rank r then holds the complete sum of chunk (r+1);
+ *  + all-gather, step k: send chunk (r+1-k), receive chunk (r-k) in place.
+ */
+void ProcessGroup::allreduce_sum(double* data, size_t n){
+    int N = m_nWorld, r = m_nRank;
+    if((N == 1) || (n == 0)) return;
+    auto begin = [&](int c){ return n*((c + N) % N)/N; };
+    auto length = [&](int c){ c = (c + N) % N; return n*(c + 1)/N - n*c/N; };
+    m_recv_chunk.resize(n/N + 1);
+    for(int k=0; k < N - 1; k++){
+        int send_c = r - k, recv_c = r - k - 1;
+        exchange(data + begin(send_c), length(send_c)*sizeof(double),
+                 m_recv_chunk.data(), length(recv_c)*sizeof(double));
+        double* dst = data + begin(recv_c);
+        for(size_t i=0; i < length(recv_c); i++) dst[i] += m_recv_chunk[i];
+    }
+    for(int k=0; k < N - 1; k++){
+        int send_c = r + 1 - k, recv_c = r - k;
+        exchange(data + begin(send_c), length(send_c)*sizeof(double),
+                 data + begin(recv_c), length(recv_c)*sizeof(double));
+    }
+}
+
+/*
+ * broadcast: the data of root flows along the ring root -> root+1 -> ... -> root-1,
+ *  pipelined in chunks; step s forwards chunk s-1 while chunk s is received.
+ *  Each rank but the last one sends the data once; the bits are copied, not summed.
+ */
+void ProcessGroup::broadcast(double* data, size_t n, int root){
+    int N = m_nWorld;
+    if((N == 1) || (n == 0)) return;
+    if((root < 0) || (root >= N))
+        throw std::invalid_argument(fmt::format("ProcessGroup::broadcast: invalid root {:d} of {:d}", root, N));
+    int pos = (m_nRank - root + N) % N; //position in the chain: 0 is root, N-1 is the last one
+    const size_t chunk = 1 << 15;
+    size_t nchunks = (n + chunk - 1)/chunk;
+    auto bytes = [&](size_t c){ return std::min(chunk, n - c*chunk)*sizeof(double); };
+    if(pos == 0){
+        for(size_t c=0; c < nchunks; c++) exchange(data + c*chunk, bytes(c), nullptr, 0);
+        return;
+    }
+    bool forwards = (pos != N - 1);
+    for(size_t s=0; s <= nchunks; s++){
+        size_t nsend = (forwards && (s > 0))? bytes(s - 1) : 0;
+        size_t nrecv = (s < nchunks)? bytes(s) : 0;
+        exchange((s > 0)? data + (s - 1)*chunk : nullptr, nsend,
+                 (s < nchunks)? data + s*chunk : nullptr, nrecv);
+    }
+}
+
+/*
+ * allgather: step k forwards the blob of rank (r-k) and receives the one of rank (r-k-1);
+ *  each blob is preceded by its length
+ */
+vector<vector<char>> ProcessGroup::allgather(const vector<char>& mine){
+    int N = m_nWorld, r = m_nRank;
+    vector<vector<char>> blobs(N);
+    blobs[r] = mine;
+    for(int k=0; k < N - 1; k++){
+        int send_r = (r - k + N) % N, recv_r = (r - k - 1 + N) % N;
+        uint64_t send_len = blobs[send_r].size(), recv_len = 0;
+        exchange(&send_len, sizeof(send_len), &recv_len, sizeof(recv_len));
+        blobs[recv_r].resize(recv_len);
+        exchange(blobs[send_r].data(), send_len, blobs[recv_r].data(), recv_len);
+    }
+    return blobs;
+}
+
+void ProcessGroup::barrier(){
+    double token = 1;
+    allreduce_sum(&token, 1);
+}
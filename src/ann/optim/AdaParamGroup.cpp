@@ -11,15 +11,19 @@
  */
 
 #include "optim/AdaParamGroup.h"
+#include "util/ThreadPool.h"
 
 AdaParamGroup::AdaParamGroup(double decay): m_decay(decay) {
-    m_pParams = new xmap<string, xt::xarray<double>*>(&stringHash);
-    m_pGrads = new xmap<string, xt::xarray<double>*>(&stringHash);
-    m_pSquaredGrads = new xmap<string, xt::xarray<double>*>(
+    m_pParams = new xmap<string, double_tensor*>(&stringHash);
+    m_pGrads = new xmap<string, double_tensor*>(&stringHash);
+    m_pSparseParams = new xmap<string, double_tensor*>(&stringHash);
+    m_pSparseGrads = new xmap<string, SparseRowGrad*>(&stringHash);
+    m_pCounter = nullptr;
+    m_pSquaredGrads = new xmap<string, double_tensor*>(
             &stringHash,
             0.75,
             0,
-            xmap<string, xt::xarray<double>*>::freeValue);
+            xmap<string, double_tensor*>::freeValue);
 }
 
 AdaParamGroup::AdaParamGroup(const AdaParamGroup& orig) {
@@ -28,24 +32,33 @@ AdaParamGroup::AdaParamGroup(const AdaParamGroup& orig) {
 AdaParamGroup::~AdaParamGroup() {
 }
 
-void AdaParamGroup::register_param(string param_name, xt::xarray<double>* ptr_param, xt::xarray<double>* ptr_grad){
+void AdaParamGroup::register_param(string param_name, double_tensor* ptr_param, double_tensor* ptr_grad){
     m_pParams->put(param_name, ptr_param);
     m_pGrads->put(param_name, ptr_grad);
     //prepare squared-grads
     m_pSquaredGrads->put(param_name, new double_tensor);
 }
+void AdaParamGroup::register_sparse_param(string param_name, double_tensor* ptr_param, SparseRowGrad* ptr_grad){
+    m_pSparseParams->put(param_name, ptr_param);
+    m_pSparseGrads->put(param_name, ptr_grad);
+    //the squared-grads of a sparse param: sized here, the table can be large
+    m_pSquaredGrads->put(param_name, new double_tensor(xt::zeros<double>(ptr_param->shape())));
+}
 void AdaParamGroup::register_sample_count(unsigned long long* pCounter){
     m_pCounter = pCounter;
 }
 void AdaParamGroup::zero_grad(){
     DLinkedList<string> keys = m_pGrads->keys();
     for(auto key: keys){
-        xt::xarray<double>* pGrad = m_pGrads->get(key);
-        xt::xarray<double>* pSquaredGrad = m_pSquaredGrads->get(key);
-        xt::xarray<double>* pParam = m_pParams->get(key);
-        *pGrad = xt::zeros<double>(pParam->shape());
-        *pSquaredGrad = xt::zeros<double>(pParam->shape());
+        double_tensor* pGrad = m_pGrads->get(key);
+        double_tensor* pSquaredGrad = m_pSquaredGrads->get(key);
+        double_tensor* pParam = m_pParams->get(key);
+        fill_zeros(*pGrad, pParam->shape());
+        //the squared-grads are the running average: sized once, kept across steps
+        if(pSquaredGrad->shape() != pParam->shape()) fill_zeros(*pSquaredGrad, pParam->shape());
     }
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys) m_pSparseGrads->get(key)->clear();
     //reset sample_counter
     *m_pCounter = 0;
 }
@@ -53,11 +66,51 @@ void AdaParamGroup::zero_grad(){
 void AdaParamGroup::step(double lr){
     DLinkedList<string> keys = m_pGrads->keys();
     for(auto key: keys){
-        xt::xarray<double>& grad_P = *m_pGrads->get(key);
-        xt::xarray<double>& squared_grad = *m_pSquaredGrads->get(key);
-        squared_grad = m_decay*squared_grad + (1 - m_decay)*grad_P*grad_P;
-        xt::xarray<double>& P = *m_pParams->get(key);
+        double_tensor& grad_P = *m_pGrads->get(key);
+        double_tensor& squared_grad = *m_pSquaredGrads->get(key);
+        double_tensor& P = *m_pParams->get(key);
         
-        P = P - lr*grad_P/(xt::sqrt(squared_grad) + 1e-7);
+        //squared_grad = decay*squared_grad + (1 - decay)*grad_P^2
+        //P = P - lr*grad_P/(sqrt(squared_grad) + 1e-7), fused and in place
+        double* p = P.data();
+        double* sq = squared_grad.data();
+        const double* g = grad_P.data();
+        double decay = m_decay;
+        parallel_for(P.size(), [&](size_t begin, size_t end){
+            for(size_t idx=begin; idx < end; idx++){
+                sq[idx] = decay*sq[idx] + (1 - decay)*g[idx]*g[idx];
+                p[idx] -= lr*g[idx]/(std::sqrt(sq[idx]) + 1e-7);
+            }
+        });
+    }
+    //sparse: the same update on the rows in the gradient only (lazy: the other rows do not decay)
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys){
+        SparseRowGrad& grad_P = *m_pSparseGrads->get(key);
+        double_tensor& squared_grad = *m_pSquaredGrads->get(key);
+        double_tensor& P = *m_pSparseParams->get(key);
+        if(squared_grad.shape() != P.shape()) fill_zeros(squared_grad, P.shape());
+        size_t ncols = grad_P.ncols();
+        double decay = m_decay;
+        parallel_for(grad_P.size(), [&](size_t begin, size_t end){
+            for(size_t k=begin; k < end; k++){
+                size_t offset = grad_P.row_id(k)*ncols;
+                double* p = P.data() + offset;
+                double* sq = squared_grad.data() + offset;
+                const double* g = grad_P.values(k);
+                for(size_t c=0; c < ncols; c++){
+                    sq[c] = decay*sq[c] + (1 - decay)*g[c]*g[c];
+                    p[c] -= lr*g[c]/(std::sqrt(sq[c]) + 1e-7);
+                }
+            }
+        }, ncols);
     }
-}
\ No newline at end of file
+}
+
+void AdaParamGroup::normalize_grad(){
+    if((m_pCounter == nullptr) || (*m_pCounter == 0)) return;
+    DLinkedList<string> keys = m_pGrads->keys();
+    for(auto key: keys) scale_inplace(*m_pGrads->get(key), 1.0/(*m_pCounter));
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys) m_pSparseGrads->get(key)->scale(1.0/(*m_pCounter));
+}
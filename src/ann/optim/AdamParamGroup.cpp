@@ -11,22 +11,26 @@
  */
 
 #include "optim/AdamParamGroup.h"
+#include "util/ThreadPool.h"
 
 AdamParamGroup::AdamParamGroup(double beta1, double beta2):
     m_beta1(beta1), m_beta2(beta2){
     //Create some maps:
-    m_pParams = new xmap<string, xt::xarray<double>*>(&stringHash);
-    m_pGrads = new xmap<string, xt::xarray<double>*>(&stringHash);
-    m_pFirstMomment = new xmap<string, xt::xarray<double>*>(
+    m_pParams = new xmap<string, double_tensor*>(&stringHash);
+    m_pGrads = new xmap<string, double_tensor*>(&stringHash);
+    m_pSparseParams = new xmap<string, double_tensor*>(&stringHash);
+    m_pSparseGrads = new xmap<string, SparseRowGrad*>(&stringHash);
+    m_pCounter = nullptr;
+    m_pFirstMomment = new xmap<string, double_tensor*>(
             &stringHash,
             0.75,
             0,
-            xmap<string, xt::xarray<double>*>::freeValue);
-    m_pSecondMomment = new xmap<string, xt::xarray<double>*>(
+            xmap<string, double_tensor*>::freeValue);
+    m_pSecondMomment = new xmap<string, double_tensor*>(
             &stringHash,
             0.75,
             0,
-            xmap<string, xt::xarray<double>*>::freeValue);
+            xmap<string, double_tensor*>::freeValue);
     //
     m_step_idx = 1;
     m_beta1_t = m_beta1;
@@ -35,21 +39,26 @@ AdamParamGroup::AdamParamGroup(double beta1, double beta2):
 
 AdamParamGroup::AdamParamGroup(const AdamParamGroup& orig):
     m_beta1(orig.m_beta1), m_beta2(orig.m_beta2){
-    m_pParams = new xmap<string, xt::xarray<double>*>(&stringHash);
-    m_pGrads = new xmap<string, xt::xarray<double>*>(&stringHash);
-    m_pFirstMomment = new xmap<string, xt::xarray<double>*>(
+    m_pParams = new xmap<string, double_tensor*>(&stringHash);
+    m_pGrads = new xmap<string, double_tensor*>(&stringHash);
+    m_pSparseParams = new xmap<string, double_tensor*>(&stringHash);
+    m_pSparseGrads = new xmap<string, SparseRowGrad*>(&stringHash);
+    m_pCounter = nullptr;
+    m_pFirstMomment = new xmap<string, double_tensor*>(
             &stringHash,
             0.75,
             0,
-            xmap<string, xt::xarray<double>*>::freeValue);
-    m_pSecondMomment = new xmap<string, xt::xarray<double>*>(
+            xmap<string, double_tensor*>::freeValue);
+    m_pSecondMomment = new xmap<string, double_tensor*>(
             &stringHash,
             0.75,
             0,
-            xmap<string, xt::xarray<double>*>::freeValue);
+            xmap<string, double_tensor*>::freeValue);
     //copy:
     *m_pParams = *orig.m_pParams;
     *m_pGrads = *orig.m_pGrads;
+    *m_pSparseParams = *orig.m_pSparseParams;
+    *m_pSparseGrads = *orig.m_pSparseGrads;
     *m_pFirstMomment = *orig.m_pFirstMomment;
     *m_pSecondMomment = *orig.m_pSecondMomment;
     //
@@ -64,23 +73,91 @@ AdamParamGroup::~AdamParamGroup() {
 }
 
 void AdamParamGroup::register_param(string param_name, 
-        xt::xarray<double>* ptr_param,
-        xt::xarray<double>* ptr_grad){
-    //YOUR CODE IS HERE
+        double_tensor* ptr_param,
+        double_tensor* ptr_grad){
+    m_pParams->put(param_name, ptr_param);
+    m_pGrads->put(param_name, ptr_grad);
+    //prepare the moments: sized (zeros) at the first step
+    m_pFirstMomment->put(param_name, new double_tensor);
+    m_pSecondMomment->put(param_name, new double_tensor);
+}
+void AdamParamGroup::register_sparse_param(string param_name,
+        double_tensor* ptr_param,
+        SparseRowGrad* ptr_grad){
+    m_pSparseParams->put(param_name, ptr_param);
+    m_pSparseGrads->put(param_name, ptr_grad);
+    m_pFirstMomment->put(param_name, new double_tensor(xt::zeros<double>(ptr_param->shape())));
+    m_pSecondMomment->put(param_name, new double_tensor(xt::zeros<double>(ptr_param->shape())));
 }
 void AdamParamGroup::register_sample_count(unsigned long long* pCounter){
     m_pCounter = pCounter;
 }
 
 void AdamParamGroup::zero_grad(){
-    //YOUR CODE IS HERE
+    DLinkedList<string> keys = m_pGrads->keys();
+    for(auto key: keys){
+        double_tensor* pGrad = m_pGrads->get(key);
+        double_tensor* pParam = m_pParams->get(key);
+        fill_zeros(*pGrad, pParam->shape());
+    }
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys) m_pSparseGrads->get(key)->clear();
+    //reset sample_counter
+    *m_pCounter = 0;
 }
 
 void AdamParamGroup::step(double lr){
-    //YOUR CODE IS HERE
+    //m = beta1*m + (1 - beta1)*g; v = beta2*v + (1 - beta2)*g^2
+    //P = P - lr*(m/(1 - beta1^t))/(sqrt(v/(1 - beta2^t)) + 1e-7), fused and in place
+    double beta1 = m_beta1, beta2 = m_beta2;
+    double correct1 = 1.0/(1 - m_beta1_t), correct2 = 1.0/(1 - m_beta2_t);
+    auto update = [=](double* p, double* m, double* v, const double* g, size_t n){
+        for(size_t idx=0; idx < n; idx++){
+            m[idx] = beta1*m[idx] + (1 - beta1)*g[idx];
+            v[idx] = beta2*v[idx] + (1 - beta2)*g[idx]*g[idx];
+            p[idx] -= lr*(m[idx]*correct1)/(std::sqrt(v[idx]*correct2) + 1e-7);
+        }
+    };
+    DLinkedList<string> keys = m_pGrads->keys();
+    for(auto key: keys){
+        double_tensor& P = *m_pParams->get(key);
+        double_tensor& grad_P = *m_pGrads->get(key);
+        double_tensor& M = *m_pFirstMomment->get(key);
+        double_tensor& V = *m_pSecondMomment->get(key);
+        if(M.shape() != P.shape()) fill_zeros(M, P.shape());
+        if(V.shape() != P.shape()) fill_zeros(V, P.shape());
+        parallel_for(P.size(), [&](size_t begin, size_t end){
+            update(P.data() + begin, M.data() + begin, V.data() + begin, grad_P.data() + begin, end - begin);
+        });
+    }
+    //sparse: the rows in the gradient only (lazy Adam: the moments of the other rows are not decayed)
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys){
+        double_tensor& P = *m_pSparseParams->get(key);
+        SparseRowGrad& grad_P = *m_pSparseGrads->get(key);
+        double_tensor& M = *m_pFirstMomment->get(key);
+        double_tensor& V = *m_pSecondMomment->get(key);
+        if(M.shape() != P.shape()) fill_zeros(M, P.shape());
+        if(V.shape() != P.shape()) fill_zeros(V, P.shape());
+        size_t ncols = grad_P.ncols();
+        parallel_for(grad_P.size(), [&](size_t begin, size_t end){
+            for(size_t k=begin; k < end; k++){
+                size_t offset = grad_P.row_id(k)*ncols;
+                update(P.data() + offset, M.data() + offset, V.data() + offset, grad_P.values(k), ncols);
+            }
+        }, ncols);
+    }
     
     //UPDATE step_idx:
     m_step_idx += 1;
     m_beta1_t *= m_beta1;
     m_beta2_t *= m_beta2;
 }
+
+void AdamParamGroup::normalize_grad(){
+    if((m_pCounter == nullptr) || (*m_pCounter == 0)) return;
+    DLinkedList<string> keys = m_pGrads->keys();
+    for(auto key: keys) scale_inplace(*m_pGrads->get(key), 1.0/(*m_pCounter));
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys) m_pSparseGrads->get(key)->scale(1.0/(*m_pCounter));
+}
@@ -38,6 +38,13 @@ void IOptimizer::step(){
         pGroup->step(m_fLearningRate);
     }
 }
+void IOptimizer::normalize_grad(){
+    DLinkedList<string> keys = m_pGroupMap->keys();
+    for(auto key: keys){
+        IParamGroup* pGroup = m_pGroupMap->get(key);
+        pGroup->normalize_grad();
+    }
+}
 void IOptimizer::zero_grad(){
     DLinkedList<string> keys = m_pGroupMap->keys();
     for(auto key: keys){
@@ -11,10 +11,15 @@
  */
 
 #include "optim/SGDParamGroup.h"
+#include "util/ThreadPool.h"
 
 SGDParamGroup::SGDParamGroup() {
-    m_pParams = new xmap<string, xt::xarray<double>*>(&stringHash);
-    m_pGrads = new xmap<string, xt::xarray<double>*>(&stringHash);
+    m_pParams = new xmap<string, double_tensor*>(&stringHash);
+    m_pGrads = new xmap<string, double_tensor*>(&stringHash);
+    m_pSparseParams = new xmap<string, double_tensor*>(&stringHash);
+    m_pSparseGrads = new xmap<string, SparseRowGrad*>(&stringHash);
+    m_pCounter = nullptr;
+    m_pStripes = nullptr;
 }
 
 SGDParamGroup::SGDParamGroup(const SGDParamGroup& orig) {
@@ -23,20 +28,27 @@ SGDParamGroup::SGDParamGroup(const SGDParamGroup& orig) {
 SGDParamGroup::~SGDParamGroup() {
 }
 
-void SGDParamGroup::register_param(string param_name, xt::xarray<double>* ptr_param, xt::xarray<double>* ptr_grad){
+void SGDParamGroup::register_param(string param_name, double_tensor* ptr_param, double_tensor* ptr_grad){
     m_pParams->put(param_name, ptr_param);
     m_pGrads->put(param_name, ptr_grad);
 }
+void SGDParamGroup::register_sparse_param(string param_name, double_tensor* ptr_param, SparseRowGrad* ptr_grad){
+    m_pSparseParams->put(param_name, ptr_param);
+    m_pSparseGrads->put(param_name, ptr_grad);
+}
 void SGDParamGroup::register_sample_count(unsigned long long* pCounter){
     m_pCounter = pCounter;
 }
 void SGDParamGroup::zero_grad(){
     DLinkedList<string> keys = m_pGrads->keys();
     for(auto key: keys){
-        xt::xarray<double>* pGrad = m_pGrads->get(key);
-        xt::xarray<double>* pParam = m_pParams->get(key);
-        *pGrad = xt::zeros<double>(pParam->shape());
+        double_tensor* pGrad = m_pGrads->get(key);
+        double_tensor* pParam = m_pParams->get(key);
+        fill_zeros(*pGrad, pParam->shape());
     }
+    //sparse: only the rows seen since the last zero_grad
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys) m_pSparseGrads->get(key)->clear();
     //reset sample_counter
     *m_pCounter = 0;
 }
@@ -44,8 +56,54 @@ void SGDParamGroup::zero_grad(){
 void SGDParamGroup::step(double lr){
     DLinkedList<string> keys = m_pGrads->keys();
     for(auto key: keys){
-        xt::xarray<double>& P = *m_pParams->get(key);
-        xt::xarray<double>& grad_P = *m_pGrads->get(key);
-        P = P - lr*grad_P;
+        double_tensor& P = *m_pParams->get(key);
+        double_tensor& grad_P = *m_pGrads->get(key);
+        //P = P - lr*grad_P, in place
+        double* p = P.data();
+        const double* g = grad_P.data();
+        if(m_pStripes != nullptr){
+            size_t nstripes = m_pStripes->size();
+            for(size_t s=0; s < nstripes; s++){
+                size_t begin = P.size()*s/nstripes, end = P.size()*(s + 1)/nstripes;
+                lock_guard<mutex> lock(m_pStripes->get(p, s));
+                for(size_t idx=begin; idx < end; idx++) p[idx] -= lr*g[idx];
+            }
+            continue;
+        }
+        parallel_for(P.size(), [&](size_t begin, size_t end){
+            for(size_t idx=begin; idx < end; idx++) p[idx] -= lr*g[idx];
+        });
+    }
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys){
+        double_tensor& P = *m_pSparseParams->get(key);
+        SparseRowGrad& grad_P = *m_pSparseGrads->get(key);
+        //P[r, :] = P[r, :] - lr*grad_P[r, :], for the rows r in grad_P only
+        size_t ncols = grad_P.ncols();
+        if(m_pStripes != nullptr){
+            //stripe of a row: its row id
+            for(size_t k=0; k < grad_P.size(); k++){
+                double* p = P.data() + grad_P.row_id(k)*ncols;
+                const double* g = grad_P.values(k);
+                lock_guard<mutex> lock(m_pStripes->get(P.data(), grad_P.row_id(k)));
+                for(size_t c=0; c < ncols; c++) p[c] -= lr*g[c];
+            }
+            continue;
+        }
+        parallel_for(grad_P.size(), [&](size_t begin, size_t end){
+            for(size_t k=begin; k < end; k++){
+                double* p = P.data() + grad_P.row_id(k)*ncols;
+                const double* g = grad_P.values(k);
+                for(size_t c=0; c < ncols; c++) p[c] -= lr*g[c];
+            }
+        }, ncols);
     }
 }
+
+void SGDParamGroup::normalize_grad(){
+    if((m_pCounter == nullptr) || (*m_pCounter == 0)) return;
+    DLinkedList<string> keys = m_pGrads->keys();
+    for(auto key: keys) scale_inplace(*m_pGrads->get(key), 1.0/(*m_pCounter));
+    DLinkedList<string> sparse_keys = m_pSparseGrads->keys();
+    for(auto key: sparse_keys) m_pSparseGrads->get(key)->scale(1.0/(*m_pCounter));
+}
@@ -19,9 +19,79 @@ namespace fs = std::filesystem;
 #include "optim/Adam.h"
 #include "modelzoo/twoclasses.h"
 #include "modelzoo/threeclasses.h"
+#include "util/ThreadPool.h"
 
+//demos: compiled with the program, so that the header-only structures are instantiated
+#include "stacknqueue/ConcurrentQueueDemo.h"
+#include "util/ThreadPoolDemo.h"
+#include "graph/DijkstraDemo.h"
+#include "graph/CSRGraphDemo.h"
+#include "sorting/FastSortDemo.h"
+#include "tree/BPlusTreeDemo.h"
+#include "ann/model/StaticMLPDemo.h"
+#include "ann/model/TopKDemo.h"
+#include "ann/model/ConcurrentPredictDemo.h"
+#include "ann/model/RecomputeDemo.h"
+#include "ann/model/PipelineDemo.h"
+#include "ann/model/DistributedDemo.h"
+#include "ann/model/HogwildDemo.h"
+#include "ann/model/CheckpointDemo.h"
+#include "ann/model/GradAccumDemo.h"
+#include "ann/model/AsyncValidationDemo.h"
+#include "ann/layer/EmbeddingDemo.h"
+#include "ann/layer/SparseFCDemo.h"
+#include "ann/layer/ActivationDemo.h"
+#include "ann/layer/SoftmaxDemo.h"
+#include "ann/layer/GemmDemo.h"
+#include "ann/loss/CrossEntropyDemo.h"
+#include "ann/dataset/DSFactoryDemo.h"
+#include "tensor/TensorAllocatorDemo.h"
+
+/*
+ * run_checks: the self-checking demos ("./program check"); each one compares a structure
+ *  with a reference implementation. Returns the number of failed checks.
+ */
+int run_checks(){
+    struct Check{ string name; bool (*run)(); };
+    Check checks[] = {
+        {"concurrentQueueCheck", [](){ return concurrentQueueCheck(); }},
+        {"threadPoolCheck", [](){ return threadPoolCheck(); }},
+        {"dijkstraCheck", [](){ return dijkstraCheck(); }},
+        {"csrGraphCheck", [](){ return csrGraphCheck(); }},
+        {"fastSortCheck", [](){ return fastSortCheck(); }},
+        {"bplusTreeCheck", [](){ return bplusTreeCheck(); }},
+        {"staticMLPCheck", [](){ return staticMLPCheck(); }},
+        {"checkpointCheck", [](){ return checkpointCheck(); }},
+        {"gradAccumCheck", [](){ return gradAccumCheck(); }},
+        {"asyncValidationCheck", [](){ return asyncValidationCheck(); }},
+        {"concurrentPredictCheck", [](){ return concurrentPredictCheck(); }},
+        {"activationCheck", [](){ return activationCheck(); }},
+        {"softmaxCheck", [](){ return softmaxCheck(); }},
+        {"gemmCheck", [](){ return gemmCheck(); }},
+        {"crossEntropyCheck", [](){ return crossEntropyCheck(); }},
+        {"dsFactoryCheck", [](){ return dsFactoryCheck(); }},
+    };
+    int nfailed = 0;
+    for(auto& check: checks){
+        cout << "== " << check.name << endl;
+        bool passed = check.run();
+        cout << "== " << check.name << ": " << (passed? "PASSED" : "FAILED") << endl;
+        nfailed += !passed;
+    }
+    return nfailed;
+}
 
 int main(int argc, char** argv) {
+    //size the shared thread pool once, before any parallel work: num_threads <= 0 means one per hardware thread
+    Config config("./config.txt");
+    int num_threads = config.get_int("num_threads", 0);
+    bool check = (argc > 1) && (string(argv[1]) == "check");
+    //the checks need a few threads even on a single core, so that the parallel paths run
+    if(check) num_threads = max(4, (num_threads > 0)? num_threads : (int)thread::hardware_concurrency());
+    ThreadPool::configure(num_threads,
+            config.get_int("parallel_threshold", ThreadPool::DEFAULT_THRESHOLD));
+    if(check) return (run_checks() == 0)? 0 : 1;
+
     //dataloader:
     //case_data_wo_label_1();
     //case_data_wi_label_1();
@@ -0,0 +1,92 @@
+/*
+ * Click nbfs://nbhost/SystemFileSystem/Templates/Licenses/license-default.txt to change this license
+ * Click nbfs://nbhost/SystemFileSystem/Templates/cppFiles/file.cc to edit this template
+ */
+
+/*
+ * File:   tensor_allocator.cpp
+ *
+ * Created on December 4, 2024, 10:20 AM
+ */
+
+#include "tensor/tensor_allocator.h"
+#include "sformat/fmt_lib.h"
+#include <cstdint>
+#include <cstdlib>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+atomic<bool> TensorMemory::m_huge_pages(false);
+atomic<size_t> TensorMemory::m_huge_page_min_bytes(4096*1024);
+atomic<unsigned long long> TensorMemory::m_allocations(0);
+atomic<unsigned long long> TensorMemory::m_deallocations(0);
+atomic<unsigned long long> TensorMemory::m_huge_page_allocations(0);
+atomic<unsigned long long> TensorMemory::m_bytes_allocated(0);
+atomic<long long> TensorMemory::m_bytes_live(0);
+atomic<long long> TensorMemory::m_bytes_peak(0);
+
+void TensorMemory::configure(bool huge_pages, size_t huge_page_min_kb){
+    m_huge_pages = huge_pages;
+    m_huge_page_min_bytes = huge_page_min_kb*1024;
+}
+
+/*
+ * allocate: malloc'ed with room for the alignment; the pointer returned by malloc is kept
+ *  just before the aligned block (glibc's posix_memalign is several times slower than malloc
+ *  for the small buffers of a training step)
+ */
+void* TensorMemory::allocate(size_t bytes){
+    size_t alignment = ALIGNMENT;
+    size_t size = bytes;
+    bool huge = m_huge_pages.load(memory_order_relaxed) && (bytes >= m_huge_page_min_bytes.load(memory_order_relaxed));
+    if(huge){
+        //whole huge pages: madvise does not touch the neighbours
+        alignment = HUGE_PAGE_SIZE;
+        size = (bytes + HUGE_PAGE_SIZE - 1)/HUGE_PAGE_SIZE*HUGE_PAGE_SIZE;
+    }
+    char* raw = (char*)malloc(size + alignment + sizeof(void*));
+    if(raw == nullptr) throw std::bad_alloc();
+    uintptr_t first = (uintptr_t)(raw + sizeof(void*));
+    char* p = (char*)((first + alignment - 1)/alignment*alignment);
+    ((void**)p)[-1] = raw;
+#ifdef MADV_HUGEPAGE
+    if(huge && (madvise(p, size, MADV_HUGEPAGE) == 0)) m_huge_page_allocations.fetch_add(1, memory_order_relaxed);
+#endif
+
+    m_allocations.fetch_add(1, memory_order_relaxed);
+    m_bytes_allocated.fetch_add(bytes, memory_order_relaxed);
+    long long live = m_bytes_live.fetch_add(bytes, memory_order_relaxed) + bytes;
+    long long peak = m_bytes_peak.load(memory_order_relaxed);
+    while((live > peak) && !m_bytes_peak.compare_exchange_weak(peak, live, memory_order_relaxed));
+    return p;
+}
+
+void TensorMemory::deallocate(void* p, size_t bytes){
+    if(p == nullptr) return;
+    free(((void**)p)[-1]);
+    m_deallocations.fetch_add(1, memory_order_relaxed);
+    m_bytes_live.fetch_sub(bytes, memory_order_relaxed);
+}
+
+TensorMemory::Stats TensorMemory::stats(){
+    return Stats{m_allocations, m_deallocations, m_huge_page_allocations,
+                 m_bytes_allocated, m_bytes_live, m_bytes_peak};
+}
+
+//reset_stats: the counters restart from 0, the peak from the live bytes
+void TensorMemory::reset_stats(){
+    m_allocations = 0;
+    m_deallocations = 0;
+    m_huge_page_allocations = 0;
+    m_bytes_allocated = 0;
+    m_bytes_peak = m_bytes_live.load();
+}
+
+string TensorMemory::get_desc(){
+    Stats s = stats();
+    return fmt::format("Tensor memory: {:d} allocations ({:d} with huge pages), {:d} deallocations; "
+                       "{:.1f} MB allocated, live {:.1f} MB, peak {:.1f} MB",
+                       s.allocations, s.huge_page_allocations, s.deallocations,
+                       s.bytes_allocated/1048576.0, s.bytes_live/1048576.0, s.bytes_peak/1048576.0);
+}
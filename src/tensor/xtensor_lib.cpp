@@ -24,36 +24,36 @@ int positive_index(int idx, int size){
 }
 
 //should use einsum if it exists
-xt::xarray<double> outer_stack(xt::xarray<double> X, xt::xarray<double>  Y){
-    xt::xarray<double> S = xt::zeros<double>({X.shape()[0], X.shape()[1], Y.shape()[1]});
+double_tensor outer_stack(double_tensor X, double_tensor  Y){
+    double_tensor S = xt::zeros<double>({X.shape()[0], X.shape()[1], Y.shape()[1]});
     int nrows = X.shape()[0];
 
     for(int r=0; r < nrows; r++){
-        xt::xarray<double> x = xt::row(X, r);
-        xt::xarray<double> y = xt::row(Y, r);
-        xt::xarray<double> U = xt::linalg::outer(x, y);
+        double_tensor x = xt::row(X, r);
+        double_tensor y = xt::row(Y, r);
+        double_tensor U = xt::linalg::outer(x, y);
         xt::view(S, r) = U;
     }
     return S;
 }
-xt::xarray<double> diag_stack(xt::xarray<double> X){
-    xt::xarray<double> DS = xt::zeros<double>({X.shape()[0], X.shape()[1], X.shape()[1]});
+double_tensor diag_stack(double_tensor X){
+    double_tensor DS = xt::zeros<double>({X.shape()[0], X.shape()[1], X.shape()[1]});
     int nrows = X.shape()[0];
 
     for(int r=0; r < nrows; r++){
-        xt::xarray<double> x = xt::row(X, r);
-        xt::xarray<double> D = xt::diag(x);
+        double_tensor x = xt::row(X, r);
+        double_tensor D = xt::diag(x);
         xt::view(DS, r) = D;
     }
     return DS;
 }
-xt::xarray<double> matmul_on_stack(xt::xarray<double> X, xt::xarray<double>  Y){
-    xt::xarray<double> S = xt::zeros<double>({X.shape()[0], X.shape()[1]});
+double_tensor matmul_on_stack(double_tensor X, double_tensor  Y){
+    double_tensor S = xt::zeros<double>({X.shape()[0], X.shape()[1]});
     int nrows = X.shape()[0];
     
     for(int r=0; r < nrows; r++){
-        xt::xarray<double> M = xt::view(X, r); //a matrix
-        xt::xarray<double> v = xt::view(Y, r); //a vector
+        double_tensor M = xt::view(X, r); //a matrix
+        double_tensor v = xt::view(Y, r); //a vector
         xt::view(S, r) = xt::linalg::dot(M, v);
     }
     return S;